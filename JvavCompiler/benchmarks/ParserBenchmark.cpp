@@ -0,0 +1,150 @@
+// 语法分析吞吐量基准测试
+// 分别在合法源代码和大量语法错误的源代码上反复执行语法分析，输出每秒处理的字节数和语句数，
+// 并比较指针语法树和扁平语法树的内存占用以及整树遍历一次的耗时。
+// 用法: jvav_parser_benchmark [语句数] [重复次数]
+
+#include "lexer/Lexer.h"
+#include "parser/Parser.h"
+#include "ast/NodeWalker.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace {
+
+// 生成一段合法的源代码，包含各种语句和较深的表达式
+std::string generateValidSource(size_t statementCount) {
+    std::string source;
+    source.reserve(statementCount * 48);
+    
+    for (size_t i = 0; i < statementCount; i++) {
+        std::string n = std::to_string(i);
+        switch (i % 6) {
+            case 0:
+                source += "set v" + n + " == (a + " + n + ") * b - c / 2 % 7\n";
+                break;
+            case 1:
+                source += "print(f(v" + n + ", x.y, arr[" + n + "]) + 1)\n";
+                break;
+            case 2:
+                source += "if (a < " + n + " && b >= 2 || !c) { print(a) } else { print(b) }\n";
+                break;
+            case 3:
+                source += "loop 10 { set t == t + " + n + " }\n";
+                break;
+            case 4:
+                source += "define g" + n + "(p, q) { return p * q + -p }\n";
+                break;
+            default:
+                source += "h(a == b, c != d, -(e + " + n + "))\n";
+                break;
+        }
+    }
+    return source;
+}
+
+// 生成一段几乎每条语句都有语法错误的源代码，模拟编辑器中正在输入的代码
+std::string generateInvalidSource(size_t statementCount) {
+    std::string source;
+    source.reserve(statementCount * 40);
+    
+    for (size_t i = 0; i < statementCount; i++) {
+        std::string n = std::to_string(i);
+        switch (i % 6) {
+            case 0:
+                source += "set v" + n + " = (a + " + n + " *\n";
+                break;
+            case 1:
+                source += "print(f(v" + n + ", x.\n";
+                break;
+            case 2:
+                source += "if (a < " + n + " { print(a) }\n";
+                break;
+            case 3:
+                source += "loop { set = }\n";
+                break;
+            case 4:
+                source += "define g" + n + "(p, { return p * }\n";
+                break;
+            default:
+                source += "set ok" + n + " == 1\n";
+                break;
+        }
+    }
+    return source;
+}
+
+// 比较两种语法树的内存占用，以及统计一遍二元运算个数的耗时
+void compareTrees(const jvav::TokenBuffer& tokens, int repetitions) {
+    jvav::Arena arena;
+    jvav::Parser parser(tokens, arena);
+    jvav::NodeList<jvav::Stmt*> statements = parser.parse();
+    
+    jvav::Arena scratch;
+    jvav::Parser flatParser(tokens, scratch);
+    jvav::FlatTree flat = flatParser.parseFlat();
+    
+    size_t pointerCount = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; i++) {
+        jvav::NodeWalker().walk(statements, [](jvav::Stmt*) {}, [&pointerCount](jvav::Expr* expr) {
+            pointerCount += expr->getType() == jvav::ExprType::BINARY;
+        });
+    }
+    double pointerSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    size_t flatCount = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; i++) {
+        flat.forEachNode([&flatCount](jvav::NodeIndex, jvav::NodeKind kind) {
+            flatCount += kind == jvav::NodeKind::BINARY;
+        });
+    }
+    double flatSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    std::cout << "  指针语法树: " << arena.bytesReserved() << " 字节, 遍历 "
+              << pointerSeconds * 1000 / repetitions << " ms" << std::endl;
+    std::cout << "  扁平语法树: " << flat.bytesUsed() << " 字节 (" << flat.size() << " 个节点), 遍历 "
+              << flatSeconds * 1000 / repetitions << " ms"
+              << (pointerCount == flatCount ? "" : " (结果不一致!)") << std::endl;
+}
+
+// 对同一份token反复执行语法分析并输出吞吐量
+void run(const char* name, const std::string& source, int repetitions) {
+    jvav::Lexer lexer(source, name);
+    jvav::TokenBuffer tokens = lexer.tokenizeToBuffer();
+    
+    size_t statements = 0;
+    size_t errors = 0;
+    
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; i++) {
+        jvav::Arena arena;
+        jvav::Parser parser(tokens, arena);
+        statements = parser.parse().size();
+        errors = parser.getDiagnostics().size();
+    }
+    auto end = std::chrono::steady_clock::now();
+    
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double megabytes = static_cast<double>(source.size()) * repetitions / (1024.0 * 1024.0);
+    
+    std::cout << name << ": " << source.size() << " 字节, " << tokens.size() << " 个token, "
+              << statements << " 条语句, " << errors << " 个错误" << std::endl;
+    std::cout << "  " << megabytes / seconds << " MB/s, "
+              << static_cast<double>(statements) * repetitions / seconds << " 语句/s" << std::endl;
+    
+    compareTrees(tokens, repetitions);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t statementCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    int repetitions = argc > 2 ? std::atoi(argv[2]) : 10;
+    
+    run("合法代码", generateValidSource(statementCount), repetitions);
+    run("错误代码", generateInvalidSource(statementCount), repetitions);
+    return 0;
+}
@@ -2,6 +2,7 @@
 #define JVAV_COMPILER_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <unordered_map>
@@ -48,15 +49,21 @@ enum class JvavTargetType {
     OBJECT_FILE,   // 目标文件
     ASSEMBLY,      // 汇编代码
     LLVM_IR,       // LLVM中间表示
-    WASM           // WebAssembly (默认)
+    WASM,          // WebAssembly (默认)
+    SSA_IR         // 编译器自己的SSA中间表示（文本）
 };
 
 // 编译器配置
 struct JvavCompilerOptions {
     bool optimize = false;              // 是否优化
     int optimizationLevel = 0;          // 优化级别 (0-3)
+    int unrollFactor = 4;               // 循环部分展开的倍数（-O2起，小于2时不展开）
+    bool useIR = false;                 // WebAssembly经由SSA中间表示生成（LLVM目标总是经由中间表示）
     bool emitDebugInfo = false;         // 是否生成调试信息
     bool verbose = false;               // 是否输出详细信息
+    bool streamTokens = false;          // 词法分析与语法分析在两个线程中流水进行
+    size_t maxNestingDepth = 256;       // 括号和语句块的最大嵌套层数
+    std::string astCacheDirectory;      // 语法树缓存目录，为空时不使用缓存
     JvavTargetType targetType = JvavTargetType::WASM;  // 编译目标类型
     std::string outputFile;             // 输出文件路径
     std::string targetPlatform;         // 目标平台 (windows, macos, linux, harmony)
@@ -77,8 +84,8 @@ public:
     // 编译文件
     JvavErrorCode compileFile(const std::string& filePath);
     
-    // 编译字符串
-    JvavErrorCode compileString(const std::string& source, const std::string& sourceName = "");
+    // 编译字符串（只借用源代码，不做复制）
+    JvavErrorCode compileString(std::string_view source, const std::string& sourceName = "");
     
     // 获取最后一次错误
     const std::string& getLastError() const;
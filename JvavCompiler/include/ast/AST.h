@@ -2,10 +2,10 @@
 #define JVAV_AST_H
 
 #include "lexer/Token.h"
-#include <string>
-#include <vector>
-#include <memory>
-#include <unordered_map>
+#include "ast/Arena.h"
+#include <cstddef>
+#include <string_view>
+#include <type_traits>
 
 namespace jvav {
 
@@ -18,9 +18,13 @@ enum class ExprType {
     CALL,
     ARRAY_ACCESS,
     RECORD_ACCESS,
-    ASSIGNMENT
+    ASSIGNMENT,
+    ERROR          // 语法错误的占位节点
 };
 
+// 表达式节点类型的个数（ERROR必须是最后一个）
+constexpr size_t EXPR_TYPE_COUNT = static_cast<size_t>(ExprType::ERROR) + 1;
+
 // 语句节点类型
 enum class StmtType {
     EXPRESSION,
@@ -37,52 +41,64 @@ enum class StmtType {
     RECORD_ACCESS,
     TRY_CATCH,
     ENUM_DEF,
-    BLOCK
+    BLOCK,
+    ERROR          // 语法错误的占位节点
 };
 
+// 语句节点类型的个数（ERROR必须是最后一个）
+constexpr size_t STMT_TYPE_COUNT = static_cast<size_t>(StmtType::ERROR) + 1;
+
 // 前置声明
 class Expr;
 class Stmt;
 
+// 语法树节点都分配在编译单元的arena中，随arena一起整体释放，不会逐个析构，
+// 因此节点只能包含平凡析构的成员：子节点用裸指针，子节点列表用NodeList，
+// 文本用指向源代码或arena的string_view。位置信息由节点中的token提供。
+
 // 所有表达式的基类
 class Expr {
 public:
-    virtual ~Expr() {}
-    virtual ExprType getType() const = 0;
+    ExprType getType() const { return type_; }
     
-    // 节点位置信息
-    SourceLocation location;
+protected:
+    explicit Expr(ExprType type) : type_(type) {}
+    
+private:
+    ExprType type_;
 };
 
 // 所有语句的基类
 class Stmt {
 public:
-    virtual ~Stmt() {}
-    virtual StmtType getType() const = 0;
+    StmtType getType() const { return type_; }
+    
+protected:
+    explicit Stmt(StmtType type) : type_(type) {}
     
-    // 节点位置信息
-    SourceLocation location;
+private:
+    StmtType type_;
 };
 
 // 字面量表达式
 class LiteralExpr : public Expr {
 public:
     LiteralExpr(const Token& token)
-        : token(token), value(token.getValue()) {}
+        : Expr(ExprType::LITERAL), token(token), value(token.getValue()) {}
     
-    ExprType getType() const override { return ExprType::LITERAL; }
+    // 文本不在源代码中的字面量（例如优化器计算出的常量），value需与语法树活得一样久
+    LiteralExpr(const Token& token, std::string_view value)
+        : Expr(ExprType::LITERAL), token(token), value(value) {}
     
     Token token;
-    std::string value;
+    std::string_view value;  // 字面量文本（字符串不含引号）
 };
 
 // 变量引用表达式
 class VariableExpr : public Expr {
 public:
     VariableExpr(const Token& name)
-        : name(name) {}
-    
-    ExprType getType() const override { return ExprType::VARIABLE; }
+        : Expr(ExprType::VARIABLE), name(name) {}
     
     Token name;
 };
@@ -90,99 +106,91 @@ public:
 // 一元操作表达式
 class UnaryExpr : public Expr {
 public:
-    UnaryExpr(const Token& op, std::unique_ptr<Expr> right)
-        : op(op), right(std::move(right)) {}
-    
-    ExprType getType() const override { return ExprType::UNARY; }
+    UnaryExpr(const Token& op, Expr* right)
+        : Expr(ExprType::UNARY), op(op), right(right) {}
     
     Token op;
-    std::unique_ptr<Expr> right;
+    Expr* right;
 };
 
 // 二元操作表达式
 class BinaryExpr : public Expr {
 public:
-    BinaryExpr(std::unique_ptr<Expr> left, const Token& op, std::unique_ptr<Expr> right)
-        : left(std::move(left)), op(op), right(std::move(right)) {}
+    BinaryExpr(Expr* left, const Token& op, Expr* right)
+        : Expr(ExprType::BINARY), left(left), op(op), right(right) {}
     
-    ExprType getType() const override { return ExprType::BINARY; }
-    
-    std::unique_ptr<Expr> left;
+    Expr* left;
     Token op;
-    std::unique_ptr<Expr> right;
+    Expr* right;
 };
 
 // 函数调用表达式
 class CallExpr : public Expr {
 public:
-    CallExpr(std::unique_ptr<Expr> callee, const Token& paren, 
-            std::vector<std::unique_ptr<Expr>> arguments)
-        : callee(std::move(callee)), paren(paren), arguments(std::move(arguments)) {}
-    
-    ExprType getType() const override { return ExprType::CALL; }
+    CallExpr(Expr* callee, const Token& paren, NodeList<Expr*> arguments)
+        : Expr(ExprType::CALL), callee(callee), paren(paren), arguments(arguments) {}
     
-    std::unique_ptr<Expr> callee;
+    Expr* callee;
     Token paren;  // 右括号位置，用于错误报告
-    std::vector<std::unique_ptr<Expr>> arguments;
+    NodeList<Expr*> arguments;
 };
 
 // 数组访问表达式
 class ArrayAccessExpr : public Expr {
 public:
-    ArrayAccessExpr(std::unique_ptr<Expr> array, std::unique_ptr<Expr> index, 
-                   const Token& bracket)
-        : array(std::move(array)), index(std::move(index)), bracket(bracket) {}
+    ArrayAccessExpr(Expr* array, Expr* index, const Token& bracket)
+        : Expr(ExprType::ARRAY_ACCESS), array(array), index(index), bracket(bracket) {}
     
-    ExprType getType() const override { return ExprType::ARRAY_ACCESS; }
-    
-    std::unique_ptr<Expr> array;
-    std::unique_ptr<Expr> index;
+    Expr* array;
+    Expr* index;
     Token bracket;  // 右括号位置，用于错误报告
 };
 
 // 记录字段访问表达式
 class RecordAccessExpr : public Expr {
 public:
-    RecordAccessExpr(std::unique_ptr<Expr> record, const Token& field)
-        : record(std::move(record)), field(field) {}
-    
-    ExprType getType() const override { return ExprType::RECORD_ACCESS; }
+    RecordAccessExpr(Expr* record, const Token& field)
+        : Expr(ExprType::RECORD_ACCESS), record(record), field(field) {}
     
-    std::unique_ptr<Expr> record;
+    Expr* record;
     Token field;
 };
 
 // 赋值表达式
 class AssignmentExpr : public Expr {
 public:
-    AssignmentExpr(std::unique_ptr<Expr> target, const Token& op, std::unique_ptr<Expr> value)
-        : target(std::move(target)), op(op), value(std::move(value)) {}
-    
-    ExprType getType() const override { return ExprType::ASSIGNMENT; }
+    AssignmentExpr(Expr* target, const Token& op, Expr* value)
+        : Expr(ExprType::ASSIGNMENT), target(target), op(op), value(value) {}
     
-    std::unique_ptr<Expr> target;
+    Expr* target;
     Token op;
-    std::unique_ptr<Expr> value;
+    Expr* value;
+};
+
+// 语法错误的占位表达式
+// 期望表达式的位置无法解析时代替它，外层的语句照常构造
+class ErrorExpr : public Expr {
+public:
+    ErrorExpr(const Token& token)
+        : Expr(ExprType::ERROR), token(token) {}
+    
+    Token token;  // 出错位置的token
 };
 
 // 表达式语句
 class ExpressionStmt : public Stmt {
 public:
-    ExpressionStmt(std::unique_ptr<Expr> expression)
-        : expression(std::move(expression)) {}
+    ExpressionStmt(Expr* expression)
+        : Stmt(StmtType::EXPRESSION), expression(expression) {}
     
-    StmtType getType() const override { return StmtType::EXPRESSION; }
-    
-    std::unique_ptr<Expr> expression;
+    Expr* expression;
 };
 
 // 导入语句
 class ImportStmt : public Stmt {
 public:
     ImportStmt(const Token& module, const Token& alias = Token())
-        : module(module), alias(alias) {}
-    
-    StmtType getType() const override { return StmtType::IMPORT; }
+        : Stmt(StmtType::IMPORT), module(module), alias(alias) {}
     
     Token module;
     Token alias;
@@ -191,110 +199,91 @@ public:
 // 打开语句
 class DakaiStmt : public Stmt {
 public:
-    DakaiStmt(std::unique_ptr<Expr> path)
-        : path(std::move(path)) {}
+    DakaiStmt(Expr* path)
+        : Stmt(StmtType::DAKAI), path(path) {}
     
-    StmtType getType() const override { return StmtType::DAKAI; }
-    
-    std::unique_ptr<Expr> path;
+    Expr* path;
 };
 
 // 设置变量语句
 class SetStmt : public Stmt {
 public:
-    SetStmt(const Token& name, std::unique_ptr<Expr> value, const Token& type = Token())
-        : name(name), value(std::move(value)), type(type) {}
-    
-    StmtType getType() const override { return StmtType::SET; }
+    SetStmt(const Token& name, Expr* value, const Token& type = Token())
+        : Stmt(StmtType::SET), name(name), value(value), type(type) {}
     
     Token name;
-    std::unique_ptr<Expr> value;
+    Expr* value;
     Token type;  // 可选的类型
 };
 
 // 打印语句
 class PrintStmt : public Stmt {
 public:
-    PrintStmt(std::unique_ptr<Expr> value)
-        : value(std::move(value)) {}
-    
-    StmtType getType() const override { return StmtType::PRINT; }
+    PrintStmt(Expr* value)
+        : Stmt(StmtType::PRINT), value(value) {}
     
-    std::unique_ptr<Expr> value;
+    Expr* value;
 };
 
 // 条件分支
 struct Branch {
-    std::unique_ptr<Expr> condition;
-    std::vector<std::unique_ptr<Stmt>> body;
+    Expr* condition;  // else分支为nullptr
+    NodeList<Stmt*> body;
     
-    Branch(std::unique_ptr<Expr> cond, std::vector<std::unique_ptr<Stmt>> b)
-        : condition(std::move(cond)), body(std::move(b)) {}
+    Branch(Expr* cond, NodeList<Stmt*> b)
+        : condition(cond), body(b) {}
 };
 
 // If语句
 class IfStmt : public Stmt {
 public:
-    IfStmt(std::vector<Branch> branches)
-        : branches(std::move(branches)) {}
+    IfStmt(NodeList<Branch> branches)
+        : Stmt(StmtType::IF), branches(branches) {}
     
-    StmtType getType() const override { return StmtType::IF; }
-    
-    std::vector<Branch> branches;
+    NodeList<Branch> branches;
 };
 
 // 循环语句
 class LoopStmt : public Stmt {
 public:
-    LoopStmt(const Token& variable, std::unique_ptr<Expr> count, 
-            std::vector<std::unique_ptr<Stmt>> body)
-        : variable(variable), count(std::move(count)), body(std::move(body)) {}
-    
-    StmtType getType() const override { return StmtType::LOOP; }
+    LoopStmt(const Token& variable, Expr* count, NodeList<Stmt*> body)
+        : Stmt(StmtType::LOOP), variable(variable), count(count), body(body) {}
     
     Token variable;  // 循环变量，可为空
-    std::unique_ptr<Expr> count;
-    std::vector<std::unique_ptr<Stmt>> body;
+    Expr* count;
+    NodeList<Stmt*> body;
 };
 
 // 函数定义语句
 class DefineStmt : public Stmt {
 public:
-    DefineStmt(const Token& name, std::vector<Token> parameters, 
-               std::vector<std::unique_ptr<Stmt>> body)
-        : name(name), parameters(std::move(parameters)), body(std::move(body)) {}
-    
-    StmtType getType() const override { return StmtType::DEFINE; }
+    DefineStmt(const Token& name, NodeList<Token> parameters, NodeList<Stmt*> body)
+        : Stmt(StmtType::DEFINE), name(name), parameters(parameters), body(body) {}
     
     Token name;
-    std::vector<Token> parameters;
-    std::vector<std::unique_ptr<Stmt>> body;
+    NodeList<Token> parameters;
+    NodeList<Stmt*> body;
 };
 
 // 返回语句
 class ReturnStmt : public Stmt {
 public:
-    ReturnStmt(const Token& keyword, std::unique_ptr<Expr> value = nullptr)
-        : keyword(keyword), value(std::move(value)) {}
-    
-    StmtType getType() const override { return StmtType::RETURN; }
+    ReturnStmt(const Token& keyword, Expr* value = nullptr)
+        : Stmt(StmtType::RETURN), keyword(keyword), value(value) {}
     
     Token keyword;
-    std::unique_ptr<Expr> value;
+    Expr* value;
 };
 
 // 数组定义语句
 class ArrayStmt : public Stmt {
 public:
-    ArrayStmt(const Token& name, const Token& elementType, 
-             std::vector<std::unique_ptr<Expr>> elements)
-        : name(name), elementType(elementType), elements(std::move(elements)) {}
-    
-    StmtType getType() const override { return StmtType::ARRAY; }
+    ArrayStmt(const Token& name, const Token& elementType, NodeList<Expr*> elements)
+        : Stmt(StmtType::ARRAY), name(name), elementType(elementType), elements(elements) {}
     
     Token name;
     Token elementType;
-    std::vector<std::unique_ptr<Expr>> elements;
+    NodeList<Expr*> elements;
 };
 
 // 记录字段定义
@@ -309,64 +298,76 @@ struct FieldDefinition {
 // 记录类型定义语句
 class RecordDefStmt : public Stmt {
 public:
-    RecordDefStmt(const Token& name, std::vector<FieldDefinition> fields)
-        : name(name), fields(std::move(fields)) {}
-    
-    StmtType getType() const override { return StmtType::RECORD_DEF; }
+    RecordDefStmt(const Token& name, NodeList<FieldDefinition> fields)
+        : Stmt(StmtType::RECORD_DEF), name(name), fields(fields) {}
     
     Token name;
-    std::vector<FieldDefinition> fields;
+    NodeList<FieldDefinition> fields;
 };
 
 // 记录访问语句
 class RecordAccessStmt : public Stmt {
 public:
-    RecordAccessStmt(const Token& record, const Token& field, std::unique_ptr<Expr> value)
-        : record(record), field(field), value(std::move(value)) {}
-    
-    StmtType getType() const override { return StmtType::RECORD_ACCESS; }
+    RecordAccessStmt(const Token& record, const Token& field, Expr* value)
+        : Stmt(StmtType::RECORD_ACCESS), record(record), field(field), value(value) {}
     
     Token record;
     Token field;
-    std::unique_ptr<Expr> value;
+    Expr* value;
 };
 
 // Try-Catch语句
 class TryCatchStmt : public Stmt {
 public:
-    TryCatchStmt(std::vector<std::unique_ptr<Stmt>> tryBlock,
-                std::vector<std::unique_ptr<Stmt>> catchBlock)
-        : tryBlock(std::move(tryBlock)), catchBlock(std::move(catchBlock)) {}
-    
-    StmtType getType() const override { return StmtType::TRY_CATCH; }
+    TryCatchStmt(NodeList<Stmt*> tryBlock, NodeList<Stmt*> catchBlock)
+        : Stmt(StmtType::TRY_CATCH), tryBlock(tryBlock), catchBlock(catchBlock) {}
     
-    std::vector<std::unique_ptr<Stmt>> tryBlock;
-    std::vector<std::unique_ptr<Stmt>> catchBlock;
+    NodeList<Stmt*> tryBlock;
+    NodeList<Stmt*> catchBlock;
 };
 
 // 枚举定义语句
 class EnumDefStmt : public Stmt {
 public:
-    EnumDefStmt(const Token& name, std::vector<Token> values)
-        : name(name), values(std::move(values)) {}
-    
-    StmtType getType() const override { return StmtType::ENUM_DEF; }
+    EnumDefStmt(const Token& name, NodeList<Token> values)
+        : Stmt(StmtType::ENUM_DEF), name(name), values(values) {}
     
     Token name;
-    std::vector<Token> values;
+    NodeList<Token> values;
 };
 
 // 语句块
 class BlockStmt : public Stmt {
 public:
-    BlockStmt(std::vector<std::unique_ptr<Stmt>> statements)
-        : statements(std::move(statements)) {}
+    BlockStmt(NodeList<Stmt*> statements)
+        : Stmt(StmtType::BLOCK), statements(statements) {}
     
-    StmtType getType() const override { return StmtType::BLOCK; }
+    NodeList<Stmt*> statements;
+};
+
+// 语法错误的占位语句
+// 出错的语句从token开始直到同步点都被跳过
+class ErrorStmt : public Stmt {
+public:
+    ErrorStmt(const Token& token)
+        : Stmt(StmtType::ERROR), token(token) {}
     
-    std::vector<std::unique_ptr<Stmt>> statements;
+    Token token;  // 出错语句的第一个token
+};
+
+// 编译单元的语法树
+// 持有分配全部节点的arena，析构时一次释放所有节点
+struct Program {
+    Arena arena;
+    NodeList<Stmt*> statements;
 };
 
+static_assert(std::is_trivially_destructible_v<BinaryExpr> &&
+              std::is_trivially_destructible_v<CallExpr> &&
+              std::is_trivially_destructible_v<IfStmt> &&
+              std::is_trivially_destructible_v<DefineStmt>,
+              "语法树节点必须是平凡析构的");
+
 } // namespace jvav
 
-#endif // JVAV_AST_H 
\ No newline at end of file
+#endif // JVAV_AST_H
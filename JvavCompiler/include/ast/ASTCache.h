@@ -0,0 +1,76 @@
+#ifndef JVAV_AST_CACHE_H
+#define JVAV_AST_CACHE_H
+
+#include "ast/AST.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace jvav {
+
+// 语法树的二进制缓存
+// 把解析得到的语法树序列化后保存在缓存目录中，文件名由源代码内容和编译器配置的哈希决定。
+// 源代码没有变化时直接映射缓存文件，一次顺序扫描就在arena中重建语法树，跳过词法和语法分析。
+//
+// 文件格式：固定长度的文件头之后是以32位字为单位的节点记录。
+// 记录按前序遍历的逆序排列，子节点总在父节点之前，读取时用一个显式栈自底向上组装，
+// 任意深的语法树都不需要递归。token只保存类型、偏移和长度，加载时归入当前的源文件；
+// 指向源代码的字面量文本保存偏移，其他文本（例如优化产生的常量）直接内嵌在记录中。
+// 缓存文件损坏、截断或与当前源代码不符时视为未命中，不会产生错误。
+class ASTCache {
+public:
+    // 格式版本，记录格式或语法树节点有变化时递增
+    static constexpr uint32_t FORMAT_VERSION = 1;
+
+    // 缓存文件的扩展名
+    static constexpr const char* FILE_EXTENSION = ".jast";
+
+    // 保存累计命中统计的文件名
+    static constexpr const char* STATISTICS_FILE = "statistics";
+
+    // 一份源代码对应的缓存项
+    struct Key {
+        uint64_t hash = 0;
+        std::string path;
+    };
+
+    // directory为缓存目录，不存在时在第一次保存时创建
+    // configuration标识编译器版本和影响语法分析结果的选项，配置不同的缓存互不干扰
+    ASTCache(const std::string& directory, const std::string& configuration);
+
+    // 计算源代码对应的缓存项
+    Key makeKey(std::string_view source) const;
+
+    // 查找缓存，命中时在program的arena中重建语法树，token属于文件file
+    // 未命中时返回false，program保持为空
+    bool load(const Key& key, std::string_view source, FileId file, Program& program) const;
+
+    // 保存语法树，其中的token属于文件file，失败时返回false并在error中给出原因
+    // 写入临时文件后再改名，并发的编译不会读到写了一半的缓存
+    bool store(const Key& key, std::string_view source, FileId file, const Program& program,
+               std::string& error) const;
+
+    // 缓存目录的累计命中统计
+    struct Statistics {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+
+    // 把一次查找的结果累加到缓存目录的统计文件中，返回累加后的统计
+    // 每次运行jvavc只编译一次，统计放在目录中才能跨多次运行累计；
+    // 同时运行的编译可能覆盖彼此的更新，统计只是近似值
+    Statistics recordLookup(bool hit) const;
+
+    // 上次load()或store()读写的字节数
+    size_t lastFileSize() const { return lastFileSize_; }
+
+private:
+    std::string directory_;
+    uint64_t configurationHash_;
+    mutable size_t lastFileSize_ = 0;
+};
+
+} // namespace jvav
+
+#endif // JVAV_AST_CACHE_H
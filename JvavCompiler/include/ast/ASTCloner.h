@@ -0,0 +1,142 @@
+#ifndef JVAV_AST_CLONER_H
+#define JVAV_AST_CLONER_H
+
+#include "ast/AST.h"
+#include "ast/ASTVisitor.h"
+#include <utility>
+#include <vector>
+
+namespace jvav {
+
+// 语法树复制
+// 深复制语句或表达式，新节点分配在给定的arena中。待复制的子节点放在显式栈中，不递归。
+// 复制时可以把对某些变量的引用替换为给定表达式的副本（例如内联时把参数换成实参，
+// 展开循环时把循环变量换成常量）；替换进来的副本内部不再替换。
+// 名字、参数、字段、枚举值这些token列表不会被修改，副本与原树共用。
+class ASTCloner : private ASTVisitor<ASTCloner> {
+public:
+    explicit ASTCloner(Arena& arena) : arena_(arena) {}
+
+    // 之后复制时把对symbol的变量引用替换为replacement的副本
+    void substitute(Symbol symbol, const Expr* replacement);
+
+    // 取消所有替换
+    void clearSubstitutions() { substitutions_.clear(); }
+
+    // 复制表达式、语句或语句列表
+    Expr* clone(const Expr* expr);
+    Stmt* clone(const Stmt* stmt);
+    NodeList<Stmt*> clone(const NodeList<Stmt*>& statements);
+
+private:
+    friend class ASTVisitor<ASTCloner>;
+
+    // 副本中一个仍指向原节点的位置，处理时换成原节点的副本
+    // exprSlot和stmtSlot恰有一个不为空；substitute为false时其中不做替换
+    struct Pending {
+        Expr** exprSlot;
+        Stmt** stmtSlot;
+        bool substitute;
+    };
+
+    // 处理栈中的全部位置
+    void run();
+
+    // 复制节点本身，子节点仍指向原树
+    template <typename Node>
+    Node* copy(const Node* node) {
+        Node* result = arena_.make<Node>(*node);
+        if constexpr (std::is_base_of_v<Expr, Node>) {
+            exprResult_ = result;
+        } else {
+            stmtResult_ = result;
+        }
+        return result;
+    }
+
+    void push(Expr** slot) {
+        if (*slot != nullptr) {
+            pending_.push_back(Pending{slot, nullptr, substituting_});
+        }
+    }
+    void push(Stmt** slot) {
+        pending_.push_back(Pending{nullptr, slot, substituting_});
+    }
+    template <typename T>
+    void pushList(NodeList<T>& list) {
+        list = arena_.copyList(list.begin(), list.size());
+        for (T& item : list) {
+            push(&item);
+        }
+    }
+
+    // 各种节点：复制自身，再排入副本中的子节点
+    void visit(const ExpressionStmt* stmt) { push(&copy(stmt)->expression); }
+    void visit(const ImportStmt* stmt) { copy(stmt); }
+    void visit(const DakaiStmt* stmt) { push(&copy(stmt)->path); }
+    void visit(const SetStmt* stmt) { push(&copy(stmt)->value); }
+    void visit(const PrintStmt* stmt) { push(&copy(stmt)->value); }
+    void visit(const IfStmt* stmt) {
+        IfStmt* result = copy(stmt);
+        result->branches = arena_.copyList(result->branches.begin(), result->branches.size());
+        for (Branch& branch : result->branches) {
+            push(&branch.condition);
+            pushList(branch.body);
+        }
+    }
+    void visit(const LoopStmt* stmt) {
+        LoopStmt* result = copy(stmt);
+        push(&result->count);
+        pushList(result->body);
+    }
+    void visit(const DefineStmt* stmt) { pushList(copy(stmt)->body); }
+    void visit(const ReturnStmt* stmt) { push(&copy(stmt)->value); }
+    void visit(const ArrayStmt* stmt) { pushList(copy(stmt)->elements); }
+    void visit(const RecordDefStmt* stmt) { copy(stmt); }
+    void visit(const RecordAccessStmt* stmt) { push(&copy(stmt)->value); }
+    void visit(const TryCatchStmt* stmt) {
+        TryCatchStmt* result = copy(stmt);
+        pushList(result->tryBlock);
+        pushList(result->catchBlock);
+    }
+    void visit(const EnumDefStmt* stmt) { copy(stmt); }
+    void visit(const BlockStmt* stmt) { pushList(copy(stmt)->statements); }
+    void visit(const ErrorStmt* stmt) { copy(stmt); }
+
+    void visit(const LiteralExpr* expr) { copy(expr); }
+    void visit(const VariableExpr* expr) { copy(expr); }
+    void visit(const UnaryExpr* expr) { push(&copy(expr)->right); }
+    void visit(const BinaryExpr* expr) {
+        BinaryExpr* result = copy(expr);
+        push(&result->left);
+        push(&result->right);
+    }
+    void visit(const CallExpr* expr) {
+        CallExpr* result = copy(expr);
+        push(&result->callee);
+        pushList(result->arguments);
+    }
+    void visit(const ArrayAccessExpr* expr) {
+        ArrayAccessExpr* result = copy(expr);
+        push(&result->array);
+        push(&result->index);
+    }
+    void visit(const RecordAccessExpr* expr) { push(&copy(expr)->record); }
+    void visit(const AssignmentExpr* expr) {
+        AssignmentExpr* result = copy(expr);
+        push(&result->target);
+        push(&result->value);
+    }
+    void visit(const ErrorExpr* expr) { copy(expr); }
+
+    Arena& arena_;
+    std::vector<std::pair<Symbol, const Expr*>> substitutions_;
+    std::vector<Pending> pending_;
+    bool substituting_ = true;
+    Expr* exprResult_ = nullptr;
+    Stmt* stmtResult_ = nullptr;
+};
+
+} // namespace jvav
+
+#endif // JVAV_AST_CLONER_H
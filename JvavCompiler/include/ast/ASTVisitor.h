@@ -0,0 +1,92 @@
+#ifndef JVAV_AST_VISITOR_H
+#define JVAV_AST_VISITOR_H
+
+#include "ast/AST.h"
+#include <type_traits>
+
+namespace jvav {
+
+// 语法树访问者（CRTP）
+// 派生类为每一种具体节点提供一个visit重载，visitStmt()/visitExpr()按节点类型
+// 静态分派到这些重载：只有一次switch和static_cast，没有虚函数，编译器可以把visit内联进来。
+//
+//   class Printer : public ASTVisitor<Printer> {
+//   public:
+//       void visit(const SetStmt* stmt) { ... }
+//       void visit(const BinaryExpr* expr) { ... }
+//       ...  // 其他每一种节点
+//   };
+//   printer.visitStmt(stmt);
+//
+// 穷尽性在编译期检查：派生类缺少某种节点的visit重载时无法编译
+// （具体节点类之间不能互相转换，不会悄悄落到别的重载上）；
+// 新增节点类型时下面的static_assert提醒同时更新分派。
+// 确实要统一处理的节点可以在派生类中用模板重载兜底，这是显式的选择。
+//
+// 节点指针的const与传入的一致：传入const Stmt*时调用visit(const XxxStmt*)，
+// 传入Stmt*时调用visit(XxxStmt*)，需要改写语法树的遍历（例如优化）用后者。
+// Result为所有visit重载共同的返回类型。
+template <typename Derived, typename Result = void>
+class ASTVisitor {
+public:
+    template <typename StmtNode>
+    Result visitStmt(StmtNode* stmt) {
+        static_assert(std::is_same_v<std::remove_const_t<StmtNode>, Stmt>, "visitStmt只接受Stmt*");
+        static_assert(STMT_TYPE_COUNT == 16, "新增了语句类型，请在ASTVisitor::visitStmt中加上它");
+
+        Derived& self = static_cast<Derived&>(*this);
+        switch (stmt->getType()) {
+            case StmtType::EXPRESSION:    return self.visit(cast<ExpressionStmt>(stmt));
+            case StmtType::IMPORT:        return self.visit(cast<ImportStmt>(stmt));
+            case StmtType::DAKAI:         return self.visit(cast<DakaiStmt>(stmt));
+            case StmtType::SET:           return self.visit(cast<SetStmt>(stmt));
+            case StmtType::PRINT:         return self.visit(cast<PrintStmt>(stmt));
+            case StmtType::IF:            return self.visit(cast<IfStmt>(stmt));
+            case StmtType::LOOP:          return self.visit(cast<LoopStmt>(stmt));
+            case StmtType::DEFINE:        return self.visit(cast<DefineStmt>(stmt));
+            case StmtType::RETURN:        return self.visit(cast<ReturnStmt>(stmt));
+            case StmtType::ARRAY:         return self.visit(cast<ArrayStmt>(stmt));
+            case StmtType::RECORD_DEF:    return self.visit(cast<RecordDefStmt>(stmt));
+            case StmtType::RECORD_ACCESS: return self.visit(cast<RecordAccessStmt>(stmt));
+            case StmtType::TRY_CATCH:     return self.visit(cast<TryCatchStmt>(stmt));
+            case StmtType::ENUM_DEF:      return self.visit(cast<EnumDefStmt>(stmt));
+            case StmtType::BLOCK:         return self.visit(cast<BlockStmt>(stmt));
+            case StmtType::ERROR:         break;
+        }
+        return self.visit(cast<ErrorStmt>(stmt));
+    }
+
+    template <typename ExprNode>
+    Result visitExpr(ExprNode* expr) {
+        static_assert(std::is_same_v<std::remove_const_t<ExprNode>, Expr>, "visitExpr只接受Expr*");
+        static_assert(EXPR_TYPE_COUNT == 9, "新增了表达式类型，请在ASTVisitor::visitExpr中加上它");
+
+        Derived& self = static_cast<Derived&>(*this);
+        switch (expr->getType()) {
+            case ExprType::LITERAL:       return self.visit(cast<LiteralExpr>(expr));
+            case ExprType::VARIABLE:      return self.visit(cast<VariableExpr>(expr));
+            case ExprType::UNARY:         return self.visit(cast<UnaryExpr>(expr));
+            case ExprType::BINARY:        return self.visit(cast<BinaryExpr>(expr));
+            case ExprType::CALL:          return self.visit(cast<CallExpr>(expr));
+            case ExprType::ARRAY_ACCESS:  return self.visit(cast<ArrayAccessExpr>(expr));
+            case ExprType::RECORD_ACCESS: return self.visit(cast<RecordAccessExpr>(expr));
+            case ExprType::ASSIGNMENT:    return self.visit(cast<AssignmentExpr>(expr));
+            case ExprType::ERROR:         break;
+        }
+        return self.visit(cast<ErrorExpr>(expr));
+    }
+
+protected:
+    ASTVisitor() = default;
+
+private:
+    // 转换为具体节点类型，保留const
+    template <typename Node, typename Base>
+    static std::conditional_t<std::is_const_v<Base>, const Node*, Node*> cast(Base* node) {
+        return static_cast<std::conditional_t<std::is_const_v<Base>, const Node*, Node*>>(node);
+    }
+};
+
+} // namespace jvav
+
+#endif // JVAV_AST_VISITOR_H
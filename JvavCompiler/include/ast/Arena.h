@@ -0,0 +1,129 @@
+#ifndef JVAV_ARENA_H
+#define JVAV_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace jvav {
+
+// arena中的连续数组（语法树节点的子节点列表等）
+// 只是指向arena内存的指针和长度，不拥有元素，复制它不会复制元素
+template <typename T>
+class NodeList {
+public:
+    NodeList() = default;
+    NodeList(T* data, uint32_t size) : data_(data), size_(size) {}
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    T& operator[](size_t index) { return data_[index]; }
+    const T& operator[](size_t index) const { return data_[index]; }
+
+    T& front() { return data_[0]; }
+    const T& front() const { return data_[0]; }
+    T& back() { return data_[size_ - 1]; }
+    const T& back() const { return data_[size_ - 1]; }
+
+    T* begin() { return data_; }
+    T* end() { return data_ + size_; }
+    const T* begin() const { return data_; }
+    const T* end() const { return data_ + size_; }
+
+private:
+    T* data_ = nullptr;
+    uint32_t size_ = 0;
+};
+
+// 区域分配器
+// 按块(slab)向系统申请内存，块内顺序分配，单个对象不能释放，
+// 析构或reset()时一次性释放全部内存。
+// 放入arena的对象不会被析构，因此只能是平凡析构的类型。
+class Arena {
+public:
+    // 默认的块大小
+    static constexpr size_t DEFAULT_SLAB_SIZE = 64 * 1024;
+
+    explicit Arena(size_t slabSize = DEFAULT_SLAB_SIZE) : slabSize_(slabSize) {}
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // 分配size字节，按alignment对齐（alignment必须是2的幂）
+    void* allocate(size_t size, size_t alignment) {
+        uintptr_t current = reinterpret_cast<uintptr_t>(ptr_);
+        uintptr_t aligned = (current + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+        if (ptr_ != nullptr && aligned + size <= reinterpret_cast<uintptr_t>(end_)) {
+            ptr_ = reinterpret_cast<char*>(aligned + size);
+            return reinterpret_cast<void*>(aligned);
+        }
+        return allocateSlow(size, alignment);
+    }
+
+    // 在arena中构造对象
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        static_assert(std::is_trivially_destructible_v<T>, "arena中的对象不会被析构");
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    // 将count个元素复制到arena中，返回对应的列表
+    template <typename T>
+    NodeList<T> copyList(const T* data, size_t count) {
+        static_assert(std::is_trivially_destructible_v<T>, "arena中的对象不会被析构");
+        if (count == 0) {
+            return NodeList<T>();
+        }
+        T* items = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+        for (size_t i = 0; i < count; i++) {
+            new (items + i) T(data[i]);
+        }
+        return NodeList<T>(items, static_cast<uint32_t>(count));
+    }
+
+    // 将字符串复制到arena中
+    std::string_view copyString(std::string_view text) {
+        if (text.empty()) {
+            return std::string_view();
+        }
+        char* copy = static_cast<char*>(allocate(text.size(), 1));
+        std::memcpy(copy, text.data(), text.size());
+        return std::string_view(copy, text.size());
+    }
+
+    // 释放全部内存，之后可以继续使用
+    void reset();
+    
+    // 接管other的全部内存，other中分配的对象从此随本arena释放，other变为空
+    // 用于把工作线程各自的arena合并到编译单元的arena中
+    void absorb(Arena& other);
+
+    // 已向系统申请的总字节数
+    size_t bytesReserved() const { return bytesReserved_; }
+
+private:
+    // 块头，块的数据紧跟在其后
+    struct Slab {
+        Slab* next;
+        size_t size;
+    };
+
+    // 当前块放不下时申请新块
+    void* allocateSlow(size_t size, size_t alignment);
+
+    size_t slabSize_;
+    Slab* slabs_ = nullptr;
+    char* ptr_ = nullptr;
+    char* end_ = nullptr;
+    size_t bytesReserved_ = 0;
+};
+
+} // namespace jvav
+
+#endif // JVAV_ARENA_H
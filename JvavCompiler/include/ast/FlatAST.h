@@ -0,0 +1,235 @@
+#ifndef JVAV_FLAT_AST_H
+#define JVAV_FLAT_AST_H
+
+#include "ast/AST.h"
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace jvav {
+
+// 扁平语法树中的编号（节点、名字、字面量、extra下标）
+using NodeIndex = uint32_t;
+
+// 不存在的可选子节点、名字或位置
+constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+// 扁平语法树的节点种类，表达式和语句合在一起
+enum class NodeKind : uint8_t {
+    // 表达式
+    LITERAL,
+    VARIABLE,
+    UNARY,
+    BINARY,
+    CALL,
+    ARRAY_ACCESS,
+    RECORD_ACCESS,
+    ASSIGNMENT,
+    ERROR_EXPR,
+
+    // 语句
+    EXPRESSION_STMT,
+    IMPORT,
+    DAKAI,
+    SET,
+    PRINT,
+    IF,
+    LOOP,
+    DEFINE,
+    RETURN,
+    ARRAY,
+    RECORD_DEF,
+    RECORD_ACCESS_STMT,
+    TRY_CATCH,
+    ENUM_DEF,
+    BLOCK,
+    ERROR_STMT
+};
+
+// 节点种类是否是表达式
+inline bool isExpression(NodeKind kind) {
+    return kind <= NodeKind::ERROR_EXPR;
+}
+
+// extra中的一个列表：长度和紧随其后的元素
+class FlatList {
+public:
+    FlatList(const uint32_t* data, uint32_t size) : data_(data), size_(size) {}
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    uint32_t operator[](size_t index) const { return data_[index]; }
+    const uint32_t* begin() const { return data_; }
+    const uint32_t* end() const { return data_ + size_; }
+
+private:
+    const uint32_t* data_;
+    uint32_t size_;
+};
+
+// 扁平的语法树
+// 节点不是互相指向的对象，而是几个并列数组中的同一个下标：
+// kind（1字节）、主token的类型（1字节）和偏移、两个32位的操作数lhs/rhs。
+// 子节点用编号引用，列表和多于两个的操作数放在extra数组中，
+// 标识符和字面量的文本放在名字表和字面量表中，只记录在源代码中的范围，每个节点只占14字节。
+//
+// 节点按后序存放：子节点的编号总是小于父节点，同一节点的子节点按源代码顺序编号。
+// 因此按编号从小到大扫描一遍就是一次自底向上的遍历（例如常量折叠），
+// 需要结构信息时再从roots()开始按lhs/rhs往下走。
+//
+// 各种节点的lhs/rhs（"名字"是名字表下标，"列表"是extra中列表的下标，可选的部分为INVALID_INDEX）：
+//   LITERAL             lhs=字面量表下标
+//   VARIABLE            lhs=名字
+//   UNARY               lhs=操作数
+//   BINARY              lhs=左操作数  rhs=右操作数
+//   CALL                lhs=被调用者  rhs=参数列表
+//   ARRAY_ACCESS        lhs=数组      rhs=下标
+//   RECORD_ACCESS       lhs=记录      rhs=字段名字
+//   ASSIGNMENT          lhs=目标      rhs=值
+//   EXPRESSION_STMT     lhs=表达式
+//   IMPORT              lhs=模块名字  rhs=别名名字
+//   DAKAI               lhs=路径
+//   SET                 lhs=值        rhs=extra[变量名字, 类型名字]
+//   PRINT               lhs=值
+//   IF                  lhs=extra[分支数, 条件0, 语句列表0, 条件1, 语句列表1, ...]（else分支没有条件）
+//   LOOP                lhs=次数      rhs=extra[循环变量名字, 语句列表]
+//   DEFINE              lhs=函数名字  rhs=extra[参数名字列表, 语句列表]
+//   RETURN              lhs=返回值
+//   ARRAY               lhs=extra[数组名字, 元素类型名字]  rhs=元素列表
+//   RECORD_DEF          lhs=记录名字  rhs=名字列表（字段名和类型名交替）
+//   RECORD_ACCESS_STMT  lhs=值        rhs=extra[记录名字, 字段名字]
+//   TRY_CATCH           lhs=try语句列表  rhs=catch语句列表
+//   ENUM_DEF            lhs=枚举名字  rhs=枚举值名字列表
+//   BLOCK               lhs=语句列表
+//   ERROR_EXPR/ERROR_STMT 没有操作数
+// 主token：字面量、变量名、运算符、调用和下标的右括号、字段名、语句的名字或关键字；
+// 表达式语句、打印、if、try、语句块这些在指针语法树中就没有token的语句偏移为INVALID_INDEX。
+class FlatTree {
+public:
+    // 节点数
+    size_t size() const { return kinds_.size(); }
+
+    NodeKind kind(NodeIndex node) const { return kinds_[node]; }
+    TokenType tokenType(NodeIndex node) const { return tokenTypes_[node]; }
+    uint32_t offset(NodeIndex node) const { return data_[node].offset; }
+    uint32_t lhs(NodeIndex node) const { return data_[node].lhs; }
+    uint32_t rhs(NodeIndex node) const { return data_[node].rhs; }
+
+    // extra数组中的一个字，以及从下标at开始的列表
+    uint32_t extra(uint32_t at) const { return extra_[at]; }
+    FlatList list(uint32_t at) const { return FlatList(extra_.data() + at + 1, extra_[at]); }
+
+    // 名字表：名字的文本和在源文件中的偏移
+    std::string_view name(uint32_t index) const { return text(names_[index]); }
+    uint32_t nameOffset(uint32_t index) const { return names_[index].offset; }
+
+    // 字面量表（字符串字面量不含引号）
+    std::string_view literal(uint32_t index) const { return text(literals_[index]); }
+
+    // 顶层语句
+    FlatList roots() const { return list(rootList_); }
+
+    // token所属的源文件
+    FileId getFile() const { return file_; }
+
+    // 按编号顺序（后序）访问每个节点，visit(NodeIndex, NodeKind)
+    template <typename Visitor>
+    void forEachNode(Visitor&& visit) const {
+        for (NodeIndex node = 0; node < kinds_.size(); node++) {
+            visit(node, kinds_[node]);
+        }
+    }
+
+    // 各数组占用的总字节数
+    size_t bytesUsed() const;
+
+private:
+    friend class FlatBuilder;
+
+    struct NodeData {
+        uint32_t offset;
+        uint32_t lhs;
+        uint32_t rhs;
+    };
+
+    // 一段文本：源代码中的范围，或者（length带OWNED_TEXT标记时）ownedText_中的范围
+    struct TextRange {
+        uint32_t offset;
+        uint32_t length;
+    };
+    static constexpr uint32_t OWNED_TEXT = 1u << 31;
+
+    std::string_view text(const TextRange& range) const {
+        if (range.length & OWNED_TEXT) {
+            return std::string_view(ownedText_).substr(range.offset, range.length & ~OWNED_TEXT);
+        }
+        return source_.substr(range.offset, range.length);
+    }
+
+    std::vector<NodeKind> kinds_;
+    std::vector<TokenType> tokenTypes_;
+    std::vector<NodeData> data_;
+    std::vector<uint32_t> extra_;
+    std::vector<TextRange> names_;
+    std::vector<TextRange> literals_;
+    std::string ownedText_;  // 不在源代码中的字面量文本（例如优化后的常量）
+    uint32_t rootList_ = INVALID_INDEX;
+    FileId file_ = INVALID_FILE_ID;
+    std::string_view source_;
+};
+
+// 扁平语法树的构造器
+// 节点只能追加，子节点必须先于父节点追加，这正是语法分析自底向上产生节点的顺序。
+// 语法分析器每解析完一条顶层语句就用addRoot()把它转换进来（见Parser::parseFlat），
+// 指针节点随即释放；也可以用各个addXxx()方法直接构造。
+class FlatBuilder {
+public:
+    // 把一条指针语法树中的语句连同子树追加进来并记为顶层语句
+    // 用后序遍历逐个追加节点，不递归
+    NodeIndex addRoot(const Stmt* stmt);
+
+    // 记录一条已经追加的语句为顶层语句
+    void addRoot(NodeIndex stmt) { roots_.push_back(stmt); }
+
+    // 追加节点，返回其编号
+    NodeIndex addNode(NodeKind kind, const Token& token, uint32_t lhs = INVALID_INDEX,
+                      uint32_t rhs = INVALID_INDEX);
+
+    // 追加名字，默认构造的token（省略的名字）返回INVALID_INDEX
+    uint32_t addName(const Token& token);
+
+    // 追加字面量文本，不在源代码中的文本会复制一份
+    uint32_t addLiteral(std::string_view value);
+
+    // 在extra中追加若干个字或一个列表，返回起始下标
+    uint32_t addExtra(std::initializer_list<uint32_t> words);
+    uint32_t addList(const uint32_t* items, size_t count);
+
+    // 完成构造并释放多余的容量，构造器恢复为空
+    FlatTree finish();
+
+private:
+    // 把一个指针节点转换为扁平节点，它的子节点已经在results_的末尾
+    void convert(const Expr* expr);
+    void convert(const Stmt* stmt);
+
+    // 第一次遇到属于某个文件的token时记下文件和源代码
+    void setFile(FileId file);
+
+    // 从results_中取出一个节点的全部子节点
+    class Children;
+
+    FlatTree tree_;
+    std::vector<NodeIndex> roots_;
+
+    // 后序转换时已转换、尚未被父节点取走的子节点
+    std::vector<NodeIndex> results_;
+    std::vector<uint32_t> scratch_;
+};
+
+} // namespace jvav
+
+#endif // JVAV_FLAT_AST_H
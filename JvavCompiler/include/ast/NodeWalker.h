@@ -0,0 +1,83 @@
+#ifndef JVAV_NODE_WALKER_H
+#define JVAV_NODE_WALKER_H
+
+#include "ast/AST.h"
+#include <vector>
+
+namespace jvav {
+
+// 不使用递归的语法树遍历
+// 待访问的节点保存在堆上的显式栈中，机器生成的任意深的语法树
+// （例如十万项的加法链）也不会耗尽线程栈。
+// 同一节点的子节点总是按源代码中的顺序访问。
+class NodeWalker {
+public:
+    // 访问statements中的每条语句及其全部子孙节点
+    // onStmt(Stmt*)和onExpr(Expr*)只需处理节点自身的字段，子节点由遍历器负责
+    // 节点按前序访问
+    template <typename StmtVisitor, typename ExprVisitor>
+    void walk(NodeList<Stmt*> statements, StmtVisitor&& onStmt, ExprVisitor&& onExpr) {
+        pushStatements(statements);
+        while (!stack_.empty()) {
+            Entry entry = stack_.back();
+            stack_.pop_back();
+            if (entry.stmt != nullptr) {
+                onStmt(entry.stmt);
+                pushChildren(entry.stmt);
+            } else {
+                onExpr(entry.expr);
+                pushChildren(entry.expr);
+            }
+        }
+    }
+
+    // 节点按后序访问：一个节点的子孙全部访问完之后才访问它，适合自底向上构造
+    template <typename StmtVisitor, typename ExprVisitor>
+    void walkPostorder(NodeList<Stmt*> statements, StmtVisitor&& onStmt, ExprVisitor&& onExpr) {
+        pushStatements(statements);
+        while (!stack_.empty()) {
+            // 第一次出栈时先展开子节点，节点留在栈中，子节点都访问完后再次到达栈顶
+            Entry entry = stack_.back();
+            if (!entry.expanded) {
+                stack_.back().expanded = true;
+                if (entry.stmt != nullptr) {
+                    pushChildren(entry.stmt);
+                } else {
+                    pushChildren(entry.expr);
+                }
+                continue;
+            }
+
+            stack_.pop_back();
+            if (entry.stmt != nullptr) {
+                onStmt(entry.stmt);
+            } else {
+                onExpr(entry.expr);
+            }
+        }
+    }
+
+private:
+    // 栈中的一项，stmt和expr恰有一个不为空
+    struct Entry {
+        Stmt* stmt;
+        Expr* expr;
+        bool expanded;  // 后序遍历时子节点是否已经压栈
+    };
+
+    // 按逆序压栈，使先出现的节点先被访问；空指针（可选的子节点）不压栈
+    void pushStatements(NodeList<Stmt*> statements);
+    void pushExpressions(NodeList<Expr*> expressions);
+    void push(Stmt* stmt);
+    void push(Expr* expr);
+
+    // 压入节点的全部子节点
+    void pushChildren(Stmt* stmt);
+    void pushChildren(Expr* expr);
+
+    std::vector<Entry> stack_;
+};
+
+} // namespace jvav
+
+#endif // JVAV_NODE_WALKER_H
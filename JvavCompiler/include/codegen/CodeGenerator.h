@@ -2,6 +2,7 @@
 #define JVAV_CODE_GENERATOR_H
 
 #include "ast/AST.h"
+#include "ir/IR.h"
 #include <string>
 #include <vector>
 #include <memory>
@@ -15,7 +16,10 @@ public:
     ~CodeGenerator();
     
     // 生成代码
-    void generateCode(const std::vector<std::unique_ptr<Stmt>>& ast, const std::string& outputFile);
+    void generateCode(const Program& program, const std::string& outputFile);
+    
+    // 从中间表示生成代码（见IRLowering）
+    void generateCode(const IRModule& module, const std::string& outputFile);
     
 private:
     // 将在后续实现
@@ -5,14 +5,17 @@
 #include <vector>
 #include <memory>
 #include <unordered_map>
-#include "ast/AST.h"
+#include "ir/IR.h"
 #include "JvavCompiler.h"
 
 namespace jvav {
 
 /**
  * LLVM代码生成器类
- * 用于将AST转换为LLVM IR并生成目标平台的代码
+ * 用于将中间表示（见IRLowering）转换为LLVM IR并生成目标平台的代码
+ * 中间表示已经是SSA，每个块、每条指令直接对应到LLVM的块和指令；
+ * 除法和取余在除数可能为0（或INT32_MIN / -1）时先检查并陷入，与WebAssembly一致。
+ * 不支持ask。
  */
 class LLVMCodeGenerator {
 public:
@@ -21,14 +24,14 @@ public:
 
     /**
      * 生成代码
-     * @param ast 抽象语法树
+     * @param module 中间表示
      * @param outputFile 输出文件路径
      * @param targetType 目标类型（可执行文件、库等）
      * @param targetPlatform 目标平台（windows, macos, linux, harmony等）
      * @return 是否成功
      */
     bool generateCode(
-        const std::vector<std::unique_ptr<Stmt>>& ast, 
+        const IRModule& module,
         const std::string& outputFile,
         JvavTargetType targetType,
         const std::string& targetPlatform = ""
@@ -1,6 +1,7 @@
 #ifndef JVAV_FUNCTIONS_H
 #define JVAV_FUNCTIONS_H
 
+#include "lexer/SymbolTable.h"
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -58,6 +59,19 @@ public:
         auto it = getAll().find(name);
         return it != getAll().end() ? it->second.type : BuiltinFunctionType::UNKNOWN;
     }
+    
+    // 按符号编号查询内置函数类型，不是内置函数时返回UNKNOWN
+    static BuiltinFunctionType getType(Symbol name) {
+        static const std::unordered_map<Symbol, BuiltinFunctionType> bySymbol = [] {
+            std::unordered_map<Symbol, BuiltinFunctionType> table;
+            for (const auto& entry : getAll()) {
+                table.emplace(SymbolTable::instance().intern(entry.first), entry.second.type);
+            }
+            return table;
+        }();
+        auto it = bySymbol.find(name);
+        return it != bySymbol.end() ? it->second : BuiltinFunctionType::UNKNOWN;
+    }
 };
 
 } // namespace jvav
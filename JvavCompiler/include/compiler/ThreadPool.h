@@ -0,0 +1,58 @@
+#ifndef JVAV_THREAD_POOL_H
+#define JVAV_THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace jvav {
+
+// 固定大小的线程池
+// 任务按提交顺序被空闲线程取走，结果通过std::future取回。
+// 析构时会先执行完队列中剩余的任务再退出。
+class ThreadPool {
+public:
+    // threadCount为0时使用硬件并发数
+    explicit ThreadPool(size_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // 提交任务
+    template <typename F>
+    std::future<std::invoke_result_t<F>> submit(F&& task) {
+        using Result = std::invoke_result_t<F>;
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> result = packaged->get_future();
+        enqueue([packaged]() { (*packaged)(); });
+        return result;
+    }
+
+    // 工作线程数
+    size_t size() const { return workers_.size(); }
+
+    // 默认线程数（硬件并发数，至少为1）
+    static size_t defaultThreadCount();
+
+private:
+    void enqueue(std::function<void()> task);
+    void workerLoop();
+
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool stopping_ = false;
+};
+
+} // namespace jvav
+
+#endif // JVAV_THREAD_POOL_H
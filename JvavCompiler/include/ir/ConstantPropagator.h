@@ -0,0 +1,31 @@
+#ifndef JVAV_CONSTANT_PROPAGATOR_H
+#define JVAV_CONSTANT_PROPAGATOR_H
+
+#include "ir/IR.h"
+#include <cstddef>
+
+namespace jvav {
+
+// 稀疏条件常量传播（Wegman和Zadeck的SCCP）
+// 同时在SSA值和控制流边上迭代：只有可能执行的边才参与phi的计算，
+// 条件为常量的跳转只有一条出边可能执行，因此被常量条件保护的代码里的值也能算出来。
+// 结束后值为常量的指令换成入口块中的常量，条件为常量的跳转改为无条件跳转，
+// 不会执行的块随之删除。
+class ConstantPropagator {
+public:
+    void run(IRFunction& function);
+
+    // 上次run()换成常量的值的个数
+    size_t foldedCount() const { return folded_; }
+
+    // 上次run()删除的块的个数
+    size_t removedBlockCount() const { return removedBlocks_; }
+
+private:
+    size_t folded_ = 0;
+    size_t removedBlocks_ = 0;
+};
+
+} // namespace jvav
+
+#endif // JVAV_CONSTANT_PROPAGATOR_H
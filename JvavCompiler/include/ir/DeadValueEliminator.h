@@ -0,0 +1,25 @@
+#ifndef JVAV_DEAD_VALUE_ELIMINATOR_H
+#define JVAV_DEAD_VALUE_ELIMINATOR_H
+
+#include "ir/IR.h"
+#include <cstddef>
+
+namespace jvav {
+
+// 中间表示上的死代码消除（-O1起）
+// 从有副作用的指令和终结符用到的值出发，沿操作数标记所有被用到的值，
+// 没有标记的指令（包括只在彼此之间循环使用的phi）都删除。
+class DeadValueEliminator {
+public:
+    void run(IRFunction& function);
+
+    // 上次run()删除的指令个数
+    size_t removedCount() const { return removed_; }
+
+private:
+    size_t removed_ = 0;
+};
+
+} // namespace jvav
+
+#endif // JVAV_DEAD_VALUE_ELIMINATOR_H
@@ -0,0 +1,48 @@
+#ifndef JVAV_DOMINATORS_H
+#define JVAV_DOMINATORS_H
+
+#include "ir/IR.h"
+#include <vector>
+
+namespace jvav {
+
+// 支配树
+// 用Cooper、Harvey和Kennedy的迭代算法在逆后序上求直接支配者，
+// 再给支配树编先序和后序号，dominates()只需比较编号。
+// 不可达的块不在树中。函数的控制流图改变之后需要重新构造。
+class DominatorTree {
+public:
+    explicit DominatorTree(const IRFunction& function);
+
+    // 可达的块，按逆后序排列（入口在最前）
+    const std::vector<BlockId>& reversePostorder() const { return order_; }
+
+    // 块在逆后序中的位置，不可达的块为NO_BLOCK
+    uint32_t rpoIndex(BlockId block) const { return rpoIndex_[block]; }
+
+    bool isReachable(BlockId block) const { return rpoIndex_[block] != NO_BLOCK; }
+
+    // 直接支配者，入口块为NO_BLOCK
+    BlockId idom(BlockId block) const { return idom_[block]; }
+
+    // 支配树中的子节点
+    const std::vector<BlockId>& children(BlockId block) const { return children_[block]; }
+
+    // a是否支配b（块支配它自己）
+    bool dominates(BlockId a, BlockId b) const;
+
+    // 各个块的支配边界
+    std::vector<std::vector<BlockId>> frontiers(const IRFunction& function) const;
+
+private:
+    std::vector<BlockId> order_;
+    std::vector<uint32_t> rpoIndex_;
+    std::vector<BlockId> idom_;
+    std::vector<std::vector<BlockId>> children_;
+    std::vector<uint32_t> preorder_;
+    std::vector<uint32_t> postorder_;
+};
+
+} // namespace jvav
+
+#endif // JVAV_DOMINATORS_H
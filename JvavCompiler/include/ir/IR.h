@@ -0,0 +1,159 @@
+#ifndef JVAV_IR_H
+#define JVAV_IR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace jvav {
+
+// SSA中间表示
+// 语法树先降低为这种带类型的SSA形式（见IRLowering），优化遍在其上运行，
+// WebAssembly和LLVM后端都从它生成代码，优化只需写一次。
+//
+// 模块由全局变量和函数组成，顶层语句是模块的第一个函数main。
+// 函数由基本块组成，0号块是入口；每个块是一串指令加一个终结符（跳转、条件跳转或返回）。
+// 指令按编号存放在函数的values中，指令的结果就用这个编号表示；
+// 删除指令只是把它从所在块的指令列表中移出，编号不会复用。
+// phi指令总在块的开头，操作数与块的predecessors一一对应。
+// 语言中只有i32一种值类型，指令的类型是I32或VOID（没有结果）。
+
+using ValueId = uint32_t;
+using BlockId = uint32_t;
+constexpr ValueId NO_VALUE = UINT32_MAX;
+constexpr BlockId NO_BLOCK = UINT32_MAX;
+
+// 值类型
+enum class IRType : uint8_t {
+    VOID,
+    I32
+};
+
+// 指令
+enum class IROpcode : uint8_t {
+    CONST,          // 常量，值为imm，只出现在入口块
+    PARAM,          // 第imm个参数
+    PHI,            // 按前驱块选择操作数
+    NEG,            // -x
+    NOT,            // x == 0
+    ADD, SUB, MUL,  // 按i32补码回绕
+    DIV, REM,       // 有符号除法和取余，除以0和INT32_MIN / -1在运行时陷入
+    EQ, NE, LT, LE, GT, GE,  // 有符号比较，结果为0或1
+    AND, OR,        // 按位与、或（语言中的&&和||）
+    LOAD_GLOBAL,    // 读第imm个全局变量
+    STORE_GLOBAL,   // 把操作数写入第imm个全局变量
+    CALL,           // 调用第imm个函数
+    ASK,            // 内置函数ask(a, b)
+    PRINT,          // 打印数字
+    PRINT_STRING,   // 打印第imm个字符串常量
+    LOCAL_GET,      // 读第imm个局部变量，只在构造SSA之前出现
+    LOCAL_SET       // 写第imm个局部变量，只在构造SSA之前出现
+};
+
+// 块的终结符
+enum class Terminator : uint8_t {
+    NONE,    // 还没有终结符（只在构造过程中出现）
+    JUMP,    // 跳转到successors[0]
+    BRANCH,  // operand不为0时跳转到successors[0]，否则到successors[1]
+    RETURN   // 返回operand
+};
+
+// 一条指令
+struct Instruction {
+    IROpcode op;
+    IRType type;
+    BlockId block;                  // 所在的块
+    int32_t imm = 0;                // 常量值，参数、全局变量、函数、字符串或局部变量的编号
+    std::vector<ValueId> operands;
+};
+
+// 基本块
+struct BasicBlock {
+    std::vector<ValueId> instructions;   // phi在最前
+    std::vector<BlockId> predecessors;   // 同一个前驱不会出现两次
+    Terminator terminator = Terminator::NONE;
+    ValueId operand = NO_VALUE;          // 条件跳转的条件，返回的值
+    BlockId successors[2] = {NO_BLOCK, NO_BLOCK};
+    bool removed = false;                // 不可达，已经删除
+
+    size_t successorCount() const {
+        return terminator == Terminator::JUMP ? 1 : terminator == Terminator::BRANCH ? 2 : 0;
+    }
+};
+
+// 函数
+struct IRFunction {
+    std::string name;
+    std::vector<std::string> parameters;  // 参数名
+    uint32_t localCount = 0;              // 构造SSA之前的局部变量个数
+    std::vector<Instruction> values;
+    std::vector<BasicBlock> blocks;
+
+    // 新建一个空块
+    BlockId addBlock();
+
+    // 在块的末尾（终结符之前）追加指令
+    ValueId append(BlockId block, IROpcode op, IRType type, int32_t imm = 0,
+                   std::vector<ValueId> operands = {});
+
+    // 在块的开头插入操作数待填的phi
+    ValueId insertPhi(BlockId block);
+
+    // 在入口块的开头新建常量
+    ValueId constant(int32_t value);
+
+    // 设置终结符，同时登记前驱
+    void jump(BlockId from, BlockId to);
+    void branch(BlockId from, ValueId condition, BlockId ifTrue, BlockId ifFalse);
+    void ret(BlockId from, ValueId value);
+
+    // 删除条件跳转from到to的边，改为无条件跳到另一个目标
+    void removeEdge(BlockId from, BlockId to);
+
+    // 从块的前驱中删除pred，同时删除各个phi的对应操作数
+    void removePredecessor(BlockId block, BlockId pred);
+
+    // 按replacement（下标为旧值，NO_VALUE表示不替换）替换所有块中指令和终结符的操作数
+    // 替换可以成链，最终取链尾的值
+    void replaceAllUses(const std::vector<ValueId>& replacement);
+
+    // 删除从入口不可达的块，返回删除的个数
+    size_t removeUnreachableBlocks();
+
+    // 合并只有一个前驱、前驱也只有它一个后继的块，返回合并的个数
+    size_t mergeBlocks();
+};
+
+// 模块
+struct IRModule {
+    std::vector<std::string> globals;   // 全局变量名
+    std::vector<std::string> strings;   // 字符串常量（不含引号）
+    std::vector<IRFunction> functions;  // functions[0]是main
+
+    // 文本形式，用于调试和--emit-ir
+    std::string toString() const;
+
+    // 检查结构是否完整（操作数已定义、phi与前驱对应、终结符齐全等）
+    bool verify(std::string& error) const;
+};
+
+// 指令的文本名
+const char* opcodeName(IROpcode op);
+
+// 计算操作数都是常量的一元或二元运算，与生成的代码一致
+// 运行时会陷入的运算和不能在编译期计算的指令返回false
+bool foldInstruction(IROpcode op, int32_t a, int32_t b, int32_t& result);
+
+// 交换操作数结果不变的运算
+bool isCommutative(IROpcode op);
+
+// 结果只取决于操作数、不会陷入的运算（常量、算术、比较），可以删除、合并或移动
+bool isPure(const IRFunction& function, const Instruction& instruction);
+
+// 指令有副作用（写全局变量、调用、输入输出或可能陷入），结果不被使用也必须保留
+bool hasSideEffects(const IRFunction& function, const Instruction& instruction);
+
+} // namespace jvav
+
+#endif // JVAV_IR_H
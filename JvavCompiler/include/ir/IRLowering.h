@@ -0,0 +1,28 @@
+#ifndef JVAV_IR_LOWERING_H
+#define JVAV_IR_LOWERING_H
+
+#include "ast/AST.h"
+#include "ir/IR.h"
+#include <string>
+
+namespace jvav {
+
+// 把语法树降低为SSA中间表示
+// 顶层语句成为main，每个函数定义（不论写在哪里）成为模块中的一个函数。
+// 被set或赋值写入的名字是全局变量；参数和循环变量是局部变量，在所在的函数或循环体中遮蔽同名的全局变量。
+// 循环由一个隐藏的计数器驱动，次数在进入循环时求值一次，不大于0时一次也不执行；
+// 循环体中修改循环变量不影响迭代次数。if语句的所有分支都会生成。
+// 降低完成后每个函数都已构造成SSA（见SSABuilder）。
+//
+// 中间表示只有i32：数组、记录、枚举、导入、打开文件、异常处理和字符串运算都不支持，
+// 遇到时lower()返回false并给出原因，调用者可以改用语法树后端生成代码。
+// 语句和表达式都用显式栈处理，任意深的语法树也不会耗尽线程栈。
+class IRLowering {
+public:
+    // 成功时结果放入module
+    bool lower(const Program& program, IRModule& module, std::string& error);
+};
+
+} // namespace jvav
+
+#endif // JVAV_IR_LOWERING_H
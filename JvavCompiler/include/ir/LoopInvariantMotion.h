@@ -0,0 +1,28 @@
+#ifndef JVAV_LOOP_INVARIANT_MOTION_H
+#define JVAV_LOOP_INVARIANT_MOTION_H
+
+#include "ir/IR.h"
+#include <cstddef>
+
+namespace jvav {
+
+// 循环不变量外提（-O2起）
+// 由回边（跳到支配自己的块）找出自然循环，从内层到外层，
+// 把操作数都在循环外定义的纯运算移到循环的前置块末尾；
+// 循环中没有写某个全局变量、也没有调用函数时，读这个全局变量也一并外提。
+// 纯运算不会陷入，即使循环一次也不执行，提前计算也没有可观察的影响。
+// 只处理从循环外只有一个前驱、且这个前驱无条件跳入的循环（降低生成的循环都是这样）。
+class LoopInvariantMotion {
+public:
+    void run(IRFunction& function);
+
+    // 上次run()外提的指令个数
+    size_t hoistedCount() const { return hoisted_; }
+
+private:
+    size_t hoisted_ = 0;
+};
+
+} // namespace jvav
+
+#endif // JVAV_LOOP_INVARIANT_MOTION_H
@@ -0,0 +1,20 @@
+#ifndef JVAV_SSA_BUILDER_H
+#define JVAV_SSA_BUILDER_H
+
+#include "ir/IR.h"
+
+namespace jvav {
+
+// 构造SSA
+// 降低时局部变量（参数、循环变量和循环计数器）用LOCAL_GET/LOCAL_SET读写，
+// 这里把它们换成SSA值：先在写入所在块的迭代支配边界上放置phi（Cytron等人的算法），
+// 再沿支配树先序重命名。没有写入就读取的局部变量值为0，与WebAssembly的局部变量一致。
+// 放置的phi不一定都被用到，没用的留给死代码消除。
+class SSABuilder {
+public:
+    void run(IRFunction& function);
+};
+
+} // namespace jvav
+
+#endif // JVAV_SSA_BUILDER_H
@@ -0,0 +1,33 @@
+#ifndef JVAV_VALUE_NUMBERING_H
+#define JVAV_VALUE_NUMBERING_H
+
+#include "ir/IR.h"
+#include <cstddef>
+
+namespace jvav {
+
+// 全局值编号（-O2起）
+// 沿支配树先序遍历，作用域随支配树进出的散列表记录已经算过的纯运算，
+// 支配者中算过的同一运算（可交换运算不分操作数顺序）直接复用，不再计算。
+// 同时做几种局部化简：
+//   - 代数恒等式：x+0、x-0、x*1、x*0、x-x、x==x等
+//   - 所有操作数都相同（或是它自己）的phi就是那个操作数，同一块中操作数相同的phi合并
+//   - 块内读全局变量：写入之后或上次读取之后、中间没有调用时，直接用已知的值
+// phi的操作数可能来自后面才遍历到的块，替换后再遍历一次，直到没有变化。
+class ValueNumbering {
+public:
+    void run(IRFunction& function);
+
+    // 上次run()删除的冗余指令个数
+    size_t removedCount() const { return removed_; }
+
+private:
+    // 最多遍历的次数
+    static constexpr int MAX_ROUNDS = 4;
+
+    size_t removed_ = 0;
+};
+
+} // namespace jvav
+
+#endif // JVAV_VALUE_NUMBERING_H
@@ -0,0 +1,98 @@
+#ifndef JVAV_FILE_TABLE_H
+#define JVAV_FILE_TABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace jvav {
+
+// 源文件编号，0 表示"无文件"（例如默认构造的token）
+using FileId = uint32_t;
+constexpr FileId INVALID_FILE_ID = 0;
+
+// token中只有24位存放文件编号，同时注册的文件不能超过这个数目（注销的编号会被复用）
+constexpr FileId MAX_FILE_ID = (1u << 24) - 1;
+
+// 行列号（均从1开始）
+struct LineColumn {
+    uint32_t line = 1;
+    uint32_t column = 1;
+};
+
+// 文件表：记录每个源文件的名称和源代码缓冲区
+// token只保存文件编号和字节偏移，文件名和文本都通过文件表查询，
+// 避免每个token各自复制一份文件名。
+// 行列号同样不在词法分析时计算，而是在需要报告位置时通过行首偏移表查出。
+// 文件表不拥有源代码缓冲区，缓冲区由编译单元持有，
+// 注册者必须保证在注销之前缓冲区一直有效。
+// 文件名和文本只由注册者在注册、修改和注销时写入，此时不能有其他线程读取这个文件的token；
+// 除此之外它们不再变化，所以getName和getText不加锁，词法、语法分析的热路径和
+// 并行解析的各个线程不会争用同一把锁。注册、注销和行首偏移表的构建仍然加锁。
+class FileTable {
+public:
+    // 获取全局文件表
+    static FileTable& instance();
+
+    // 注册源文件，返回文件编号
+    // 同时注册的文件超过MAX_FILE_ID个时抛出std::length_error，编号放不进token
+    FileId addFile(const std::string& name, std::string_view text);
+
+    // 源文件被修改后换成新的缓冲区，编号不变，行首偏移表在下次查询时重建
+    void updateText(FileId id, std::string_view text);
+
+    // 注销源文件，其编号可以被后续注册复用
+    void removeFile(FileId id);
+
+    // 获取文件名
+    std::string getName(FileId id) const;
+
+    // 获取源代码文本
+    std::string_view getText(FileId id) const;
+
+    // 将字节偏移转换为行列号
+    // 第一次查询某个文件时才构建它的行首偏移表，之后二分查找
+    LineColumn getLineColumn(FileId id, uint32_t offset) const;
+
+private:
+    FileTable();
+    ~FileTable();
+
+    struct Entry {
+        std::string name;
+        std::string_view text;
+        bool inUse = false;
+
+        // 每一行第一个字节的偏移，按需构建
+        mutable std::vector<uint32_t> lineStarts;
+        mutable bool lineStartsBuilt = false;
+    };
+
+    // 构建行首偏移表（调用者需持有锁）
+    static void buildLineStarts(const Entry& entry);
+
+    // 查找条目，编号从未分配过时返回nullptr
+    const Entry* find(FileId id) const;
+    Entry* find(FileId id) { return const_cast<Entry*>(static_cast<const FileTable*>(this)->find(id)); }
+
+    // 条目按块分配，块分配后不再移动也不释放，读取方不加锁也能安全地找到条目
+    static constexpr uint32_t CHUNK_BITS = 10;
+    static constexpr uint32_t CHUNK_SIZE = 1u << CHUNK_BITS;
+    static constexpr uint32_t CHUNK_COUNT = (MAX_FILE_ID >> CHUNK_BITS) + 1;
+    std::atomic<Entry*> chunks_[CHUNK_COUNT] = {};
+
+    // 下一个从未使用过的编号
+    FileId nextId_ = 1;
+
+    // 已注销、可复用的文件编号
+    std::vector<FileId> freeIds_;
+
+    mutable std::mutex mutex_;
+};
+
+} // namespace jvav
+
+#endif // JVAV_FILE_TABLE_H
@@ -2,22 +2,36 @@
 #define JVAV_LEXER_H
 
 #include "lexer/Token.h"
+#include "lexer/TokenBuffer.h"
 #include <string>
+#include <string_view>
 #include <vector>
-#include <unordered_map>
 #include <memory>
 
 namespace jvav {
 
+class ThreadPool;
+class TokenRing;
+
 // 词法分析器类
 class Lexer {
 public:
     // 构造函数接受源代码和文件名
-    Lexer(const std::string& source, const std::string& filename = "<source>");
+    // 词法分析器只借用源代码，不做复制，调用者需保证源代码在token使用期间有效
+    Lexer(std::string_view source, const std::string& filename = "<source>");
+    
+    // 从已注册文件的中间开始分析：共享文件编号fileId，从begin处开始分析source
+    // 用于分段并行分析（source只包含到该段末尾为止的源代码）和增量分析，
+    // begin必须是某个token的开头，产生的偏移仍相对于整个文件
+    Lexer(std::string_view source, const std::string& filename, FileId fileId, size_t begin);
     
     // 析构函数
     ~Lexer();
     
+    // token引用词法分析器注册的源文件，不允许复制
+    Lexer(const Lexer&) = delete;
+    Lexer& operator=(const Lexer&) = delete;
+    
     // 获取下一个token
     Token getNextToken();
     
@@ -33,33 +47,64 @@ public:
     // 获取所有tokens（调试用）
     std::vector<Token> tokenize();
     
+    // 将全部token写入按源代码大小预留好容量的token缓冲区
+    TokenBuffer tokenizeToBuffer();
+    
+    // 并行分析，结果与tokenizeToBuffer()完全相同
+    // 源代码在行边界处切分成若干段，各段在线程池中分别分析后按顺序拼接；
+    // 文件小于PARALLEL_MIN_SIZE或线程池只有一个线程时退回串行分析。
+    // 以上两个方法都必须在还没有读取任何token时调用。
+    TokenBuffer tokenizeParallel(ThreadPool& pool);
+    
+    // 流式分析：依次把token写入环形缓冲区，直到写入END_OF_FILE或消费者关闭缓冲区
+    // 在单独的线程中调用，与从缓冲区读取的语法分析器同时进行
+    void tokenizeToRing(TokenRing& ring);
+    
+    // 按需分析：把接下来最多maxCount个token追加到out，返回追加的个数
+    // 追加了END_OF_FILE之后不能再调用
+    size_t tokenizeBatch(TokenBuffer& out, size_t maxCount);
+    
+    // 值得并行分析的最小源文件大小
+    static constexpr size_t PARALLEL_MIN_SIZE = 512 * 1024;
+    
     // 获取词法错误
     const std::vector<std::string>& getErrors() const { return errors_; }
+    
+    // 获取源文件在文件表中的编号
+    FileId getFileId() const { return fileId_; }
+    
+    // 查询关键字类型，不是关键字时返回IDENTIFIER
+    static TokenType lookupKeyword(std::string_view text);
 
 private:
-    // 源代码
-    std::string source_;
+    // 源代码（借用）
+    std::string_view source_;
     
     // 文件名
     std::string filename_;
     
-    // 当前位置
+    // 文件表中的编号
+    FileId fileId_ = INVALID_FILE_ID;
+    
+    // 是否由本词法分析器注册（分段分析用的词法分析器不注册）
+    bool ownsFile_ = false;
+    
+    // 当前位置（字节偏移，行列号按需由文件表计算）
     size_t position_ = 0;
     
-    // 当前行和列
-    int line_ = 1;
-    int column_ = 1;
+    // 正在扫描的token的起始位置
+    size_t tokenStart_ = 0;
     
     // 存储已扫描但未消耗的token
     Token nextToken_;
     bool hasNextToken_ = false;
     
-    // 关键字映射表
-    std::unordered_map<std::string, TokenType> keywords_;
-    
     // 错误消息列表
     std::vector<std::string> errors_;
     
+    // 标识符的符号编号缓存
+    SymbolCache symbols_;
+    
     // 辅助方法
     char advance();             // 读取下一个字符并前进
     char peek() const;          // 查看当前字符
@@ -73,18 +118,22 @@ private:
     Token identifier();         // 处理标识符和关键字
     Token number();             // 处理数字字面量
     Token string();             // 处理字符串字面量
+    Token unicodeToken();       // 处理以非ASCII字符开头的token
+    
+    // 用[tokenStart_, position_)范围构造token
+    Token makeToken(TokenType type) const;
     
     // 辅助函数
     bool isDigit(char c) const;
     bool isAlpha(char c) const;
     bool isAlphaNumeric(char c) const;
-    bool isChineseChar(char c) const;
+    
+    // 获取某个字节偏移的位置信息
+    SourceLocation getLocation(size_t offset) const;
     
     // 添加词法错误
     void addError(const std::string& message);
-    
-    // 初始化关键字表
-    void initKeywords();
+
 };
 
 } // namespace jvav
@@ -0,0 +1,34 @@
+#ifndef JVAV_SCAN_KERNELS_H
+#define JVAV_SCAN_KERNELS_H
+
+#include <cstddef>
+
+namespace jvav {
+namespace scan {
+
+// 词法分析使用的批量扫描函数
+// 在x86上按16字节(SSE2)或32字节(AVX2)一组处理，运行时根据CPU选择实现，
+// 其他平台使用逐字节的标量实现。所有函数都不会读取end之后的内存。
+
+// 跳过空白字符(' ', '\t', '\r', '\n')，返回第一个非空白字符的位置
+const char* skipWhitespace(const char* p, const char* end);
+
+// 查找下一个换行符，没有则返回end（用于跳过#注释）
+const char* findNewline(const char* p, const char* end);
+
+// 查找字符串中下一个需要特殊处理的字符：'"'、'\\'或'\n'
+const char* findStringSpecial(const char* p, const char* end);
+
+// 跳过ASCII标识符字符[A-Za-z0-9_]，遇到非ASCII字节即停止
+const char* skipIdentifier(const char* p, const char* end);
+
+// 统计[p, end)中的换行符个数，lastNewline返回最后一个换行符的位置（没有则为nullptr）
+size_t countNewlines(const char* p, const char* end, const char** lastNewline);
+
+// 当前使用的实现名称："avx2"、"sse2"或"scalar"
+const char* implementationName();
+
+} // namespace scan
+} // namespace jvav
+
+#endif // JVAV_SCAN_KERNELS_H
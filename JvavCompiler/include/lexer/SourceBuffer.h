@@ -0,0 +1,48 @@
+#ifndef JVAV_SOURCE_BUFFER_H
+#define JVAV_SOURCE_BUFFER_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace jvav {
+
+// 源代码缓冲区
+// 普通文件以只读方式映射到内存，整个编译过程只存在这一份源代码；
+// 管道、标准输入等无法映射的输入退回到read()读入内存。
+// 词法分析器和token只借用其中的文本，缓冲区必须比它们活得更久。
+class SourceBuffer {
+public:
+    ~SourceBuffer();
+
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+    // 从文件加载源代码，路径为"-"时读取标准输入
+    // 失败时返回nullptr并在error中给出原因
+    static std::unique_ptr<SourceBuffer> fromFile(const std::string& path, std::string& error);
+
+    // 获取源代码文本
+    std::string_view getText() const { return std::string_view(data_, size_); }
+
+    // 是否通过内存映射加载
+    bool isMapped() const { return mapped_; }
+
+private:
+    SourceBuffer() = default;
+
+    // 从文件描述符读取全部内容（用于无法映射的输入）
+    bool readAll(int fd, std::string& error);
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+
+    // read()回退方式下持有的数据
+    std::string storage_;
+};
+
+} // namespace jvav
+
+#endif // JVAV_SOURCE_BUFFER_H
@@ -0,0 +1,100 @@
+#ifndef JVAV_SYMBOL_TABLE_H
+#define JVAV_SYMBOL_TABLE_H
+
+#include "ast/Arena.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace jvav {
+
+// 符号编号：同一个标识符在任何文件中都得到同一个编号，0 表示"不是标识符"
+using Symbol = uint32_t;
+constexpr Symbol INVALID_SYMBOL = 0;
+
+// 全局符号表（标识符驻留）
+// 词法分析器产生标识符token时把文本登记到这里，token带上32位的符号编号，
+// 之后的语法分析和代码生成比较、查找名字都只用编号，不再对文本求哈希和逐字节比较，
+// 对每个字符占三个字节的中文标识符尤其划算。
+// 编号从1开始连续分配，可以直接作为数组下标；文本复制在表内的arena中，
+// 编号和文本在进程结束前一直有效。表是线程安全的。
+class SymbolTable {
+public:
+    // 获取全局符号表
+    static SymbolTable& instance();
+
+    // 登记标识符，返回其编号，已登记过的返回原来的编号
+    Symbol intern(std::string_view text);
+
+    // 同上，hash必须是hashText(text)
+    Symbol intern(std::string_view text, uint32_t hash);
+
+    // 获取符号的文本，INVALID_SYMBOL或未分配的编号返回空串
+    std::string_view name(Symbol symbol) const;
+
+    // 已分配的最大编号加一，按编号建立的数组取这个大小即可容纳所有符号
+    size_t size() const;
+
+    // 标识符文本的哈希
+    static uint32_t hashText(std::string_view text) {
+        uint32_t hash = 2166136261u;
+        for (unsigned char c : text) {
+            hash = (hash ^ c) * 16777619u;
+        }
+        return hash;
+    }
+
+private:
+    SymbolTable();
+
+    // 开放寻址的哈希表槽位，symbol为INVALID_SYMBOL表示空槽
+    struct Slot {
+        uint32_t hash;
+        Symbol symbol;
+    };
+
+    // 装载因子超过一半时扩容（调用者需持有锁）
+    void grow();
+
+    std::vector<Slot> slots_;
+    std::vector<std::string_view> names_;
+    Arena text_;
+    mutable std::mutex mutex_;
+};
+
+// 符号表前面的一层直接映射缓存
+// 每个词法分析器持有一个，重复出现的标识符在这里命中，不必获取全局符号表的锁，
+// 并行分析的各个线程之间也就不会争用。
+class SymbolCache {
+public:
+    Symbol intern(std::string_view text) {
+        uint32_t hash = SymbolTable::hashText(text);
+        Entry& entry = entries_[hash & (CACHE_SIZE - 1)];
+        if (entry.symbol != INVALID_SYMBOL && entry.hash == hash && entry.text == text) {
+            return entry.symbol;
+        }
+        entry.symbol = SymbolTable::instance().intern(text, hash);
+        entry.hash = hash;
+        // 缓存符号表中的文本，它比源代码活得更久
+        entry.text = SymbolTable::instance().name(entry.symbol);
+        return entry.symbol;
+    }
+
+private:
+    static constexpr size_t CACHE_SIZE = 256;
+
+    struct Entry {
+        std::string_view text;
+        uint32_t hash = 0;
+        Symbol symbol = INVALID_SYMBOL;
+    };
+
+    std::array<Entry, CACHE_SIZE> entries_{};
+};
+
+} // namespace jvav
+
+#endif // JVAV_SYMBOL_TABLE_H
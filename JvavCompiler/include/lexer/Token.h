@@ -1,13 +1,17 @@
 #ifndef JVAV_TOKEN_H
 #define JVAV_TOKEN_H
 
+#include "lexer/FileTable.h"
+#include "lexer/SymbolTable.h"
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <iostream>
 
 namespace jvav {
 
 // 词法单元类型
-enum class TokenType {
+enum class TokenType : uint8_t {
     // 特殊标记
     END_OF_FILE,
     ERROR,
@@ -94,35 +98,62 @@ struct SourceLocation {
 };
 
 // 词法单元类
+// token不持有任何字符串，只记录它在源文件中的位置，
+// 文本通过文件表从编译单元持有的源代码缓冲区中取得，
+// 行列号也只在报告位置时由文件表根据偏移计算。
+// 标识符另外带有符号表中的编号，比较名字时不必再读文本。
+// 类型和文件编号合用一个字，整个token仍是16字节。
 class Token {
 public:
-    Token() : type(TokenType::ERROR) {}
+    Token() : typeAndFile(packTypeAndFile(TokenType::ERROR, INVALID_FILE_ID)),
+              offset(0), length(0), symbol(INVALID_SYMBOL) {}
     
-    Token(TokenType t, const std::string& v, const SourceLocation& loc)
-        : type(t), value(v), location(loc) {}
+    Token(TokenType t, FileId f, uint32_t off, uint32_t len, Symbol sym = INVALID_SYMBOL)
+        : typeAndFile(packTypeAndFile(t, f)), offset(off), length(len), symbol(sym) {}
     
     // 获取token类型
-    TokenType getType() const { return type; }
+    TokenType getType() const { return static_cast<TokenType>(typeAndFile & TYPE_MASK); }
     
-    // 获取token值
-    const std::string& getValue() const { return value; }
+    // 获取token值（字符串字面量不包含引号）
+    std::string_view getValue() const;
     
-    // 获取token位置
-    const SourceLocation& getLocation() const { return location; }
+    // 获取token在源代码中的原始文本
+    // 优化器合成的标识符长度为0、不在源代码中，文本取自符号表
+    std::string_view getLexeme() const;
+    
+    // 获取token所在的文件及字节范围
+    FileId getFile() const { return typeAndFile >> TYPE_BITS; }
+    uint32_t getOffset() const { return offset; }
+    uint32_t getLength() const { return length; }
+    
+    // 获取标识符的符号编号，其他token为INVALID_SYMBOL
+    Symbol getSymbol() const { return symbol; }
+    
+    // 获取token位置（按需构造，仅用于诊断信息）
+    SourceLocation getLocation() const;
     
     // 转为字符串
     std::string toString() const;
     
     // 检查是否为指定类型
-    bool is(TokenType t) const { return type == t; }
+    bool is(TokenType t) const { return getType() == t; }
     
     // 检查是否为结束标记
-    bool isEOF() const { return type == TokenType::END_OF_FILE; }
+    bool isEOF() const { return getType() == TokenType::END_OF_FILE; }
 
 private:
-    TokenType type;
-    std::string value;
-    SourceLocation location;
+    static constexpr uint32_t TYPE_BITS = 8;
+    static constexpr uint32_t TYPE_MASK = (1u << TYPE_BITS) - 1;
+    static_assert(MAX_FILE_ID <= (UINT32_MAX >> TYPE_BITS), "文件编号放不进token");
+    
+    static uint32_t packTypeAndFile(TokenType t, FileId f) {
+        return static_cast<uint32_t>(t) | (f << TYPE_BITS);
+    }
+    
+    uint32_t typeAndFile;  // 低8位是类型，其余是文件编号
+    uint32_t offset;
+    uint32_t length;
+    Symbol symbol;
 };
 
 // 将TokenType转换为字符串
@@ -0,0 +1,70 @@
+#ifndef JVAV_TOKEN_BUFFER_H
+#define JVAV_TOKEN_BUFFER_H
+
+#include "lexer/Token.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace jvav {
+
+// token缓冲区
+// 一个源文件的全部token按结构数组存放：类型、偏移、长度、符号编号各占一个连续数组，
+// 语法分析器通过下标访问，前瞻和回退都只是下标运算。
+// 所有token属于同一个文件，文件编号只保存一份。
+class TokenBuffer {
+public:
+    TokenBuffer() = default;
+    explicit TokenBuffer(FileId file) : file_(file) {}
+
+    // 预留容量
+    void reserve(size_t count);
+
+    // 追加一个token
+    void push(TokenType type, uint32_t offset, uint32_t length, Symbol symbol = INVALID_SYMBOL) {
+        types_.push_back(type);
+        offsets_.push_back(offset);
+        lengths_.push_back(length);
+        symbols_.push_back(symbol);
+    }
+
+    // 追加一个token（必须属于本缓冲区的文件）
+    void push(const Token& token) {
+        push(token.getType(), token.getOffset(), token.getLength(), token.getSymbol());
+    }
+
+    // 追加另一个缓冲区中的全部token（两者必须属于同一文件）
+    void append(const TokenBuffer& other);
+
+    // 清空所有token，保留容量
+    void clear();
+
+    // token个数
+    size_t size() const { return types_.size(); }
+    bool empty() const { return types_.empty(); }
+
+    // 按下标访问各字段
+    TokenType type(size_t index) const { return types_[index]; }
+    uint32_t offset(size_t index) const { return offsets_[index]; }
+    uint32_t length(size_t index) const { return lengths_[index]; }
+    Symbol symbol(size_t index) const { return symbols_[index]; }
+
+    // 按下标构造token（只是拼装字段，不涉及字符串）
+    Token get(size_t index) const {
+        return Token(types_[index], file_, offsets_[index], lengths_[index], symbols_[index]);
+    }
+
+    // 所属文件
+    FileId getFile() const { return file_; }
+
+private:
+    FileId file_ = INVALID_FILE_ID;
+    std::vector<TokenType> types_;
+    std::vector<uint32_t> offsets_;
+    std::vector<uint32_t> lengths_;
+    std::vector<Symbol> symbols_;
+};
+
+} // namespace jvav
+
+#endif // JVAV_TOKEN_BUFFER_H
@@ -0,0 +1,59 @@
+#ifndef JVAV_TOKEN_RING_H
+#define JVAV_TOKEN_RING_H
+
+#include "lexer/TokenBuffer.h"
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace jvav {
+
+// 单生产者/单消费者的无锁token环形缓冲区
+// 流式编译时词法分析线程写入、语法分析线程批量读出，
+// 两边同时进行，token占用的内存不超过环的容量。
+// 缓冲区满或空时对应的一方让出CPU等待，不使用锁。
+class TokenRing {
+public:
+    // capacity会向上取整为2的幂
+    TokenRing(FileId file, size_t capacity);
+
+    TokenRing(const TokenRing&) = delete;
+    TokenRing& operator=(const TokenRing&) = delete;
+
+    // 生产者：写入一个token，缓冲区满时等待
+    // 消费者已关闭缓冲区时返回false，生产者应停止
+    bool push(const Token& token);
+
+    // 消费者：读出最多maxCount个token追加到out，缓冲区空时等待
+    // 返回读出的个数（至少为1）。生产者最后写入的一定是END_OF_FILE，
+    // 消费者读到它之后不能再调用本方法。
+    size_t popBatch(TokenBuffer& out, size_t maxCount);
+
+    // 消费者：不再读取，让等待中的生产者退出
+    void close();
+
+    // 所属文件
+    FileId getFile() const { return file_; }
+
+private:
+    // 避免生产者和消费者的位置落在同一缓存行上
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    FileId file_;
+    std::vector<Token> slots_;
+    size_t mask_;
+
+    // 消费者读取位置，以及消费者看到的生产者位置的旧值
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_{0};
+    size_t cachedTail_ = 0;
+
+    // 生产者写入位置，以及生产者看到的消费者位置的旧值
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_{0};
+    size_t cachedHead_ = 0;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<bool> closed_{false};
+};
+
+} // namespace jvav
+
+#endif // JVAV_TOKEN_RING_H
@@ -0,0 +1,84 @@
+#ifndef JVAV_UTF8_H
+#define JVAV_UTF8_H
+
+#include <array>
+#include <cstdint>
+
+namespace jvav {
+namespace utf8 {
+
+// 字符类别
+enum class CharKind : uint8_t {
+    INVALID,      // 非法的UTF-8序列
+    OTHER,        // 合法字符，但不能出现在标识符中
+    ID_START,     // 可以作为标识符开头（XID_Start及'_'）
+    ID_CONTINUE   // 只能出现在标识符中间（XID_Continue，如数字、组合符号）
+};
+
+// 一个字符的解码结果
+struct CodePoint {
+    uint32_t value;   // Unicode码点，非法序列时无意义
+    uint32_t length;  // 占用的字节数，非法序列时为应跳过的字节数（至少为1）
+    CharKind kind;
+};
+
+// 字节类别表
+// ASCII字节直接给出标识符类别，不需要进入状态机；
+// 其余字节给出UTF-8状态机使用的类别（首字节种类或续字节范围）
+enum ByteClass : uint8_t {
+    BYTE_ASCII_OTHER,
+    BYTE_ASCII_ID_START,   // A-Z a-z _
+    BYTE_ASCII_DIGIT,      // 0-9
+    BYTE_CONT_80_8F,       // 续字节 0x80-0x8F
+    BYTE_CONT_90_9F,       // 续字节 0x90-0x9F
+    BYTE_CONT_A0_BF,       // 续字节 0xA0-0xBF
+    BYTE_LEAD2,            // 0xC2-0xDF
+    BYTE_LEAD3_E0,         // 0xE0，第二字节须为0xA0-0xBF
+    BYTE_LEAD3,            // 0xE1-0xEC、0xEE-0xEF
+    BYTE_LEAD3_ED,         // 0xED，第二字节须为0x80-0x9F（排除代理项）
+    BYTE_LEAD4_F0,         // 0xF0，第二字节须为0x90-0xBF
+    BYTE_LEAD4,            // 0xF1-0xF3
+    BYTE_LEAD4_F4,         // 0xF4，第二字节须为0x80-0x8F
+    BYTE_INVALID,          // 0xC0、0xC1、0xF5-0xFF
+    BYTE_CLASS_COUNT
+};
+
+extern const std::array<uint8_t, 256> BYTE_CLASSES;
+
+// 是否是ASCII标识符开头字符
+inline bool isAsciiIdStart(unsigned char c) {
+    return BYTE_CLASSES[c] == BYTE_ASCII_ID_START;
+}
+
+// 是否是ASCII标识符字符
+inline bool isAsciiIdContinue(unsigned char c) {
+    return BYTE_CLASSES[c] == BYTE_ASCII_ID_START || BYTE_CLASSES[c] == BYTE_ASCII_DIGIT;
+}
+
+// 通过状态机解码并分类多字节字符，校验和分类在一次扫描中完成
+CodePoint decodeMultibyteSlow(const char* p, const char* end);
+
+// 解码并分类多字节字符（调用者保证p < end且*p >= 0x80）
+// 最常见的CJK统一表意文字（U+4E00-U+9FFF）直接判断，其余交给状态机
+inline CodePoint decodeMultibyte(const char* p, const char* end) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(p);
+    if (end - p >= 3 && bytes[0] >= 0xE4 && bytes[0] <= 0xE9 &&
+        (bytes[1] & 0xC0) == 0x80 && (bytes[2] & 0xC0) == 0x80) {
+        uint32_t value = (static_cast<uint32_t>(bytes[0] & 0x0F) << 12) |
+                         (static_cast<uint32_t>(bytes[1] & 0x3F) << 6) |
+                         (bytes[2] & 0x3F);
+        if (value >= 0x4E00) {
+            return CodePoint{value, 3, CharKind::ID_START};
+        }
+    }
+    return decodeMultibyteSlow(p, end);
+}
+
+// 码点是否属于XID_Start / XID_Continue
+bool isXidStart(uint32_t codepoint);
+bool isXidContinue(uint32_t codepoint);
+
+} // namespace utf8
+} // namespace jvav
+
+#endif // JVAV_UTF8_H
@@ -0,0 +1,18 @@
+#ifndef JVAV_BINDINGS_H
+#define JVAV_BINDINGS_H
+
+#include "ast/AST.h"
+#include <cstdint>
+#include <vector>
+
+namespace jvav {
+
+// 统计每个符号在整个程序中被绑定的次数，按符号编号索引
+// 绑定是所有引入名字或改变名字所指的地方：设置语句、以变量为目标的赋值、循环变量、
+// 函数名和参数、导入的模块名和别名、数组、记录、枚举及其枚举值的名字、记录访问语句的记录名。
+// 优化只信任恰好被绑定一次的名字：它的值或定义在程序中只有一处来源。
+std::vector<uint32_t> countBindings(Program& program);
+
+} // namespace jvav
+
+#endif // JVAV_BINDINGS_H
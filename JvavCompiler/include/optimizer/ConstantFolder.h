@@ -0,0 +1,42 @@
+#ifndef JVAV_CONSTANT_FOLDER_H
+#define JVAV_CONSTANT_FOLDER_H
+
+#include "ast/AST.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace jvav {
+
+// 常量折叠和常量传播（-O1）
+// 操作数都是常量的一元、二元表达式在编译期求值，换成一个数字字面量；
+// 只在顶层被设置过一次、值为常量的变量，其后的引用也换成字面量，并继续参与折叠。
+// 求值与生成的代码完全一致：按i32补码回绕，&&和||是按位运算；
+// 运行时会陷入的运算（除以0、INT32_MIN / -1）保留原样，不在编译期报错。
+//
+// 常量传播是保守的：变量在程序中任何别的地方被写入（赋值、循环变量、参数、同名定义等）
+// 就不传播；函数体内的引用也不替换，因为函数可能在变量设置之前就被调用。
+// 语法树用显式栈遍历，任意长的表达式链也不会耗尽线程栈。
+class ConstantFolder {
+public:
+    // 就地改写program，新的字面量节点分配在program的arena中
+    void run(Program& program);
+
+    // 上次run()折叠的运算个数和替换为常量的变量引用个数
+    size_t foldedCount() const { return folded_; }
+    size_t propagatedCount() const { return propagated_; }
+
+    // 表达式是否是值已知的常量（数字或布尔字面量），是时给出它作为i32的值
+    // 数字字面量按代码生成的方式取整数部分，超出i32范围的不算常量
+    static bool evaluate(const Expr* expr, int32_t& value);
+
+    // 在arena中构造值为value的数字字面量，位置取自position
+    static LiteralExpr* makeLiteral(Arena& arena, int32_t value, const Token& position);
+
+private:
+    size_t folded_ = 0;
+    size_t propagated_ = 0;
+};
+
+} // namespace jvav
+
+#endif // JVAV_CONSTANT_FOLDER_H
@@ -0,0 +1,34 @@
+#ifndef JVAV_DEAD_CODE_ELIMINATOR_H
+#define JVAV_DEAD_CODE_ELIMINATOR_H
+
+#include "ast/AST.h"
+#include <cstddef>
+
+namespace jvav {
+
+// 死代码消除（-O1，在常量折叠之后运行）
+// 删除不会执行或执行了也没有效果的语句：
+//   - 条件为常量的if分支：恒假的分支删除，恒真的分支成为else，其后的分支删除；
+//     只剩else时用它的语句代替整个if
+//   - 次数为不大于0的常量的循环
+//   - 函数体中return之后的语句
+//   - 没有副作用的表达式语句（只由字面量、变量和不会陷入的运算组成）
+// 语句列表用显式栈逐个处理，不递归。
+class DeadCodeEliminator {
+public:
+    // 就地改写program，新的语句列表分配在program的arena中
+    void run(Program& program);
+
+    // 上次run()删除的语句和if分支个数
+    size_t removedCount() const { return removed_; }
+
+    // 表达式求值是否没有副作用且不会陷入
+    static bool isPure(const Expr* expr);
+
+private:
+    size_t removed_ = 0;
+};
+
+} // namespace jvav
+
+#endif // JVAV_DEAD_CODE_ELIMINATOR_H
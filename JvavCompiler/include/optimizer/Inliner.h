@@ -0,0 +1,44 @@
+#ifndef JVAV_INLINER_H
+#define JVAV_INLINER_H
+
+#include "ast/AST.h"
+#include <cstddef>
+
+namespace jvav {
+
+// 函数内联（-O2起）
+// 把小函数的调用替换为函数体的副本，省去调用开销，也让常量折叠能看穿调用。
+//
+// 可以内联的函数：整个程序中只定义一次、名字没有别的绑定，函数体只有一条带返回值的return，
+// 返回值表达式只由字面量、变量、一元、二元运算和调用组成，不直接调用自己，节点数不超过上限。
+// 这门语言的函数没有局部变量（函数体中的设置语句写的是全局变量），
+// 所以内联只需把参数替换为实参表达式，不需要重新命名。
+//
+// 调用处的实参必须保证替换前后求值的结果和副作用不变：
+// 实参是字面量或变量，或者是只被使用一次的无副作用表达式；
+// 函数体中还有调用时（可能修改全局变量），实参只能是字面量。
+// 函数体中的全局变量在调用处被同名参数遮蔽时不内联。
+// 副本中的调用不再继续内联，展开的规模有界。
+class Inliner {
+public:
+    // maxBodySize：可内联的函数体的最大节点数
+    explicit Inliner(size_t maxBodySize) : maxBodySize_(maxBodySize) {}
+
+    // 就地改写program，副本分配在program的arena中
+    void run(Program& program);
+
+    // 上次run()内联的调用个数
+    size_t inlinedCount() const { return inlined_; }
+
+    // 各优化级别的函数体大小上限
+    static constexpr size_t O2_MAX_BODY_SIZE = 8;
+    static constexpr size_t O3_MAX_BODY_SIZE = 32;
+
+private:
+    size_t maxBodySize_;
+    size_t inlined_ = 0;
+};
+
+} // namespace jvav
+
+#endif // JVAV_INLINER_H
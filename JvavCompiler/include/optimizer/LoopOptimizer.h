@@ -0,0 +1,51 @@
+#ifndef JVAV_LOOP_OPTIMIZER_H
+#define JVAV_LOOP_OPTIMIZER_H
+
+#include "ast/AST.h"
+#include <cstddef>
+
+namespace jvav {
+
+// 循环优化（-O2起）
+// 对`loop as i(N) {...}`依次尝试：
+//   - 完全展开：次数是不大于FULL_UNROLL_MAX_TRIPS的常量、展开后不太大时，
+//     换成N份循环体，每份中的循环变量换成0..N-1
+//   - 强度削弱：循环体中的i * k（k为常量）换成一个累加器，循环前置0，每次迭代末尾加k
+//   - 不变量外提：不依赖循环变量、也不依赖循环中被写入的变量的无副作用表达式，
+//     在循环前算好存入临时变量
+//   累加器和临时变量都是全局变量，循环体或次数中有调用时不做这两种变换：
+//   被调用的函数可能写全局变量，递归调用循环所在的函数时还会改写同一个累加器
+//   - 部分展开：次数为常量时按倍数展开，循环体复制多份、次数相应减少，余下的几次放在循环后
+// 循环体中有函数、数组等定义，或者循环变量在别处也被绑定时，不做任何变换。
+// 引入的临时变量名含有'.'，不会与源代码中的标识符冲突。
+class LoopOptimizer {
+public:
+    // unrollFactor：部分展开的倍数，小于2时不做部分展开
+    explicit LoopOptimizer(int unrollFactor) : unrollFactor_(unrollFactor) {}
+
+    // 就地改写program，新节点分配在program的arena中
+    void run(Program& program);
+
+    // 上次run()的统计
+    size_t unrolledCount() const { return unrolled_; }    // 完全或部分展开的循环
+    size_t hoistedCount() const { return hoisted_; }      // 外提的不变表达式
+    size_t reducedCount() const { return reduced_; }      // 换成累加器的乘法
+
+    // 默认的部分展开倍数
+    static constexpr int DEFAULT_UNROLL_FACTOR = 4;
+
+    // 完全展开的最大次数，以及完全、部分展开后循环体的最大节点数
+    static constexpr int FULL_UNROLL_MAX_TRIPS = 8;
+    static constexpr size_t FULL_UNROLL_BUDGET = 256;
+    static constexpr size_t PARTIAL_UNROLL_BUDGET = 256;
+
+private:
+    int unrollFactor_;
+    size_t unrolled_ = 0;
+    size_t hoisted_ = 0;
+    size_t reduced_ = 0;
+};
+
+} // namespace jvav
+
+#endif // JVAV_LOOP_OPTIMIZER_H
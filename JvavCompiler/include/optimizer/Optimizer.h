@@ -2,27 +2,65 @@
 #define JVAV_OPTIMIZER_H
 
 #include "ast/AST.h"
+#include "ir/IR.h"
+#include <cstddef>
 #include <string>
 #include <vector>
 #include <memory>
 
 namespace jvav {
 
+// 一次优化的统计
+struct OptimizationStats {
+    size_t foldedExpressions = 0;    // 编译期求值的运算
+    size_t propagatedConstants = 0;  // 替换为常量的变量引用
+    size_t removedStatements = 0;    // 删除的死代码（语句和if分支）
+    size_t inlinedCalls = 0;         // 内联的函数调用
+    size_t unrolledLoops = 0;        // 完全或部分展开的循环
+    size_t hoistedExpressions = 0;   // 外提到循环前的不变表达式
+    size_t reducedMultiplications = 0;  // 换成累加的乘法
+    
+    // 中间表示上的优化
+    size_t irConstants = 0;          // 换成常量的值
+    size_t irRedundantValues = 0;    // 值编号删除的冗余指令
+    size_t irHoistedValues = 0;      // 外提到循环前的指令
+    size_t irDeadValues = 0;         // 删除的无用指令
+    size_t irRemovedBlocks = 0;      // 删除或合并的基本块
+};
+
 // 优化器类
+// 在语法树上就地优化，各级别包含的遍：
+//   -O0  不优化
+//   -O1  常量折叠和常量传播（见ConstantFolder），死代码消除（见DeadCodeEliminator）
+//   -O2  另外内联小函数（见Inliner），然后再做一遍-O1的化简；
+//        再做循环展开、不变量外提和强度削弱（见LoopOptimizer），然后再化简一遍
+//   -O3  同-O2，可内联的函数体更大
+// 降低为中间表示之后再优化一次（见optimize(IRModule&, int)）：
+//   -O1  稀疏条件常量传播（见ConstantPropagator），死代码消除（见DeadValueEliminator）
+//   -O2  另外做全局值编号（见ValueNumbering）和循环不变量外提（见LoopInvariantMotion）
+// 两部分的统计累加在同一个OptimizationStats中。
 class Optimizer {
 public:
     Optimizer();
     ~Optimizer();
     
     // 优化AST
-    void optimize(std::vector<std::unique_ptr<Stmt>>& ast, int optimizationLevel);
+    void optimize(Program& program, int optimizationLevel);
+    
+    // 优化中间表示
+    void optimize(IRModule& module, int optimizationLevel);
+    
+    // -O2起循环部分展开的倍数，小于2时不做部分展开
+    void setUnrollFactor(int factor);
+    
+    // 上次优化的统计
+    const OptimizationStats& getStats() const;
     
 private:
-    // 将在后续实现
     class OptimizerImpl;
     std::unique_ptr<OptimizerImpl> impl_;
 };
 
 } // namespace jvav
 
-#endif // JVAV_OPTIMIZER_H 
\ No newline at end of file
+#endif // JVAV_OPTIMIZER_H
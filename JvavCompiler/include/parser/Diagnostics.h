@@ -0,0 +1,58 @@
+#ifndef JVAV_DIAGNOSTICS_H
+#define JVAV_DIAGNOSTICS_H
+
+#include "lexer/Token.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace jvav {
+
+// 一条语法错误
+struct Diagnostic {
+    Token token;          // 出错位置的token
+    const char* message;  // 错误说明，必须是静态字符串
+    
+    // 格式化为"文件:行:列 在 'xxx': 说明"
+    std::string toString() const;
+};
+
+// 语法错误收集器
+// 报告错误时只记录token和静态的说明文字，不分配字符串也不计算行列号，
+// 显示时才格式化。编辑器中代码几乎总是有错，报告错误需要足够便宜。
+class DiagnosticSink {
+public:
+    // 预先分配的条数
+    static constexpr size_t DEFAULT_CAPACITY = 64;
+    
+    explicit DiagnosticSink(size_t capacity = DEFAULT_CAPACITY) {
+        diagnostics_.reserve(capacity);
+    }
+    
+    // 记录一条错误
+    void report(const Token& token, const char* message) {
+        diagnostics_.push_back(Diagnostic{token, message});
+    }
+    
+    // 清空所有错误，保留容量
+    void clear() { diagnostics_.clear(); }
+    
+    // 并入另一组错误，合并后按在源文件中的位置排序
+    // 两组错误必须属于同一个文件
+    void merge(const DiagnosticSink& other);
+    
+    size_t size() const { return diagnostics_.size(); }
+    bool empty() const { return diagnostics_.empty(); }
+    
+    const Diagnostic& operator[](size_t index) const { return diagnostics_[index]; }
+    const Diagnostic& back() const { return diagnostics_.back(); }
+    std::vector<Diagnostic>::const_iterator begin() const { return diagnostics_.begin(); }
+    std::vector<Diagnostic>::const_iterator end() const { return diagnostics_.end(); }
+    
+private:
+    std::vector<Diagnostic> diagnostics_;
+};
+
+} // namespace jvav
+
+#endif // JVAV_DIAGNOSTICS_H
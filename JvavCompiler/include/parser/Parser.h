@@ -1,95 +1,188 @@
 #ifndef JVAV_PARSER_H
 #define JVAV_PARSER_H
 
-#include "lexer/Lexer.h"
+#include "lexer/TokenBuffer.h"
+#include "lexer/TokenRing.h"
 #include "ast/AST.h"
-#include <memory>
+#include "ast/FlatAST.h"
+#include "parser/Diagnostics.h"
+#include "compiler/ThreadPool.h"
+#include <cstdint>
+#include <initializer_list>
 #include <vector>
 #include <string>
-#include <stdexcept>
 
 namespace jvav {
 
-// 解析错误异常
-class ParseError : public std::runtime_error {
-public:
-    ParseError(const std::string& message) : std::runtime_error(message) {}
+class Lexer;
+
+// 表达式操作符的优先级，从低到高
+enum class Precedence : uint8_t {
+    NONE,
+    OR,          // ||
+    AND,         // &&
+    EQUALITY,    // == !=
+    COMPARISON,  // < <= > >=
+    TERM,        // + -
+    FACTOR,      // * / %
+    UNARY,       // - !
+    CALL         // () . []
 };
 
 // 解析器类
 class Parser {
 public:
-    // 构造函数需要一个词法分析器
-    Parser(Lexer& lexer);
+    // 构造函数需要词法分析器产生的token缓冲区和存放语法树节点的arena
+    // 缓冲区必须以END_OF_FILE结尾，并且在语法分析期间保持有效
+    Parser(const TokenBuffer& tokens, Arena& arena);
+    
+    // 流式模式：边读取环形缓冲区边分析，只保留一个滑动窗口内的token
+    Parser(TokenRing& ring, Arena& arena);
+    
+    // 按需模式：在同一线程中边分析词法边解析，只读取实际解析到的token
+    // 增量解析从文件中间开始，解析到可以复用旧语法树的位置就停下，不必分析整个文件
+    Parser(Lexer& lexer, Arena& arena);
+    
+    // 解析源代码，生成语法树（节点属于arena）
+    NodeList<Stmt*> parse();
+    
+    // 并行解析，结果与parse()相同
+    // 先扫描一遍token匹配花括号，找出顶层函数定义的函数体；顶层解析时跳过这些函数体，
+    // 再把它们分组交给线程池解析，最后按源代码顺序填回并合并错误。
+    // 函数体的token总数少于PARALLEL_MIN_BODY_TOKENS、线程池只有一个线程
+    // 或处于流式/按需模式时退回串行解析。
+    NodeList<Stmt*> parseParallel(ThreadPool& pool);
+    
+    // 解析为扁平语法树
+    // 每解析完一条顶层语句就转换为扁平节点并清空arena，arena只用作单条语句的临时空间，
+    // 内存中不会同时存在整棵指针语法树
+    FlatTree parseFlat();
+    
+    // 值得并行解析的函数体token总数
+    static constexpr size_t PARALLEL_MIN_BODY_TOKENS = 64 * 1024;
+    
+    // 括号和语句块默认允许的最大嵌套层数
+    // 嵌套的括号、语句块按层递归解析，限制层数保证机器生成的代码也不会耗尽线程栈；
+    // 连续的二元操作和一元操作在循环中解析，不受这个限制
+    static constexpr size_t DEFAULT_MAX_DEPTH = 256;
+    
+    // 设置最大嵌套层数（至少为1），超过时报告错误并跳过这条语句
+    void setMaxDepth(size_t depth);
+    
+    // 逐条解析顶层语句，供增量解析记录每条语句的起点和错误
+    // 返回的语句出错时是ErrorStmt，返回后总是停在下一条顶层语句的开头
+    Stmt* parseDeclaration();
     
-    // 解析源代码，生成语法树
-    std::vector<std::unique_ptr<Stmt>> parse();
+    // 是否已解析到文件末尾
+    bool isAtEnd() const { return check(TokenType::END_OF_FILE); }
+    
+    // 下一个待解析的token在源文件中的偏移
+    uint32_t currentOffset() const { return tokens_->offset(current_); }
     
     // 获取解析错误
-    const std::vector<std::string>& getErrors() const { return errors_; }
+    const DiagnosticSink& getDiagnostics() const { return diagnostics_; }
     
 private:
-    // 词法分析器
-    Lexer& lexer_;
+    // 每个线程分到的函数体组数，多分几组以平衡负载
+    static constexpr size_t GROUPS_PER_THREAD = 4;
+    
+    // 顶层函数定义的函数体：左右花括号的下标和所属的语句
+    struct DeferredBody {
+        size_t open;
+        size_t close;
+        DefineStmt* stmt;
+    };
+    
+    // 全部token（流式模式和按需模式下指向window_）
+    const TokenBuffer* tokens_;
+    
+    // 流式模式或按需模式下的token来源，以及当前窗口
+    TokenRing* ring_ = nullptr;
+    Lexer* lexer_ = nullptr;
+    TokenBuffer window_;
+    
+    // 语法树节点分配在这里
+    Arena& arena_;
+    
+    // 构造子节点列表时的临时栈，列表完成后复制到arena
+    std::vector<Stmt*> stmtScratch_;
+    std::vector<Expr*> exprScratch_;
+    std::vector<Token> tokenScratch_;
     
-    // 当前处理的token
-    Token current_;
+    // 当前处理的token的下标
+    size_t current_ = 0;
     
-    // 上一个处理的token
-    Token previous_;
+    // 上一个处理的token的下标
+    size_t previous_ = 0;
     
-    // 解析错误列表
-    std::vector<std::string> errors_;
+    // 解析错误
+    DiagnosticSink diagnostics_;
     
     // 是否正在恢复错误
+    // 出错时置位，各解析方法检查到后立即返回nullptr，由declaration()同步并清除
     bool panicMode_ = false;
     
+    // 当前所在的花括号层数，错误恢复时用来找到同一层的同步点
+    size_t braceDepth_ = 0;
+    
+    // 当前的嵌套层数（表达式和语句块）及其上限
+    size_t depth_ = 0;
+    size_t maxDepth_ = DEFAULT_MAX_DEPTH;
+    
+    // 并行解析时预扫描找到的顶层函数体（stmt为空），以及下一个待匹配的下标
+    std::vector<DeferredBody> bodySpans_;
+    size_t nextBodySpan_ = 0;
+    
+    // 顶层解析时跳过、留给线程池解析的函数体
+    std::vector<DeferredBody> deferredBodies_;
+    
     // 解析方法
-    std::unique_ptr<Stmt> declaration();
-    std::unique_ptr<Stmt> importStatement();
-    std::unique_ptr<Stmt> dakaiStatement();
-    std::unique_ptr<Stmt> setStatement();
-    std::unique_ptr<Stmt> printStatement();
-    std::unique_ptr<Stmt> ifStatement();
-    std::unique_ptr<Stmt> loopStatement();
-    std::unique_ptr<Stmt> defineStatement();
-    std::unique_ptr<Stmt> returnStatement();
-    std::unique_ptr<Stmt> arrayStatement();
-    std::unique_ptr<Stmt> recordDefinition();
-    std::unique_ptr<Stmt> enumDefinition();
-    std::unique_ptr<Stmt> tryStatement();
-    std::unique_ptr<Stmt> expressionStatement();
-    std::unique_ptr<Stmt> block();
+    Stmt* declaration();
+    Stmt* statement();
+    Stmt* importStatement();
+    Stmt* dakaiStatement();
+    Stmt* setStatement();
+    Stmt* printStatement();
+    Stmt* ifStatement();
+    Stmt* loopStatement();
+    Stmt* defineStatement();
+    Stmt* returnStatement();
+    Stmt* arrayStatement();
+    Stmt* recordDefinition();
+    Stmt* enumDefinition();
+    Stmt* tryStatement();
+    Stmt* expressionStatement();
+    NodeList<Stmt*> block();
     
     // 表达式解析方法
-    std::unique_ptr<Expr> expression();
-    std::unique_ptr<Expr> assignment();
-    std::unique_ptr<Expr> logicalOr();
-    std::unique_ptr<Expr> logicalAnd();
-    std::unique_ptr<Expr> equality();
-    std::unique_ptr<Expr> comparison();
-    std::unique_ptr<Expr> term();
-    std::unique_ptr<Expr> factor();
-    std::unique_ptr<Expr> unary();
-    std::unique_ptr<Expr> call();
-    std::unique_ptr<Expr> primary();
+    Expr* expression();
+    Expr* parsePrecedence(Precedence minPrecedence);
+    Expr* prefix();
+    Expr* primary();
     
     // 辅助方法
     bool match(TokenType type);
-    bool match(const std::vector<TokenType>& types);
+    bool match(std::initializer_list<TokenType> types);
     bool check(TokenType type) const;
     Token advance();
+    void refill();
     Token peek() const;
     Token previous() const;
-    Token consume(TokenType type, const std::string& message);
-    Token consume(const std::vector<TokenType>& types, const std::string& message);
+    Token consume(TokenType type, const char* message);
+    Token consume(std::initializer_list<TokenType> types, const char* message);
+    
+    void findTopLevelBodies();
+    bool deferBody(DefineStmt* stmt);
+    static DiagnosticSink parseBodies(const TokenBuffer& tokens, const DeferredBody* bodies,
+                                      size_t count, Arena& arena, size_t maxDepth);
     
-    ParseError error(const Token& token, const std::string& message);
-    void synchronize();
-    void addError(const std::string& message);
-    void addError(const Token& token, const std::string& message);
+    void errorAt(const Token& token, const char* message);
+    void errorAtCurrent(const char* message);
+    bool tooDeep();
+    void synchronize(size_t depth);
+    bool isStatementStart(TokenType type) const;
     
-    std::unique_ptr<Expr> finishCall(std::unique_ptr<Expr> callee);
+    Expr* finishCall(Expr* callee);
 };
 
 } // namespace jvav
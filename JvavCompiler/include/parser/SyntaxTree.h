@@ -0,0 +1,88 @@
+#ifndef JVAV_SYNTAX_TREE_H
+#define JVAV_SYNTAX_TREE_H
+
+#include "ast/AST.h"
+#include "parser/Diagnostics.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace jvav {
+
+// 对源代码的一次修改：把字节范围[begin, end)替换为text
+struct TextEdit {
+    size_t begin;
+    size_t end;
+    std::string text;
+};
+
+// 可增量更新的语法树，供编辑器集成使用
+// 持有源代码、语法树和语法错误，并记录每条顶层语句的起点。
+// 修改源代码后只从受影响的顶层语句开始重新分析词法和语法，
+// 一旦解析到修改位置之后某条旧语句的起点就停下，其后的语句连同子树原样复用，
+// 只把其中的偏移整体平移。结果与对修改后的源代码完整解析一次相同。
+class SyntaxTree {
+public:
+    // 注册源文件并完整解析一次
+    SyntaxTree(const std::string& filename, std::string source);
+    ~SyntaxTree();
+
+    // 语法树中的token引用本对象注册的源文件，不允许复制
+    SyntaxTree(const SyntaxTree&) = delete;
+    SyntaxTree& operator=(const SyntaxTree&) = delete;
+
+    // 应用一次修改并增量更新语法树
+    // 范围超出源代码时不做任何修改，返回false
+    bool applyEdit(const TextEdit& edit);
+
+    // 当前的源代码及其在文件表中的编号
+    const std::string& getSource() const { return source_; }
+    FileId getFileId() const { return fileId_; }
+
+    // 当前的语法树，语句列表在下次修改之前有效
+    const Program& getProgram() const { return program_; }
+
+    // 当前的语法错误，按位置排序
+    const DiagnosticSink& getDiagnostics() const { return diagnostics_; }
+
+    // 上次更新重新解析的顶层语句数（完整解析时为全部语句数）
+    size_t getReparsedCount() const { return reparsedCount_; }
+
+    // 被替换的旧节点留在arena中，arena超过上次完整解析时的这么多倍后改为完整解析以回收内存
+    static constexpr size_t ARENA_GROWTH_LIMIT = 4;
+
+private:
+    // 完整解析，重建arena
+    void parseAll();
+
+    // 让program_的语句列表指向statements_
+    void updateProgram();
+
+    std::string filename_;
+
+    // 源代码，修改时就地替换，字面量文本直接指向其中
+    std::string source_;
+    FileId fileId_;
+
+    // 语法树，statements指向statements_
+    Program program_;
+    std::vector<Stmt*> statements_;
+
+    // 每条顶层语句第一个token的偏移
+    std::vector<uint32_t> starts_;
+
+    // 每条顶层语句的第一条错误在diagnostics_中的下标
+    std::vector<uint32_t> firstDiagnostics_;
+
+    DiagnosticSink diagnostics_;
+
+    // 上次完整解析后arena的大小
+    size_t fullParseBytes_ = 0;
+
+    size_t reparsedCount_ = 0;
+};
+
+} // namespace jvav
+
+#endif // JVAV_SYNTAX_TREE_H
@@ -4,13 +4,45 @@
 #include "codegen/CodeGenerator.h"
 #include "optimizer/Optimizer.h"
 #include "codegen/LLVMCodeGenerator.h"
+#include "ir/IRLowering.h"
+#include "lexer/SourceBuffer.h"
+#include "lexer/ScanKernels.h"
+#include "lexer/TokenRing.h"
+#include "compiler/ThreadPool.h"
+#include "ast/ASTCache.h"
 
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <optional>
 #include <filesystem>
+#include <thread>
 #include <vector>
 
+namespace {
+
+// 流式编译时环形缓冲区的容量（token个数）
+constexpr size_t TOKEN_RING_CAPACITY = 16 * 1024;
+
+// 流式编译时的词法分析线程
+// 析构时关闭环形缓冲区并等待线程结束，语法分析提前结束或抛出异常时也不会遗留线程
+class LexerThread {
+public:
+    LexerThread(jvav::Lexer& lexer, jvav::TokenRing& ring)
+        : ring_(ring), thread_([&lexer, &ring]() { lexer.tokenizeToRing(ring); }) {}
+    
+    ~LexerThread() {
+        ring_.close();
+        thread_.join();
+    }
+    
+private:
+    jvav::TokenRing& ring_;
+    std::thread thread_;
+};
+
+} // namespace
+
 // 实现JvavCompiler的私有实现类
 class JvavCompiler::JvavCompilerImpl {
 public:
@@ -18,35 +50,49 @@ public:
     ~JvavCompilerImpl() {}
     
     // 编译源代码
-    JvavErrorCode compile(const std::string& source, const std::string& sourceName, const JvavCompilerOptions& options, std::string& lastError) {
+    JvavErrorCode compile(std::string_view source, const std::string& sourceName, const JvavCompilerOptions& options, std::string& lastError) {
         try {
             // 创建词法分析器
             jvav::Lexer lexer(source, sourceName);
             
-            // 执行词法分析
-            if (options.verbose) {
-                std::cout << "执行词法分析..." << std::endl;
-            }
+            // 语法树节点都分配在program的arena中，编译结束时整体释放
+            jvav::Program program;
             
-            // 创建语法分析器
-            jvav::Parser parser(lexer);
-            
-            // 执行语法分析
-            if (options.verbose) {
-                std::cout << "执行语法分析..." << std::endl;
+            // 源代码与上次编译相同时直接加载缓存的语法树，跳过词法和语法分析
+            std::optional<jvav::ASTCache> cache;
+            jvav::ASTCache::Key cacheKey;
+            bool cacheHit = false;
+            if (!options.astCacheDirectory.empty()) {
+                cache.emplace(options.astCacheDirectory, cacheConfiguration(options));
+                cacheKey = cache->makeKey(source);
+                cacheHit = cache->load(cacheKey, source, lexer.getFileId(), program);
+                jvav::ASTCache::Statistics totals = cache->recordLookup(cacheHit);
+                if (options.verbose) {
+                    std::cout << "AST缓存" << (cacheHit ? "命中: " : "未命中: ") << cacheKey.path;
+                    if (cacheHit) {
+                        std::cout << " (" << cache->lastFileSize() << " 字节)";
+                    }
+                    std::cout << " [累计命中 " << totals.hits << " 次, 未命中 " << totals.misses << " 次]" << std::endl;
+                }
             }
             
-            auto ast = parser.parse();
-            
-            // 检查语法错误
-            const auto& errors = parser.getErrors();
-            if (!errors.empty()) {
-                // 合并所有错误信息
-                lastError = "语法分析出错:\n";
-                for (const auto& error : errors) {
-                    lastError += error + "\n";
+            if (!cacheHit) {
+                JvavErrorCode result = parse(lexer, source, options, program, lastError);
+                if (result != JvavErrorCode::SUCCESS) {
+                    return result;
+                }
+                
+                // 只缓存没有语法错误的语法树，写入失败不影响编译
+                if (cache) {
+                    std::string cacheError;
+                    if (cache->store(cacheKey, source, lexer.getFileId(), program, cacheError)) {
+                        if (options.verbose) {
+                            std::cout << "写入AST缓存: " << cacheKey.path << " (" << cache->lastFileSize() << " 字节)" << std::endl;
+                        }
+                    } else if (options.verbose) {
+                        std::cout << "警告: " << cacheError << std::endl;
+                    }
                 }
-                return JvavErrorCode::SYNTAX_ERROR;
             }
             
             // 优化
@@ -55,7 +101,67 @@ public:
                     std::cout << "执行优化，级别: " << options.optimizationLevel << std::endl;
                 }
                 jvav::Optimizer optimizer;
-                optimizer.optimize(ast, options.optimizationLevel);
+                optimizer.setUnrollFactor(options.unrollFactor);
+                optimizer.optimize(program, options.optimizationLevel);
+                if (options.verbose) {
+                    const jvav::OptimizationStats& stats = optimizer.getStats();
+                    std::cout << "常量折叠: " << stats.foldedExpressions << " 处, 常量传播: "
+                              << stats.propagatedConstants << " 处, 删除死代码: "
+                              << stats.removedStatements << " 处, 内联调用: "
+                              << stats.inlinedCalls << " 处" << std::endl;
+                    std::cout << "展开循环: " << stats.unrolledLoops << " 个, 外提不变量: "
+                              << stats.hoistedExpressions << " 处, 强度削弱: "
+                              << stats.reducedMultiplications << " 处" << std::endl;
+                }
+            }
+            
+            // 原生目标
+            bool nativeTarget = options.targetType == JvavTargetType::EXECUTABLE ||
+                                options.targetType == JvavTargetType::LIBRARY ||
+                                options.targetType == JvavTargetType::OBJECT_FILE ||
+                                options.targetType == JvavTargetType::ASSEMBLY ||
+                                options.targetType == JvavTargetType::LLVM_IR;
+#ifdef JVAV_HAS_LLVM
+            bool llvmTarget = nativeTarget;
+#else
+            bool llvmTarget = false;
+#endif
+            
+            // 降低为SSA中间表示并在其上优化
+            // LLVM目标和--emit-ir只能经由中间表示；WebAssembly在--ir时经由中间表示，
+            // 有中间表示不支持的语法时回退到语法树后端
+            std::optional<jvav::IRModule> ir;
+            bool irRequired = llvmTarget || options.targetType == JvavTargetType::SSA_IR;
+            if (irRequired || options.useIR) {
+                if (options.verbose) {
+                    std::cout << "降低为SSA中间表示..." << std::endl;
+                }
+                jvav::IRModule module;
+                std::string irError;
+                if (!jvav::IRLowering().lower(program, module, irError)) {
+                    if (irRequired) {
+                        lastError = irError;
+                        return JvavErrorCode::CODEGEN_ERROR;
+                    }
+                    std::cerr << "警告: " << irError << "，改用语法树生成WebAssembly" << std::endl;
+                } else {
+                    if (options.optimize) {
+                        jvav::Optimizer optimizer;
+                        optimizer.optimize(module, options.optimizationLevel);
+                        if (options.verbose) {
+                            const jvav::OptimizationStats& stats = optimizer.getStats();
+                            std::cout << "中间表示: 常量传播 " << stats.irConstants << " 处, 删除冗余 "
+                                      << stats.irRedundantValues << " 处, 外提 " << stats.irHoistedValues
+                                      << " 处, 删除无用指令 " << stats.irDeadValues << " 条, 删除或合并块 "
+                                      << stats.irRemovedBlocks << " 个" << std::endl;
+                        }
+                    }
+                    if (!module.verify(irError)) {
+                        lastError = "中间表示验证失败: " + irError;
+                        return JvavErrorCode::INTERNAL_ERROR;
+                    }
+                    ir = std::move(module);
+                }
             }
             
             // 代码生成
@@ -77,42 +183,25 @@ public:
             }
             
             // 根据目标类型和是否支持LLVM选择代码生成器
-            if (options.targetType == JvavTargetType::EXECUTABLE || 
-                options.targetType == JvavTargetType::LIBRARY || 
-                options.targetType == JvavTargetType::OBJECT_FILE || 
-                options.targetType == JvavTargetType::ASSEMBLY || 
-                options.targetType == JvavTargetType::LLVM_IR) {
+            if (options.targetType == JvavTargetType::SSA_IR) {
+                std::ofstream outFile(options.outputFile);
+                if (!outFile) {
+                    lastError = "无法创建输出文件: " + options.outputFile;
+                    return JvavErrorCode::CODEGEN_ERROR;
+                }
+                outFile << ir->toString();
+            } else if (nativeTarget) {
 #ifdef JVAV_HAS_LLVM
                 // 使用LLVM代码生成器生成原生代码
                 if (options.verbose) {
                     std::cout << "使用LLVM代码生成器生成目标代码..." << std::endl;
                 }
                 
+                // LIBRARY暂未实现，使用EXECUTABLE代替
+                JvavTargetType targetType = options.targetType == JvavTargetType::LIBRARY
+                    ? JvavTargetType::EXECUTABLE : options.targetType;
                 jvav::LLVMCodeGenerator codeGenerator;
-                // 转换目标类型
-                jvav::JvavTargetType targetType;
-                switch (options.targetType) {
-                    case JvavTargetType::EXECUTABLE:
-                        targetType = jvav::JvavTargetType::EXECUTABLE;
-                        break;
-                    case JvavTargetType::LIBRARY:
-                        targetType = jvav::JvavTargetType::EXECUTABLE; // LIBRARY暂未实现，使用EXECUTABLE代替
-                        break;
-                    case JvavTargetType::OBJECT_FILE:
-                        targetType = jvav::JvavTargetType::OBJECT_FILE;
-                        break;
-                    case JvavTargetType::ASSEMBLY:
-                        targetType = jvav::JvavTargetType::ASSEMBLY;
-                        break;
-                    case JvavTargetType::LLVM_IR:
-                        targetType = jvav::JvavTargetType::LLVM_IR;
-                        break;
-                    default:
-                        targetType = jvav::JvavTargetType::EXECUTABLE;
-                        break;
-                }
-                
-                if (!codeGenerator.generateCode(ast, options.outputFile, targetType, targetPlatform)) {
+                if (!codeGenerator.generateCode(*ir, options.outputFile, targetType, targetPlatform)) {
                     lastError = "LLVM代码生成失败";
                     return JvavErrorCode::CODEGEN_ERROR;
                 }
@@ -124,7 +213,11 @@ public:
                 
                 // 使用WebAssembly代码生成器，然后通过外部工具转换（不完美的替代方案）
                 jvav::CodeGenerator codeGenerator;
-                codeGenerator.generateCode(ast, options.outputFile);
+                if (ir) {
+                    codeGenerator.generateCode(*ir, options.outputFile);
+                } else {
+                    codeGenerator.generateCode(program, options.outputFile);
+                }
                 
                 // 提醒用户需要启用LLVM支持
                 std::cout << "注意: 要生成完整的原生可执行文件，请使用CMake选项 -DJVAV_ENABLE_LLVM=ON 重新构建编译器。" << std::endl;
@@ -132,11 +225,15 @@ public:
             } else {
                 // 默认使用WebAssembly代码生成器
                 if (options.verbose) {
-                    std::cout << "使用WebAssembly代码生成器..." << std::endl;
+                    std::cout << "使用WebAssembly代码生成器" << (ir ? "（经由中间表示）" : "") << "..." << std::endl;
                 }
                 
                 jvav::CodeGenerator codeGenerator;
-                codeGenerator.generateCode(ast, options.outputFile);
+                if (ir) {
+                    codeGenerator.generateCode(*ir, options.outputFile);
+                } else {
+                    codeGenerator.generateCode(program, options.outputFile);
+                }
             }
             
             // 写入输出文件
@@ -151,6 +248,76 @@ public:
             return JvavErrorCode::INTERNAL_ERROR;
         }
     }
+    
+private:
+    // 词法分析和语法分析，结果放入program
+    JvavErrorCode parse(jvav::Lexer& lexer, std::string_view source, const JvavCompilerOptions& options,
+                        jvav::Program& program, std::string& lastError) {
+        // 执行词法分析
+        if (options.verbose) {
+            std::cout << "执行词法分析... (扫描实现: " << jvav::scan::implementationName()
+                      << (options.streamTokens ? ", 流式" : "") << ")" << std::endl;
+        }
+        
+        if (options.streamTokens) {
+            // 词法分析线程写入环形缓冲区，语法分析同时从中读取
+            jvav::TokenRing ring(lexer.getFileId(), TOKEN_RING_CAPACITY);
+            LexerThread lexerThread(lexer, ring);
+            
+            if (options.verbose) {
+                std::cout << "执行语法分析..." << std::endl;
+            }
+            
+            jvav::Parser parser(ring, program.arena);
+            parser.setMaxDepth(options.maxNestingDepth);
+            program.statements = parser.parse();
+            if (!reportSyntaxErrors(parser, lastError)) {
+                return JvavErrorCode::SYNTAX_ERROR;
+            }
+        } else {
+            // 大文件按行切分后并行做词法分析，顶层函数体也并行解析
+            std::optional<jvav::ThreadPool> pool;
+            jvav::TokenBuffer tokens;
+            if (source.size() >= jvav::Lexer::PARALLEL_MIN_SIZE) {
+                pool.emplace();
+                tokens = lexer.tokenizeParallel(*pool);
+            } else {
+                tokens = lexer.tokenizeToBuffer();
+            }
+            
+            if (options.verbose) {
+                std::cout << "执行语法分析..." << std::endl;
+            }
+            
+            jvav::Parser parser(tokens, program.arena);
+            parser.setMaxDepth(options.maxNestingDepth);
+            program.statements = pool ? parser.parseParallel(*pool) : parser.parse();
+            if (!reportSyntaxErrors(parser, lastError)) {
+                return JvavErrorCode::SYNTAX_ERROR;
+            }
+        }
+        return JvavErrorCode::SUCCESS;
+    }
+    
+    // 缓存的语法树只对相同的编译器版本和语法分析选项有效
+    static std::string cacheConfiguration(const JvavCompilerOptions& options) {
+        return JvavCompiler::getVersionString() + " max-depth=" + std::to_string(options.maxNestingDepth);
+    }
+    
+    // 检查语法错误，有错误时合并所有错误信息并返回false
+    bool reportSyntaxErrors(const jvav::Parser& parser, std::string& lastError) {
+        const auto& diagnostics = parser.getDiagnostics();
+        if (diagnostics.empty()) {
+            return true;
+        }
+        
+        lastError = "语法分析出错:\n";
+        for (const auto& diagnostic : diagnostics) {
+            lastError += diagnostic.toString() + "\n";
+        }
+        return false;
+    }
+    
 };
 
 JvavCompiler::JvavCompiler() : impl_(std::make_unique<JvavCompilerImpl>()) {
@@ -166,22 +333,23 @@ void JvavCompiler::setOptions(const JvavCompilerOptions& options) {
 }
 
 JvavErrorCode JvavCompiler::compileFile(const std::string& filePath) {
-    // 读取源文件
-    std::ifstream file(filePath);
-    if (!file) {
-        lastError_ = "无法打开源文件: " + filePath;
+    // 映射源文件，整个编译过程只保留这一份源代码
+    std::string error;
+    auto buffer = jvav::SourceBuffer::fromFile(filePath, error);
+    if (!buffer) {
+        lastError_ = "无法打开源文件: " + filePath + " (" + error + ")";
         return JvavErrorCode::FILE_NOT_FOUND;
     }
     
-    // 读取文件内容
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    std::string source = buffer.str();
+    if (options_.verbose) {
+        std::cout << "加载源文件: " << filePath << " (" << buffer->getText().size() << " 字节, "
+                  << (buffer->isMapped() ? "内存映射" : "读取") << ")" << std::endl;
+    }
     
-    return compileString(source, filePath);
+    return compileString(buffer->getText(), filePath);
 }
 
-JvavErrorCode JvavCompiler::compileString(const std::string& source, const std::string& sourceName) {
+JvavErrorCode JvavCompiler::compileString(std::string_view source, const std::string& sourceName) {
     return impl_->compile(source, sourceName, options_, lastError_);
 }
 
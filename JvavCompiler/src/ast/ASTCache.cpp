@@ -0,0 +1,869 @@
+#include "ast/ASTCache.h"
+#include "ast/NodeWalker.h"
+#include "lexer/SourceBuffer.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace jvav {
+
+namespace {
+
+// 文件头，按本机字节序直接写入
+struct Header {
+    char magic[8];
+    uint32_t byteOrder;
+    uint32_t formatVersion;
+    uint64_t configurationHash;
+    uint64_t sourceHash;
+    uint64_t sourceSize;
+    uint32_t statementCount;  // 顶层语句数
+    uint32_t recordCount;     // 节点记录数
+    uint64_t bodyWords;       // 文件头之后的32位字数
+};
+
+constexpr char MAGIC[8] = {'J', 'V', 'A', 'V', 'A', 'S', 'T', '\0'};
+
+// 读出的值与此不同说明文件是在另一种字节序的机器上写的
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+// 记录的第一个字：低8位是节点类型，STMT_TAG区分语句和表达式，
+// 其后每一位对应一个可以为空的子节点指针，置位表示该子节点存在
+constexpr uint32_t TYPE_MASK = 0xFF;
+constexpr uint32_t STMT_TAG = 1u << 8;
+constexpr uint32_t CHILD_SHIFT = 9;
+
+constexpr uint32_t childBit(int slot) {
+    return 1u << (CHILD_SHIFT + slot);
+}
+
+// token的第一个字：低8位是token类型，TOKEN_HAS_FILE表示属于当前源文件（否则是默认构造的token）
+constexpr uint32_t TOKEN_HAS_FILE = 1u << 8;
+
+// 字面量文本的存放方式
+constexpr uint32_t TEXT_TOKEN_VALUE = 0;  // 与token的值相同，不再保存
+constexpr uint32_t TEXT_IN_SOURCE = 1;    // 后跟源代码中的偏移和长度
+constexpr uint32_t TEXT_INLINE = 2;       // 后跟长度和按4字节补齐的内容
+
+// 按8字节分组的哈希，只用于区分缓存项，不需要抗碰撞攻击
+uint64_t hashBytes(std::string_view data, uint64_t seed) {
+    constexpr uint64_t MULTIPLIER = 0x9E3779B97F4A7C15ULL;
+    uint64_t hash = seed ^ (static_cast<uint64_t>(data.size()) * MULTIPLIER);
+    const char* p = data.data();
+    size_t remaining = data.size();
+    while (remaining >= 8) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        hash = (hash ^ word) * MULTIPLIER;
+        hash ^= hash >> 29;
+        p += 8;
+        remaining -= 8;
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, p, remaining);
+    hash = (hash ^ tail) * MULTIPLIER;
+
+    // 最后再充分混合一次
+    hash ^= hash >> 32;
+    hash *= 0xD6E8FEB86659FD93ULL;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+// 把节点逐个编码为记录
+class RecordWriter {
+public:
+    RecordWriter(std::string_view source, FileId file, std::vector<uint32_t>& words)
+        : source_(source), file_(file), words_(words) {}
+
+    // 有无法编码的节点（不属于当前文件的token、列表中的空指针）
+    bool failed() const { return failed_; }
+
+    void write(const Expr* expr) {
+        switch (expr->getType()) {
+            case ExprType::LITERAL: {
+                auto* literal = static_cast<const LiteralExpr*>(expr);
+                tag(expr, 0);
+                token(literal->token);
+                text(literal->value, literal->token);
+                break;
+            }
+            case ExprType::VARIABLE:
+                tag(expr, 0);
+                token(static_cast<const VariableExpr*>(expr)->name);
+                break;
+            case ExprType::UNARY: {
+                auto* unary = static_cast<const UnaryExpr*>(expr);
+                tag(expr, child(unary->right, 0));
+                token(unary->op);
+                break;
+            }
+            case ExprType::BINARY: {
+                auto* binary = static_cast<const BinaryExpr*>(expr);
+                tag(expr, child(binary->left, 0) | child(binary->right, 1));
+                token(binary->op);
+                break;
+            }
+            case ExprType::CALL: {
+                auto* call = static_cast<const CallExpr*>(expr);
+                tag(expr, child(call->callee, 0));
+                token(call->paren);
+                list(call->arguments);
+                break;
+            }
+            case ExprType::ARRAY_ACCESS: {
+                auto* access = static_cast<const ArrayAccessExpr*>(expr);
+                tag(expr, child(access->array, 0) | child(access->index, 1));
+                token(access->bracket);
+                break;
+            }
+            case ExprType::RECORD_ACCESS: {
+                auto* access = static_cast<const RecordAccessExpr*>(expr);
+                tag(expr, child(access->record, 0));
+                token(access->field);
+                break;
+            }
+            case ExprType::ASSIGNMENT: {
+                auto* assignment = static_cast<const AssignmentExpr*>(expr);
+                tag(expr, child(assignment->target, 0) | child(assignment->value, 1));
+                token(assignment->op);
+                break;
+            }
+            case ExprType::ERROR:
+                tag(expr, 0);
+                token(static_cast<const ErrorExpr*>(expr)->token);
+                break;
+        }
+    }
+
+    void write(const Stmt* stmt) {
+        switch (stmt->getType()) {
+            case StmtType::EXPRESSION:
+                tag(stmt, child(static_cast<const ExpressionStmt*>(stmt)->expression, 0));
+                break;
+            case StmtType::IMPORT: {
+                auto* import = static_cast<const ImportStmt*>(stmt);
+                tag(stmt, 0);
+                token(import->module);
+                token(import->alias);
+                break;
+            }
+            case StmtType::DAKAI:
+                tag(stmt, child(static_cast<const DakaiStmt*>(stmt)->path, 0));
+                break;
+            case StmtType::SET: {
+                auto* set = static_cast<const SetStmt*>(stmt);
+                tag(stmt, child(set->value, 0));
+                token(set->name);
+                token(set->type);
+                break;
+            }
+            case StmtType::PRINT:
+                tag(stmt, child(static_cast<const PrintStmt*>(stmt)->value, 0));
+                break;
+            case StmtType::IF: {
+                const NodeList<Branch>& branches = static_cast<const IfStmt*>(stmt)->branches;
+                tag(stmt, 0);
+                word(static_cast<uint32_t>(branches.size()));
+                for (const Branch& branch : branches) {
+                    word(branch.condition != nullptr ? 1 : 0);
+                    list(branch.body);
+                }
+                break;
+            }
+            case StmtType::LOOP: {
+                auto* loop = static_cast<const LoopStmt*>(stmt);
+                tag(stmt, child(loop->count, 0));
+                token(loop->variable);
+                list(loop->body);
+                break;
+            }
+            case StmtType::DEFINE: {
+                auto* define = static_cast<const DefineStmt*>(stmt);
+                tag(stmt, 0);
+                token(define->name);
+                tokens(define->parameters);
+                list(define->body);
+                break;
+            }
+            case StmtType::RETURN: {
+                auto* ret = static_cast<const ReturnStmt*>(stmt);
+                tag(stmt, child(ret->value, 0));
+                token(ret->keyword);
+                break;
+            }
+            case StmtType::ARRAY: {
+                auto* array = static_cast<const ArrayStmt*>(stmt);
+                tag(stmt, 0);
+                token(array->name);
+                token(array->elementType);
+                list(array->elements);
+                break;
+            }
+            case StmtType::RECORD_DEF: {
+                auto* record = static_cast<const RecordDefStmt*>(stmt);
+                tag(stmt, 0);
+                token(record->name);
+                word(static_cast<uint32_t>(record->fields.size()));
+                for (const FieldDefinition& field : record->fields) {
+                    token(field.name);
+                    token(field.type);
+                }
+                break;
+            }
+            case StmtType::RECORD_ACCESS: {
+                auto* access = static_cast<const RecordAccessStmt*>(stmt);
+                tag(stmt, child(access->value, 0));
+                token(access->record);
+                token(access->field);
+                break;
+            }
+            case StmtType::TRY_CATCH: {
+                auto* tryCatch = static_cast<const TryCatchStmt*>(stmt);
+                tag(stmt, 0);
+                list(tryCatch->tryBlock);
+                list(tryCatch->catchBlock);
+                break;
+            }
+            case StmtType::ENUM_DEF: {
+                auto* enumDef = static_cast<const EnumDefStmt*>(stmt);
+                tag(stmt, 0);
+                token(enumDef->name);
+                tokens(enumDef->values);
+                break;
+            }
+            case StmtType::BLOCK:
+                tag(stmt, 0);
+                list(static_cast<const BlockStmt*>(stmt)->statements);
+                break;
+            case StmtType::ERROR:
+                tag(stmt, 0);
+                token(static_cast<const ErrorStmt*>(stmt)->token);
+                break;
+        }
+    }
+
+private:
+    void word(uint32_t value) {
+        words_.push_back(value);
+    }
+
+    void tag(const Expr* expr, uint32_t children) {
+        word(static_cast<uint32_t>(expr->getType()) | children);
+    }
+
+    void tag(const Stmt* stmt, uint32_t children) {
+        word(static_cast<uint32_t>(stmt->getType()) | STMT_TAG | children);
+    }
+
+    template <typename Node>
+    static uint32_t child(const Node* node, int slot) {
+        return node != nullptr ? childBit(slot) : 0;
+    }
+
+    void token(const Token& token) {
+        if (token.getFile() != INVALID_FILE_ID && token.getFile() != file_) {
+            failed_ = true;
+        }
+        word(static_cast<uint32_t>(token.getType()) |
+             (token.getFile() != INVALID_FILE_ID ? TOKEN_HAS_FILE : 0));
+        word(token.getOffset());
+        word(token.getLength());
+    }
+
+    void tokens(const NodeList<Token>& list) {
+        word(static_cast<uint32_t>(list.size()));
+        for (const Token& item : list) {
+            token(item);
+        }
+    }
+
+    // 子节点列表只记录长度，子节点本身是单独的记录
+    // 遍历器会跳过空指针，列表中有空指针时长度就对不上了
+    template <typename Node>
+    void list(const NodeList<Node*>& nodes) {
+        word(static_cast<uint32_t>(nodes.size()));
+        for (const Node* node : nodes) {
+            if (node == nullptr) {
+                failed_ = true;
+            }
+        }
+    }
+
+    void text(std::string_view value, const Token& token) {
+        std::string_view tokenValue = token.getValue();
+        if (value.data() == tokenValue.data() && value.size() == tokenValue.size()) {
+            word(TEXT_TOKEN_VALUE);
+            return;
+        }
+
+        const char* begin = source_.data();
+        if (value.data() != nullptr && value.data() >= begin &&
+            value.data() + value.size() <= begin + source_.size()) {
+            word(TEXT_IN_SOURCE);
+            word(static_cast<uint32_t>(value.data() - begin));
+            word(static_cast<uint32_t>(value.size()));
+            return;
+        }
+
+        word(TEXT_INLINE);
+        word(static_cast<uint32_t>(value.size()));
+        size_t first = words_.size();
+        words_.resize(first + (value.size() + 3) / 4, 0);
+        if (!value.empty()) {
+            std::memcpy(words_.data() + first, value.data(), value.size());
+        }
+    }
+
+    std::string_view source_;
+    FileId file_;
+    std::vector<uint32_t>& words_;
+    bool failed_ = false;
+};
+
+// 从映射的缓存文件中读出记录并在arena中重建节点
+// 任何不一致（越界、类型非法、子节点不够）都使读取失败，不会访问缓存文件以外的内存
+class RecordReader {
+public:
+    RecordReader(const char* data, size_t size, std::string_view source, FileId file, Arena& arena)
+        : p_(data), end_(data + size), source_(source), file_(file), arena_(arena) {}
+
+    bool read(uint32_t recordCount, uint32_t statementCount, NodeList<Stmt*>& statements) {
+        for (uint32_t i = 0; i < recordCount && !failed_; i++) {
+            uint32_t tag = word();
+            uint32_t type = tag & TYPE_MASK;
+            if (tag & STMT_TAG) {
+                readStmt(type, tag);
+            } else {
+                readExpr(type, tag);
+            }
+        }
+
+        // 记录必须恰好用完，栈中剩下的是全部顶层语句
+        if (failed_ || p_ != end_ || stack_.size() != statementCount) {
+            return false;
+        }
+        statements = popStatements(statementCount);
+        return !failed_;
+    }
+
+private:
+    // 栈中的一项，stmt和expr恰有一个不为空
+    struct Entry {
+        Stmt* stmt;
+        Expr* expr;
+    };
+
+    uint32_t word() {
+        if (end_ - p_ < 4) {
+            failed_ = true;
+            return 0;
+        }
+        uint32_t value;
+        std::memcpy(&value, p_, 4);
+        p_ += 4;
+        return value;
+    }
+
+    Token token() {
+        uint32_t kind = word();
+        uint32_t offset = word();
+        uint32_t length = word();
+        uint32_t type = kind & TYPE_MASK;
+        if (type > static_cast<uint32_t>(TokenType::RIGHT_BRACKET) ||
+            static_cast<uint64_t>(offset) + length > source_.size()) {
+            failed_ = true;
+            return Token();
+        }
+        if (!(kind & TOKEN_HAS_FILE)) {
+            // 不属于文件的token只能是默认构造的
+            if (offset != 0 || length != 0) {
+                failed_ = true;
+            }
+            return Token();
+        }
+        // 缓存中不保存符号编号（编号只在本进程内有效），标识符重新登记
+        Symbol symbol = INVALID_SYMBOL;
+        if (static_cast<TokenType>(type) == TokenType::IDENTIFIER) {
+            symbol = symbols_.intern(source_.substr(offset, length));
+        }
+        return Token(static_cast<TokenType>(type), file_, offset, length, symbol);
+    }
+
+    NodeList<Token> tokens() {
+        uint32_t count = word();
+        if (count > static_cast<size_t>(end_ - p_) / 12) {
+            failed_ = true;
+            return NodeList<Token>();
+        }
+        tokenScratch_.clear();
+        for (uint32_t i = 0; i < count; i++) {
+            tokenScratch_.push_back(token());
+        }
+        return arena_.copyList(tokenScratch_.data(), tokenScratch_.size());
+    }
+
+    // 读出字面量的文本，与token的值相同时value保持构造时取得的值
+    void text(std::string_view& value) {
+        uint32_t kind = word();
+        if (kind == TEXT_TOKEN_VALUE) {
+            return;
+        }
+
+        uint32_t first = word();
+        if (kind == TEXT_IN_SOURCE) {
+            uint32_t length = word();
+            if (static_cast<uint64_t>(first) + length > source_.size()) {
+                failed_ = true;
+                return;
+            }
+            value = source_.substr(first, length);
+            return;
+        }
+
+        // 内嵌的文本复制到arena中，缓存文件的映射在加载后就解除了
+        size_t padded = (static_cast<size_t>(first) + 3) / 4 * 4;
+        if (kind != TEXT_INLINE || padded > static_cast<size_t>(end_ - p_)) {
+            failed_ = true;
+            return;
+        }
+        value = arena_.copyString(std::string_view(p_, first));
+        p_ += padded;
+    }
+
+    void push(Stmt* stmt) {
+        stack_.push_back(Entry{stmt, nullptr});
+    }
+
+    void push(Expr* expr) {
+        stack_.push_back(Entry{nullptr, expr});
+    }
+
+    Expr* popExpr() {
+        if (stack_.empty() || stack_.back().expr == nullptr) {
+            failed_ = true;
+            return nullptr;
+        }
+        Expr* expr = stack_.back().expr;
+        stack_.pop_back();
+        return expr;
+    }
+
+    Stmt* popStmt() {
+        if (stack_.empty() || stack_.back().stmt == nullptr) {
+            failed_ = true;
+            return nullptr;
+        }
+        Stmt* stmt = stack_.back().stmt;
+        stack_.pop_back();
+        return stmt;
+    }
+
+    // 弹出第slot个可选的子节点，不存在时为空指针
+    Expr* popChild(uint32_t tag, int slot) {
+        return (tag & childBit(slot)) ? popExpr() : nullptr;
+    }
+
+    NodeList<Stmt*> popStatements(uint32_t count) {
+        if (count > stack_.size()) {
+            failed_ = true;
+            return NodeList<Stmt*>();
+        }
+        stmtScratch_.clear();
+        for (uint32_t i = 0; i < count; i++) {
+            stmtScratch_.push_back(popStmt());
+        }
+        return arena_.copyList(stmtScratch_.data(), stmtScratch_.size());
+    }
+
+    NodeList<Expr*> popExpressions(uint32_t count) {
+        if (count > stack_.size()) {
+            failed_ = true;
+            return NodeList<Expr*>();
+        }
+        exprScratch_.clear();
+        for (uint32_t i = 0; i < count; i++) {
+            exprScratch_.push_back(popExpr());
+        }
+        return arena_.copyList(exprScratch_.data(), exprScratch_.size());
+    }
+
+    void readExpr(uint32_t type, uint32_t tag) {
+        Expr* expr = nullptr;
+        switch (static_cast<ExprType>(type)) {
+            case ExprType::LITERAL: {
+                Token literalToken = token();
+                auto* literal = arena_.make<LiteralExpr>(literalToken);
+                text(literal->value);
+                expr = literal;
+                break;
+            }
+            case ExprType::VARIABLE:
+                expr = arena_.make<VariableExpr>(token());
+                break;
+            case ExprType::UNARY: {
+                Token op = token();
+                expr = arena_.make<UnaryExpr>(op, popChild(tag, 0));
+                break;
+            }
+            case ExprType::BINARY: {
+                Token op = token();
+                Expr* left = popChild(tag, 0);
+                Expr* right = popChild(tag, 1);
+                expr = arena_.make<BinaryExpr>(left, op, right);
+                break;
+            }
+            case ExprType::CALL: {
+                Token paren = token();
+                uint32_t count = word();
+                Expr* callee = popChild(tag, 0);
+                expr = arena_.make<CallExpr>(callee, paren, popExpressions(count));
+                break;
+            }
+            case ExprType::ARRAY_ACCESS: {
+                Token bracket = token();
+                Expr* array = popChild(tag, 0);
+                Expr* index = popChild(tag, 1);
+                expr = arena_.make<ArrayAccessExpr>(array, index, bracket);
+                break;
+            }
+            case ExprType::RECORD_ACCESS: {
+                Token field = token();
+                expr = arena_.make<RecordAccessExpr>(popChild(tag, 0), field);
+                break;
+            }
+            case ExprType::ASSIGNMENT: {
+                Token op = token();
+                Expr* target = popChild(tag, 0);
+                Expr* value = popChild(tag, 1);
+                expr = arena_.make<AssignmentExpr>(target, op, value);
+                break;
+            }
+            case ExprType::ERROR:
+                expr = arena_.make<ErrorExpr>(token());
+                break;
+            default:
+                failed_ = true;
+                return;
+        }
+        push(expr);
+    }
+
+    void readStmt(uint32_t type, uint32_t tag) {
+        Stmt* stmt = nullptr;
+        switch (static_cast<StmtType>(type)) {
+            case StmtType::EXPRESSION:
+                stmt = arena_.make<ExpressionStmt>(popChild(tag, 0));
+                break;
+            case StmtType::IMPORT: {
+                Token module = token();
+                Token alias = token();
+                stmt = arena_.make<ImportStmt>(module, alias);
+                break;
+            }
+            case StmtType::DAKAI:
+                stmt = arena_.make<DakaiStmt>(popChild(tag, 0));
+                break;
+            case StmtType::SET: {
+                Token name = token();
+                Token valueType = token();
+                stmt = arena_.make<SetStmt>(name, popChild(tag, 0), valueType);
+                break;
+            }
+            case StmtType::PRINT:
+                stmt = arena_.make<PrintStmt>(popChild(tag, 0));
+                break;
+            case StmtType::IF: {
+                uint32_t count = word();
+                if (count > static_cast<size_t>(end_ - p_) / 8) {
+                    failed_ = true;
+                    return;
+                }
+                std::vector<Branch> branches;
+                branches.reserve(count);
+                for (uint32_t i = 0; i < count && !failed_; i++) {
+                    bool hasCondition = word() != 0;
+                    uint32_t bodyCount = word();
+                    Expr* condition = hasCondition ? popExpr() : nullptr;
+                    branches.emplace_back(condition, popStatements(bodyCount));
+                }
+                stmt = arena_.make<IfStmt>(arena_.copyList(branches.data(), branches.size()));
+                break;
+            }
+            case StmtType::LOOP: {
+                Token variable = token();
+                uint32_t bodyCount = word();
+                Expr* count = popChild(tag, 0);
+                stmt = arena_.make<LoopStmt>(variable, count, popStatements(bodyCount));
+                break;
+            }
+            case StmtType::DEFINE: {
+                Token name = token();
+                NodeList<Token> parameters = tokens();
+                uint32_t bodyCount = word();
+                stmt = arena_.make<DefineStmt>(name, parameters, popStatements(bodyCount));
+                break;
+            }
+            case StmtType::RETURN: {
+                Token keyword = token();
+                stmt = arena_.make<ReturnStmt>(keyword, popChild(tag, 0));
+                break;
+            }
+            case StmtType::ARRAY: {
+                Token name = token();
+                Token elementType = token();
+                uint32_t count = word();
+                stmt = arena_.make<ArrayStmt>(name, elementType, popExpressions(count));
+                break;
+            }
+            case StmtType::RECORD_DEF: {
+                Token name = token();
+                uint32_t count = word();
+                if (count > static_cast<size_t>(end_ - p_) / 24) {
+                    failed_ = true;
+                    return;
+                }
+                std::vector<FieldDefinition> fields;
+                fields.reserve(count);
+                for (uint32_t i = 0; i < count; i++) {
+                    Token fieldName = token();
+                    Token fieldType = token();
+                    fields.emplace_back(fieldName, fieldType);
+                }
+                stmt = arena_.make<RecordDefStmt>(name, arena_.copyList(fields.data(), fields.size()));
+                break;
+            }
+            case StmtType::RECORD_ACCESS: {
+                Token record = token();
+                Token field = token();
+                stmt = arena_.make<RecordAccessStmt>(record, field, popChild(tag, 0));
+                break;
+            }
+            case StmtType::TRY_CATCH: {
+                uint32_t tryCount = word();
+                uint32_t catchCount = word();
+                NodeList<Stmt*> tryBlock = popStatements(tryCount);
+                NodeList<Stmt*> catchBlock = popStatements(catchCount);
+                stmt = arena_.make<TryCatchStmt>(tryBlock, catchBlock);
+                break;
+            }
+            case StmtType::ENUM_DEF: {
+                Token name = token();
+                stmt = arena_.make<EnumDefStmt>(name, tokens());
+                break;
+            }
+            case StmtType::BLOCK:
+                stmt = arena_.make<BlockStmt>(popStatements(word()));
+                break;
+            case StmtType::ERROR:
+                stmt = arena_.make<ErrorStmt>(token());
+                break;
+            default:
+                failed_ = true;
+                return;
+        }
+        push(stmt);
+    }
+
+    const char* p_;
+    const char* end_;
+    std::string_view source_;
+    FileId file_;
+    Arena& arena_;
+    bool failed_ = false;
+    SymbolCache symbols_;
+
+    std::vector<Entry> stack_;
+    std::vector<Stmt*> stmtScratch_;
+    std::vector<Expr*> exprScratch_;
+    std::vector<Token> tokenScratch_;
+};
+
+// 十六进制的缓存文件名
+std::string hexName(uint64_t hash) {
+    static const char DIGITS[] = "0123456789abcdef";
+    std::string name(16, '0');
+    for (int i = 15; i >= 0; i--) {
+        name[i] = DIGITS[hash & 0xF];
+        hash >>= 4;
+    }
+    return name + ASTCache::FILE_EXTENSION;
+}
+
+// 临时文件名带上时间和线程，同时写同一个文件的进程不会互相覆盖
+std::string temporaryPath(const std::string& path) {
+    uint64_t unique = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()) ^
+                      std::hash<std::thread::id>()(std::this_thread::get_id());
+    return path + ".tmp" + std::to_string(unique);
+}
+
+} // namespace
+
+// 构造函数
+ASTCache::ASTCache(const std::string& directory, const std::string& configuration)
+    : directory_(directory),
+      configurationHash_(hashBytes(configuration, FORMAT_VERSION)) {
+}
+
+// 计算缓存项
+ASTCache::Key ASTCache::makeKey(std::string_view source) const {
+    Key key;
+    key.hash = hashBytes(source, configurationHash_);
+    key.path = (std::filesystem::path(directory_) / hexName(key.hash)).string();
+    return key;
+}
+
+// 查找缓存
+bool ASTCache::load(const Key& key, std::string_view source, FileId file, Program& program) const {
+    lastFileSize_ = 0;
+
+    std::error_code exists;
+    if (!std::filesystem::is_regular_file(key.path, exists)) {
+        return false;
+    }
+
+    std::string error;
+    auto buffer = SourceBuffer::fromFile(key.path, error);
+    if (!buffer) {
+        return false;
+    }
+    std::string_view data = buffer->getText();
+
+    Header header;
+    if (data.size() < sizeof(Header)) {
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(Header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        header.byteOrder != BYTE_ORDER_MARK ||
+        header.formatVersion != FORMAT_VERSION ||
+        header.configurationHash != configurationHash_ ||
+        header.sourceHash != key.hash ||
+        header.sourceSize != source.size() ||
+        header.bodyWords != (data.size() - sizeof(Header)) / 4 ||
+        (data.size() - sizeof(Header)) % 4 != 0) {
+        return false;
+    }
+
+    RecordReader reader(data.data() + sizeof(Header), data.size() - sizeof(Header), source, file, program.arena);
+    if (!reader.read(header.recordCount, header.statementCount, program.statements)) {
+        program.arena.reset();
+        program.statements = NodeList<Stmt*>();
+        return false;
+    }
+
+    lastFileSize_ = data.size();
+    return true;
+}
+
+// 保存语法树
+bool ASTCache::store(const Key& key, std::string_view source, FileId file, const Program& program,
+                     std::string& error) const {
+    lastFileSize_ = 0;
+
+    // 按前序编码每个节点，再把记录逆序写出，使子节点排在父节点之前
+    std::vector<uint32_t> words;
+    std::vector<size_t> recordStarts;
+    RecordWriter writer(source, file, words);
+    NodeWalker().walk(program.statements,
+                      [&](Stmt* stmt) { recordStarts.push_back(words.size()); writer.write(stmt); },
+                      [&](Expr* expr) { recordStarts.push_back(words.size()); writer.write(expr); });
+    if (writer.failed()) {
+        error = "语法树中有无法缓存的节点";
+        return false;
+    }
+
+    Header header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.formatVersion = FORMAT_VERSION;
+    header.configurationHash = configurationHash_;
+    header.sourceHash = key.hash;
+    header.sourceSize = source.size();
+    header.statementCount = static_cast<uint32_t>(program.statements.size());
+    header.recordCount = static_cast<uint32_t>(recordStarts.size());
+    header.bodyWords = words.size();
+
+    std::vector<uint32_t> body;
+    body.reserve(words.size());
+    for (size_t i = recordStarts.size(); i-- > 0;) {
+        size_t end = i + 1 < recordStarts.size() ? recordStarts[i + 1] : words.size();
+        body.insert(body.end(), words.begin() + recordStarts[i], words.begin() + end);
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+    if (ec) {
+        error = "无法创建缓存目录: " + ec.message();
+        return false;
+    }
+
+    std::string temporary = temporaryPath(key.path);
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        out.write(reinterpret_cast<const char*>(body.data()),
+                  static_cast<std::streamsize>(body.size() * sizeof(uint32_t)));
+        if (!out) {
+            error = "无法写入缓存文件: " + temporary;
+            out.close();
+            std::filesystem::remove(temporary, ec);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temporary, key.path, ec);
+    if (ec) {
+        error = "无法写入缓存文件: " + ec.message();
+        std::filesystem::remove(temporary, ec);
+        return false;
+    }
+
+    lastFileSize_ = sizeof(Header) + body.size() * sizeof(uint32_t);
+    return true;
+}
+
+// 记录一次查找的结果
+ASTCache::Statistics ASTCache::recordLookup(bool hit) const {
+    std::string path = (std::filesystem::path(directory_) / STATISTICS_FILE).string();
+    Statistics statistics;
+    {
+        std::ifstream in(path);
+        if (!(in >> statistics.hits >> statistics.misses)) {
+            statistics = Statistics();
+        }
+    }
+    if (hit) {
+        statistics.hits++;
+    } else {
+        statistics.misses++;
+    }
+
+    // 写入失败时只是统计不再累加，不影响编译
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+    if (ec) {
+        return statistics;
+    }
+    std::string temporary = temporaryPath(path);
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        out << statistics.hits << ' ' << statistics.misses << '\n';
+        if (!out) {
+            out.close();
+            std::filesystem::remove(temporary, ec);
+            return statistics;
+        }
+    }
+    std::filesystem::rename(temporary, path, ec);
+    if (ec) {
+        std::filesystem::remove(temporary, ec);
+    }
+    return statistics;
+}
+
+} // namespace jvav
@@ -0,0 +1,72 @@
+#include "ast/ASTCloner.h"
+
+namespace jvav {
+
+// 登记替换
+void ASTCloner::substitute(Symbol symbol, const Expr* replacement) {
+    for (auto& substitution : substitutions_) {
+        if (substitution.first == symbol) {
+            substitution.second = replacement;
+            return;
+        }
+    }
+    substitutions_.emplace_back(symbol, replacement);
+}
+
+// 复制表达式
+Expr* ASTCloner::clone(const Expr* expr) {
+    Expr* root = const_cast<Expr*>(expr);
+    substituting_ = true;
+    push(&root);
+    run();
+    return root;
+}
+
+// 复制语句
+Stmt* ASTCloner::clone(const Stmt* stmt) {
+    Stmt* root = const_cast<Stmt*>(stmt);
+    substituting_ = true;
+    push(&root);
+    run();
+    return root;
+}
+
+// 复制语句列表
+NodeList<Stmt*> ASTCloner::clone(const NodeList<Stmt*>& statements) {
+    NodeList<Stmt*> result = statements;
+    substituting_ = true;
+    pushList(result);
+    run();
+    return result;
+}
+
+// 逐个把副本中指向原树的位置换成副本
+void ASTCloner::run() {
+    while (!pending_.empty()) {
+        Pending pending = pending_.back();
+        pending_.pop_back();
+        substituting_ = pending.substitute;
+
+        if (pending.stmtSlot != nullptr) {
+            visitStmt(static_cast<const Stmt*>(*pending.stmtSlot));
+            *pending.stmtSlot = stmtResult_;
+            continue;
+        }
+
+        const Expr* original = *pending.exprSlot;
+        if (substituting_ && original->getType() == ExprType::VARIABLE) {
+            Symbol symbol = static_cast<const VariableExpr*>(original)->name.getSymbol();
+            for (const auto& substitution : substitutions_) {
+                if (substitution.first == symbol) {
+                    original = substitution.second;
+                    substituting_ = false;
+                    break;
+                }
+            }
+        }
+        visitExpr(original);
+        *pending.exprSlot = exprResult_;
+    }
+}
+
+} // namespace jvav
@@ -0,0 +1,75 @@
+#include "ast/Arena.h"
+#include <cstdlib>
+
+namespace jvav {
+
+// 析构函数：释放所有块
+Arena::~Arena() {
+    reset();
+}
+
+// 释放全部内存
+void Arena::reset() {
+    Slab* slab = slabs_;
+    while (slab != nullptr) {
+        Slab* next = slab->next;
+        std::free(slab);
+        slab = next;
+    }
+
+    slabs_ = nullptr;
+    ptr_ = nullptr;
+    end_ = nullptr;
+    bytesReserved_ = 0;
+}
+
+// 接管另一个arena的全部块
+void Arena::absorb(Arena& other) {
+    if (other.slabs_ == nullptr) {
+        return;
+    }
+    
+    // 把other的块链表接在本arena的链表前面，当前分配位置不变
+    Slab* last = other.slabs_;
+    while (last->next != nullptr) {
+        last = last->next;
+    }
+    last->next = slabs_;
+    slabs_ = other.slabs_;
+    bytesReserved_ += other.bytesReserved_;
+    
+    other.slabs_ = nullptr;
+    other.ptr_ = nullptr;
+    other.end_ = nullptr;
+    other.bytesReserved_ = 0;
+}
+
+// 当前块放不下时申请新块
+void* Arena::allocateSlow(size_t size, size_t alignment) {
+    // 超大的对象单独占一块，对齐所需的额外空间也算在内
+    size_t dataSize = slabSize_;
+    if (size + alignment > dataSize) {
+        dataSize = size + alignment;
+    }
+
+    // 块头之后的数据按max_align_t对齐
+    constexpr size_t headerSize = (sizeof(Slab) + alignof(std::max_align_t) - 1) &
+                                  ~(alignof(std::max_align_t) - 1);
+    void* memory = std::malloc(headerSize + dataSize);
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    Slab* slab = static_cast<Slab*>(memory);
+    slab->next = slabs_;
+    slab->size = dataSize;
+    slabs_ = slab;
+    bytesReserved_ += headerSize + dataSize;
+
+    ptr_ = static_cast<char*>(memory) + headerSize;
+    end_ = ptr_ + dataSize;
+
+    return allocate(size, alignment);
+}
+
+} // namespace jvav
@@ -0,0 +1,421 @@
+#include "ast/FlatAST.h"
+#include "ast/NodeWalker.h"
+
+namespace jvav {
+
+namespace {
+
+template <typename Node>
+size_t present(const Node* node) {
+    return node != nullptr ? 1 : 0;
+}
+
+// 节点的非空子节点个数，与NodeWalker压入的子节点一致
+size_t childCount(const Expr* expr) {
+    switch (expr->getType()) {
+        case ExprType::UNARY:
+            return present(static_cast<const UnaryExpr*>(expr)->right);
+        case ExprType::BINARY: {
+            auto* binary = static_cast<const BinaryExpr*>(expr);
+            return present(binary->left) + present(binary->right);
+        }
+        case ExprType::CALL: {
+            auto* call = static_cast<const CallExpr*>(expr);
+            size_t count = present(call->callee);
+            for (const Expr* argument : call->arguments) {
+                count += present(argument);
+            }
+            return count;
+        }
+        case ExprType::ARRAY_ACCESS: {
+            auto* access = static_cast<const ArrayAccessExpr*>(expr);
+            return present(access->array) + present(access->index);
+        }
+        case ExprType::RECORD_ACCESS:
+            return present(static_cast<const RecordAccessExpr*>(expr)->record);
+        case ExprType::ASSIGNMENT: {
+            auto* assignment = static_cast<const AssignmentExpr*>(expr);
+            return present(assignment->target) + present(assignment->value);
+        }
+        case ExprType::LITERAL:
+        case ExprType::VARIABLE:
+        case ExprType::ERROR:
+            break;
+    }
+    return 0;
+}
+
+size_t countStatements(const NodeList<Stmt*>& statements) {
+    size_t count = 0;
+    for (const Stmt* stmt : statements) {
+        count += present(stmt);
+    }
+    return count;
+}
+
+size_t childCount(const Stmt* stmt) {
+    switch (stmt->getType()) {
+        case StmtType::EXPRESSION:
+            return present(static_cast<const ExpressionStmt*>(stmt)->expression);
+        case StmtType::DAKAI:
+            return present(static_cast<const DakaiStmt*>(stmt)->path);
+        case StmtType::SET:
+            return present(static_cast<const SetStmt*>(stmt)->value);
+        case StmtType::PRINT:
+            return present(static_cast<const PrintStmt*>(stmt)->value);
+        case StmtType::IF: {
+            size_t count = 0;
+            for (const Branch& branch : static_cast<const IfStmt*>(stmt)->branches) {
+                count += present(branch.condition) + countStatements(branch.body);
+            }
+            return count;
+        }
+        case StmtType::LOOP: {
+            auto* loop = static_cast<const LoopStmt*>(stmt);
+            return present(loop->count) + countStatements(loop->body);
+        }
+        case StmtType::DEFINE:
+            return countStatements(static_cast<const DefineStmt*>(stmt)->body);
+        case StmtType::RETURN:
+            return present(static_cast<const ReturnStmt*>(stmt)->value);
+        case StmtType::ARRAY: {
+            size_t count = 0;
+            for (const Expr* element : static_cast<const ArrayStmt*>(stmt)->elements) {
+                count += present(element);
+            }
+            return count;
+        }
+        case StmtType::RECORD_ACCESS:
+            return present(static_cast<const RecordAccessStmt*>(stmt)->value);
+        case StmtType::TRY_CATCH: {
+            auto* tryCatch = static_cast<const TryCatchStmt*>(stmt);
+            return countStatements(tryCatch->tryBlock) + countStatements(tryCatch->catchBlock);
+        }
+        case StmtType::BLOCK:
+            return countStatements(static_cast<const BlockStmt*>(stmt)->statements);
+        case StmtType::IMPORT:
+        case StmtType::RECORD_DEF:
+        case StmtType::ENUM_DEF:
+        case StmtType::ERROR:
+            break;
+    }
+    return 0;
+}
+
+} // namespace
+
+// 一个节点已经转换好的子节点，按源代码顺序依次取出
+// 析构时把它们从results_中移除
+class FlatBuilder::Children {
+public:
+    Children(FlatBuilder& builder, size_t count)
+        : builder_(builder), first_(builder.results_.size() - count), next_(first_) {}
+
+    ~Children() {
+        builder_.results_.resize(first_);
+    }
+
+    // 取出下一个子节点，指针为空时是INVALID_INDEX
+    template <typename Node>
+    NodeIndex next(const Node* node) {
+        return node != nullptr ? builder_.results_[next_++] : INVALID_INDEX;
+    }
+
+    // 取出一个子节点列表，追加到extra中
+    template <typename Node>
+    uint32_t list(const NodeList<Node*>& nodes) {
+        std::vector<uint32_t>& items = builder_.scratch_;
+        items.clear();
+        for (const Node* node : nodes) {
+            items.push_back(next(node));
+        }
+        return builder_.addList(items.data(), items.size());
+    }
+
+private:
+    FlatBuilder& builder_;
+    size_t first_;
+    size_t next_;
+};
+
+// 各数组占用的总字节数
+size_t FlatTree::bytesUsed() const {
+    return kinds_.capacity() * sizeof(NodeKind) +
+           tokenTypes_.capacity() * sizeof(TokenType) +
+           data_.capacity() * sizeof(NodeData) +
+           extra_.capacity() * sizeof(uint32_t) +
+           names_.capacity() * sizeof(TextRange) +
+           literals_.capacity() * sizeof(TextRange) +
+           ownedText_.capacity();
+}
+
+// 记下源文件
+void FlatBuilder::setFile(FileId file) {
+    if (tree_.file_ == INVALID_FILE_ID && file != INVALID_FILE_ID) {
+        tree_.file_ = file;
+        tree_.source_ = FileTable::instance().getText(file);
+    }
+}
+
+// 追加节点
+NodeIndex FlatBuilder::addNode(NodeKind kind, const Token& token, uint32_t lhs, uint32_t rhs) {
+    setFile(token.getFile());
+    uint32_t offset = token.getFile() != INVALID_FILE_ID ? token.getOffset() : INVALID_INDEX;
+    tree_.kinds_.push_back(kind);
+    tree_.tokenTypes_.push_back(token.getType());
+    tree_.data_.push_back(FlatTree::NodeData{offset, lhs, rhs});
+    return static_cast<NodeIndex>(tree_.kinds_.size() - 1);
+}
+
+// 追加名字
+uint32_t FlatBuilder::addName(const Token& token) {
+    if (token.getFile() == INVALID_FILE_ID) {
+        return INVALID_INDEX;
+    }
+    setFile(token.getFile());
+    tree_.names_.push_back(FlatTree::TextRange{token.getOffset(), token.getLength()});
+    return static_cast<uint32_t>(tree_.names_.size() - 1);
+}
+
+// 追加字面量文本
+uint32_t FlatBuilder::addLiteral(std::string_view value) {
+    const char* source = tree_.source_.data();
+    FlatTree::TextRange range;
+    if (value.data() != nullptr && source != nullptr && value.data() >= source &&
+        value.data() + value.size() <= source + tree_.source_.size()) {
+        range = FlatTree::TextRange{static_cast<uint32_t>(value.data() - source),
+                                    static_cast<uint32_t>(value.size())};
+    } else {
+        range = FlatTree::TextRange{static_cast<uint32_t>(tree_.ownedText_.size()),
+                                    static_cast<uint32_t>(value.size()) | FlatTree::OWNED_TEXT};
+        tree_.ownedText_.append(value);
+    }
+    tree_.literals_.push_back(range);
+    return static_cast<uint32_t>(tree_.literals_.size() - 1);
+}
+
+// 在extra中追加若干个字
+uint32_t FlatBuilder::addExtra(std::initializer_list<uint32_t> words) {
+    uint32_t at = static_cast<uint32_t>(tree_.extra_.size());
+    tree_.extra_.insert(tree_.extra_.end(), words.begin(), words.end());
+    return at;
+}
+
+// 在extra中追加列表
+uint32_t FlatBuilder::addList(const uint32_t* items, size_t count) {
+    uint32_t at = static_cast<uint32_t>(tree_.extra_.size());
+    tree_.extra_.push_back(static_cast<uint32_t>(count));
+    tree_.extra_.insert(tree_.extra_.end(), items, items + count);
+    return at;
+}
+
+// 转换一条语句并记为顶层语句
+NodeIndex FlatBuilder::addRoot(const Stmt* stmt) {
+    Stmt* statements[] = {const_cast<Stmt*>(stmt)};
+    NodeWalker().walkPostorder(NodeList<Stmt*>(statements, 1),
+                               [this](Stmt* node) { convert(node); },
+                               [this](Expr* node) { convert(node); });
+    NodeIndex root = results_.back();
+    results_.pop_back();
+    roots_.push_back(root);
+    return root;
+}
+
+// 转换表达式
+void FlatBuilder::convert(const Expr* expr) {
+    NodeIndex node = INVALID_INDEX;
+    {
+        Children children(*this, childCount(expr));
+        switch (expr->getType()) {
+            case ExprType::LITERAL: {
+                auto* literal = static_cast<const LiteralExpr*>(expr);
+                node = addNode(NodeKind::LITERAL, literal->token, addLiteral(literal->value));
+                break;
+            }
+            case ExprType::VARIABLE: {
+                auto* variable = static_cast<const VariableExpr*>(expr);
+                node = addNode(NodeKind::VARIABLE, variable->name, addName(variable->name));
+                break;
+            }
+            case ExprType::UNARY: {
+                auto* unary = static_cast<const UnaryExpr*>(expr);
+                node = addNode(NodeKind::UNARY, unary->op, children.next(unary->right));
+                break;
+            }
+            case ExprType::BINARY: {
+                auto* binary = static_cast<const BinaryExpr*>(expr);
+                NodeIndex left = children.next(binary->left);
+                NodeIndex right = children.next(binary->right);
+                node = addNode(NodeKind::BINARY, binary->op, left, right);
+                break;
+            }
+            case ExprType::CALL: {
+                auto* call = static_cast<const CallExpr*>(expr);
+                NodeIndex callee = children.next(call->callee);
+                node = addNode(NodeKind::CALL, call->paren, callee, children.list(call->arguments));
+                break;
+            }
+            case ExprType::ARRAY_ACCESS: {
+                auto* access = static_cast<const ArrayAccessExpr*>(expr);
+                NodeIndex array = children.next(access->array);
+                NodeIndex index = children.next(access->index);
+                node = addNode(NodeKind::ARRAY_ACCESS, access->bracket, array, index);
+                break;
+            }
+            case ExprType::RECORD_ACCESS: {
+                auto* access = static_cast<const RecordAccessExpr*>(expr);
+                node = addNode(NodeKind::RECORD_ACCESS, access->field, children.next(access->record),
+                               addName(access->field));
+                break;
+            }
+            case ExprType::ASSIGNMENT: {
+                auto* assignment = static_cast<const AssignmentExpr*>(expr);
+                NodeIndex target = children.next(assignment->target);
+                NodeIndex value = children.next(assignment->value);
+                node = addNode(NodeKind::ASSIGNMENT, assignment->op, target, value);
+                break;
+            }
+            case ExprType::ERROR:
+                node = addNode(NodeKind::ERROR_EXPR, static_cast<const ErrorExpr*>(expr)->token);
+                break;
+        }
+    }
+    results_.push_back(node);
+}
+
+// 转换语句
+void FlatBuilder::convert(const Stmt* stmt) {
+    NodeIndex node = INVALID_INDEX;
+    {
+        Children children(*this, childCount(stmt));
+        switch (stmt->getType()) {
+            case StmtType::EXPRESSION:
+                node = addNode(NodeKind::EXPRESSION_STMT, Token(),
+                               children.next(static_cast<const ExpressionStmt*>(stmt)->expression));
+                break;
+            case StmtType::IMPORT: {
+                auto* import = static_cast<const ImportStmt*>(stmt);
+                node = addNode(NodeKind::IMPORT, import->module, addName(import->module), addName(import->alias));
+                break;
+            }
+            case StmtType::DAKAI:
+                node = addNode(NodeKind::DAKAI, Token(), children.next(static_cast<const DakaiStmt*>(stmt)->path));
+                break;
+            case StmtType::SET: {
+                auto* set = static_cast<const SetStmt*>(stmt);
+                NodeIndex value = children.next(set->value);
+                node = addNode(NodeKind::SET, set->name, value, addExtra({addName(set->name), addName(set->type)}));
+                break;
+            }
+            case StmtType::PRINT:
+                node = addNode(NodeKind::PRINT, Token(), children.next(static_cast<const PrintStmt*>(stmt)->value));
+                break;
+            case StmtType::IF: {
+                // 先取出各分支的条件和语句列表，再写成一段extra
+                const NodeList<Branch>& branches = static_cast<const IfStmt*>(stmt)->branches;
+                std::vector<uint32_t> words;
+                words.reserve(1 + branches.size() * 2);
+                words.push_back(static_cast<uint32_t>(branches.size()));
+                for (const Branch& branch : branches) {
+                    words.push_back(children.next(branch.condition));
+                    words.push_back(children.list(branch.body));
+                }
+                uint32_t at = static_cast<uint32_t>(tree_.extra_.size());
+                tree_.extra_.insert(tree_.extra_.end(), words.begin(), words.end());
+                node = addNode(NodeKind::IF, Token(), at);
+                break;
+            }
+            case StmtType::LOOP: {
+                auto* loop = static_cast<const LoopStmt*>(stmt);
+                NodeIndex count = children.next(loop->count);
+                uint32_t body = children.list(loop->body);
+                node = addNode(NodeKind::LOOP, loop->variable, count, addExtra({addName(loop->variable), body}));
+                break;
+            }
+            case StmtType::DEFINE: {
+                auto* define = static_cast<const DefineStmt*>(stmt);
+                uint32_t body = children.list(define->body);
+                scratch_.clear();
+                for (const Token& parameter : define->parameters) {
+                    scratch_.push_back(addName(parameter));
+                }
+                uint32_t parameters = addList(scratch_.data(), scratch_.size());
+                node = addNode(NodeKind::DEFINE, define->name, addName(define->name), addExtra({parameters, body}));
+                break;
+            }
+            case StmtType::RETURN: {
+                auto* ret = static_cast<const ReturnStmt*>(stmt);
+                node = addNode(NodeKind::RETURN, ret->keyword, children.next(ret->value));
+                break;
+            }
+            case StmtType::ARRAY: {
+                auto* array = static_cast<const ArrayStmt*>(stmt);
+                uint32_t elements = children.list(array->elements);
+                node = addNode(NodeKind::ARRAY, array->name,
+                               addExtra({addName(array->name), addName(array->elementType)}), elements);
+                break;
+            }
+            case StmtType::RECORD_DEF: {
+                auto* record = static_cast<const RecordDefStmt*>(stmt);
+                scratch_.clear();
+                for (const FieldDefinition& field : record->fields) {
+                    scratch_.push_back(addName(field.name));
+                    scratch_.push_back(addName(field.type));
+                }
+                uint32_t fields = addList(scratch_.data(), scratch_.size());
+                node = addNode(NodeKind::RECORD_DEF, record->name, addName(record->name), fields);
+                break;
+            }
+            case StmtType::RECORD_ACCESS: {
+                auto* access = static_cast<const RecordAccessStmt*>(stmt);
+                NodeIndex value = children.next(access->value);
+                node = addNode(NodeKind::RECORD_ACCESS_STMT, access->record, value,
+                               addExtra({addName(access->record), addName(access->field)}));
+                break;
+            }
+            case StmtType::TRY_CATCH: {
+                auto* tryCatch = static_cast<const TryCatchStmt*>(stmt);
+                uint32_t tryBlock = children.list(tryCatch->tryBlock);
+                uint32_t catchBlock = children.list(tryCatch->catchBlock);
+                node = addNode(NodeKind::TRY_CATCH, Token(), tryBlock, catchBlock);
+                break;
+            }
+            case StmtType::ENUM_DEF: {
+                auto* enumDef = static_cast<const EnumDefStmt*>(stmt);
+                scratch_.clear();
+                for (const Token& value : enumDef->values) {
+                    scratch_.push_back(addName(value));
+                }
+                uint32_t values = addList(scratch_.data(), scratch_.size());
+                node = addNode(NodeKind::ENUM_DEF, enumDef->name, addName(enumDef->name), values);
+                break;
+            }
+            case StmtType::BLOCK:
+                node = addNode(NodeKind::BLOCK, Token(), children.list(static_cast<const BlockStmt*>(stmt)->statements));
+                break;
+            case StmtType::ERROR:
+                node = addNode(NodeKind::ERROR_STMT, static_cast<const ErrorStmt*>(stmt)->token);
+                break;
+        }
+    }
+    results_.push_back(node);
+}
+
+// 完成构造
+FlatTree FlatBuilder::finish() {
+    tree_.rootList_ = addList(roots_.data(), roots_.size());
+    tree_.kinds_.shrink_to_fit();
+    tree_.tokenTypes_.shrink_to_fit();
+    tree_.data_.shrink_to_fit();
+    tree_.extra_.shrink_to_fit();
+    tree_.names_.shrink_to_fit();
+    tree_.literals_.shrink_to_fit();
+    tree_.ownedText_.shrink_to_fit();
+    FlatTree tree = std::move(tree_);
+    tree_ = FlatTree();
+    roots_.clear();
+    results_.clear();
+    return tree;
+}
+
+} // namespace jvav
@@ -0,0 +1,131 @@
+#include "ast/NodeWalker.h"
+
+namespace jvav {
+
+// 逆序压入语句列表
+void NodeWalker::pushStatements(NodeList<Stmt*> statements) {
+    for (size_t i = statements.size(); i-- > 0;) {
+        push(statements[i]);
+    }
+}
+
+// 逆序压入表达式列表
+void NodeWalker::pushExpressions(NodeList<Expr*> expressions) {
+    for (size_t i = expressions.size(); i-- > 0;) {
+        push(expressions[i]);
+    }
+}
+
+void NodeWalker::push(Stmt* stmt) {
+    if (stmt != nullptr) {
+        stack_.push_back(Entry{stmt, nullptr, false});
+    }
+}
+
+void NodeWalker::push(Expr* expr) {
+    if (expr != nullptr) {
+        stack_.push_back(Entry{nullptr, expr, false});
+    }
+}
+
+// 压入语句的子节点，最后压入的最先访问
+void NodeWalker::pushChildren(Stmt* stmt) {
+    switch (stmt->getType()) {
+        case StmtType::EXPRESSION:
+            push(static_cast<ExpressionStmt*>(stmt)->expression);
+            break;
+        case StmtType::DAKAI:
+            push(static_cast<DakaiStmt*>(stmt)->path);
+            break;
+        case StmtType::SET:
+            push(static_cast<SetStmt*>(stmt)->value);
+            break;
+        case StmtType::PRINT:
+            push(static_cast<PrintStmt*>(stmt)->value);
+            break;
+        case StmtType::IF: {
+            NodeList<Branch>& branches = static_cast<IfStmt*>(stmt)->branches;
+            for (size_t i = branches.size(); i-- > 0;) {
+                pushStatements(branches[i].body);
+                push(branches[i].condition);
+            }
+            break;
+        }
+        case StmtType::LOOP: {
+            auto* loop = static_cast<LoopStmt*>(stmt);
+            pushStatements(loop->body);
+            push(loop->count);
+            break;
+        }
+        case StmtType::DEFINE:
+            pushStatements(static_cast<DefineStmt*>(stmt)->body);
+            break;
+        case StmtType::RETURN:
+            push(static_cast<ReturnStmt*>(stmt)->value);
+            break;
+        case StmtType::ARRAY:
+            pushExpressions(static_cast<ArrayStmt*>(stmt)->elements);
+            break;
+        case StmtType::RECORD_ACCESS:
+            push(static_cast<RecordAccessStmt*>(stmt)->value);
+            break;
+        case StmtType::TRY_CATCH: {
+            auto* tryCatch = static_cast<TryCatchStmt*>(stmt);
+            pushStatements(tryCatch->catchBlock);
+            pushStatements(tryCatch->tryBlock);
+            break;
+        }
+        case StmtType::BLOCK:
+            pushStatements(static_cast<BlockStmt*>(stmt)->statements);
+            break;
+        case StmtType::IMPORT:
+        case StmtType::RECORD_DEF:
+        case StmtType::ENUM_DEF:
+        case StmtType::ERROR:
+            // 没有子节点
+            break;
+    }
+}
+
+// 压入表达式的子节点，最后压入的最先访问
+void NodeWalker::pushChildren(Expr* expr) {
+    switch (expr->getType()) {
+        case ExprType::UNARY:
+            push(static_cast<UnaryExpr*>(expr)->right);
+            break;
+        case ExprType::BINARY: {
+            auto* binary = static_cast<BinaryExpr*>(expr);
+            push(binary->right);
+            push(binary->left);
+            break;
+        }
+        case ExprType::CALL: {
+            auto* call = static_cast<CallExpr*>(expr);
+            pushExpressions(call->arguments);
+            push(call->callee);
+            break;
+        }
+        case ExprType::ARRAY_ACCESS: {
+            auto* access = static_cast<ArrayAccessExpr*>(expr);
+            push(access->index);
+            push(access->array);
+            break;
+        }
+        case ExprType::RECORD_ACCESS:
+            push(static_cast<RecordAccessExpr*>(expr)->record);
+            break;
+        case ExprType::ASSIGNMENT: {
+            auto* assignment = static_cast<AssignmentExpr*>(expr);
+            push(assignment->value);
+            push(assignment->target);
+            break;
+        }
+        case ExprType::LITERAL:
+        case ExprType::VARIABLE:
+        case ExprType::ERROR:
+            // 没有子节点
+            break;
+    }
+}
+
+} // namespace jvav
@@ -1,16 +1,20 @@
 #include "codegen/CodeGenerator.h"
+#include "ast/ASTVisitor.h"
 #include "compiler/Functions.h"
+#include "ir/Dominators.h"
+#include <algorithm>
 #include <iostream>
 #include <fstream>
-#include <unordered_map>
+#include <set>
 #include <sstream>
+#include <unordered_map>
 
 namespace jvav {
 
 // 前向声明私有实现类
-class CodeGenerator::CodeGeneratorImpl {
+class CodeGenerator::CodeGeneratorImpl : public ASTVisitor<CodeGenerator::CodeGeneratorImpl> {
 public:
-    void generateCode(const std::vector<std::unique_ptr<Stmt>>& ast, const std::string& outputFile) {
+    void generateCode(const Program& program, const std::string& outputFile) {
         // 重置状态
         resetState();
         
@@ -21,7 +25,7 @@ public:
         generateImports();
         
         // 生成全局变量和主函数
-        generateGlobals(ast);
+        generateGlobals(program);
         
         // 生成模块尾
         generateModuleFooter();
@@ -31,16 +35,36 @@ public:
         
         std::cout << "WebAssembly代码生成完成: " << outputFile << std::endl;
     }
+    
+    // 从中间表示生成代码
+    void generateCode(const IRModule& module, const std::string& outputFile) {
+        resetState();
+        generateModuleHeader();
+        generateImports();
+        generateStrings(module);
+        
+        codeBuffer_ << "  ;; 全局变量定义\n";
+        for (size_t i = 0; i < module.globals.size(); i++) {
+            codeBuffer_ << "  (global $g" << i << " (mut i32) (i32.const 0)) ;; " << module.globals[i] << "\n";
+        }
+        codeBuffer_ << "\n";
+        
+        for (uint32_t i = 0; i < module.functions.size(); i++) {
+            generateFunction(module, i);
+        }
+        
+        generateModuleFooter();
+        writeToFile(outputFile);
+        
+        std::cout << "WebAssembly代码生成完成: " << outputFile << std::endl;
+    }
 
 private:
     // 代码缓冲区
     std::stringstream codeBuffer_;
     
-    // 变量映射表
-    std::unordered_map<std::string, int> variables_;
-    
-    // 函数映射表
-    std::unordered_map<std::string, std::string> functions_;
+    // 变量映射表：按符号编号索引的全局变量序号，-1表示未定义
+    std::vector<int> variables_;
     
     // 全局变量计数
     int globalVarCount_ = 0;
@@ -51,9 +75,34 @@ private:
     // 当前函数名
     std::string currentFunction_;
     
+    // 循环的编号，在模块中唯一；循环次数和下标放在局部变量$loop_count_N、$loop_index_N中
+    std::unordered_map<const LoopStmt*, int> loopIds_;
+    int loopCount_ = 0;
+    
+    // 待完成的代码生成工作
+    // 语句和表达式都不递归生成：展开一个节点时先直接输出它前面的代码，
+    // 再把子节点和它后面的代码按顺序排入工作栈，由runWork()依次取出处理，
+    // 机器生成的任意深的语法树也不会耗尽线程栈。
+    struct Work {
+        enum class Kind { STMT, EXPR, TEXT, WARNING, END_FUNCTION };
+        Kind kind;
+        const Stmt* stmt = nullptr;
+        const Expr* expr = nullptr;
+        std::string text;
+    };
+    std::vector<Work> work_;
+    
     // 重置生成器状态
     void resetState();
     
+    // 变量是否已定义
+    bool isVariableDefined(Symbol name) const {
+        return name < variables_.size() && variables_[name] >= 0;
+    }
+    
+    // 定义全局变量，分配新的序号
+    void defineVariable(Symbol name);
+    
     // 生成模块头
     void generateModuleHeader();
     
@@ -64,68 +113,172 @@ private:
     void generateImports();
     
     // 生成全局变量
-    void generateGlobals(const std::vector<std::unique_ptr<Stmt>>& ast);
+    void generateGlobals(const Program& program);
     
-    // 生成语句代码
+    // 生成一条语句及其全部子节点的代码
     void generateStatement(const Stmt* stmt);
     
+    // 在函数开头声明函数体中的循环用到的局部变量，不进入嵌套的函数定义
+    void declareLoopLocals(const NodeList<Stmt*>& statements, const NodeList<Token>* parameters);
+    
+    // 处理工作栈直到为空
+    void runWork();
+    
+    // 排入工作项，按排入的顺序处理；一个节点排入的工作项必须用schedule()提交
+    void queue(const Stmt* stmt);
+    void queue(const Expr* expr);
+    void queue(const NodeList<Stmt*>& statements);
+    void queue(std::string text);
+    void queueWarning(std::string message);
+    void queueEndFunction();
+    
+    // 提交mark之后排入的工作项：逆序放到栈顶，使最先排入的最先处理
+    void schedule(size_t mark);
+    
+    // 各种节点的代码生成，由ASTVisitor按节点类型分派
+    friend class ASTVisitor<CodeGeneratorImpl>;
+    
     // 生成打印语句
-    void generatePrintStatement(const PrintStmt* stmt);
+    void visit(const PrintStmt* stmt);
     
     // 生成设置变量语句
-    void generateSetStatement(const SetStmt* stmt);
+    void visit(const SetStmt* stmt);
     
     // 生成IF语句
-    void generateIfStatement(const IfStmt* stmt);
+    void visit(const IfStmt* stmt);
     
     // 生成循环语句
-    void generateLoopStatement(const LoopStmt* stmt);
+    void visit(const LoopStmt* stmt);
     
     // 生成函数定义
-    void generateDefineStatement(const DefineStmt* stmt);
+    void visit(const DefineStmt* stmt);
     
     // 生成表达式语句
-    void generateExpressionStatement(const ExpressionStmt* stmt);
+    void visit(const ExpressionStmt* stmt);
     
     // 生成语句块
-    void generateBlockStatement(const BlockStmt* stmt);
+    void visit(const BlockStmt* stmt);
     
     // 生成try-catch语句
-    void generateTryCatchStatement(const TryCatchStmt* stmt);
+    void visit(const TryCatchStmt* stmt);
     
-    // 生成表达式代码
-    void generateExpression(const Expr* expr);
+    // WebAssembly后端暂不支持的语句：只给出警告
+    void visit(const ImportStmt* stmt) { unsupported(stmt); }
+    void visit(const DakaiStmt* stmt) { unsupported(stmt); }
+    void visit(const ReturnStmt* stmt) { unsupported(stmt); }
+    void visit(const ArrayStmt* stmt) { unsupported(stmt); }
+    void visit(const RecordDefStmt* stmt) { unsupported(stmt); }
+    void visit(const RecordAccessStmt* stmt) { unsupported(stmt); }
+    void visit(const EnumDefStmt* stmt) { unsupported(stmt); }
+    void unsupported(const Stmt* stmt);
+    
+    // 语法错误的占位语句，不生成代码
+    void visit(const ErrorStmt*) {}
     
     // 生成字面量表达式
-    void generateLiteralExpression(const LiteralExpr* expr);
+    void visit(const LiteralExpr* expr);
     
     // 生成变量引用表达式
-    void generateVariableExpression(const VariableExpr* expr);
+    void visit(const VariableExpr* expr);
     
     // 生成二元表达式
-    void generateBinaryExpression(const BinaryExpr* expr);
+    void visit(const BinaryExpr* expr);
     
     // 生成一元表达式
-    void generateUnaryExpression(const UnaryExpr* expr);
+    void visit(const UnaryExpr* expr);
     
     // 生成函数调用表达式
-    void generateCallExpression(const CallExpr* expr);
+    void visit(const CallExpr* expr);
     
     // 生成赋值表达式
-    void generateAssignmentExpression(const AssignmentExpr* expr);
+    void visit(const AssignmentExpr* expr);
+    
+    // 暂不支持的表达式：给出警告并以0代替
+    void visit(const ArrayAccessExpr* expr) { unsupported(expr); }
+    void visit(const RecordAccessExpr* expr) { unsupported(expr); }
+    void unsupported(const Expr* expr);
+    
+    // 语法错误的占位表达式
+    void visit(const ErrorExpr* expr);
     
     // 写入输出文件
     void writeToFile(const std::string& outputFile);
+    
+    // 从中间表示生成代码
+    // 控制流按Ramsey的“Beyond Relooper”还原为结构化的block/loop/if：
+    // 沿支配树生成，循环头包在loop中，有多个前向前驱的汇合块作为支配者中一个block之后的代码，
+    // 跳到汇合块是跳出这个block，回边是跳回loop开头，其余的边把目标块直接生成在跳转处。
+    // 降低得到的控制流图都是可归约的，总能这样还原。
+    // SSA值放在局部变量$vN中，常量和参数在用到的地方直接生成；phi在每条入边上赋值。
+    struct IRWork {
+        enum class Kind {
+            TREE,    // 生成块a及它在支配树中的子树
+            WITHIN,  // 生成块a，外面包着它的前b个汇合子块的block
+            BRANCH,  // 从块a跳到块b
+            OPEN,    // 输出text，之后缩进一级
+            CLOSE    // 回退一级缩进，输出右括号
+        };
+        Kind kind;
+        BlockId a = NO_BLOCK;
+        uint32_t b = 0;
+        std::string text;
+    };
+    
+    // 一个函数的结构信息
+    struct IRLayout {
+        std::vector<uint32_t> rpoIndex;
+        std::vector<uint8_t> loopHeader;
+        std::vector<uint8_t> mergeNode;
+        std::vector<std::vector<BlockId>> mergeChildren;  // 按逆后序排列
+    };
+    
+    // 字符串常量放在内存开头，以0结尾
+    void generateStrings(const IRModule& module);
+    
+    // 生成一个函数
+    void generateFunction(const IRModule& module, uint32_t index);
+    
+    // 处理一项结构化工作，展开的工作项放入work
+    void generateIRWork(const IRFunction& function, const IRLayout& layout,
+                        const IRWork& item, std::vector<IRWork>& work);
+    
+    // 生成块中的指令
+    void generateInstructions(const IRFunction& function, BlockId block);
+    
+    // 生成从from跳到to时对to的phi的赋值
+    void generatePhiCopies(const IRFunction& function, BlockId from, BlockId to);
+    
+    // 把值压栈的指令
+    std::string valueOperand(const IRFunction& function, ValueId value) const;
+    
+    // 按当前缩进输出一行
+    void irLine(const std::string& text) {
+        codeBuffer_ << std::string(irIndent_ * 2, ' ') << text << "\n";
+    }
+    
+    // 中间表示的缩进层数、字符串常量的地址
+    int irIndent_ = 0;
+    std::vector<uint32_t> stringAddresses_;
 };
 
 // 重置生成器状态
 void CodeGenerator::CodeGeneratorImpl::resetState() {
     codeBuffer_.str("");
     variables_.clear();
-    functions_.clear();
     globalVarCount_ = 0;
     localVarCount_ = 0;
     currentFunction_ = "";
+    loopIds_.clear();
+    loopCount_ = 0;
+    work_.clear();
+}
+
+// 定义全局变量
+void CodeGenerator::CodeGeneratorImpl::defineVariable(Symbol name) {
+    if (name >= variables_.size()) {
+        variables_.resize(std::max(SymbolTable::instance().size(), static_cast<size_t>(name) + 1), -1);
+    }
+    variables_[name] = globalVarCount_++;
 }
 
 // 生成模块头
@@ -164,20 +317,22 @@ void CodeGenerator::CodeGeneratorImpl::generateImports() {
 }
 
 // 生成全局变量
-void CodeGenerator::CodeGeneratorImpl::generateGlobals(const std::vector<std::unique_ptr<Stmt>>& ast) {
+void CodeGenerator::CodeGeneratorImpl::generateGlobals(const Program& program) {
     codeBuffer_ << "  ;; 全局变量定义\n";
     
     // 遍历AST寻找全局变量定义
-    for (const auto& stmt : ast) {
+    for (const Stmt* stmt : program.statements) {
         if (stmt->getType() == StmtType::SET) {
-            auto setStmt = static_cast<const SetStmt*>(stmt.get());
-            std::string varName = setStmt->name.getValue();
+            auto setStmt = static_cast<const SetStmt*>(stmt);
+            if (isVariableDefined(setStmt->name.getSymbol())) {
+                continue;
+            }
             
             // 添加到变量映射表
-            variables_[varName] = globalVarCount_++;
+            defineVariable(setStmt->name.getSymbol());
             
             // 生成全局变量定义
-            codeBuffer_ << "  (global $" << varName << " (mut i32) (i32.const 0))\n";
+            codeBuffer_ << "  (global $" << setStmt->name.getValue() << " (mut i32) (i32.const 0))\n";
         }
     }
     
@@ -187,14 +342,14 @@ void CodeGenerator::CodeGeneratorImpl::generateGlobals(const std::vector<std::un
     
     // 添加临时变量
     codeBuffer_ << "    ;; 局部临时变量\n";
-    codeBuffer_ << "    (local $temp i32)\n\n";
+    codeBuffer_ << "    (local $temp i32)\n";
+    declareLoopLocals(program.statements, nullptr);
+    codeBuffer_ << "\n";
     
     // 遍历AST生成执行代码
-    for (const auto& stmt : ast) {
-        // 跳过全局变量定义，它们已经被处理
-        if (stmt->getType() != StmtType::SET) {
-            generateStatement(stmt.get());
-        }
+    // 顶层的设置语句也在这里按顺序求值并写入全局变量，上面只是声明了它们
+    for (const Stmt* stmt : program.statements) {
+        generateStatement(stmt);
     }
     
     // 返回0
@@ -205,144 +360,250 @@ void CodeGenerator::CodeGeneratorImpl::generateGlobals(const std::vector<std::un
     codeBuffer_ << "  (export \"main\" (func $main))\n\n";
 }
 
-// 生成语句代码
+// 声明循环用到的局部变量
+// WebAssembly的局部变量只能在函数开头声明，每个循环有自己的次数和下标，
+// 循环变量按名字只声明一次，与参数或$temp同名时直接使用它们
+void CodeGenerator::CodeGeneratorImpl::declareLoopLocals(const NodeList<Stmt*>& statements,
+                                                         const NodeList<Token>* parameters) {
+    std::set<std::string> declared{"temp"};
+    if (parameters != nullptr) {
+        for (const auto& param : *parameters) {
+            declared.insert(std::string(param.getValue()));
+        }
+    }
+    
+    // 按源程序中的顺序编号，用显式的栈遍历
+    std::vector<const Stmt*> stack;
+    auto push = [&stack](const NodeList<Stmt*>& list) {
+        for (size_t i = list.size(); i-- > 0;) {
+            stack.push_back(list[i]);
+        }
+    };
+    push(statements);
+    while (!stack.empty()) {
+        const Stmt* stmt = stack.back();
+        stack.pop_back();
+        switch (stmt->getType()) {
+            case StmtType::LOOP: {
+                auto* loop = static_cast<const LoopStmt*>(stmt);
+                int id = loopCount_++;
+                loopIds_[loop] = id;
+                codeBuffer_ << "    (local $loop_count_" << id << " i32)\n";
+                codeBuffer_ << "    (local $loop_index_" << id << " i32)\n";
+                std::string iterName(loop->variable.getValue());
+                if (!iterName.empty() && declared.insert(iterName).second) {
+                    codeBuffer_ << "    (local $" << iterName << " i32)\n";
+                }
+                push(loop->body);
+                break;
+            }
+            case StmtType::IF: {
+                auto* ifStmt = static_cast<const IfStmt*>(stmt);
+                for (size_t i = ifStmt->branches.size(); i-- > 0;) {
+                    push(ifStmt->branches[i].body);
+                }
+                break;
+            }
+            case StmtType::BLOCK:
+                push(static_cast<const BlockStmt*>(stmt)->statements);
+                break;
+            case StmtType::TRY_CATCH:
+                push(static_cast<const TryCatchStmt*>(stmt)->catchBlock);
+                push(static_cast<const TryCatchStmt*>(stmt)->tryBlock);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// 生成一条语句及其全部子节点的代码
 void CodeGenerator::CodeGeneratorImpl::generateStatement(const Stmt* stmt) {
-    switch (stmt->getType()) {
-        case StmtType::PRINT:
-            generatePrintStatement(static_cast<const PrintStmt*>(stmt));
-            break;
-        case StmtType::SET:
-            generateSetStatement(static_cast<const SetStmt*>(stmt));
-            break;
-        case StmtType::IF:
-            generateIfStatement(static_cast<const IfStmt*>(stmt));
-            break;
-        case StmtType::LOOP:
-            generateLoopStatement(static_cast<const LoopStmt*>(stmt));
-            break;
-        case StmtType::DEFINE:
-            generateDefineStatement(static_cast<const DefineStmt*>(stmt));
-            break;
-        case StmtType::EXPRESSION:
-            generateExpressionStatement(static_cast<const ExpressionStmt*>(stmt));
-            break;
-        case StmtType::BLOCK:
-            generateBlockStatement(static_cast<const BlockStmt*>(stmt));
-            break;
-        case StmtType::TRY_CATCH:
-            generateTryCatchStatement(static_cast<const TryCatchStmt*>(stmt));
-            break;
-        default:
-            std::cerr << "警告: 未支持的语句类型 " << (int)stmt->getType() << std::endl;
-            break;
+    size_t mark = work_.size();
+    queue(stmt);
+    schedule(mark);
+    runWork();
+}
+
+// 处理工作栈
+void CodeGenerator::CodeGeneratorImpl::runWork() {
+    while (!work_.empty()) {
+        Work work = std::move(work_.back());
+        work_.pop_back();
+        
+        switch (work.kind) {
+            case Work::Kind::STMT:
+                visitStmt(work.stmt);
+                break;
+            case Work::Kind::EXPR:
+                visitExpr(work.expr);
+                break;
+            case Work::Kind::TEXT:
+                codeBuffer_ << work.text;
+                break;
+            case Work::Kind::WARNING:
+                std::cerr << work.text << std::endl;
+                break;
+            case Work::Kind::END_FUNCTION:
+                currentFunction_ = "";
+                break;
+        }
     }
 }
 
+// 排入工作项
+void CodeGenerator::CodeGeneratorImpl::queue(const Stmt* stmt) {
+    work_.push_back(Work{Work::Kind::STMT, stmt, nullptr, std::string()});
+}
+
+void CodeGenerator::CodeGeneratorImpl::queue(const Expr* expr) {
+    work_.push_back(Work{Work::Kind::EXPR, nullptr, expr, std::string()});
+}
+
+void CodeGenerator::CodeGeneratorImpl::queue(const NodeList<Stmt*>& statements) {
+    for (const Stmt* stmt : statements) {
+        queue(stmt);
+    }
+}
+
+void CodeGenerator::CodeGeneratorImpl::queue(std::string text) {
+    work_.push_back(Work{Work::Kind::TEXT, nullptr, nullptr, std::move(text)});
+}
+
+void CodeGenerator::CodeGeneratorImpl::queueWarning(std::string message) {
+    work_.push_back(Work{Work::Kind::WARNING, nullptr, nullptr, std::move(message)});
+}
+
+void CodeGenerator::CodeGeneratorImpl::queueEndFunction() {
+    work_.push_back(Work{Work::Kind::END_FUNCTION, nullptr, nullptr, std::string()});
+}
+
+// 提交排入的工作项
+void CodeGenerator::CodeGeneratorImpl::schedule(size_t mark) {
+    std::reverse(work_.begin() + mark, work_.end());
+}
+
+// 暂不支持的语句
+void CodeGenerator::CodeGeneratorImpl::unsupported(const Stmt* stmt) {
+    std::cerr << "警告: 未支持的语句类型 " << (int)stmt->getType() << std::endl;
+}
+
 // 生成打印语句
-void CodeGenerator::CodeGeneratorImpl::generatePrintStatement(const PrintStmt* stmt) {
+void CodeGenerator::CodeGeneratorImpl::visit(const PrintStmt* stmt) {
     codeBuffer_ << "  ;; 打印语句\n";
-    generateExpression(stmt->value.get());
-    codeBuffer_ << "  call $print_number\n\n";
+    size_t mark = work_.size();
+    queue(stmt->value);
+    queue("  call $print_number\n\n");
+    schedule(mark);
 }
 
 // 生成设置变量语句
-void CodeGenerator::CodeGeneratorImpl::generateSetStatement(const SetStmt* stmt) {
+void CodeGenerator::CodeGeneratorImpl::visit(const SetStmt* stmt) {
     codeBuffer_ << "  ;; 设置变量: " << stmt->name.getValue() << "\n";
     
     // 检查变量是否已经存在
-    std::string varName = stmt->name.getValue();
-    if (variables_.find(varName) == variables_.end()) {
+    std::string varName(stmt->name.getValue());
+    if (!isVariableDefined(stmt->name.getSymbol())) {
         // 添加到变量映射表
-        variables_[varName] = globalVarCount_++;
+        defineVariable(stmt->name.getSymbol());
         
         // 生成全局变量定义
         codeBuffer_ << "  (global $" << varName << " (mut i32) (i32.const 0))\n";
     }
     
+    size_t mark = work_.size();
     // 生成表达式代码
-    generateExpression(stmt->value.get());
-    
+    queue(stmt->value);
     // 设置变量值
-    codeBuffer_ << "  global.set $" << varName << "\n\n";
+    queue("  global.set $" + varName + "\n\n");
+    schedule(mark);
 }
 
 // 生成IF语句
-void CodeGenerator::CodeGeneratorImpl::generateIfStatement(const IfStmt* stmt) {
+void CodeGenerator::CodeGeneratorImpl::visit(const IfStmt* stmt) {
     codeBuffer_ << "  ;; IF语句\n";
+    size_t mark = work_.size();
     
     // 生成条件代码
-    generateExpression(stmt->branches[0].condition.get());
+    queue(stmt->branches[0].condition);
     
     // 生成IF结构
-    codeBuffer_ << "  (if\n";
-    codeBuffer_ << "    (then\n";
+    queue("  (if\n"
+          "    (then\n");
     
     // 生成IF块中的代码
-    for (const auto& bodyStmt : stmt->branches[0].body) {
-        generateStatement(bodyStmt.get());
-    }
+    queue(stmt->branches[0].body);
     
-    codeBuffer_ << "    )\n";
+    queue("    )\n");
     
     // 如果有ELSE块
     if (stmt->branches.size() > 1 && !stmt->branches.back().condition) {
-        codeBuffer_ << "    (else\n";
+        queue("    (else\n");
         
         // 生成ELSE块中的代码
-        for (const auto& bodyStmt : stmt->branches.back().body) {
-            generateStatement(bodyStmt.get());
-        }
+        queue(stmt->branches.back().body);
         
-        codeBuffer_ << "    )\n";
+        queue("    )\n");
     }
     
-    codeBuffer_ << "  )\n\n";
+    queue("  )\n\n");
+    schedule(mark);
 }
 
 // 生成循环语句
-void CodeGenerator::CodeGeneratorImpl::generateLoopStatement(const LoopStmt* stmt) {
+void CodeGenerator::CodeGeneratorImpl::visit(const LoopStmt* stmt) {
     codeBuffer_ << "  ;; 循环语句\n";
     
-    // 初始化循环计数器
-    std::string iterName = stmt->variable.getValue();
-    if (!iterName.empty()) {
-        codeBuffer_ << "  (local $" << iterName << " i32)\n";
-        codeBuffer_ << "  i32.const 0\n";
-        codeBuffer_ << "  local.set $" << iterName << "\n";
-    }
+    // 局部变量已经由declareLoopLocals()在函数开头声明
+    std::string id = std::to_string(loopIds_.at(stmt));
+    std::string count = "$loop_count_" + id;
+    std::string index = "$loop_index_" + id;
+    std::string iterName(stmt->variable.getValue());
     
-    // 生成循环次数表达式
-    generateExpression(stmt->count.get());
-    codeBuffer_ << "  (local $loop_count i32)\n";
-    codeBuffer_ << "  local.set $loop_count\n";
-    
-    // 循环结构
-    codeBuffer_ << "  (loop $loop\n";
+    size_t mark = work_.size();
     
-    // 循环体
-    for (const auto& bodyStmt : stmt->body) {
-        generateStatement(bodyStmt.get());
-    }
-    
-    // 增加迭代器
+    // 生成循环次数表达式
+    queue(stmt->count);
+    
+    // 循环结构：次数不大于0时一次也不执行，与死代码消除和中间表示的语义一致
+    std::string head = "  local.set " + count + "\n"
+                       "  i32.const 0\n"
+                       "  local.set " + index + "\n"
+                       "  i32.const 0\n"
+                       "  local.get " + count + "\n"
+                       "  i32.lt_s\n"
+                       "  (if\n"
+                       "    (then\n"
+                       "  (loop $loop_" + id + "\n";
+    
+    // 迭代器取本次的下标
     if (!iterName.empty()) {
-        codeBuffer_ << "    local.get $" << iterName << "\n";
-        codeBuffer_ << "    i32.const 1\n";
-        codeBuffer_ << "    i32.add\n";
-        codeBuffer_ << "    local.set $" << iterName << "\n";
+        head += "    local.get " + index + "\n";
+        head += "    local.set $" + iterName + "\n";
     }
+    queue(std::move(head));
     
-    // 循环条件
-    codeBuffer_ << "    local.get $" << iterName << "\n";
-    codeBuffer_ << "    local.get $loop_count\n";
-    codeBuffer_ << "    i32.lt_s\n";
-    codeBuffer_ << "    br_if $loop\n";
-    codeBuffer_ << "  )\n\n";
+    // 循环体
+    queue(stmt->body);
+    
+    // 下标加1，小于次数时继续
+    queue("    local.get " + index + "\n"
+          "    i32.const 1\n"
+          "    i32.add\n"
+          "    local.set " + index + "\n"
+          "    local.get " + index + "\n"
+          "    local.get " + count + "\n"
+          "    i32.lt_s\n"
+          "    br_if $loop_" + id + "\n"
+          "  )\n"
+          "    )\n"
+          "  )\n\n");
+    schedule(mark);
 }
 
 // 生成函数定义
-void CodeGenerator::CodeGeneratorImpl::generateDefineStatement(const DefineStmt* stmt) {
-    std::string funcName = stmt->name.getValue();
+void CodeGenerator::CodeGeneratorImpl::visit(const DefineStmt* stmt) {
+    std::string funcName(stmt->name.getValue());
     currentFunction_ = funcName;
     
     codeBuffer_ << "  ;; 函数定义: " << funcName << "\n";
@@ -358,122 +619,105 @@ void CodeGenerator::CodeGeneratorImpl::generateDefineStatement(const DefineStmt*
     
     // 添加局部变量
     codeBuffer_ << "    (local $temp i32)\n";
+    declareLoopLocals(stmt->body, &stmt->parameters);
+    
+    size_t mark = work_.size();
     
     // 函数体
     for (const auto& bodyStmt : stmt->body) {
         // 检查是否是return语句
         if (bodyStmt->getType() == StmtType::RETURN) {
-            auto* returnStmt = static_cast<const ReturnStmt*>(bodyStmt.get());
+            auto* returnStmt = static_cast<const ReturnStmt*>(bodyStmt);
             if (returnStmt->value) {
-                // 生成返回值表达式
-                generateExpression(returnStmt->value.get());
-                // 返回值已经在栈顶
-                codeBuffer_ << "    return\n";
+                // 生成返回值表达式，返回值在栈顶
+                queue(returnStmt->value);
+                queue("    return\n");
             } else {
                 // 没有返回值，返回0
-                codeBuffer_ << "    i32.const 0\n";
-                codeBuffer_ << "    return\n";
+                queue("    i32.const 0\n"
+                      "    return\n");
             }
         } else {
-            generateStatement(bodyStmt.get());
+            queue(bodyStmt);
         }
     }
     
-    // 默认返回0
-    codeBuffer_ << "    i32.const 0 ;; 默认返回值\n";
-    codeBuffer_ << "  )\n\n";
-    
-    // 导出函数
-    codeBuffer_ << "  (export \"" << funcName << "\" (func $" << funcName << "))\n\n";
+    // 默认返回0，然后导出函数
+    queue("    i32.const 0 ;; 默认返回值\n"
+          "  )\n\n"
+          "  (export \"" + funcName + "\" (func $" + funcName + "))\n\n");
     
-    currentFunction_ = "";
+    queueEndFunction();
+    schedule(mark);
 }
 
 // 生成表达式语句
-void CodeGenerator::CodeGeneratorImpl::generateExpressionStatement(const ExpressionStmt* stmt) {
-    generateExpression(stmt->expression.get());
+void CodeGenerator::CodeGeneratorImpl::visit(const ExpressionStmt* stmt) {
+    size_t mark = work_.size();
+    queue(stmt->expression);
     // 丢弃表达式结果
-    codeBuffer_ << "  drop\n";
+    queue("  drop\n");
+    schedule(mark);
 }
 
 // 生成语句块
-void CodeGenerator::CodeGeneratorImpl::generateBlockStatement(const BlockStmt* stmt) {
+void CodeGenerator::CodeGeneratorImpl::visit(const BlockStmt* stmt) {
     codeBuffer_ << "  ;; 语句块\n";
     codeBuffer_ << "  (block\n";
     
-    for (const auto& bodyStmt : stmt->statements) {
-        generateStatement(bodyStmt.get());
-    }
-    
-    codeBuffer_ << "  )\n";
+    size_t mark = work_.size();
+    queue(stmt->statements);
+    queue("  )\n");
+    schedule(mark);
 }
 
 // 生成try-catch语句
-void CodeGenerator::CodeGeneratorImpl::generateTryCatchStatement(const TryCatchStmt* stmt) {
+void CodeGenerator::CodeGeneratorImpl::visit(const TryCatchStmt* stmt) {
     codeBuffer_ << "  ;; Try-Catch语句\n";
     codeBuffer_ << "  (block $try_block\n";
     
-    // try块中的代码
-    for (const auto& tryStmt : stmt->tryBlock) {
-        generateStatement(tryStmt.get());
-    }
+    size_t mark = work_.size();
     
-    codeBuffer_ << "  )\n";
+    // try块中的代码
+    queue(stmt->tryBlock);
     
     // 在WebAssembly中暂时不支持异常处理，这里只是简单执行catch块
-    codeBuffer_ << "  ;; Catch块 (简化实现，不支持真正的异常处理)\n";
-    codeBuffer_ << "  (block $catch_block\n";
+    queue("  )\n"
+          "  ;; Catch块 (简化实现，不支持真正的异常处理)\n"
+          "  (block $catch_block\n");
     
-    for (const auto& catchStmt : stmt->catchBlock) {
-        generateStatement(catchStmt.get());
-    }
+    queue(stmt->catchBlock);
     
-    codeBuffer_ << "  )\n\n";
+    queue("  )\n\n");
+    schedule(mark);
 }
 
-// 生成表达式代码
-void CodeGenerator::CodeGeneratorImpl::generateExpression(const Expr* expr) {
-    switch (expr->getType()) {
-        case ExprType::LITERAL:
-            generateLiteralExpression(static_cast<const LiteralExpr*>(expr));
-            break;
-        case ExprType::VARIABLE:
-            generateVariableExpression(static_cast<const VariableExpr*>(expr));
-            break;
-        case ExprType::BINARY:
-            generateBinaryExpression(static_cast<const BinaryExpr*>(expr));
-            break;
-        case ExprType::UNARY:
-            generateUnaryExpression(static_cast<const UnaryExpr*>(expr));
-            break;
-        case ExprType::CALL:
-            generateCallExpression(static_cast<const CallExpr*>(expr));
-            break;
-        case ExprType::ASSIGNMENT:
-            generateAssignmentExpression(static_cast<const AssignmentExpr*>(expr));
-            break;
-        default:
-            std::cerr << "警告: 未支持的表达式类型 " << (int)expr->getType() << std::endl;
-            // 默认值
-            codeBuffer_ << "  i32.const 0 ;; 未支持的表达式\n";
-            break;
-    }
+// 暂不支持的表达式
+void CodeGenerator::CodeGeneratorImpl::unsupported(const Expr* expr) {
+    std::cerr << "警告: 未支持的表达式类型 " << (int)expr->getType() << std::endl;
+    // 默认值
+    codeBuffer_ << "  i32.const 0 ;; 未支持的表达式\n";
+}
+
+// 语法错误的占位表达式
+void CodeGenerator::CodeGeneratorImpl::visit(const ErrorExpr*) {
+    codeBuffer_ << "  i32.const 0 ;; 语法错误\n";
 }
 
 // 生成字面量表达式
-void CodeGenerator::CodeGeneratorImpl::generateLiteralExpression(const LiteralExpr* expr) {
+void CodeGenerator::CodeGeneratorImpl::visit(const LiteralExpr* expr) {
     const Token& token = expr->token;
     
     switch (token.getType()) {
         case TokenType::NUMBER_LITERAL: {
             // 数字字面量
-            int value = std::stoi(token.getValue());
+            int value = std::stoi(std::string(expr->value));
             codeBuffer_ << "  i32.const " << value << "\n";
             break;
         }
         case TokenType::BOOL_LITERAL: {
             // 布尔字面量
-            bool value = (token.getValue() == "true" || token.getValue() == "真");
+            bool value = (expr->value == "true" || expr->value == "真");
             codeBuffer_ << "  i32.const " << (value ? 1 : 0) << "\n";
             break;
         }
@@ -489,90 +733,95 @@ void CodeGenerator::CodeGeneratorImpl::generateLiteralExpression(const LiteralEx
 }
 
 // 生成变量引用表达式
-void CodeGenerator::CodeGeneratorImpl::generateVariableExpression(const VariableExpr* expr) {
-    std::string varName = expr->name.getValue();
-    
-    if (variables_.find(varName) != variables_.end()) {
-        codeBuffer_ << "  global.get $" << varName << "\n";
+void CodeGenerator::CodeGeneratorImpl::visit(const VariableExpr* expr) {
+    if (isVariableDefined(expr->name.getSymbol())) {
+        codeBuffer_ << "  global.get $" << expr->name.getValue() << "\n";
     } else {
-        std::cerr << "警告: 使用未定义的变量 " << varName << std::endl;
+        std::cerr << "警告: 使用未定义的变量 " << expr->name.getValue() << std::endl;
         codeBuffer_ << "  i32.const 0 ;; 未定义的变量\n";
     }
 }
 
 // 生成二元表达式
-void CodeGenerator::CodeGeneratorImpl::generateBinaryExpression(const BinaryExpr* expr) {
+void CodeGenerator::CodeGeneratorImpl::visit(const BinaryExpr* expr) {
+    size_t mark = work_.size();
+    
     // 生成左右操作数
-    generateExpression(expr->left.get());
-    generateExpression(expr->right.get());
+    queue(expr->left);
+    queue(expr->right);
     
     // 生成操作符
     switch (expr->op.getType()) {
         case TokenType::PLUS:
-            codeBuffer_ << "  i32.add\n";
+            queue("  i32.add\n");
             break;
         case TokenType::MINUS:
-            codeBuffer_ << "  i32.sub\n";
+            queue("  i32.sub\n");
             break;
         case TokenType::STAR:
-            codeBuffer_ << "  i32.mul\n";
+            queue("  i32.mul\n");
             break;
         case TokenType::SLASH:
-            codeBuffer_ << "  i32.div_s\n";
+            queue("  i32.div_s\n");
             break;
         case TokenType::PERCENT:
-            codeBuffer_ << "  i32.rem_s\n";
+            queue("  i32.rem_s\n");
             break;
         case TokenType::EQUAL:
-            codeBuffer_ << "  i32.eq\n";
+            queue("  i32.eq\n");
             break;
         case TokenType::NOT_EQUAL:
-            codeBuffer_ << "  i32.ne\n";
+            queue("  i32.ne\n");
             break;
         case TokenType::LESS:
-            codeBuffer_ << "  i32.lt_s\n";
+            queue("  i32.lt_s\n");
             break;
         case TokenType::LESS_EQUAL:
-            codeBuffer_ << "  i32.le_s\n";
+            queue("  i32.le_s\n");
             break;
         case TokenType::GREATER:
-            codeBuffer_ << "  i32.gt_s\n";
+            queue("  i32.gt_s\n");
             break;
         case TokenType::GREATER_EQUAL:
-            codeBuffer_ << "  i32.ge_s\n";
+            queue("  i32.ge_s\n");
             break;
         case TokenType::AND:
-            codeBuffer_ << "  i32.and\n";
+            queue("  i32.and\n");
             break;
         case TokenType::OR:
-            codeBuffer_ << "  i32.or\n";
+            queue("  i32.or\n");
             break;
         default:
-            std::cerr << "警告: 未支持的二元操作符 " << (int)expr->op.getType() << std::endl;
+            queueWarning("警告: 未支持的二元操作符 " + std::to_string((int)expr->op.getType()));
             break;
     }
+    
+    schedule(mark);
 }
 
 // 生成一元表达式
-void CodeGenerator::CodeGeneratorImpl::generateUnaryExpression(const UnaryExpr* expr) {
-    generateExpression(expr->right.get());
+void CodeGenerator::CodeGeneratorImpl::visit(const UnaryExpr* expr) {
+    size_t mark = work_.size();
+    queue(expr->right);
     
     switch (expr->op.getType()) {
         case TokenType::MINUS:
-            codeBuffer_ << "  i32.const -1\n";
-            codeBuffer_ << "  i32.mul\n";
+            queue("  i32.const -1\n"
+                  "  i32.mul\n");
             break;
         case TokenType::NOT:
-            codeBuffer_ << "  i32.eqz\n";
+            queue("  i32.eqz\n");
             break;
         default:
-            std::cerr << "警告: 未支持的一元操作符 " << (int)expr->op.getType() << std::endl;
+            queueWarning("警告: 未支持的一元操作符 " + std::to_string((int)expr->op.getType()));
             break;
     }
+    
+    schedule(mark);
 }
 
 // 生成函数调用表达式
-void CodeGenerator::CodeGeneratorImpl::generateCallExpression(const CallExpr* expr) {
+void CodeGenerator::CodeGeneratorImpl::visit(const CallExpr* expr) {
     // 获取被调用的函数名
     if (expr->callee->getType() != ExprType::VARIABLE) {
         std::cerr << "警告: 只支持简单函数调用\n";
@@ -580,16 +829,17 @@ void CodeGenerator::CodeGeneratorImpl::generateCallExpression(const CallExpr* ex
         return;
     }
     
-    auto* varExpr = static_cast<const VariableExpr*>(expr->callee.get());
-    std::string funcName = varExpr->name.getValue();
+    auto* varExpr = static_cast<const VariableExpr*>(expr->callee);
     
     // 检查是否是内置函数
-    bool isBuiltin = BuiltinFunctions::isBuiltin(funcName);
-    BuiltinFunctionType builtinType = BuiltinFunctions::getType(funcName);
+    BuiltinFunctionType builtinType = BuiltinFunctions::getType(varExpr->name.getSymbol());
+    bool isBuiltin = builtinType != BuiltinFunctionType::UNKNOWN;
+    
+    size_t mark = work_.size();
     
     // 生成参数
     for (const auto& arg : expr->arguments) {
-        generateExpression(arg.get());
+        queue(arg);
     }
     
     // 调用函数
@@ -597,8 +847,8 @@ void CodeGenerator::CodeGeneratorImpl::generateCallExpression(const CallExpr* ex
         // 处理内置函数
         switch (builtinType) {
             case BuiltinFunctionType::PRINT:
-                codeBuffer_ << "  call $console_log\n";
-                codeBuffer_ << "  i32.const 0 ;; print函数返回0\n";
+                queue("  call $console_log\n"
+                      "  i32.const 0 ;; print函数返回0\n");
                 break;
             case BuiltinFunctionType::PARSE_INT:
                 // 假设参数已经是整数
@@ -611,25 +861,27 @@ void CodeGenerator::CodeGeneratorImpl::generateCallExpression(const CallExpr* ex
                 break;
             case BuiltinFunctionType::LENGTH:
                 // 对于字符串和数组长度
-                codeBuffer_ << "  i32.const 0 ;; length函数暂不支持\n";
+                queue("  i32.const 0 ;; length函数暂不支持\n");
                 break;
             case BuiltinFunctionType::ASK:
                 // 调用ask函数
-                codeBuffer_ << "  call $ask\n";
+                queue("  call $ask\n");
                 break;
             default:
-                std::cerr << "警告: 未知的内置函数类型 " << (int)builtinType << std::endl;
-                codeBuffer_ << "  i32.const 0 ;; 未支持的内置函数\n";
+                queueWarning("警告: 未知的内置函数类型 " + std::to_string((int)builtinType));
+                queue("  i32.const 0 ;; 未支持的内置函数\n");
                 break;
         }
     } else {
         // 调用自定义函数
-        codeBuffer_ << "  call $" << funcName << "\n";
+        queue("  call $" + std::string(varExpr->name.getValue()) + "\n");
     }
+    
+    schedule(mark);
 }
 
 // 生成赋值表达式
-void CodeGenerator::CodeGeneratorImpl::generateAssignmentExpression(const AssignmentExpr* expr) {
+void CodeGenerator::CodeGeneratorImpl::visit(const AssignmentExpr* expr) {
     // 暂时只支持简单变量赋值
     if (expr->target->getType() != ExprType::VARIABLE) {
         std::cerr << "警告: 只支持简单变量赋值\n";
@@ -637,21 +889,20 @@ void CodeGenerator::CodeGeneratorImpl::generateAssignmentExpression(const Assign
         return;
     }
     
-    auto* varExpr = static_cast<const VariableExpr*>(expr->target.get());
-    std::string varName = varExpr->name.getValue();
+    auto* varExpr = static_cast<const VariableExpr*>(expr->target);
+    std::string varName(varExpr->name.getValue());
     
-    // 生成值表达式
-    generateExpression(expr->value.get());
-    
-    // 保存表达式结果的副本用于返回
-    codeBuffer_ << "  local.set $temp\n";
-    codeBuffer_ << "  local.get $temp\n";
-    
-    // 设置变量值
-    codeBuffer_ << "  global.set $" << varName << "\n";
+    size_t mark = work_.size();
     
-    // 返回赋值后的值
-    codeBuffer_ << "  local.get $temp\n";
+    // 生成值表达式
+    queue(expr->value);
+    
+    // 保存表达式结果的副本用于返回，设置变量值，再返回赋值后的值
+    queue("  local.set $temp\n"
+          "  local.get $temp\n"
+          "  global.set $" + varName + "\n"
+          "  local.get $temp\n");
+    schedule(mark);
 }
 
 // 写入输出文件
@@ -666,6 +917,281 @@ void CodeGenerator::CodeGeneratorImpl::writeToFile(const std::string& outputFile
     outFile.close();
 }
 
+// 字符串常量
+void CodeGenerator::CodeGeneratorImpl::generateStrings(const IRModule& module) {
+    stringAddresses_.clear();
+    if (module.strings.empty()) {
+        return;
+    }
+    codeBuffer_ << "  ;; 字符串常量\n";
+    uint32_t address = 0;
+    for (const std::string& text : module.strings) {
+        stringAddresses_.push_back(address);
+        codeBuffer_ << "  (data (i32.const " << address << ") \"";
+        for (unsigned char c : text) {
+            if (c < 0x20 || c == 0x7f || c == '"' || c == '\\') {
+                static const char digits[] = "0123456789abcdef";
+                codeBuffer_ << '\\' << digits[c >> 4] << digits[c & 15];
+            } else {
+                codeBuffer_ << c;
+            }
+        }
+        codeBuffer_ << "\\00\")\n";
+        address += static_cast<uint32_t>(text.size()) + 1;
+    }
+    codeBuffer_ << "\n";
+}
+
+// 生成一个函数
+void CodeGenerator::CodeGeneratorImpl::generateFunction(const IRModule& module, uint32_t index) {
+    const IRFunction& function = module.functions[index];
+    DominatorTree dominators(function);
+    
+    // 循环头有来自逆后序中不在它之前的块的边（回边），汇合块有至少两个前向前驱
+    IRLayout layout;
+    size_t blockCount = function.blocks.size();
+    layout.rpoIndex.assign(blockCount, NO_BLOCK);
+    layout.loopHeader.assign(blockCount, 0);
+    layout.mergeNode.assign(blockCount, 0);
+    layout.mergeChildren.assign(blockCount, {});
+    for (BlockId block : dominators.reversePostorder()) {
+        layout.rpoIndex[block] = dominators.rpoIndex(block);
+    }
+    for (BlockId block : dominators.reversePostorder()) {
+        size_t forward = 0;
+        for (BlockId pred : function.blocks[block].predecessors) {
+            if (layout.rpoIndex[pred] < layout.rpoIndex[block]) {
+                forward++;
+            } else {
+                layout.loopHeader[block] = 1;
+            }
+        }
+        layout.mergeNode[block] = forward >= 2;
+        if (layout.mergeNode[block]) {
+            layout.mergeChildren[dominators.idom(block)].push_back(block);
+        }
+    }
+    
+    std::string name = index == 0 ? "$main" : "$f" + std::to_string(index);
+    codeBuffer_ << "  ;; 函数 " << function.name << "\n";
+    codeBuffer_ << "  (func " << name;
+    for (size_t i = 0; i < function.parameters.size(); i++) {
+        codeBuffer_ << " (param $p" << i << " i32)";
+    }
+    codeBuffer_ << " (result i32)\n";
+    
+    // 每个有结果的指令一个局部变量，常量和参数除外
+    for (BlockId block : dominators.reversePostorder()) {
+        for (ValueId value : function.blocks[block].instructions) {
+            const Instruction& instruction = function.values[value];
+            if (instruction.type == IRType::I32 && instruction.op != IROpcode::CONST &&
+                instruction.op != IROpcode::PARAM) {
+                codeBuffer_ << "    (local $v" << value << " i32)\n";
+            }
+        }
+    }
+    
+    irIndent_ = 2;
+    std::vector<IRWork> work{IRWork{IRWork::Kind::TREE, 0, 0, std::string()}};
+    while (!work.empty()) {
+        IRWork item = std::move(work.back());
+        work.pop_back();
+        generateIRWork(function, layout, item, work);
+    }
+    
+    // 每条路径都以return或跳转结束，到不了这里
+    irLine("unreachable");
+    codeBuffer_ << "  )\n";
+    codeBuffer_ << "  (export \"" << function.name << "\" (func " << name << "))\n\n";
+}
+
+// 处理一项结构化工作
+void CodeGenerator::CodeGeneratorImpl::generateIRWork(const IRFunction& function, const IRLayout& layout,
+                                                      const IRWork& item, std::vector<IRWork>& work) {
+    // 展开的工作项按顺序放入，最后逆序，使最先放入的最先处理
+    size_t mark = work.size();
+    auto push = [&work](IRWork::Kind kind, BlockId a = NO_BLOCK, uint32_t b = 0, std::string text = "") {
+        work.push_back(IRWork{kind, a, b, std::move(text)});
+    };
+    std::string label = std::to_string(item.a);
+    
+    switch (item.kind) {
+        case IRWork::Kind::TREE: {
+            uint32_t merges = static_cast<uint32_t>(layout.mergeChildren[item.a].size());
+            if (layout.loopHeader[item.a]) {
+                push(IRWork::Kind::OPEN, NO_BLOCK, 0, "(loop $L" + label);
+                push(IRWork::Kind::WITHIN, item.a, merges);
+                push(IRWork::Kind::CLOSE);
+            } else {
+                push(IRWork::Kind::WITHIN, item.a, merges);
+            }
+            break;
+        }
+        case IRWork::Kind::WITHIN: {
+            if (item.b > 0) {
+                // 逆后序最靠后的汇合块在最外层：block结束之后生成它
+                BlockId merge = layout.mergeChildren[item.a][item.b - 1];
+                push(IRWork::Kind::OPEN, NO_BLOCK, 0, "(block $B" + std::to_string(merge));
+                push(IRWork::Kind::WITHIN, item.a, item.b - 1);
+                push(IRWork::Kind::CLOSE);
+                push(IRWork::Kind::TREE, merge);
+                break;
+            }
+            generateInstructions(function, item.a);
+            const BasicBlock& block = function.blocks[item.a];
+            switch (block.terminator) {
+                case Terminator::JUMP:
+                    push(IRWork::Kind::BRANCH, item.a, block.successors[0]);
+                    break;
+                case Terminator::BRANCH:
+                    irLine(valueOperand(function, block.operand));
+                    push(IRWork::Kind::OPEN, NO_BLOCK, 0, "(if");
+                    push(IRWork::Kind::OPEN, NO_BLOCK, 0, "(then");
+                    push(IRWork::Kind::BRANCH, item.a, block.successors[0]);
+                    push(IRWork::Kind::CLOSE);
+                    push(IRWork::Kind::OPEN, NO_BLOCK, 0, "(else");
+                    push(IRWork::Kind::BRANCH, item.a, block.successors[1]);
+                    push(IRWork::Kind::CLOSE);
+                    push(IRWork::Kind::CLOSE);
+                    break;
+                case Terminator::RETURN:
+                    irLine(valueOperand(function, block.operand));
+                    irLine("return");
+                    break;
+                case Terminator::NONE:
+                    irLine("unreachable");
+                    break;
+            }
+            break;
+        }
+        case IRWork::Kind::BRANCH: {
+            BlockId target = item.b;
+            generatePhiCopies(function, item.a, target);
+            if (layout.rpoIndex[target] <= layout.rpoIndex[item.a]) {
+                irLine("br $L" + std::to_string(target));
+            } else if (layout.mergeNode[target]) {
+                irLine("br $B" + std::to_string(target));
+            } else {
+                push(IRWork::Kind::TREE, target);
+            }
+            break;
+        }
+        case IRWork::Kind::OPEN:
+            irLine(item.text);
+            irIndent_++;
+            break;
+        case IRWork::Kind::CLOSE:
+            irIndent_--;
+            irLine(")");
+            break;
+    }
+    std::reverse(work.begin() + mark, work.end());
+}
+
+// 生成块中的指令
+void CodeGenerator::CodeGeneratorImpl::generateInstructions(const IRFunction& function, BlockId block) {
+    for (ValueId value : function.blocks[block].instructions) {
+        const Instruction& instruction = function.values[value];
+        const auto& operands = instruction.operands;
+        const char* wasm = nullptr;
+        switch (instruction.op) {
+            case IROpcode::CONST:
+            case IROpcode::PARAM:
+            case IROpcode::PHI:
+            case IROpcode::LOCAL_GET:
+            case IROpcode::LOCAL_SET:
+                // 常量和参数在使用处生成，phi在入边上赋值
+                continue;
+            case IROpcode::NEG:
+                irLine("i32.const 0");
+                irLine(valueOperand(function, operands[0]));
+                irLine("i32.sub");
+                break;
+            case IROpcode::NOT:
+                irLine(valueOperand(function, operands[0]));
+                irLine("i32.eqz");
+                break;
+            case IROpcode::ADD: wasm = "i32.add"; break;
+            case IROpcode::SUB: wasm = "i32.sub"; break;
+            case IROpcode::MUL: wasm = "i32.mul"; break;
+            case IROpcode::DIV: wasm = "i32.div_s"; break;
+            case IROpcode::REM: wasm = "i32.rem_s"; break;
+            case IROpcode::EQ:  wasm = "i32.eq"; break;
+            case IROpcode::NE:  wasm = "i32.ne"; break;
+            case IROpcode::LT:  wasm = "i32.lt_s"; break;
+            case IROpcode::LE:  wasm = "i32.le_s"; break;
+            case IROpcode::GT:  wasm = "i32.gt_s"; break;
+            case IROpcode::GE:  wasm = "i32.ge_s"; break;
+            case IROpcode::AND: wasm = "i32.and"; break;
+            case IROpcode::OR:  wasm = "i32.or"; break;
+            case IROpcode::LOAD_GLOBAL:
+                irLine("global.get $g" + std::to_string(instruction.imm));
+                break;
+            case IROpcode::STORE_GLOBAL:
+                irLine(valueOperand(function, operands[0]));
+                irLine("global.set $g" + std::to_string(instruction.imm));
+                break;
+            case IROpcode::CALL:
+                for (ValueId operand : operands) {
+                    irLine(valueOperand(function, operand));
+                }
+                irLine("call $f" + std::to_string(instruction.imm));
+                break;
+            case IROpcode::ASK:
+                irLine(valueOperand(function, operands[0]));
+                irLine(valueOperand(function, operands[1]));
+                irLine("call $ask");
+                break;
+            case IROpcode::PRINT:
+                irLine(valueOperand(function, operands[0]));
+                irLine("call $print_number");
+                break;
+            case IROpcode::PRINT_STRING:
+                irLine("i32.const " + std::to_string(stringAddresses_[instruction.imm]));
+                irLine("call $console_log_str");
+                break;
+        }
+        if (wasm != nullptr) {
+            irLine(valueOperand(function, operands[0]));
+            irLine(valueOperand(function, operands[1]));
+            irLine(wasm);
+        }
+        if (instruction.type == IRType::I32) {
+            irLine("local.set $v" + std::to_string(value));
+        }
+    }
+}
+
+// phi的赋值：先把所有入值压栈再逆序写入，phi之间互相引用时也取的是跳转前的值
+void CodeGenerator::CodeGeneratorImpl::generatePhiCopies(const IRFunction& function, BlockId from, BlockId to) {
+    const BasicBlock& target = function.blocks[to];
+    size_t index = static_cast<size_t>(
+        std::find(target.predecessors.begin(), target.predecessors.end(), from) - target.predecessors.begin());
+    std::vector<ValueId> phis;
+    for (ValueId value : target.instructions) {
+        if (function.values[value].op != IROpcode::PHI) {
+            break;
+        }
+        phis.push_back(value);
+        irLine(valueOperand(function, function.values[value].operands[index]));
+    }
+    for (auto it = phis.rbegin(); it != phis.rend(); ++it) {
+        irLine("local.set $v" + std::to_string(*it));
+    }
+}
+
+// 把值压栈的指令
+std::string CodeGenerator::CodeGeneratorImpl::valueOperand(const IRFunction& function, ValueId value) const {
+    const Instruction& instruction = function.values[value];
+    if (instruction.op == IROpcode::CONST) {
+        return "i32.const " + std::to_string(instruction.imm);
+    }
+    if (instruction.op == IROpcode::PARAM) {
+        return "local.get $p" + std::to_string(instruction.imm);
+    }
+    return "local.get $v" + std::to_string(value);
+}
+
 // 构造函数
 CodeGenerator::CodeGenerator() : impl_(std::make_unique<CodeGeneratorImpl>()) {
 }
@@ -674,8 +1200,13 @@ CodeGenerator::CodeGenerator() : impl_(std::make_unique<CodeGeneratorImpl>()) {
 CodeGenerator::~CodeGenerator() = default;
 
 // 生成代码
-void CodeGenerator::generateCode(const std::vector<std::unique_ptr<Stmt>>& ast, const std::string& outputFile) {
-    impl_->generateCode(ast, outputFile);
+void CodeGenerator::generateCode(const Program& program, const std::string& outputFile) {
+    impl_->generateCode(program, outputFile);
+}
+
+// 从中间表示生成代码
+void CodeGenerator::generateCode(const IRModule& module, const std::string& outputFile) {
+    impl_->generateCode(module, outputFile);
 }
 
 } // namespace jvav 
\ No newline at end of file
@@ -1,29 +1,33 @@
 #include "codegen/LLVMCodeGenerator.h"
+#include "ir/Dominators.h"
+#include <cstdlib>
 #include <iostream>
-#include <fstream>
-#include <sstream>
-#include <unordered_map>
 #include <system_error>
-#include <optional>
 
 // 引入LLVM库的头文件（如果LLVM依赖已安装）
 #ifdef JVAV_HAS_LLVM
+#include <llvm/Config/llvm-config.h>
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/Verifier.h>
+#include <llvm/IR/LegacyPassManager.h>
 #include <llvm/Support/TargetSelect.h>
 #include <llvm/Support/FileSystem.h>
-#include <llvm/TargetParser/Host.h>
 #include <llvm/Support/raw_ostream.h>
-#include <llvm/MC/TargetRegistry.h>
 #include <llvm/Target/TargetMachine.h>
-#include <llvm/CodeGen/CodeGenCommonISel.h>
-#include <llvm/IR/LegacyPassManager.h>
-#include <llvm/Transforms/InstCombine/InstCombine.h>
-#include <llvm/Transforms/Scalar.h>
-#include <llvm/Transforms/Scalar/GVN.h>
-#include <llvm/Transforms/Utils.h>
+#include <llvm/Target/TargetOptions.h>
+// 这两个头文件在不同的LLVM版本中位置不同
+#if LLVM_VERSION_MAJOR >= 17
+#include <llvm/TargetParser/Host.h>
+#else
+#include <llvm/Support/Host.h>
+#endif
+#if LLVM_VERSION_MAJOR >= 14
+#include <llvm/MC/TargetRegistry.h>
+#else
+#include <llvm/Support/TargetRegistry.h>
+#endif
 #endif
 
 namespace jvav {
@@ -35,7 +39,7 @@ public:
     ~LLVMCodeGeneratorImpl() {}
 
     bool generateCode(
-        const std::vector<std::unique_ptr<Stmt>>& ast, 
+        const IRModule& program,
         const std::string& outputFile,
         JvavTargetType targetType,
         const std::string& targetPlatform
@@ -79,14 +83,13 @@ public:
         }
 
         llvm::TargetOptions opt;
-        auto RM = std::optional<llvm::Reloc::Model>(llvm::Reloc::PIC_);
         auto targetMachine = target->createTargetMachine(
-            targetTriple, "generic", "", opt, RM);
+            targetTriple, "generic", "", opt, llvm::Reloc::PIC_);
 
         module->setDataLayout(targetMachine->createDataLayout());
 
-        // 将AST转换为LLVM IR
-        if (!generateLLVMIR(ast, module.get(), builder)) {
+        // 将中间表示转换为LLVM IR
+        if (!generateLLVMIR(program, module.get(), builder)) {
             std::cerr << "LLVM IR生成失败" << std::endl;
             return false;
         }
@@ -111,26 +114,17 @@ public:
             module->print(dest, nullptr);
             return true;
         } else {
-            // 创建一个PassManager进行优化
+            // 中间表示已经是SSA并按优化级别优化过，这里只需要目标机器的代码生成
             llvm::legacy::PassManager passManager;
-            
-            // 添加一些基本优化
-            passManager.add(llvm::createPromoteMemoryToRegisterPass());
-            passManager.add(llvm::createInstructionCombiningPass());
-            passManager.add(llvm::createReassociatePass());
-            passManager.add(llvm::createGVNPass());
-            passManager.add(llvm::createCFGSimplificationPass());
 
-            // 根据目标类型设置输出格式
-            llvm::CodeGenFileType fileType;
-            if (targetType == JvavTargetType::OBJECT_FILE) {
-                fileType = llvm::CodeGenFileType::ObjectFile;
-            } else if (targetType == JvavTargetType::ASSEMBLY) {
-                fileType = llvm::CodeGenFileType::AssemblyFile;
-            } else {
-                // 默认输出对象文件，然后由外部链接器链接
-                fileType = llvm::CodeGenFileType::ObjectFile;
-            }
+            // 汇编输出汇编代码，其余输出对象文件，可执行文件再由外部链接器链接
+#if LLVM_VERSION_MAJOR >= 18
+            llvm::CodeGenFileType fileType = targetType == JvavTargetType::ASSEMBLY
+                ? llvm::CodeGenFileType::AssemblyFile : llvm::CodeGenFileType::ObjectFile;
+#else
+            llvm::CodeGenFileType fileType = targetType == JvavTargetType::ASSEMBLY
+                ? llvm::CGFT_AssemblyFile : llvm::CGFT_ObjectFile;
+#endif
 
             // 输出到文件
             std::error_code EC;
@@ -166,234 +160,246 @@ public:
 
 private:
 #ifdef JVAV_HAS_LLVM
-    // 将AST转换为LLVM IR
+    // 将中间表示转换为LLVM IR
     bool generateLLVMIR(
-        const std::vector<std::unique_ptr<Stmt>>& ast,
+        const IRModule& program,
         llvm::Module* module,
         llvm::IRBuilder<>& builder
     ) {
-        // 创建一个全局上下文
         llvm::LLVMContext& context = module->getContext();
+        module_ = module;
+        builder_ = &builder;
+        int32Type_ = llvm::Type::getInt32Ty(context);
         
         // 声明printf函数
         std::vector<llvm::Type*> printfArgs;
         printfArgs.push_back(llvm::PointerType::get(llvm::Type::getInt8Ty(context), 0));
-        llvm::FunctionType* printfType = llvm::FunctionType::get(
-            llvm::Type::getInt32Ty(context), printfArgs, true);
-        llvm::Function* printfFunc = llvm::Function::Create(
-            printfType, llvm::Function::ExternalLinkage, "printf", module);
-
-        // 创建main函数
-        llvm::FunctionType* mainType = llvm::FunctionType::get(
-            llvm::Type::getInt32Ty(context), false);
-        llvm::Function* mainFunc = llvm::Function::Create(
-            mainType, llvm::Function::ExternalLinkage, "main", module);
+        llvm::FunctionType* printfType = llvm::FunctionType::get(int32Type_, printfArgs, true);
+        printfFunc_ = llvm::Function::Create(printfType, llvm::Function::ExternalLinkage, "printf", module);
+        trapFunc_ = module->getOrInsertFunction("llvm.trap", llvm::FunctionType::get(
+            llvm::Type::getVoidTy(context), false));
+        // 陷入前刷新输出缓冲区，已打印的内容与WebAssembly一致
+        fflushFunc_ = module->getOrInsertFunction("fflush", llvm::FunctionType::get(
+            int32Type_, {llvm::PointerType::get(llvm::Type::getInt8Ty(context), 0)}, false));
+        numberFormat_ = createString("%d\n");
+        stringFormat_ = createString("%s\n");
         
-        // 创建main函数的基本块
-        llvm::BasicBlock* mainBlock = llvm::BasicBlock::Create(context, "entry", mainFunc);
-        builder.SetInsertPoint(mainBlock);
-
-        // 用于存储变量的映射表
-        std::unordered_map<std::string, llvm::Value*> variables;
+        // 全局变量
+        globals_.clear();
+        for (const std::string& name : program.globals) {
+            globals_.push_back(new llvm::GlobalVariable(
+                *module, int32Type_, false, llvm::GlobalValue::InternalLinkage,
+                llvm::ConstantInt::get(int32Type_, 0), "jvav_" + name));
+        }
+        strings_.clear();
+        for (const std::string& text : program.strings) {
+            strings_.push_back(createString(text));
+        }
         
-        // 遍历AST并生成LLVM IR
-        for (const auto& stmt : ast) {
-            if (!generateStmt(stmt.get(), module, builder, variables, printfFunc)) {
+        // 先声明所有函数，调用可以出现在定义之前
+        functions_.clear();
+        for (size_t i = 0; i < program.functions.size(); i++) {
+            const IRFunction& function = program.functions[i];
+            std::vector<llvm::Type*> parameters(function.parameters.size(), int32Type_);
+            llvm::FunctionType* type = llvm::FunctionType::get(int32Type_, parameters, false);
+            functions_.push_back(i == 0
+                ? llvm::Function::Create(type, llvm::Function::ExternalLinkage, "main", module)
+                : llvm::Function::Create(type, llvm::Function::InternalLinkage, "jvav_" + function.name, module));
+        }
+        for (size_t i = 0; i < program.functions.size(); i++) {
+            if (!generateFunction(program.functions[i], functions_[i])) {
                 return false;
             }
         }
-        
-        // 返回0表示程序成功执行
-        builder.CreateRet(llvm::ConstantInt::get(context, llvm::APInt(32, 0)));
-        
         return true;
     }
     
-    // 生成语句的LLVM IR
-    bool generateStmt(
-        const Stmt* stmt,
-        llvm::Module* module,
-        llvm::IRBuilder<>& builder,
-        std::unordered_map<std::string, llvm::Value*>& variables,
-        llvm::Function* printfFunc
-    ) {
-        // 根据语句类型生成不同的IR
-        switch (stmt->getType()) {
-            case StmtType::PRINT:
-                return generatePrintStmt(static_cast<const PrintStmt*>(stmt), 
-                                        module, builder, variables, printfFunc);
-            case StmtType::SET:
-                return generateSetStmt(static_cast<const SetStmt*>(stmt), 
-                                      module, builder, variables);
-            case StmtType::IF:
-                return generateIfStmt(static_cast<const IfStmt*>(stmt), 
-                                     module, builder, variables, printfFunc);
-            // 其他语句类型...
-            default:
-                std::cerr << "未实现的语句类型: " << static_cast<int>(stmt->getType()) << std::endl;
-                return false;
-        }
-    }
-    
-    // 生成打印语句的LLVM IR
-    bool generatePrintStmt(
-        const PrintStmt* stmt,
-        llvm::Module* module,
-        llvm::IRBuilder<>& builder,
-        std::unordered_map<std::string, llvm::Value*>& variables,
-        llvm::Function* printfFunc
-    ) {
-        // 简单实现：目前只支持直接的字符串字面量
-        if (stmt->value->getType() == ExprType::LITERAL) {
-            auto* literalExpr = static_cast<const LiteralExpr*>(stmt->value.get());
-            if (literalExpr->token.getType() == TokenType::STRING_LITERAL) {
-                // 获取字符串值
-                std::string strValue = literalExpr->token.getValue();
-                // 删除引号
-                strValue = strValue.substr(1, strValue.length() - 2);
-                // 添加换行符
-                strValue += "\n";
-                
-                // 创建全局字符串常量
-                llvm::Constant* strConstant = llvm::ConstantDataArray::getString(
-                    module->getContext(), strValue, true);
-                llvm::GlobalVariable* strGlobal = new llvm::GlobalVariable(
-                    *module, strConstant->getType(), true,
-                    llvm::GlobalValue::PrivateLinkage, strConstant, ".str");
-                
-                // 创建对全局字符串的引用
-                llvm::Constant* zero = llvm::ConstantInt::get(
-                    llvm::Type::getInt32Ty(module->getContext()), 0);
-                llvm::Constant* indices[] = {zero, zero};
-                llvm::Constant* strPtr = llvm::ConstantExpr::getGetElementPtr(
-                    strGlobal->getValueType(), strGlobal, indices, true);
-                
-                // 调用printf函数
-                std::vector<llvm::Value*> args;
-                args.push_back(strPtr);
-                builder.CreateCall(printfFunc, args);
-                
-                return true;
-            }
-        }
+    // 生成一个函数
+    // 按逆后序生成，操作数的定义总在使用之前；phi的入值在所有块生成之后补上。
+    // 除法的检查会拆分块，phi的入边要用中间表示的前驱块最后对应的LLVM块。
+    bool generateFunction(const IRFunction& function, llvm::Function* llvmFunction) {
+        llvm::LLVMContext& context = module_->getContext();
+        DominatorTree dominators(function);
         
-        std::cerr << "暂时只支持直接的字符串字面量打印" << std::endl;
-        return false;
-    }
-    
-    // 生成设置变量语句的LLVM IR
-    bool generateSetStmt(
-        const SetStmt* stmt,
-        llvm::Module* module,
-        llvm::IRBuilder<>& builder,
-        std::unordered_map<std::string, llvm::Value*>& variables
-    ) {
-        // 暂时只支持整数字面量赋值
-        if (stmt->value->getType() == ExprType::LITERAL) {
-            auto* literalExpr = static_cast<const LiteralExpr*>(stmt->value.get());
-            if (literalExpr->token.getType() == TokenType::NUMBER_LITERAL) {
-                // 解析数字
-                int numValue = std::stoi(literalExpr->token.getValue());
-                
-                // 创建整数常量
-                llvm::Value* val = llvm::ConstantInt::get(
-                    llvm::Type::getInt32Ty(module->getContext()), numValue);
-                
-                // 为变量分配内存
-                std::string varName = stmt->name.getValue();
-                llvm::AllocaInst* alloca = builder.CreateAlloca(
-                    llvm::Type::getInt32Ty(module->getContext()), nullptr, varName);
-                
-                // 存储值
-                builder.CreateStore(val, alloca);
-                
-                // 将变量添加到映射表
-                variables[varName] = alloca;
-                
-                return true;
-            }
+        std::vector<llvm::BasicBlock*> blocks(function.blocks.size(), nullptr);
+        std::vector<llvm::BasicBlock*> lastBlocks(function.blocks.size(), nullptr);
+        for (BlockId block : dominators.reversePostorder()) {
+            blocks[block] = llvm::BasicBlock::Create(context, "b" + std::to_string(block), llvmFunction);
         }
         
-        std::cerr << "暂时只支持整数字面量赋值" << std::endl;
-        return false;
-    }
-    
-    // 生成if语句的LLVM IR
-    bool generateIfStmt(
-        const IfStmt* stmt,
-        llvm::Module* module,
-        llvm::IRBuilder<>& builder,
-        std::unordered_map<std::string, llvm::Value*>& variables,
-        llvm::Function* printfFunc
-    ) {
-        // 暂时只实现简单的条件
-        llvm::Value* condValue = nullptr;
-        
-        // 创建基本块
-        llvm::Function* function = builder.GetInsertBlock()->getParent();
-        llvm::BasicBlock* thenBlock = llvm::BasicBlock::Create(
-            module->getContext(), "then", function);
-        llvm::BasicBlock* elseBlock = nullptr;
-        
-        // 检查是否有else分支（第二个分支）
-        bool hasElse = stmt->branches.size() > 1;
-        
-        if (hasElse) {
-            elseBlock = llvm::BasicBlock::Create(module->getContext(), "else", function);
+        values_.assign(function.values.size(), nullptr);
+        std::vector<llvm::Argument*> arguments;
+        for (llvm::Argument& argument : llvmFunction->args()) {
+            arguments.push_back(&argument);
         }
-        llvm::BasicBlock* mergeBlock = llvm::BasicBlock::Create(
-            module->getContext(), "ifcont", function);
         
-        // 简单条件实现 - 暂时只支持布尔字面量
-        if (stmt->branches[0].condition->getType() == ExprType::LITERAL) {
-            auto* literalExpr = static_cast<const LiteralExpr*>(stmt->branches[0].condition.get());
-            if (literalExpr->token.getType() == TokenType::BOOL_LITERAL && 
-                literalExpr->token.getValue() == "true") {
-                condValue = llvm::ConstantInt::getTrue(module->getContext());
-            } else if (literalExpr->token.getType() == TokenType::BOOL_LITERAL && 
-                       literalExpr->token.getValue() == "false") {
-                condValue = llvm::ConstantInt::getFalse(module->getContext());
+        std::vector<ValueId> phis;
+        for (BlockId id : dominators.reversePostorder()) {
+            const BasicBlock& block = function.blocks[id];
+            builder_->SetInsertPoint(blocks[id]);
+            for (ValueId value : block.instructions) {
+                const Instruction& instruction = function.values[value];
+                if (instruction.op == IROpcode::PHI) {
+                    values_[value] = builder_->CreatePHI(int32Type_, static_cast<unsigned>(instruction.operands.size()));
+                    phis.push_back(value);
+                } else if (instruction.op == IROpcode::PARAM) {
+                    values_[value] = arguments[instruction.imm];
+                } else if (!generateInstruction(instruction, value)) {
+                    return false;
+                }
             }
+            
+            switch (block.terminator) {
+                case Terminator::JUMP:
+                    builder_->CreateBr(blocks[block.successors[0]]);
+                    break;
+                case Terminator::BRANCH:
+                    builder_->CreateCondBr(builder_->CreateICmpNE(values_[block.operand], constant(0)),
+                                           blocks[block.successors[0]], blocks[block.successors[1]]);
+                    break;
+                case Terminator::RETURN:
+                    builder_->CreateRet(values_[block.operand]);
+                    break;
+                case Terminator::NONE:
+                    builder_->CreateUnreachable();
+                    break;
+            }
+            lastBlocks[id] = builder_->GetInsertBlock();
         }
         
-        if (!condValue) {
-            std::cerr << "暂时只支持布尔字面量条件" << std::endl;
-            return false;
-        }
-        
-        // 创建条件分支
-        if (hasElse) {
-            builder.CreateCondBr(condValue, thenBlock, elseBlock);
-        } else {
-            builder.CreateCondBr(condValue, thenBlock, mergeBlock);
-        }
-        
-        // 生成then分支代码
-        builder.SetInsertPoint(thenBlock);
-        for (const auto& thenStmt : stmt->branches[0].body) {
-            if (!generateStmt(thenStmt.get(), module, builder, variables, printfFunc)) {
-                return false;
+        for (ValueId value : phis) {
+            const Instruction& instruction = function.values[value];
+            auto* phi = llvm::cast<llvm::PHINode>(values_[value]);
+            const auto& predecessors = function.blocks[instruction.block].predecessors;
+            for (size_t i = 0; i < predecessors.size(); i++) {
+                phi->addIncoming(values_[instruction.operands[i]], lastBlocks[predecessors[i]]);
             }
         }
-        builder.CreateBr(mergeBlock);
-        
-        // 生成else分支代码
-        if (hasElse) {
-            builder.SetInsertPoint(elseBlock);
-            for (const auto& elseStmt : stmt->branches[1].body) {
-                if (!generateStmt(elseStmt.get(), module, builder, variables, printfFunc)) {
-                    return false;
+        return true;
+    }
+    
+    // 生成一条指令
+    bool generateInstruction(const Instruction& instruction, ValueId value) {
+        auto operand = [this, &instruction](size_t i) { return values_[instruction.operands[i]]; };
+        auto boolean = [this](llvm::Value* condition) { return builder_->CreateZExt(condition, int32Type_); };
+        llvm::Value* result = nullptr;
+        switch (instruction.op) {
+            case IROpcode::CONST:
+                result = constant(instruction.imm);
+                break;
+            case IROpcode::NEG: result = builder_->CreateNeg(operand(0)); break;
+            case IROpcode::NOT: result = boolean(builder_->CreateICmpEQ(operand(0), constant(0))); break;
+            case IROpcode::ADD: result = builder_->CreateAdd(operand(0), operand(1)); break;
+            case IROpcode::SUB: result = builder_->CreateSub(operand(0), operand(1)); break;
+            case IROpcode::MUL: result = builder_->CreateMul(operand(0), operand(1)); break;
+            case IROpcode::DIV: result = generateDivision(operand(0), operand(1), false); break;
+            case IROpcode::REM: result = generateDivision(operand(0), operand(1), true); break;
+            case IROpcode::EQ: result = boolean(builder_->CreateICmpEQ(operand(0), operand(1))); break;
+            case IROpcode::NE: result = boolean(builder_->CreateICmpNE(operand(0), operand(1))); break;
+            case IROpcode::LT: result = boolean(builder_->CreateICmpSLT(operand(0), operand(1))); break;
+            case IROpcode::LE: result = boolean(builder_->CreateICmpSLE(operand(0), operand(1))); break;
+            case IROpcode::GT: result = boolean(builder_->CreateICmpSGT(operand(0), operand(1))); break;
+            case IROpcode::GE: result = boolean(builder_->CreateICmpSGE(operand(0), operand(1))); break;
+            case IROpcode::AND: result = builder_->CreateAnd(operand(0), operand(1)); break;
+            case IROpcode::OR:  result = builder_->CreateOr(operand(0), operand(1)); break;
+            case IROpcode::LOAD_GLOBAL:
+                result = builder_->CreateLoad(int32Type_, globals_[instruction.imm]);
+                break;
+            case IROpcode::STORE_GLOBAL:
+                builder_->CreateStore(operand(0), globals_[instruction.imm]);
+                break;
+            case IROpcode::CALL: {
+                std::vector<llvm::Value*> arguments;
+                for (size_t i = 0; i < instruction.operands.size(); i++) {
+                    arguments.push_back(operand(i));
                 }
+                result = builder_->CreateCall(functions_[instruction.imm], arguments);
+                break;
             }
-            builder.CreateBr(mergeBlock);
+            case IROpcode::PRINT:
+                builder_->CreateCall(printfFunc_, {numberFormat_, operand(0)});
+                break;
+            case IROpcode::PRINT_STRING:
+                builder_->CreateCall(printfFunc_, {stringFormat_, strings_[instruction.imm]});
+                break;
+            case IROpcode::ASK:
+                std::cerr << "LLVM后端不支持ask" << std::endl;
+                return false;
+            default:
+                std::cerr << "未实现的中间表示指令: " << opcodeName(instruction.op) << std::endl;
+                return false;
         }
-        
-        // 设置合并块为当前插入点
-        builder.SetInsertPoint(mergeBlock);
-        
+        values_[value] = result;
         return true;
     }
     
+    // 有符号除法和取余，与WebAssembly一致：除以0和INT32_MIN / -1陷入，x % -1为0
+    // LLVM中这些情况是未定义行为，不能直接生成sdiv/srem
+    llvm::Value* generateDivision(llvm::Value* a, llvm::Value* b, bool remainder) {
+        llvm::ConstantInt* divisor = llvm::dyn_cast<llvm::ConstantInt>(b);
+        bool safe = divisor != nullptr && !divisor->isZero() && !divisor->isMinusOne();
+        if (!safe) {
+            llvm::Value* trap = builder_->CreateICmpEQ(b, constant(0));
+            if (!remainder) {
+                trap = builder_->CreateOr(trap, builder_->CreateAnd(
+                    builder_->CreateICmpEQ(a, constant(INT32_MIN)), builder_->CreateICmpEQ(b, constant(-1))));
+            }
+            llvm::Function* function = builder_->GetInsertBlock()->getParent();
+            llvm::BasicBlock* trapBlock = llvm::BasicBlock::Create(module_->getContext(), "trap", function);
+            llvm::BasicBlock* next = llvm::BasicBlock::Create(module_->getContext(), "div", function);
+            builder_->CreateCondBr(trap, trapBlock, next);
+            builder_->SetInsertPoint(trapBlock);
+            builder_->CreateCall(fflushFunc_, {llvm::ConstantPointerNull::get(
+                llvm::PointerType::get(llvm::Type::getInt8Ty(module_->getContext()), 0))});
+            builder_->CreateCall(trapFunc_);
+            builder_->CreateUnreachable();
+            builder_->SetInsertPoint(next);
+        }
+        if (!remainder) {
+            return builder_->CreateSDiv(a, b);
+        }
+        if (safe) {
+            return builder_->CreateSRem(a, b);
+        }
+        llvm::Value* minusOne = builder_->CreateICmpEQ(b, constant(-1));
+        llvm::Value* rem = builder_->CreateSRem(a, builder_->CreateSelect(minusOne, constant(1), b));
+        return builder_->CreateSelect(minusOne, constant(0), rem);
+    }
+    
+    // i32常量
+    llvm::Constant* constant(int32_t value) {
+        return llvm::ConstantInt::get(int32Type_, static_cast<uint64_t>(static_cast<int64_t>(value)), true);
+    }
+    
+    // 以0结尾的全局字符串常量，返回指向第一个字符的指针
+    llvm::Constant* createString(const std::string& text) {
+        llvm::Constant* strConstant = llvm::ConstantDataArray::getString(module_->getContext(), text, true);
+        llvm::GlobalVariable* strGlobal = new llvm::GlobalVariable(
+            *module_, strConstant->getType(), true,
+            llvm::GlobalValue::PrivateLinkage, strConstant, ".str");
+        llvm::Constant* zero = constant(0);
+        llvm::Constant* indices[] = {zero, zero};
+        return llvm::ConstantExpr::getGetElementPtr(strGlobal->getValueType(), strGlobal, indices, true);
+    }
+    
+    // 正在生成的模块、IR构造器
+    llvm::Module* module_ = nullptr;
+    llvm::IRBuilder<>* builder_ = nullptr;
+    llvm::Type* int32Type_ = nullptr;
+    
+    // 运行时函数和格式字符串
+    llvm::Function* printfFunc_ = nullptr;
+    llvm::FunctionCallee trapFunc_;
+    llvm::FunctionCallee fflushFunc_;
+    llvm::Constant* numberFormat_ = nullptr;
+    llvm::Constant* stringFormat_ = nullptr;
+    
+    // 按中间表示中的编号索引的全局变量、字符串、函数和当前函数中的值
+    std::vector<llvm::GlobalVariable*> globals_;
+    std::vector<llvm::Constant*> strings_;
+    std::vector<llvm::Function*> functions_;
+    std::vector<llvm::Value*> values_;
+    
     // 链接生成可执行文件
     bool linkExecutable(const std::string& objFile, const std::string& targetTriple) {
         // 使用系统链接器链接目标文件
@@ -427,12 +433,12 @@ LLVMCodeGenerator::~LLVMCodeGenerator() = default;
 
 // 生成代码
 bool LLVMCodeGenerator::generateCode(
-    const std::vector<std::unique_ptr<Stmt>>& ast, 
+    const IRModule& program,
     const std::string& outputFile,
     JvavTargetType targetType,
     const std::string& targetPlatform
 ) {
-    return impl_->generateCode(ast, outputFile, targetType, targetPlatform);
+    return impl_->generateCode(program, outputFile, targetType, targetPlatform);
 }
 
 } // namespace jvav 
\ No newline at end of file
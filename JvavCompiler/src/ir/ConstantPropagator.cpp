@@ -0,0 +1,244 @@
+#include "ir/ConstantPropagator.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace jvav {
+
+namespace {
+
+// 格：UNDEFINED（还没有算出）< CONSTANT < OVERDEFINED（不是常量）
+struct Lattice {
+    enum class State : uint8_t { UNDEFINED, CONSTANT, OVERDEFINED };
+    State state = State::UNDEFINED;
+    int32_t value = 0;
+
+    bool isConstant() const { return state == State::CONSTANT; }
+    bool isUndefined() const { return state == State::UNDEFINED; }
+    bool isOverdefined() const { return state == State::OVERDEFINED; }
+};
+
+} // namespace
+
+// 稀疏条件常量传播
+void ConstantPropagator::run(IRFunction& function) {
+    folded_ = 0;
+    removedBlocks_ = 0;
+
+    size_t valueCount = function.values.size();
+    size_t blockCount = function.blocks.size();
+
+    // 每个值的使用者：指令，以及以它为条件的块
+    std::vector<std::vector<ValueId>> users(valueCount);
+    std::vector<std::vector<BlockId>> branchUsers(valueCount);
+    for (BlockId id = 0; id < blockCount; id++) {
+        const BasicBlock& block = function.blocks[id];
+        if (block.removed) {
+            continue;
+        }
+        for (ValueId value : block.instructions) {
+            for (ValueId operand : function.values[value].operands) {
+                users[operand].push_back(value);
+            }
+        }
+        if (block.terminator == Terminator::BRANCH) {
+            branchUsers[block.operand].push_back(id);
+        }
+    }
+
+    std::vector<Lattice> lattice(valueCount);
+    std::vector<uint8_t> executable(blockCount, 0);
+    // edges[b][i]：从b的第i个前驱到b的边可能执行
+    std::vector<std::vector<uint8_t>> edges(blockCount);
+    for (BlockId id = 0; id < blockCount; id++) {
+        edges[id].assign(function.blocks[id].predecessors.size(), 0);
+    }
+
+    std::vector<std::pair<BlockId, BlockId>> flowWork{{NO_BLOCK, 0}};
+    std::vector<ValueId> valueWork;
+
+    auto lower = [&lattice, &valueWork](ValueId value, Lattice next) {
+        Lattice& current = lattice[value];
+        if (next.state == current.state && (!next.isConstant() || next.value == current.value)) {
+            return;
+        }
+        current = next;
+        valueWork.push_back(value);
+    };
+
+    auto evaluate = [&](ValueId value) {
+        const Instruction& instruction = function.values[value];
+        if (instruction.type == IRType::VOID) {
+            return;
+        }
+        Lattice result;
+        switch (instruction.op) {
+            case IROpcode::CONST:
+                result.state = Lattice::State::CONSTANT;
+                result.value = instruction.imm;
+                break;
+            case IROpcode::PHI: {
+                const auto& predecessors = function.blocks[instruction.block].predecessors;
+                for (size_t i = 0; i < predecessors.size(); i++) {
+                    if (!edges[instruction.block][i]) {
+                        continue;
+                    }
+                    const Lattice& operand = lattice[instruction.operands[i]];
+                    if (operand.isUndefined()) {
+                        continue;
+                    }
+                    if (operand.isOverdefined() || (result.isConstant() && result.value != operand.value)) {
+                        result.state = Lattice::State::OVERDEFINED;
+                        break;
+                    }
+                    result = operand;
+                }
+                break;
+            }
+            case IROpcode::NEG:
+            case IROpcode::NOT:
+            case IROpcode::ADD: case IROpcode::SUB: case IROpcode::MUL:
+            case IROpcode::DIV: case IROpcode::REM:
+            case IROpcode::EQ: case IROpcode::NE: case IROpcode::LT:
+            case IROpcode::LE: case IROpcode::GT: case IROpcode::GE:
+            case IROpcode::AND: case IROpcode::OR: {
+                const Lattice& a = lattice[instruction.operands[0]];
+                const Lattice& b = instruction.operands.size() > 1 ? lattice[instruction.operands[1]] : a;
+                if (a.isOverdefined() || b.isOverdefined()) {
+                    result.state = Lattice::State::OVERDEFINED;
+                } else if (a.isConstant() && b.isConstant()) {
+                    // 会陷入的运算不折叠，留到运行时
+                    if (foldInstruction(instruction.op, a.value, b.value, result.value)) {
+                        result.state = Lattice::State::CONSTANT;
+                    } else {
+                        result.state = Lattice::State::OVERDEFINED;
+                    }
+                }
+                break;
+            }
+            default:
+                // 参数、读全局变量、调用和输入
+                result.state = Lattice::State::OVERDEFINED;
+                break;
+        }
+        lower(value, result);
+    };
+
+    auto markEdge = [&](BlockId from, BlockId to) {
+        flowWork.emplace_back(from, to);
+    };
+
+    auto evaluateTerminator = [&](BlockId id) {
+        const BasicBlock& block = function.blocks[id];
+        if (block.terminator == Terminator::JUMP) {
+            markEdge(id, block.successors[0]);
+        } else if (block.terminator == Terminator::BRANCH) {
+            const Lattice& condition = lattice[block.operand];
+            if (condition.isConstant()) {
+                markEdge(id, block.successors[condition.value != 0 ? 0 : 1]);
+            } else if (condition.isOverdefined()) {
+                markEdge(id, block.successors[0]);
+                markEdge(id, block.successors[1]);
+            }
+        }
+    };
+
+    while (!flowWork.empty() || !valueWork.empty()) {
+        while (!flowWork.empty()) {
+            auto [from, to] = flowWork.back();
+            flowWork.pop_back();
+
+            BlockId target = from == NO_BLOCK ? 0 : to;
+            if (from != NO_BLOCK) {
+                const auto& predecessors = function.blocks[target].predecessors;
+                size_t index = static_cast<size_t>(
+                    std::find(predecessors.begin(), predecessors.end(), from) - predecessors.begin());
+                if (edges[target][index]) {
+                    continue;
+                }
+                edges[target][index] = 1;
+            }
+
+            if (executable[target]) {
+                // 块已经处理过，只有phi因为新的边需要重新计算
+                for (ValueId value : function.blocks[target].instructions) {
+                    if (function.values[value].op != IROpcode::PHI) {
+                        break;
+                    }
+                    evaluate(value);
+                }
+                continue;
+            }
+            executable[target] = 1;
+            for (ValueId value : function.blocks[target].instructions) {
+                evaluate(value);
+            }
+            evaluateTerminator(target);
+        }
+
+        while (!valueWork.empty()) {
+            ValueId value = valueWork.back();
+            valueWork.pop_back();
+            for (ValueId user : users[value]) {
+                if (executable[function.values[user].block]) {
+                    evaluate(user);
+                }
+            }
+            for (BlockId block : branchUsers[value]) {
+                if (executable[block]) {
+                    evaluateTerminator(block);
+                }
+            }
+        }
+    }
+
+    // 条件为常量的跳转只保留会走的边，先全部找出来再删，删边会改变前驱的下标
+    auto edgeTaken = [&function, &edges](BlockId from, BlockId to) {
+        const auto& predecessors = function.blocks[to].predecessors;
+        size_t index = static_cast<size_t>(
+            std::find(predecessors.begin(), predecessors.end(), from) - predecessors.begin());
+        return edges[to][index] != 0;
+    };
+    std::vector<std::pair<BlockId, BlockId>> deadEdges;
+    for (BlockId id = 0; id < blockCount; id++) {
+        const BasicBlock& block = function.blocks[id];
+        if (!executable[id] || block.terminator != Terminator::BRANCH) {
+            continue;
+        }
+        bool trueTaken = edgeTaken(id, block.successors[0]);
+        bool falseTaken = edgeTaken(id, block.successors[1]);
+        if (trueTaken != falseTaken) {
+            deadEdges.emplace_back(id, block.successors[trueTaken ? 1 : 0]);
+        }
+    }
+
+    // 值为常量的指令换成入口块中的常量，同一个常量只建一次
+    std::unordered_map<int32_t, ValueId> constants;
+    std::vector<ValueId> replacement(valueCount, NO_VALUE);
+    for (ValueId value = 0; value < valueCount; value++) {
+        const Instruction& instruction = function.values[value];
+        if (instruction.op == IROpcode::CONST || !lattice[value].isConstant() || !executable[instruction.block]) {
+            continue;
+        }
+        int32_t constant = lattice[value].value;
+        auto found = constants.find(constant);
+        if (found == constants.end()) {
+            found = constants.emplace(constant, function.constant(constant)).first;
+        }
+        replacement[value] = found->second;
+        folded_++;
+    }
+    for (BasicBlock& block : function.blocks) {
+        auto& list = block.instructions;
+        list.erase(std::remove_if(list.begin(), list.end(), [&replacement](ValueId value) {
+            return value < replacement.size() && replacement[value] != NO_VALUE;
+        }), list.end());
+    }
+    function.replaceAllUses(replacement);
+
+    for (auto [from, to] : deadEdges) {
+        function.removeEdge(from, to);
+    }
+    removedBlocks_ = function.removeUnreachableBlocks();
+}
+
+} // namespace jvav
@@ -0,0 +1,47 @@
+#include "ir/DeadValueEliminator.h"
+#include <algorithm>
+
+namespace jvav {
+
+// 标记-清除
+void DeadValueEliminator::run(IRFunction& function) {
+    removed_ = 0;
+    std::vector<uint8_t> live(function.values.size(), 0);
+    std::vector<ValueId> worklist;
+    auto mark = [&live, &worklist](ValueId value) {
+        if (value != NO_VALUE && !live[value]) {
+            live[value] = 1;
+            worklist.push_back(value);
+        }
+    };
+
+    for (const BasicBlock& block : function.blocks) {
+        if (block.removed) {
+            continue;
+        }
+        for (ValueId value : block.instructions) {
+            if (hasSideEffects(function, function.values[value])) {
+                mark(value);
+            }
+        }
+        mark(block.operand);
+    }
+    while (!worklist.empty()) {
+        ValueId value = worklist.back();
+        worklist.pop_back();
+        for (ValueId operand : function.values[value].operands) {
+            mark(operand);
+        }
+    }
+
+    for (BasicBlock& block : function.blocks) {
+        auto& list = block.instructions;
+        size_t before = list.size();
+        list.erase(std::remove_if(list.begin(), list.end(), [&live](ValueId value) {
+            return !live[value];
+        }), list.end());
+        removed_ += before - list.size();
+    }
+}
+
+} // namespace jvav
@@ -0,0 +1,127 @@
+#include "ir/Dominators.h"
+#include <algorithm>
+
+namespace jvav {
+
+// 构造支配树
+DominatorTree::DominatorTree(const IRFunction& function) {
+    size_t count = function.blocks.size();
+    rpoIndex_.assign(count, NO_BLOCK);
+    idom_.assign(count, NO_BLOCK);
+    children_.assign(count, {});
+    preorder_.assign(count, 0);
+    postorder_.assign(count, 0);
+
+    // 后序遍历（显式栈，next为下一个要看的后继）
+    struct Frame {
+        BlockId block;
+        size_t next;
+    };
+    std::vector<uint8_t> visited(count, 0);
+    std::vector<Frame> stack{Frame{0, 0}};
+    visited[0] = 1;
+    while (!stack.empty()) {
+        Frame& frame = stack.back();
+        const BasicBlock& block = function.blocks[frame.block];
+        if (frame.next < block.successorCount()) {
+            BlockId next = block.successors[frame.next++];
+            if (!visited[next]) {
+                visited[next] = 1;
+                stack.push_back(Frame{next, 0});
+            }
+            continue;
+        }
+        order_.push_back(frame.block);
+        stack.pop_back();
+    }
+    std::reverse(order_.begin(), order_.end());
+    for (uint32_t i = 0; i < order_.size(); i++) {
+        rpoIndex_[order_[i]] = i;
+    }
+
+    // 迭代求直接支配者，两个块的公共支配者沿idom链向逆后序靠前的方向找
+    auto intersect = [this](BlockId a, BlockId b) {
+        while (a != b) {
+            while (rpoIndex_[a] > rpoIndex_[b]) {
+                a = idom_[a];
+            }
+            while (rpoIndex_[b] > rpoIndex_[a]) {
+                b = idom_[b];
+            }
+        }
+        return a;
+    };
+    idom_[0] = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 1; i < order_.size(); i++) {
+            BlockId block = order_[i];
+            BlockId dominator = NO_BLOCK;
+            for (BlockId pred : function.blocks[block].predecessors) {
+                if (idom_[pred] == NO_BLOCK) {
+                    continue;  // 还没有处理过，或者不可达
+                }
+                dominator = dominator == NO_BLOCK ? pred : intersect(pred, dominator);
+            }
+            if (idom_[block] != dominator) {
+                idom_[block] = dominator;
+                changed = true;
+            }
+        }
+    }
+    idom_[0] = NO_BLOCK;
+
+    for (size_t i = 1; i < order_.size(); i++) {
+        children_[idom_[order_[i]]].push_back(order_[i]);
+    }
+
+    // 支配树的先序和后序编号
+    uint32_t pre = 0;
+    uint32_t post = 0;
+    std::vector<Frame> tree{Frame{0, 0}};
+    preorder_[0] = pre++;
+    while (!tree.empty()) {
+        Frame& frame = tree.back();
+        if (frame.next < children_[frame.block].size()) {
+            BlockId child = children_[frame.block][frame.next++];
+            preorder_[child] = pre++;
+            tree.push_back(Frame{child, 0});
+            continue;
+        }
+        postorder_[frame.block] = post++;
+        tree.pop_back();
+    }
+}
+
+// a是否支配b
+bool DominatorTree::dominates(BlockId a, BlockId b) const {
+    if (!isReachable(a) || !isReachable(b)) {
+        return false;
+    }
+    return preorder_[a] <= preorder_[b] && postorder_[b] <= postorder_[a];
+}
+
+// 支配边界：从每个汇合点的各个前驱沿idom链向上，直到汇合点的直接支配者
+std::vector<std::vector<BlockId>> DominatorTree::frontiers(const IRFunction& function) const {
+    std::vector<std::vector<BlockId>> result(function.blocks.size());
+    for (BlockId block : order_) {
+        const auto& predecessors = function.blocks[block].predecessors;
+        if (predecessors.size() < 2) {
+            continue;
+        }
+        for (BlockId pred : predecessors) {
+            BlockId runner = pred;
+            while (runner != NO_BLOCK && isReachable(runner) && runner != idom_[block]) {
+                auto& frontier = result[runner];
+                if (frontier.empty() || frontier.back() != block) {
+                    frontier.push_back(block);
+                }
+                runner = idom_[runner];
+            }
+        }
+    }
+    return result;
+}
+
+} // namespace jvav
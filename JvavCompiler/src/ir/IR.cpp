@@ -0,0 +1,551 @@
+#include "ir/IR.h"
+#include "ir/Dominators.h"
+#include <algorithm>
+#include <climits>
+#include <sstream>
+
+namespace jvav {
+
+// 新建块
+BlockId IRFunction::addBlock() {
+    blocks.emplace_back();
+    return static_cast<BlockId>(blocks.size() - 1);
+}
+
+// 追加指令
+ValueId IRFunction::append(BlockId block, IROpcode op, IRType type, int32_t imm,
+                           std::vector<ValueId> operands) {
+    ValueId id = static_cast<ValueId>(values.size());
+    values.push_back(Instruction{op, type, block, imm, std::move(operands)});
+    blocks[block].instructions.push_back(id);
+    return id;
+}
+
+// 插入phi
+ValueId IRFunction::insertPhi(BlockId block) {
+    ValueId id = static_cast<ValueId>(values.size());
+    values.push_back(Instruction{IROpcode::PHI, IRType::I32, block, 0,
+                                 std::vector<ValueId>(blocks[block].predecessors.size(), NO_VALUE)});
+    auto& list = blocks[block].instructions;
+    list.insert(list.begin(), id);
+    return id;
+}
+
+// 新建常量
+ValueId IRFunction::constant(int32_t value) {
+    ValueId id = static_cast<ValueId>(values.size());
+    values.push_back(Instruction{IROpcode::CONST, IRType::I32, 0, value, {}});
+    auto& list = blocks[0].instructions;
+    list.insert(list.begin(), id);
+    return id;
+}
+
+// 设置终结符
+void IRFunction::jump(BlockId from, BlockId to) {
+    blocks[from].terminator = Terminator::JUMP;
+    blocks[from].successors[0] = to;
+    blocks[from].successors[1] = NO_BLOCK;
+    blocks[to].predecessors.push_back(from);
+}
+
+void IRFunction::branch(BlockId from, ValueId condition, BlockId ifTrue, BlockId ifFalse) {
+    blocks[from].terminator = Terminator::BRANCH;
+    blocks[from].operand = condition;
+    blocks[from].successors[0] = ifTrue;
+    blocks[from].successors[1] = ifFalse;
+    blocks[ifTrue].predecessors.push_back(from);
+    blocks[ifFalse].predecessors.push_back(from);
+}
+
+void IRFunction::ret(BlockId from, ValueId value) {
+    blocks[from].terminator = Terminator::RETURN;
+    blocks[from].operand = value;
+}
+
+// 删除一条边
+void IRFunction::removeEdge(BlockId from, BlockId to) {
+    BasicBlock& block = blocks[from];
+    if (block.terminator == Terminator::BRANCH) {
+        BlockId other = block.successors[0] == to ? block.successors[1] : block.successors[0];
+        block.terminator = Terminator::JUMP;
+        block.operand = NO_VALUE;
+        block.successors[0] = other;
+        block.successors[1] = NO_BLOCK;
+    } else {
+        block.terminator = Terminator::NONE;
+        block.successors[0] = NO_BLOCK;
+    }
+    removePredecessor(to, from);
+}
+
+// 删除前驱
+void IRFunction::removePredecessor(BlockId block, BlockId pred) {
+    auto& predecessors = blocks[block].predecessors;
+    auto found = std::find(predecessors.begin(), predecessors.end(), pred);
+    if (found == predecessors.end()) {
+        return;
+    }
+    size_t index = static_cast<size_t>(found - predecessors.begin());
+    predecessors.erase(found);
+    for (ValueId id : blocks[block].instructions) {
+        Instruction& phi = values[id];
+        if (phi.op != IROpcode::PHI) {
+            break;
+        }
+        phi.operands.erase(phi.operands.begin() + index);
+    }
+}
+
+// 替换操作数
+void IRFunction::replaceAllUses(const std::vector<ValueId>& replacement) {
+    auto resolve = [&replacement](ValueId value) {
+        // 各遍保证替换链不成环
+        while (value < replacement.size() && replacement[value] != NO_VALUE && replacement[value] != value) {
+            value = replacement[value];
+        }
+        return value;
+    };
+    for (BasicBlock& block : blocks) {
+        if (block.removed) {
+            continue;
+        }
+        for (ValueId id : block.instructions) {
+            for (ValueId& operand : values[id].operands) {
+                operand = resolve(operand);
+            }
+        }
+        if (block.operand != NO_VALUE) {
+            block.operand = resolve(block.operand);
+        }
+    }
+}
+
+// 删除不可达的块
+size_t IRFunction::removeUnreachableBlocks() {
+    std::vector<uint8_t> reachable(blocks.size(), 0);
+    std::vector<BlockId> stack{0};
+    reachable[0] = 1;
+    while (!stack.empty()) {
+        const BasicBlock& block = blocks[stack.back()];
+        stack.pop_back();
+        for (size_t i = 0; i < block.successorCount(); i++) {
+            BlockId next = block.successors[i];
+            if (!reachable[next]) {
+                reachable[next] = 1;
+                stack.push_back(next);
+            }
+        }
+    }
+
+    size_t removed = 0;
+    for (BlockId id = 0; id < blocks.size(); id++) {
+        if (reachable[id] || blocks[id].removed) {
+            continue;
+        }
+        // 先从可达的后继中删除这条边，它们的phi随之少一个操作数
+        BasicBlock& block = blocks[id];
+        for (size_t i = 0; i < block.successorCount(); i++) {
+            if (reachable[block.successors[i]]) {
+                removePredecessor(block.successors[i], id);
+            }
+        }
+        block = BasicBlock();
+        block.removed = true;
+        removed++;
+    }
+    return removed;
+}
+
+// 合并块
+size_t IRFunction::mergeBlocks() {
+    std::vector<ValueId> replacement(values.size(), NO_VALUE);
+    size_t merged = 0;
+    for (BlockId id = 0; id < blocks.size(); id++) {
+        // 把id的唯一后继并入id，并入后再看新的后继
+        while (blocks[id].terminator == Terminator::JUMP) {
+            BlockId next = blocks[id].successors[0];
+            BasicBlock& successor = blocks[next];
+            if (next == id || next == 0 || successor.predecessors.size() != 1) {
+                break;
+            }
+
+            // 只有一个前驱的phi就是它的操作数
+            std::vector<ValueId> moved;
+            for (ValueId value : successor.instructions) {
+                if (values[value].op == IROpcode::PHI) {
+                    replacement[value] = values[value].operands[0];
+                } else {
+                    values[value].block = id;
+                    moved.push_back(value);
+                }
+            }
+
+            BasicBlock& block = blocks[id];
+            block.instructions.insert(block.instructions.end(), moved.begin(), moved.end());
+            block.terminator = successor.terminator;
+            block.operand = successor.operand;
+            block.successors[0] = successor.successors[0];
+            block.successors[1] = successor.successors[1];
+            for (size_t i = 0; i < block.successorCount(); i++) {
+                for (BlockId& pred : blocks[block.successors[i]].predecessors) {
+                    if (pred == next) {
+                        pred = id;
+                    }
+                }
+            }
+            successor = BasicBlock();
+            successor.removed = true;
+            merged++;
+        }
+    }
+    if (merged > 0) {
+        replaceAllUses(replacement);
+    }
+    return merged;
+}
+
+// 指令的文本名
+const char* opcodeName(IROpcode op) {
+    switch (op) {
+        case IROpcode::CONST:        return "const";
+        case IROpcode::PARAM:        return "param";
+        case IROpcode::PHI:          return "phi";
+        case IROpcode::NEG:          return "neg";
+        case IROpcode::NOT:          return "not";
+        case IROpcode::ADD:          return "add";
+        case IROpcode::SUB:          return "sub";
+        case IROpcode::MUL:          return "mul";
+        case IROpcode::DIV:          return "div";
+        case IROpcode::REM:          return "rem";
+        case IROpcode::EQ:           return "eq";
+        case IROpcode::NE:           return "ne";
+        case IROpcode::LT:           return "lt";
+        case IROpcode::LE:           return "le";
+        case IROpcode::GT:           return "gt";
+        case IROpcode::GE:           return "ge";
+        case IROpcode::AND:          return "and";
+        case IROpcode::OR:           return "or";
+        case IROpcode::LOAD_GLOBAL:  return "load_global";
+        case IROpcode::STORE_GLOBAL: return "store_global";
+        case IROpcode::CALL:         return "call";
+        case IROpcode::ASK:          return "ask";
+        case IROpcode::PRINT:        return "print";
+        case IROpcode::PRINT_STRING: return "print_string";
+        case IROpcode::LOCAL_GET:    return "local_get";
+        case IROpcode::LOCAL_SET:    return "local_set";
+    }
+    return "?";
+}
+
+// 编译期计算，与ConstantFolder和生成的WebAssembly指令一致
+bool foldInstruction(IROpcode op, int32_t a, int32_t b, int32_t& result) {
+    uint32_t ua = static_cast<uint32_t>(a);
+    uint32_t ub = static_cast<uint32_t>(b);
+
+    switch (op) {
+        case IROpcode::NEG: result = static_cast<int32_t>(0u - ua); return true;
+        case IROpcode::NOT: result = a == 0; return true;
+        case IROpcode::ADD: result = static_cast<int32_t>(ua + ub); return true;
+        case IROpcode::SUB: result = static_cast<int32_t>(ua - ub); return true;
+        case IROpcode::MUL: result = static_cast<int32_t>(ua * ub); return true;
+        case IROpcode::DIV:
+            if (b == 0 || (a == INT32_MIN && b == -1)) {
+                return false;
+            }
+            result = a / b;
+            return true;
+        case IROpcode::REM:
+            if (b == 0) {
+                return false;
+            }
+            result = (b == -1) ? 0 : a % b;
+            return true;
+        case IROpcode::EQ:  result = a == b; return true;
+        case IROpcode::NE:  result = a != b; return true;
+        case IROpcode::LT:  result = a < b; return true;
+        case IROpcode::LE:  result = a <= b; return true;
+        case IROpcode::GT:  result = a > b; return true;
+        case IROpcode::GE:  result = a >= b; return true;
+        case IROpcode::AND: result = a & b; return true;
+        case IROpcode::OR:  result = a | b; return true;
+        default:
+            return false;
+    }
+}
+
+// 可交换的运算
+bool isCommutative(IROpcode op) {
+    switch (op) {
+        case IROpcode::ADD:
+        case IROpcode::MUL:
+        case IROpcode::EQ:
+        case IROpcode::NE:
+        case IROpcode::AND:
+        case IROpcode::OR:
+            return true;
+        default:
+            return false;
+    }
+}
+
+namespace {
+
+// 除法和取余的除数是0和-1以外的常量时不会陷入
+bool mayTrap(const IRFunction& function, const Instruction& instruction) {
+    if (instruction.op != IROpcode::DIV && instruction.op != IROpcode::REM) {
+        return false;
+    }
+    const Instruction& divisor = function.values[instruction.operands[1]];
+    return divisor.op != IROpcode::CONST || divisor.imm == 0 || divisor.imm == -1;
+}
+
+} // namespace
+
+// 纯运算
+bool isPure(const IRFunction& function, const Instruction& instruction) {
+    switch (instruction.op) {
+        case IROpcode::CONST:
+        case IROpcode::NEG:
+        case IROpcode::NOT:
+        case IROpcode::ADD:
+        case IROpcode::SUB:
+        case IROpcode::MUL:
+        case IROpcode::EQ:
+        case IROpcode::NE:
+        case IROpcode::LT:
+        case IROpcode::LE:
+        case IROpcode::GT:
+        case IROpcode::GE:
+        case IROpcode::AND:
+        case IROpcode::OR:
+            return true;
+        case IROpcode::DIV:
+        case IROpcode::REM:
+            return !mayTrap(function, instruction);
+        default:
+            return false;
+    }
+}
+
+// 有副作用
+bool hasSideEffects(const IRFunction& function, const Instruction& instruction) {
+    switch (instruction.op) {
+        case IROpcode::STORE_GLOBAL:
+        case IROpcode::CALL:
+        case IROpcode::ASK:
+        case IROpcode::PRINT:
+        case IROpcode::PRINT_STRING:
+        case IROpcode::LOCAL_SET:
+            return true;
+        case IROpcode::DIV:
+        case IROpcode::REM:
+            return mayTrap(function, instruction);
+        default:
+            return false;
+    }
+}
+
+// 文本形式
+std::string IRModule::toString() const {
+    std::ostringstream out;
+    for (size_t i = 0; i < globals.size(); i++) {
+        out << "global @" << i << " " << globals[i] << "\n";
+    }
+    for (size_t i = 0; i < strings.size(); i++) {
+        out << "string #" << i << " \"" << strings[i] << "\"\n";
+    }
+
+    for (size_t f = 0; f < functions.size(); f++) {
+        const IRFunction& function = functions[f];
+        out << "\nfunction " << f << " " << function.name << "(";
+        for (size_t i = 0; i < function.parameters.size(); i++) {
+            out << (i > 0 ? ", " : "") << function.parameters[i];
+        }
+        out << ") {\n";
+
+        for (BlockId id = 0; id < function.blocks.size(); id++) {
+            const BasicBlock& block = function.blocks[id];
+            if (block.removed) {
+                continue;
+            }
+            out << "b" << id << ":";
+            if (!block.predecessors.empty()) {
+                out << "  ; 前驱";
+                for (BlockId pred : block.predecessors) {
+                    out << " b" << pred;
+                }
+            }
+            out << "\n";
+
+            for (ValueId value : block.instructions) {
+                const Instruction& instruction = function.values[value];
+                out << "  ";
+                if (instruction.type == IRType::I32) {
+                    out << "%" << value << " = ";
+                }
+                out << opcodeName(instruction.op);
+                switch (instruction.op) {
+                    case IROpcode::CONST:
+                    case IROpcode::PARAM:
+                        out << " " << instruction.imm;
+                        break;
+                    case IROpcode::LOAD_GLOBAL:
+                    case IROpcode::STORE_GLOBAL:
+                    case IROpcode::CALL:
+                        out << " @" << instruction.imm;
+                        break;
+                    case IROpcode::PRINT_STRING:
+                        out << " #" << instruction.imm;
+                        break;
+                    case IROpcode::LOCAL_GET:
+                    case IROpcode::LOCAL_SET:
+                        out << " $" << instruction.imm;
+                        break;
+                    default:
+                        break;
+                }
+                for (size_t i = 0; i < instruction.operands.size(); i++) {
+                    out << (i > 0 || instruction.op != IROpcode::PHI ? ", " : " ");
+                    if (instruction.op == IROpcode::PHI) {
+                        out << "[%" << instruction.operands[i] << ", b" << block.predecessors[i] << "]";
+                    } else {
+                        out << "%" << instruction.operands[i];
+                    }
+                }
+                out << "\n";
+            }
+
+            switch (block.terminator) {
+                case Terminator::NONE:
+                    out << "  <无终结符>\n";
+                    break;
+                case Terminator::JUMP:
+                    out << "  jump b" << block.successors[0] << "\n";
+                    break;
+                case Terminator::BRANCH:
+                    out << "  branch %" << block.operand << ", b" << block.successors[0]
+                        << ", b" << block.successors[1] << "\n";
+                    break;
+                case Terminator::RETURN:
+                    out << "  ret %" << block.operand << "\n";
+                    break;
+            }
+        }
+        out << "}\n";
+    }
+    return out.str();
+}
+
+// 检查结构
+bool IRModule::verify(std::string& error) const {
+    for (const IRFunction& function : functions) {
+        auto fail = [&error, &function](BlockId block, const std::string& message) {
+            error = "函数 " + function.name + " 块 b" + std::to_string(block) + ": " + message;
+            return false;
+        };
+        if (function.blocks.empty() || function.blocks[0].removed || !function.blocks[0].predecessors.empty()) {
+            return fail(0, "入口块不存在或有前驱");
+        }
+
+        // 每个值所在的块和块中的位置
+        std::vector<BlockId> home(function.values.size(), NO_BLOCK);
+        std::vector<uint32_t> position(function.values.size(), 0);
+        for (BlockId id = 0; id < function.blocks.size(); id++) {
+            const BasicBlock& block = function.blocks[id];
+            if (block.removed) {
+                continue;
+            }
+            for (uint32_t i = 0; i < block.instructions.size(); i++) {
+                ValueId value = block.instructions[i];
+                if (value >= function.values.size() || home[value] != NO_BLOCK) {
+                    return fail(id, "指令%" + std::to_string(value) + "不存在或出现两次");
+                }
+                home[value] = id;
+                position[value] = i;
+            }
+        }
+
+        DominatorTree dominators(function);
+        auto defined = [&](ValueId value, BlockId use, uint32_t index) {
+            if (value >= function.values.size() || home[value] == NO_BLOCK ||
+                function.values[value].type != IRType::I32) {
+                return false;
+            }
+            if (home[value] == use) {
+                return position[value] < index;
+            }
+            return dominators.dominates(home[value], use);
+        };
+
+        for (BlockId id = 0; id < function.blocks.size(); id++) {
+            const BasicBlock& block = function.blocks[id];
+            if (block.removed) {
+                continue;
+            }
+            if (block.terminator == Terminator::NONE) {
+                return fail(id, "没有终结符");
+            }
+            for (size_t i = 0; i < block.successorCount(); i++) {
+                BlockId next = block.successors[i];
+                if (next >= function.blocks.size() || function.blocks[next].removed ||
+                    std::count(function.blocks[next].predecessors.begin(),
+                               function.blocks[next].predecessors.end(), id) != 1) {
+                    return fail(id, "后继b" + std::to_string(next) + "的前驱不对应");
+                }
+            }
+            if (block.terminator == Terminator::BRANCH && block.successors[0] == block.successors[1]) {
+                return fail(id, "条件跳转的两个目标相同");
+            }
+            for (BlockId pred : block.predecessors) {
+                const BasicBlock& from = function.blocks[pred];
+                if (from.removed || (from.successors[0] != id && from.successors[1] != id)) {
+                    return fail(id, "前驱b" + std::to_string(pred) + "不跳转到这里");
+                }
+            }
+
+            bool phis = true;
+            for (uint32_t i = 0; i < block.instructions.size(); i++) {
+                ValueId value = block.instructions[i];
+                const Instruction& instruction = function.values[value];
+                std::string name = "%" + std::to_string(value);
+                if (instruction.block != id) {
+                    return fail(id, name + "记录的所在块不对");
+                }
+                if (instruction.op == IROpcode::CONST && id != 0) {
+                    return fail(id, name + "是常量，但不在入口块");
+                }
+                if (instruction.op == IROpcode::LOCAL_GET || instruction.op == IROpcode::LOCAL_SET) {
+                    return fail(id, name + "是局部变量访问，还没有构造SSA");
+                }
+                if (instruction.op == IROpcode::PHI) {
+                    if (!phis) {
+                        return fail(id, name + "是phi，但不在块的开头");
+                    }
+                    if (instruction.operands.size() != block.predecessors.size()) {
+                        return fail(id, name + "的操作数与前驱个数不同");
+                    }
+                    for (size_t k = 0; k < instruction.operands.size(); k++) {
+                        BlockId pred = block.predecessors[k];
+                        if (!defined(instruction.operands[k], pred, UINT32_MAX)) {
+                            return fail(id, name + "的操作数在前驱b" + std::to_string(pred) + "中不可用");
+                        }
+                    }
+                    continue;
+                }
+                phis = false;
+                for (ValueId operand : instruction.operands) {
+                    if (!defined(operand, id, i)) {
+                        return fail(id, name + "的操作数%" + std::to_string(operand) + "未定义或不支配它");
+                    }
+                }
+            }
+            if ((block.terminator == Terminator::BRANCH || block.terminator == Terminator::RETURN) &&
+                !defined(block.operand, id, UINT32_MAX)) {
+                return fail(id, "终结符的操作数未定义或不支配它");
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace jvav
@@ -0,0 +1,662 @@
+#include "ir/IRLowering.h"
+#include "ast/ASTVisitor.h"
+#include "ast/NodeWalker.h"
+#include "compiler/Functions.h"
+#include "ir/SSABuilder.h"
+#include "lexer/SymbolTable.h"
+#include "optimizer/ConstantFolder.h"
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+namespace jvav {
+
+namespace {
+
+// 一次降低：先收集函数定义和被写入的名字，再逐个函数降低
+// 语句和表达式都拆成工作项放在显式栈中：表达式按后序求值，结果放在值栈values_上，
+// 控制流语句在条件求值之后由后续的工作项建立基本块和跳转。
+class LoweringPass : public ASTVisitor<LoweringPass> {
+public:
+    LoweringPass(IRModule& module, std::string& error) : module_(module), error_(error) {}
+
+    bool run(const Program& program);
+
+private:
+    friend class ASTVisitor<LoweringPass>;
+
+    // 工作项
+    struct Work {
+        enum class Kind {
+            STMT,     // 语句
+            EXPR,     // 表达式：排入子表达式和FINISH
+            FINISH,   // 子表达式都已求值，计算表达式本身
+            SET,      // 把值写入set的变量
+            PRINT,    // 打印值
+            DISCARD,  // 丢弃值
+            RETURN,   // 返回值（没有返回值时返回0）
+            TEST,     // if的第index个条件已求值，按它跳转
+            JUMP,     // 跳转到block
+            ENTER,    // 从block继续生成
+            LOOP,     // 循环次数已求值，建立循环
+            NEXT      // 循环体结束，计数器加一并回到循环头
+        };
+        Kind kind;
+        const Stmt* stmt = nullptr;
+        const Expr* expr = nullptr;
+        uint32_t index = 0;
+        BlockId block = NO_BLOCK;
+    };
+
+    // 正在生成的循环
+    struct Loop {
+        BlockId header;
+        BlockId exit;
+        uint32_t counter;    // 计数器的局部变量
+        Symbol iterator;     // 循环变量，没有时为INVALID_SYMBOL
+        int32_t shadowed;    // 循环变量遮蔽的局部变量，没有时为-1
+    };
+
+    // 收集函数定义和被写入的名字
+    void collect(const Program& program);
+
+    // 降低一个函数
+    void lowerFunction(uint32_t index, const DefineStmt* define, NodeList<Stmt*> body);
+
+    // 处理工作栈直到为空或出错
+    void runWork();
+
+    // 出错，停止降低
+    void fail(std::string message);
+
+    // 变量读写
+    ValueId read(Symbol symbol);
+    void write(Symbol symbol, ValueId value);
+    int32_t globalIndex(Symbol symbol);
+    uint32_t newLocal() { return function_->localCount++; }
+
+    // 在当前块追加指令
+    ValueId emit(IROpcode op, IRType type, int32_t imm = 0, std::vector<ValueId> operands = {}) {
+        return function_->append(current_, op, type, imm, std::move(operands));
+    }
+    // 常量都放在入口块，同一个值只建一次；入口块支配所有的块，追加到末尾即可
+    ValueId emitConstant(int32_t value) {
+        auto [found, inserted] = constants_.emplace(value, NO_VALUE);
+        if (inserted) {
+            found->second = function_->append(0, IROpcode::CONST, IRType::I32, value);
+        }
+        return found->second;
+    }
+    ValueId pop() {
+        ValueId value = values_.back();
+        values_.pop_back();
+        return value;
+    }
+
+    // 排入工作项，按排入的顺序处理；一个节点排入的工作项必须用schedule()提交
+    void queue(Work::Kind kind, const Stmt* stmt = nullptr, const Expr* expr = nullptr,
+               uint32_t index = 0, BlockId block = NO_BLOCK) {
+        work_.push_back(Work{kind, stmt, expr, index, block});
+    }
+    void queue(const Expr* expr) { queue(Work::Kind::EXPR, nullptr, expr); }
+    void queue(const NodeList<Stmt*>& statements) {
+        for (const Stmt* stmt : statements) {
+            queue(Work::Kind::STMT, stmt);
+        }
+    }
+    void schedule(size_t mark) { std::reverse(work_.begin() + mark, work_.end()); }
+
+    // 排入if的第index个分支
+    void queueBranch(const IfStmt* stmt, uint32_t index, BlockId join);
+
+    // 工作项的处理
+    void test(const IfStmt* stmt, uint32_t index, BlockId join);
+    void enterLoop(const LoopStmt* stmt);
+    void leaveLoop();
+    void finish(const Expr* expr);
+
+    // 语句：排入工作项
+    void visit(const ExpressionStmt* stmt);
+    void visit(const ImportStmt*) { fail("不支持导入语句"); }
+    void visit(const DakaiStmt*) { fail("不支持打开语句"); }
+    void visit(const SetStmt* stmt);
+    void visit(const PrintStmt* stmt);
+    void visit(const IfStmt* stmt);
+    void visit(const LoopStmt* stmt);
+    void visit(const DefineStmt*) {}  // 函数体单独降低
+    void visit(const ReturnStmt* stmt);
+    void visit(const ArrayStmt*) { fail("不支持数组"); }
+    void visit(const RecordDefStmt*) { fail("不支持记录"); }
+    void visit(const RecordAccessStmt*) { fail("不支持记录"); }
+    void visit(const TryCatchStmt*) { fail("不支持异常处理"); }
+    void visit(const EnumDefStmt*) { fail("不支持枚举"); }
+    void visit(const BlockStmt* stmt);
+    void visit(const ErrorStmt*) { fail("语法树中有语法错误"); }
+
+    // 表达式：叶子直接求值，其余排入子表达式和FINISH
+    void visit(const LiteralExpr* expr);
+    void visit(const VariableExpr* expr);
+    void visit(const UnaryExpr* expr);
+    void visit(const BinaryExpr* expr);
+    void visit(const CallExpr* expr);
+    void visit(const ArrayAccessExpr*) { fail("不支持数组"); }
+    void visit(const RecordAccessExpr*) { fail("不支持记录"); }
+    void visit(const AssignmentExpr* expr);
+    void visit(const ErrorExpr*) { fail("语法树中有语法错误"); }
+
+    IRModule& module_;
+    std::string& error_;
+
+    // 按符号编号索引：是否被写入，全局变量编号，函数编号（-1表示没有），当前的局部变量
+    std::vector<uint8_t> written_;
+    std::vector<int32_t> globals_;
+    std::vector<int32_t> functions_;
+    std::vector<int32_t> locals_;
+    std::vector<const DefineStmt*> defines_;
+
+    IRFunction* function_ = nullptr;
+    BlockId current_ = NO_BLOCK;
+    std::vector<Work> work_;
+    std::vector<ValueId> values_;
+    std::vector<Loop> loops_;
+    std::unordered_map<int32_t, ValueId> constants_;  // 当前函数中已有的常量
+};
+
+// 二元运算符对应的指令
+bool binaryOpcode(TokenType type, IROpcode& op) {
+    switch (type) {
+        case TokenType::PLUS:          op = IROpcode::ADD; return true;
+        case TokenType::MINUS:         op = IROpcode::SUB; return true;
+        case TokenType::STAR:          op = IROpcode::MUL; return true;
+        case TokenType::SLASH:         op = IROpcode::DIV; return true;
+        case TokenType::PERCENT:       op = IROpcode::REM; return true;
+        case TokenType::EQUAL:         op = IROpcode::EQ; return true;
+        case TokenType::NOT_EQUAL:     op = IROpcode::NE; return true;
+        case TokenType::LESS:          op = IROpcode::LT; return true;
+        case TokenType::LESS_EQUAL:    op = IROpcode::LE; return true;
+        case TokenType::GREATER:       op = IROpcode::GT; return true;
+        case TokenType::GREATER_EQUAL: op = IROpcode::GE; return true;
+        case TokenType::AND:           op = IROpcode::AND; return true;
+        case TokenType::OR:            op = IROpcode::OR; return true;
+        default:
+            return false;
+    }
+}
+
+bool LoweringPass::run(const Program& program) {
+    size_t symbols = SymbolTable::instance().size();
+    written_.assign(symbols, 0);
+    globals_.assign(symbols, -1);
+    functions_.assign(symbols, -1);
+    locals_.assign(symbols, -1);
+
+    collect(program);
+    if (!error_.empty()) {
+        return false;
+    }
+
+    module_.functions.resize(1 + defines_.size());
+    lowerFunction(0, nullptr, program.statements);
+    for (uint32_t i = 0; i < defines_.size() && error_.empty(); i++) {
+        lowerFunction(i + 1, defines_[i], defines_[i]->body);
+    }
+    return error_.empty();
+}
+
+void LoweringPass::collect(const Program& program) {
+    NodeWalker walker;
+    walker.walk(program.statements,
+        [this](Stmt* stmt) {
+            if (stmt->getType() == StmtType::SET) {
+                written_[static_cast<SetStmt*>(stmt)->name.getSymbol()] = 1;
+            } else if (stmt->getType() == StmtType::DEFINE) {
+                auto* define = static_cast<DefineStmt*>(stmt);
+                Symbol name = define->name.getSymbol();
+                if (functions_[name] >= 0) {
+                    fail("函数 " + std::string(define->name.getValue()) + " 重复定义");
+                } else if (define->name.getValue() == "main") {
+                    fail("函数名main与入口函数冲突");
+                }
+                functions_[name] = static_cast<int32_t>(defines_.size()) + 1;
+                defines_.push_back(define);
+            }
+        },
+        [this](Expr* expr) {
+            if (expr->getType() == ExprType::ASSIGNMENT) {
+                auto* assignment = static_cast<AssignmentExpr*>(expr);
+                if (assignment->target->getType() == ExprType::VARIABLE) {
+                    written_[static_cast<VariableExpr*>(assignment->target)->name.getSymbol()] = 1;
+                }
+            }
+        });
+}
+
+void LoweringPass::lowerFunction(uint32_t index, const DefineStmt* define, NodeList<Stmt*> body) {
+    function_ = &module_.functions[index];
+    current_ = function_->addBlock();
+    constants_.clear();
+
+    // 参数也是局部变量，参数名重复时后面的遮蔽前面的
+    std::vector<std::pair<Symbol, int32_t>> shadowed;
+    if (define != nullptr) {
+        function_->name = std::string(define->name.getValue());
+        for (uint32_t i = 0; i < define->parameters.size(); i++) {
+            const Token& parameter = define->parameters[i];
+            function_->parameters.emplace_back(parameter.getValue());
+            uint32_t slot = newLocal();
+            ValueId value = emit(IROpcode::PARAM, IRType::I32, static_cast<int32_t>(i));
+            emit(IROpcode::LOCAL_SET, IRType::VOID, static_cast<int32_t>(slot), {value});
+            shadowed.emplace_back(parameter.getSymbol(), locals_[parameter.getSymbol()]);
+            locals_[parameter.getSymbol()] = static_cast<int32_t>(slot);
+        }
+    } else {
+        function_->name = "main";
+    }
+
+    size_t mark = work_.size();
+    queue(body);
+    schedule(mark);
+    runWork();
+
+    for (auto it = shadowed.rbegin(); it != shadowed.rend(); ++it) {
+        locals_[it->first] = it->second;
+    }
+    if (!error_.empty()) {
+        return;
+    }
+
+    // 执行到末尾返回0
+    function_->ret(current_, emitConstant(0));
+    SSABuilder().run(*function_);
+}
+
+void LoweringPass::runWork() {
+    while (!work_.empty() && error_.empty()) {
+        Work work = work_.back();
+        work_.pop_back();
+
+        switch (work.kind) {
+            case Work::Kind::STMT:
+                visitStmt(work.stmt);
+                break;
+            case Work::Kind::EXPR:
+                visitExpr(work.expr);
+                break;
+            case Work::Kind::FINISH:
+                finish(work.expr);
+                break;
+            case Work::Kind::SET:
+                write(static_cast<const SetStmt*>(work.stmt)->name.getSymbol(), pop());
+                break;
+            case Work::Kind::PRINT:
+                emit(IROpcode::PRINT, IRType::VOID, 0, {pop()});
+                break;
+            case Work::Kind::DISCARD:
+                pop();
+                break;
+            case Work::Kind::RETURN: {
+                // return之后的语句不可达，放在一个没有前驱的新块中，构造SSA时删除
+                ValueId value = static_cast<const ReturnStmt*>(work.stmt)->value != nullptr ? pop() : emitConstant(0);
+                function_->ret(current_, value);
+                current_ = function_->addBlock();
+                break;
+            }
+            case Work::Kind::TEST:
+                test(static_cast<const IfStmt*>(work.stmt), work.index, work.block);
+                break;
+            case Work::Kind::JUMP:
+                function_->jump(current_, work.block);
+                current_ = NO_BLOCK;
+                break;
+            case Work::Kind::ENTER:
+                current_ = work.block;
+                break;
+            case Work::Kind::LOOP:
+                enterLoop(static_cast<const LoopStmt*>(work.stmt));
+                break;
+            case Work::Kind::NEXT:
+                leaveLoop();
+                break;
+        }
+    }
+    if (!error_.empty()) {
+        work_.clear();
+        values_.clear();
+        loops_.clear();
+    }
+}
+
+void LoweringPass::fail(std::string message) {
+    if (error_.empty()) {
+        error_ = "中间表示" + message;
+    }
+}
+
+ValueId LoweringPass::read(Symbol symbol) {
+    if (locals_[symbol] >= 0) {
+        return emit(IROpcode::LOCAL_GET, IRType::I32, locals_[symbol]);
+    }
+    if (written_[symbol]) {
+        return emit(IROpcode::LOAD_GLOBAL, IRType::I32, globalIndex(symbol));
+    }
+    // 与语法树后端一样，未定义的变量给出警告并当作0
+    std::cerr << "警告: 使用未定义的变量 " << SymbolTable::instance().name(symbol) << std::endl;
+    return emitConstant(0);
+}
+
+void LoweringPass::write(Symbol symbol, ValueId value) {
+    if (locals_[symbol] >= 0) {
+        emit(IROpcode::LOCAL_SET, IRType::VOID, locals_[symbol], {value});
+    } else {
+        emit(IROpcode::STORE_GLOBAL, IRType::VOID, globalIndex(symbol), {value});
+    }
+}
+
+int32_t LoweringPass::globalIndex(Symbol symbol) {
+    if (globals_[symbol] < 0) {
+        globals_[symbol] = static_cast<int32_t>(module_.globals.size());
+        module_.globals.emplace_back(SymbolTable::instance().name(symbol));
+    }
+    return globals_[symbol];
+}
+
+void LoweringPass::queueBranch(const IfStmt* stmt, uint32_t index, BlockId join) {
+    if (index >= stmt->branches.size()) {
+        queue(Work::Kind::JUMP, nullptr, nullptr, 0, join);
+    } else if (stmt->branches[index].condition != nullptr) {
+        queue(stmt->branches[index].condition);
+        queue(Work::Kind::TEST, stmt, nullptr, index, join);
+    } else {
+        queue(stmt->branches[index].body);
+        queue(Work::Kind::JUMP, nullptr, nullptr, 0, join);
+    }
+}
+
+void LoweringPass::test(const IfStmt* stmt, uint32_t index, BlockId join) {
+    ValueId condition = pop();
+    BlockId taken = function_->addBlock();
+    BlockId next = function_->addBlock();
+    function_->branch(current_, condition, taken, next);
+    current_ = taken;
+
+    size_t mark = work_.size();
+    queue(stmt->branches[index].body);
+    queue(Work::Kind::JUMP, nullptr, nullptr, 0, join);
+    queue(Work::Kind::ENTER, nullptr, nullptr, 0, next);
+    queueBranch(stmt, index + 1, join);
+    schedule(mark);
+}
+
+// 循环生成为：
+//   counter = 0; jump header
+//   header: k = counter; branch k < count, body, exit
+//   body:   i = k; ...; counter = k + 1; jump header
+//   exit:
+void LoweringPass::enterLoop(const LoopStmt* stmt) {
+    ValueId count = pop();
+    Loop loop{function_->addBlock(), NO_BLOCK, newLocal(), stmt->variable.getSymbol(), -1};
+    emit(IROpcode::LOCAL_SET, IRType::VOID, static_cast<int32_t>(loop.counter), {emitConstant(0)});
+    function_->jump(current_, loop.header);
+
+    current_ = loop.header;
+    ValueId index = emit(IROpcode::LOCAL_GET, IRType::I32, static_cast<int32_t>(loop.counter));
+    ValueId condition = emit(IROpcode::LT, IRType::I32, 0, {index, count});
+    BlockId body = function_->addBlock();
+    loop.exit = function_->addBlock();
+    function_->branch(current_, condition, body, loop.exit);
+
+    current_ = body;
+    if (loop.iterator != INVALID_SYMBOL) {
+        uint32_t slot = newLocal();
+        loop.shadowed = locals_[loop.iterator];
+        locals_[loop.iterator] = static_cast<int32_t>(slot);
+        emit(IROpcode::LOCAL_SET, IRType::VOID, static_cast<int32_t>(slot), {index});
+    }
+    loops_.push_back(loop);
+
+    size_t mark = work_.size();
+    queue(stmt->body);
+    queue(Work::Kind::NEXT, stmt);
+    schedule(mark);
+}
+
+void LoweringPass::leaveLoop() {
+    Loop loop = loops_.back();
+    loops_.pop_back();
+
+    ValueId index = emit(IROpcode::LOCAL_GET, IRType::I32, static_cast<int32_t>(loop.counter));
+    ValueId next = emit(IROpcode::ADD, IRType::I32, 0, {index, emitConstant(1)});
+    emit(IROpcode::LOCAL_SET, IRType::VOID, static_cast<int32_t>(loop.counter), {next});
+    function_->jump(current_, loop.header);
+    current_ = loop.exit;
+
+    if (loop.iterator != INVALID_SYMBOL) {
+        locals_[loop.iterator] = loop.shadowed;
+    }
+}
+
+void LoweringPass::finish(const Expr* expr) {
+    switch (expr->getType()) {
+        case ExprType::UNARY: {
+            auto* unary = static_cast<const UnaryExpr*>(expr);
+            IROpcode op = unary->op.getType() == TokenType::MINUS ? IROpcode::NEG : IROpcode::NOT;
+            values_.push_back(emit(op, IRType::I32, 0, {pop()}));
+            break;
+        }
+        case ExprType::BINARY: {
+            IROpcode op = IROpcode::ADD;
+            binaryOpcode(static_cast<const BinaryExpr*>(expr)->op.getType(), op);
+            ValueId right = pop();
+            ValueId left = pop();
+            values_.push_back(emit(op, IRType::I32, 0, {left, right}));
+            break;
+        }
+        case ExprType::CALL: {
+            auto* call = static_cast<const CallExpr*>(expr);
+            Symbol callee = static_cast<const VariableExpr*>(call->callee)->name.getSymbol();
+            std::vector<ValueId> arguments(values_.end() - call->arguments.size(), values_.end());
+            values_.resize(values_.size() - call->arguments.size());
+
+            // 与语法树后端一样，内置函数优先于同名的自定义函数
+            switch (BuiltinFunctions::getType(callee)) {
+                case BuiltinFunctionType::PRINT:
+                    emit(IROpcode::PRINT, IRType::VOID, 0, {arguments[0]});
+                    values_.push_back(emitConstant(0));
+                    break;
+                case BuiltinFunctionType::ASK:
+                    values_.push_back(emit(IROpcode::ASK, IRType::I32, 0, arguments));
+                    break;
+                case BuiltinFunctionType::PARSE_INT:
+                case BuiltinFunctionType::PARSE_FLOAT:
+                case BuiltinFunctionType::TO_STRING:
+                    // 只有整数，原样返回
+                    values_.push_back(arguments[0]);
+                    break;
+                case BuiltinFunctionType::LENGTH:
+                    values_.push_back(emitConstant(0));
+                    break;
+                default:
+                    values_.push_back(emit(IROpcode::CALL, IRType::I32, functions_[callee], arguments));
+                    break;
+            }
+            break;
+        }
+        case ExprType::ASSIGNMENT: {
+            // 赋值表达式的值就是赋的值，留在值栈上
+            auto* assignment = static_cast<const AssignmentExpr*>(expr);
+            write(static_cast<const VariableExpr*>(assignment->target)->name.getSymbol(), values_.back());
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void LoweringPass::visit(const ExpressionStmt* stmt) {
+    size_t mark = work_.size();
+    queue(stmt->expression);
+    queue(Work::Kind::DISCARD);
+    schedule(mark);
+}
+
+void LoweringPass::visit(const SetStmt* stmt) {
+    size_t mark = work_.size();
+    queue(stmt->value);
+    queue(Work::Kind::SET, stmt);
+    schedule(mark);
+}
+
+void LoweringPass::visit(const PrintStmt* stmt) {
+    // 字符串字面量只能直接打印
+    if (stmt->value->getType() == ExprType::LITERAL) {
+        auto* literal = static_cast<const LiteralExpr*>(stmt->value);
+        if (literal->token.getType() == TokenType::STRING_LITERAL) {
+            int32_t index = static_cast<int32_t>(module_.strings.size());
+            module_.strings.emplace_back(literal->value);
+            emit(IROpcode::PRINT_STRING, IRType::VOID, index);
+            return;
+        }
+    }
+
+    size_t mark = work_.size();
+    queue(stmt->value);
+    queue(Work::Kind::PRINT);
+    schedule(mark);
+}
+
+void LoweringPass::visit(const IfStmt* stmt) {
+    BlockId join = function_->addBlock();
+    size_t mark = work_.size();
+    queueBranch(stmt, 0, join);
+    queue(Work::Kind::ENTER, nullptr, nullptr, 0, join);
+    schedule(mark);
+}
+
+void LoweringPass::visit(const LoopStmt* stmt) {
+    size_t mark = work_.size();
+    queue(stmt->count);
+    queue(Work::Kind::LOOP, stmt);
+    schedule(mark);
+}
+
+void LoweringPass::visit(const ReturnStmt* stmt) {
+    size_t mark = work_.size();
+    if (stmt->value != nullptr) {
+        queue(stmt->value);
+    }
+    queue(Work::Kind::RETURN, stmt);
+    schedule(mark);
+}
+
+void LoweringPass::visit(const BlockStmt* stmt) {
+    size_t mark = work_.size();
+    queue(stmt->statements);
+    schedule(mark);
+}
+
+void LoweringPass::visit(const LiteralExpr* expr) {
+    int32_t value = 0;
+    if (expr->token.getType() == TokenType::STRING_LITERAL) {
+        fail("只能直接打印字符串");
+    } else if (!ConstantFolder::evaluate(expr, value)) {
+        fail("不支持超出i32范围的数字 " + std::string(expr->value));
+    } else {
+        values_.push_back(emitConstant(value));
+    }
+}
+
+void LoweringPass::visit(const VariableExpr* expr) {
+    values_.push_back(read(expr->name.getSymbol()));
+}
+
+void LoweringPass::visit(const UnaryExpr* expr) {
+    TokenType op = expr->op.getType();
+    if (op != TokenType::MINUS && op != TokenType::NOT) {
+        fail("不支持一元运算符 " + std::string(expr->op.getValue()));
+        return;
+    }
+    size_t mark = work_.size();
+    queue(expr->right);
+    queue(Work::Kind::FINISH, nullptr, expr);
+    schedule(mark);
+}
+
+void LoweringPass::visit(const BinaryExpr* expr) {
+    IROpcode op;
+    if (!binaryOpcode(expr->op.getType(), op)) {
+        fail("不支持二元运算符 " + std::string(expr->op.getValue()));
+        return;
+    }
+    size_t mark = work_.size();
+    queue(expr->left);
+    queue(expr->right);
+    queue(Work::Kind::FINISH, nullptr, expr);
+    schedule(mark);
+}
+
+void LoweringPass::visit(const CallExpr* expr) {
+    if (expr->callee->getType() != ExprType::VARIABLE) {
+        fail("只支持按名字调用函数");
+        return;
+    }
+    const Token& name = static_cast<const VariableExpr*>(expr->callee)->name;
+    size_t expected = 0;
+    switch (BuiltinFunctions::getType(name.getSymbol())) {
+        case BuiltinFunctionType::PRINT:
+        case BuiltinFunctionType::PARSE_INT:
+        case BuiltinFunctionType::PARSE_FLOAT:
+        case BuiltinFunctionType::TO_STRING:
+            expected = 1;
+            break;
+        case BuiltinFunctionType::ASK:
+            expected = 2;
+            break;
+        case BuiltinFunctionType::LENGTH:
+            expected = expr->arguments.size();
+            break;
+        default: {
+            int32_t index = functions_[name.getSymbol()];
+            if (index < 0) {
+                fail("调用了未定义的函数 " + std::string(name.getValue()));
+                return;
+            }
+            expected = defines_[index - 1]->parameters.size();
+            break;
+        }
+    }
+    if (expr->arguments.size() != expected) {
+        fail("调用 " + std::string(name.getValue()) + " 的参数个数不对");
+        return;
+    }
+
+    size_t mark = work_.size();
+    for (const Expr* argument : expr->arguments) {
+        queue(argument);
+    }
+    queue(Work::Kind::FINISH, nullptr, expr);
+    schedule(mark);
+}
+
+void LoweringPass::visit(const AssignmentExpr* expr) {
+    if (expr->target->getType() != ExprType::VARIABLE) {
+        fail("只支持给变量赋值");
+        return;
+    }
+    size_t mark = work_.size();
+    queue(expr->value);
+    queue(Work::Kind::FINISH, nullptr, expr);
+    schedule(mark);
+}
+
+} // namespace
+
+// 降低为中间表示
+bool IRLowering::lower(const Program& program, IRModule& module, std::string& error) {
+    module = IRModule();
+    error.clear();
+    LoweringPass pass(module, error);
+    return pass.run(program);
+}
+
+} // namespace jvav
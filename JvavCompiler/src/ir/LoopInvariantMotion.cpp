@@ -0,0 +1,136 @@
+#include "ir/LoopInvariantMotion.h"
+#include "ir/Dominators.h"
+#include <algorithm>
+
+namespace jvav {
+
+namespace {
+
+// 自然循环
+struct NaturalLoop {
+    BlockId header;
+    std::vector<BlockId> blocks;   // 包括循环头
+    std::vector<uint8_t> contains; // 按块编号索引
+};
+
+// 找出所有自然循环，回到同一个循环头的回边合成一个循环
+std::vector<NaturalLoop> findLoops(const IRFunction& function, const DominatorTree& dominators) {
+    std::vector<NaturalLoop> loops;
+    std::vector<size_t> loopOf(function.blocks.size(), SIZE_MAX);
+    for (BlockId block : dominators.reversePostorder()) {
+        const BasicBlock& tail = function.blocks[block];
+        for (size_t i = 0; i < tail.successorCount(); i++) {
+            BlockId header = tail.successors[i];
+            if (!dominators.dominates(header, block)) {
+                continue;
+            }
+            if (loopOf[header] == SIZE_MAX) {
+                loopOf[header] = loops.size();
+                NaturalLoop loop{header, {header}, std::vector<uint8_t>(function.blocks.size(), 0)};
+                loop.contains[header] = 1;
+                loops.push_back(std::move(loop));
+            }
+
+            // 从回边的起点逆着边向上，直到循环头
+            NaturalLoop& loop = loops[loopOf[header]];
+            std::vector<BlockId> stack;
+            if (!loop.contains[block]) {
+                loop.contains[block] = 1;
+                loop.blocks.push_back(block);
+                stack.push_back(block);
+            }
+            while (!stack.empty()) {
+                BlockId current = stack.back();
+                stack.pop_back();
+                for (BlockId pred : function.blocks[current].predecessors) {
+                    if (!loop.contains[pred] && dominators.isReachable(pred)) {
+                        loop.contains[pred] = 1;
+                        loop.blocks.push_back(pred);
+                        stack.push_back(pred);
+                    }
+                }
+            }
+        }
+    }
+
+    // 内层循环的块少，先处理
+    std::stable_sort(loops.begin(), loops.end(), [](const NaturalLoop& a, const NaturalLoop& b) {
+        return a.blocks.size() < b.blocks.size();
+    });
+    for (NaturalLoop& loop : loops) {
+        std::sort(loop.blocks.begin(), loop.blocks.end(), [&dominators](BlockId a, BlockId b) {
+            return dominators.rpoIndex(a) < dominators.rpoIndex(b);
+        });
+    }
+    return loops;
+}
+
+} // namespace
+
+// 循环不变量外提
+void LoopInvariantMotion::run(IRFunction& function) {
+    hoisted_ = 0;
+    DominatorTree dominators(function);
+
+    for (const NaturalLoop& loop : findLoops(function, dominators)) {
+        // 唯一的、无条件跳入的前置块
+        BlockId preheader = NO_BLOCK;
+        bool unique = true;
+        for (BlockId pred : function.blocks[loop.header].predecessors) {
+            if (loop.contains[pred]) {
+                continue;
+            }
+            unique = preheader == NO_BLOCK;
+            preheader = pred;
+        }
+        if (!unique || preheader == NO_BLOCK || function.blocks[preheader].terminator != Terminator::JUMP) {
+            continue;
+        }
+
+        // 循环中写入的全局变量，是否有调用
+        std::vector<uint8_t> stored;
+        bool calls = false;
+        for (BlockId block : loop.blocks) {
+            for (ValueId value : function.blocks[block].instructions) {
+                const Instruction& instruction = function.values[value];
+                if (instruction.op == IROpcode::STORE_GLOBAL) {
+                    if (stored.size() <= static_cast<size_t>(instruction.imm)) {
+                        stored.resize(instruction.imm + 1, 0);
+                    }
+                    stored[instruction.imm] = 1;
+                } else if (instruction.op == IROpcode::CALL) {
+                    calls = true;
+                }
+            }
+        }
+        auto invariantLoad = [&stored, calls](const Instruction& instruction) {
+            return instruction.op == IROpcode::LOAD_GLOBAL && !calls &&
+                   (static_cast<size_t>(instruction.imm) >= stored.size() || !stored[instruction.imm]);
+        };
+
+        // 按逆后序处理，定义先于使用，外提后的指令所在块就是前置块，不在循环中
+        for (BlockId block : loop.blocks) {
+            auto& list = function.blocks[block].instructions;
+            list.erase(std::remove_if(list.begin(), list.end(), [&](ValueId value) {
+                Instruction& instruction = function.values[value];
+                if (instruction.op == IROpcode::PHI || instruction.op == IROpcode::CONST) {
+                    return false;
+                }
+                if (!isPure(function, instruction) && !invariantLoad(instruction)) {
+                    return false;
+                }
+                for (ValueId operand : instruction.operands) {
+                    if (loop.contains[function.values[operand].block]) {
+                        return false;
+                    }
+                }
+                instruction.block = preheader;
+                function.blocks[preheader].instructions.push_back(value);
+                hoisted_++;
+                return true;
+            }), list.end());
+        }
+    }
+}
+
+} // namespace jvav
@@ -0,0 +1,137 @@
+#include "ir/SSABuilder.h"
+#include "ir/Dominators.h"
+#include <algorithm>
+
+namespace jvav {
+
+// 构造SSA
+void SSABuilder::run(IRFunction& function) {
+    function.removeUnreachableBlocks();
+    if (function.localCount == 0) {
+        return;
+    }
+
+    DominatorTree dominators(function);
+    std::vector<std::vector<BlockId>> frontiers = dominators.frontiers(function);
+    size_t blockCount = function.blocks.size();
+
+    // 每个局部变量被写入的块
+    std::vector<std::vector<BlockId>> definitions(function.localCount);
+    for (BlockId block : dominators.reversePostorder()) {
+        for (ValueId value : function.blocks[block].instructions) {
+            const Instruction& instruction = function.values[value];
+            if (instruction.op == IROpcode::LOCAL_SET) {
+                auto& blocks = definitions[instruction.imm];
+                if (blocks.empty() || blocks.back() != block) {
+                    blocks.push_back(block);
+                }
+            }
+        }
+    }
+
+    // 放置phi，phiSlot记录每个phi属于哪个局部变量
+    std::vector<uint32_t> phiSlot;
+    std::vector<uint32_t> placed(blockCount, UINT32_MAX);
+    std::vector<uint32_t> queued(blockCount, UINT32_MAX);
+    std::vector<BlockId> worklist;
+    for (uint32_t slot = 0; slot < function.localCount; slot++) {
+        worklist = definitions[slot];
+        for (BlockId block : worklist) {
+            queued[block] = slot;
+        }
+        while (!worklist.empty()) {
+            BlockId block = worklist.back();
+            worklist.pop_back();
+            for (BlockId frontier : frontiers[block]) {
+                if (placed[frontier] == slot) {
+                    continue;
+                }
+                placed[frontier] = slot;
+                ValueId phi = function.insertPhi(frontier);
+                phiSlot.resize(function.values.size(), UINT32_MAX);
+                phiSlot[phi] = slot;
+                if (queued[frontier] != slot) {
+                    queued[frontier] = slot;
+                    worklist.push_back(frontier);
+                }
+            }
+        }
+    }
+
+    // 沿支配树先序重命名，stacks[slot]栈顶是当前可见的定义，pushed记录压栈的顺序以便回退
+    ValueId zero = function.constant(0);
+    phiSlot.resize(function.values.size(), UINT32_MAX);
+    std::vector<ValueId> replacement(function.values.size(), NO_VALUE);
+    std::vector<std::vector<ValueId>> stacks(function.localCount);
+    std::vector<uint32_t> pushed;
+    auto current = [&stacks, zero](uint32_t slot) {
+        return stacks[slot].empty() ? zero : stacks[slot].back();
+    };
+
+    struct Frame {
+        BlockId block;
+        size_t nextChild;
+        size_t pushedMark;
+    };
+    std::vector<Frame> frames{Frame{0, 0, 0}};
+    bool entering = true;
+    while (!frames.empty()) {
+        Frame& frame = frames.back();
+        if (entering) {
+            BasicBlock& block = function.blocks[frame.block];
+            for (ValueId value : block.instructions) {
+                Instruction& instruction = function.values[value];
+                if (instruction.op == IROpcode::PHI && phiSlot[value] != UINT32_MAX) {
+                    stacks[phiSlot[value]].push_back(value);
+                    pushed.push_back(phiSlot[value]);
+                } else if (instruction.op == IROpcode::LOCAL_GET) {
+                    replacement[value] = current(instruction.imm);
+                } else if (instruction.op == IROpcode::LOCAL_SET) {
+                    stacks[instruction.imm].push_back(instruction.operands[0]);
+                    pushed.push_back(instruction.imm);
+                }
+            }
+            for (size_t i = 0; i < block.successorCount(); i++) {
+                BasicBlock& successor = function.blocks[block.successors[i]];
+                size_t index = static_cast<size_t>(
+                    std::find(successor.predecessors.begin(), successor.predecessors.end(), frame.block) -
+                    successor.predecessors.begin());
+                for (ValueId value : successor.instructions) {
+                    if (function.values[value].op != IROpcode::PHI) {
+                        break;
+                    }
+                    if (phiSlot[value] != UINT32_MAX) {
+                        function.values[value].operands[index] = current(phiSlot[value]);
+                    }
+                }
+            }
+        }
+
+        const auto& children = dominators.children(frame.block);
+        if (frame.nextChild < children.size()) {
+            BlockId child = children[frame.nextChild++];
+            frames.push_back(Frame{child, 0, pushed.size()});
+            entering = true;
+            continue;
+        }
+        while (pushed.size() > frame.pushedMark) {
+            stacks[pushed.back()].pop_back();
+            pushed.pop_back();
+        }
+        frames.pop_back();
+        entering = false;
+    }
+
+    // 删除局部变量访问，把读取换成当时的定义
+    for (BasicBlock& block : function.blocks) {
+        auto& list = block.instructions;
+        list.erase(std::remove_if(list.begin(), list.end(), [&function](ValueId value) {
+            IROpcode op = function.values[value].op;
+            return op == IROpcode::LOCAL_GET || op == IROpcode::LOCAL_SET;
+        }), list.end());
+    }
+    function.replaceAllUses(replacement);
+    function.localCount = 0;
+}
+
+} // namespace jvav
@@ -0,0 +1,296 @@
+#include "ir/ValueNumbering.h"
+#include "ir/Dominators.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace jvav {
+
+namespace {
+
+// 散列表的键：运算、立即数、phi所在的块和操作数
+struct Key {
+    IROpcode op;
+    int32_t imm;
+    BlockId block;
+    std::vector<ValueId> operands;
+
+    bool operator==(const Key& other) const {
+        return op == other.op && imm == other.imm && block == other.block && operands == other.operands;
+    }
+};
+
+struct KeyHash {
+    size_t operator()(const Key& key) const {
+        size_t hash = static_cast<size_t>(key.op) * 0x9E3779B97F4A7C15ull;
+        hash ^= static_cast<uint32_t>(key.imm) + 0x9E3779B9u + (hash << 6) + (hash >> 2);
+        hash ^= key.block + 0x9E3779B9u + (hash << 6) + (hash >> 2);
+        for (ValueId operand : key.operands) {
+            hash ^= operand + 0x9E3779B9u + (hash << 6) + (hash >> 2);
+        }
+        return hash;
+    }
+};
+
+// 一次遍历
+class Numbering {
+public:
+    explicit Numbering(IRFunction& function) : function_(function), replacement_(function.values.size(), NO_VALUE) {}
+
+    // 遍历一次，返回删除的指令个数
+    size_t run();
+
+private:
+    ValueId resolve(ValueId value) const {
+        while (value < replacement_.size() && replacement_[value] != NO_VALUE) {
+            value = replacement_[value];
+        }
+        return value;
+    }
+
+    bool isConstant(ValueId value, int32_t& constant) const {
+        const Instruction& instruction = function_.values[value];
+        constant = instruction.imm;
+        return instruction.op == IROpcode::CONST;
+    }
+
+    bool isConstantEqual(ValueId value, int32_t expected) const {
+        int32_t constant;
+        return isConstant(value, constant) && constant == expected;
+    }
+
+    // 取值为constant的常量，没有时新建，遍历结束后放入入口块
+    ValueId makeConstant(int32_t constant);
+
+    // 按代数恒等式化简，返回等价的已有值，不能化简时返回NO_VALUE
+    ValueId simplify(const Instruction& instruction);
+
+    // 处理一条指令，返回代替它的值，保留时返回NO_VALUE
+    ValueId number(ValueId value);
+
+    IRFunction& function_;
+    std::vector<ValueId> replacement_;
+    std::unordered_map<Key, ValueId, KeyHash> table_;
+    std::vector<Key> log_;  // 按插入顺序记录的键，离开支配树子树时撤销
+    std::unordered_map<int32_t, ValueId> constants_;
+    std::vector<ValueId> created_;
+    std::unordered_map<int32_t, ValueId> globals_;  // 当前块中全局变量的已知值
+};
+
+ValueId Numbering::makeConstant(int32_t constant) {
+    auto found = constants_.find(constant);
+    if (found != constants_.end()) {
+        return found->second;
+    }
+    ValueId value = static_cast<ValueId>(function_.values.size());
+    function_.values.push_back(Instruction{IROpcode::CONST, IRType::I32, 0, constant, {}});
+    replacement_.push_back(NO_VALUE);
+    created_.push_back(value);
+    constants_.emplace(constant, value);
+    return value;
+}
+
+ValueId Numbering::simplify(const Instruction& instruction) {
+    const auto& operands = instruction.operands;
+    int32_t a = 0;
+    int32_t b = 0;
+    bool constantA = isConstant(operands[0], a);
+    bool constantB = operands.size() > 1 && isConstant(operands[1], b);
+    if (constantA && (operands.size() == 1 || constantB)) {
+        int32_t result;
+        if (foldInstruction(instruction.op, a, b, result)) {
+            return makeConstant(result);
+        }
+        return NO_VALUE;
+    }
+    if (operands.size() == 1) {
+        return NO_VALUE;
+    }
+
+    bool same = operands[0] == operands[1];
+    switch (instruction.op) {
+        case IROpcode::ADD:
+            if (isConstantEqual(operands[0], 0)) return operands[1];
+            if (isConstantEqual(operands[1], 0)) return operands[0];
+            break;
+        case IROpcode::SUB:
+            if (isConstantEqual(operands[1], 0)) return operands[0];
+            if (same) return makeConstant(0);
+            break;
+        case IROpcode::MUL:
+            if (isConstantEqual(operands[0], 1)) return operands[1];
+            if (isConstantEqual(operands[1], 1)) return operands[0];
+            if (isConstantEqual(operands[0], 0) || isConstantEqual(operands[1], 0)) return makeConstant(0);
+            break;
+        case IROpcode::AND:
+            if (same) return operands[0];
+            if (isConstantEqual(operands[0], 0) || isConstantEqual(operands[1], 0)) return makeConstant(0);
+            break;
+        case IROpcode::OR:
+            if (same) return operands[0];
+            if (isConstantEqual(operands[0], 0)) return operands[1];
+            if (isConstantEqual(operands[1], 0)) return operands[0];
+            break;
+        case IROpcode::EQ:
+        case IROpcode::LE:
+        case IROpcode::GE:
+            if (same) return makeConstant(1);
+            break;
+        case IROpcode::NE:
+        case IROpcode::LT:
+        case IROpcode::GT:
+            if (same) return makeConstant(0);
+            break;
+        default:
+            break;
+    }
+    return NO_VALUE;
+}
+
+ValueId Numbering::number(ValueId value) {
+    Instruction& instruction = function_.values[value];
+    for (ValueId& operand : instruction.operands) {
+        operand = resolve(operand);
+    }
+
+    switch (instruction.op) {
+        case IROpcode::PHI: {
+            // 除了自己只有一个不同的操作数
+            ValueId only = NO_VALUE;
+            bool trivial = true;
+            for (ValueId operand : instruction.operands) {
+                if (operand == value || operand == only) {
+                    continue;
+                }
+                if (only != NO_VALUE) {
+                    trivial = false;
+                    break;
+                }
+                only = operand;
+            }
+            if (trivial && only != NO_VALUE) {
+                return only;
+            }
+            break;
+        }
+        case IROpcode::CONST: {
+            auto found = constants_.find(instruction.imm);
+            if (found != constants_.end()) {
+                return found->second;
+            }
+            constants_.emplace(instruction.imm, value);
+            return NO_VALUE;
+        }
+        case IROpcode::LOAD_GLOBAL: {
+            auto found = globals_.find(instruction.imm);
+            if (found != globals_.end()) {
+                return found->second;
+            }
+            globals_[instruction.imm] = value;
+            return NO_VALUE;
+        }
+        case IROpcode::STORE_GLOBAL:
+            globals_[instruction.imm] = instruction.operands[0];
+            return NO_VALUE;
+        case IROpcode::CALL:
+            // 被调用的函数可能写任何全局变量
+            globals_.clear();
+            return NO_VALUE;
+        default:
+            if (instruction.op != IROpcode::PARAM && !isPure(function_, instruction)) {
+                return NO_VALUE;
+            }
+            if (instruction.op != IROpcode::PARAM) {
+                ValueId simpler = simplify(instruction);
+                if (simpler != NO_VALUE) {
+                    return simpler;
+                }
+            }
+            if (isCommutative(instruction.op) && instruction.operands[0] > instruction.operands[1]) {
+                std::swap(instruction.operands[0], instruction.operands[1]);
+            }
+            break;
+    }
+
+    Key key{instruction.op, instruction.imm,
+            instruction.op == IROpcode::PHI ? instruction.block : NO_BLOCK, instruction.operands};
+    auto [found, inserted] = table_.emplace(key, value);
+    if (!inserted) {
+        return found->second;
+    }
+    log_.push_back(std::move(key));
+    return NO_VALUE;
+}
+
+size_t Numbering::run() {
+    DominatorTree dominators(function_);
+    size_t removed = 0;
+
+    struct Frame {
+        BlockId block;
+        size_t nextChild;
+        size_t logMark;
+    };
+    std::vector<Frame> frames{Frame{0, 0, 0}};
+    bool entering = true;
+    while (!frames.empty()) {
+        Frame& frame = frames.back();
+        if (entering) {
+            BasicBlock& block = function_.blocks[frame.block];
+            globals_.clear();
+            std::vector<ValueId> kept;
+            kept.reserve(block.instructions.size());
+            for (ValueId value : block.instructions) {
+                ValueId equivalent = number(value);
+                if (equivalent == NO_VALUE) {
+                    kept.push_back(value);
+                } else {
+                    replacement_[value] = equivalent;
+                    removed++;
+                }
+            }
+            block.instructions = std::move(kept);
+            if (block.operand != NO_VALUE) {
+                block.operand = resolve(block.operand);
+            }
+        }
+
+        const auto& children = dominators.children(frame.block);
+        if (frame.nextChild < children.size()) {
+            BlockId child = children[frame.nextChild++];
+            frames.push_back(Frame{child, 0, log_.size()});
+            entering = true;
+            continue;
+        }
+        while (log_.size() > frame.logMark) {
+            table_.erase(log_.back());
+            log_.pop_back();
+        }
+        frames.pop_back();
+        entering = false;
+    }
+
+    // 新建的常量放在入口块开头，phi操作数等在遍历时还没替换的使用一并替换
+    for (ValueId value : created_) {
+        function_.values[value].block = 0;
+    }
+    auto& entry = function_.blocks[0].instructions;
+    entry.insert(entry.begin(), created_.begin(), created_.end());
+    function_.replaceAllUses(replacement_);
+    return removed;
+}
+
+} // namespace
+
+// 全局值编号
+void ValueNumbering::run(IRFunction& function) {
+    removed_ = 0;
+    for (int round = 0; round < MAX_ROUNDS; round++) {
+        size_t removed = Numbering(function).run();
+        removed_ += removed;
+        if (removed == 0) {
+            break;
+        }
+    }
+}
+
+} // namespace jvav
@@ -0,0 +1,150 @@
+#include "lexer/FileTable.h"
+#include "lexer/ScanKernels.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace jvav {
+
+// 获取全局文件表
+FileTable& FileTable::instance() {
+    static FileTable table;
+    return table;
+}
+
+// 构造函数：编号0保留给"无文件"
+FileTable::FileTable() {
+    chunks_[0].store(new Entry[CHUNK_SIZE], std::memory_order_release);
+}
+
+// 析构函数
+FileTable::~FileTable() {
+    for (std::atomic<Entry*>& chunk : chunks_) {
+        delete[] chunk.load(std::memory_order_relaxed);
+    }
+}
+
+// 查找条目
+const FileTable::Entry* FileTable::find(FileId id) const {
+    if (id > MAX_FILE_ID) {
+        return nullptr;
+    }
+    const Entry* chunk = chunks_[id >> CHUNK_BITS].load(std::memory_order_acquire);
+    return chunk != nullptr ? &chunk[id & (CHUNK_SIZE - 1)] : nullptr;
+}
+
+// 注册源文件
+FileId FileTable::addFile(const std::string& name, std::string_view text) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    FileId id;
+    if (!freeIds_.empty()) {
+        id = freeIds_.back();
+        freeIds_.pop_back();
+    } else {
+        if (nextId_ > MAX_FILE_ID) {
+            throw std::length_error("同时注册的源文件过多");
+        }
+        id = nextId_++;
+        std::atomic<Entry*>& chunk = chunks_[id >> CHUNK_BITS];
+        if (chunk.load(std::memory_order_relaxed) == nullptr) {
+            chunk.store(new Entry[CHUNK_SIZE], std::memory_order_release);
+        }
+    }
+
+    Entry& entry = *find(id);
+    entry.name = name;
+    entry.text = text;
+    entry.inUse = true;
+    entry.lineStarts.clear();
+    entry.lineStartsBuilt = false;
+    return id;
+}
+
+// 更新源代码文本
+void FileTable::updateText(FileId id, std::string_view text) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    Entry* entry = id != INVALID_FILE_ID ? find(id) : nullptr;
+    if (entry == nullptr || !entry->inUse) {
+        return;
+    }
+
+    entry->text = text;
+    entry->lineStarts.clear();
+    entry->lineStartsBuilt = false;
+}
+
+// 注销源文件
+void FileTable::removeFile(FileId id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    Entry* entry = id != INVALID_FILE_ID ? find(id) : nullptr;
+    if (entry == nullptr || !entry->inUse) {
+        return;
+    }
+
+    entry->name.clear();
+    entry->text = std::string_view();
+    entry->inUse = false;
+    entry->lineStarts.clear();
+    entry->lineStarts.shrink_to_fit();
+    entry->lineStartsBuilt = false;
+    freeIds_.push_back(id);
+}
+
+// 获取文件名（不加锁）
+std::string FileTable::getName(FileId id) const {
+    const Entry* entry = find(id);
+    return entry != nullptr ? entry->name : std::string();
+}
+
+// 获取源代码文本（不加锁）
+std::string_view FileTable::getText(FileId id) const {
+    const Entry* entry = find(id);
+    return entry != nullptr ? entry->text : std::string_view();
+}
+
+// 将字节偏移转换为行列号
+LineColumn FileTable::getLineColumn(FileId id, uint32_t offset) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    LineColumn result;
+    const Entry* found = id != INVALID_FILE_ID ? find(id) : nullptr;
+    if (found == nullptr || !found->inUse) {
+        return result;
+    }
+
+    const Entry& entry = *found;
+    if (!entry.lineStartsBuilt) {
+        buildLineStarts(entry);
+    }
+
+    // 找到最后一个不大于offset的行首
+    const std::vector<uint32_t>& starts = entry.lineStarts;
+    auto it = std::upper_bound(starts.begin(), starts.end(), offset);
+    size_t lineIndex = static_cast<size_t>(it - starts.begin()) - 1;
+
+    result.line = static_cast<uint32_t>(lineIndex + 1);
+    result.column = offset - starts[lineIndex] + 1;
+    return result;
+}
+
+// 构建行首偏移表
+void FileTable::buildLineStarts(const Entry& entry) {
+    const char* begin = entry.text.data();
+    const char* end = begin + entry.text.size();
+    const char* lastNewline = nullptr;
+
+    entry.lineStarts.clear();
+    entry.lineStarts.reserve(scan::countNewlines(begin, end, &lastNewline) + 1);
+    entry.lineStarts.push_back(0);
+
+    const char* p = scan::findNewline(begin, end);
+    while (p < end) {
+        entry.lineStarts.push_back(static_cast<uint32_t>(p + 1 - begin));
+        p = scan::findNewline(p + 1, end);
+    }
+    entry.lineStartsBuilt = true;
+}
+
+} // namespace jvav
@@ -1,17 +1,164 @@
 #include "lexer/Lexer.h"
+#include "lexer/ScanKernels.h"
+#include "lexer/Utf8.h"
+#include "lexer/TokenRing.h"
+#include "compiler/ThreadPool.h"
 #include <cctype>
+#include <algorithm>
+#include <array>
+#include <future>
 #include <iostream>
 
 namespace jvav {
 
+namespace {
+
+// 关键字表
+struct KeywordEntry {
+    std::string_view text;
+    TokenType type;
+};
+
+constexpr KeywordEntry KEYWORDS[] = {
+    // 英文关键字
+    {"import", TokenType::IMPORT},
+    {"set", TokenType::SET},
+    {"print", TokenType::PRINT},
+    {"if", TokenType::IF},
+    {"elif", TokenType::ELIF},
+    {"else", TokenType::ELSE},
+    {"loop", TokenType::LOOP},
+    {"define", TokenType::DEFINE},
+    {"return", TokenType::RETURN},
+    {"try", TokenType::TRY},
+    {"catch", TokenType::CATCH},
+    {"enum", TokenType::ENUM},
+    {"throw", TokenType::THROW},
+    {"jilu", TokenType::JILU},
+    
+    // 布尔值
+    {"true", TokenType::BOOL_LITERAL},
+    {"false", TokenType::BOOL_LITERAL},
+    
+    // 中文关键字
+    {"导入", TokenType::ZH_IMPORT},
+    {"设置", TokenType::ZH_SET},
+    {"输出", TokenType::ZH_PRINT},
+    {"如果", TokenType::ZH_IF},
+    {"否则如果", TokenType::ZH_ELIF},
+    {"否则", TokenType::ZH_ELSE},
+    {"循环", TokenType::ZH_LOOP},
+    {"定义", TokenType::ZH_DEFINE},
+    {"返回", TokenType::ZH_RETURN},
+    {"尝试", TokenType::ZH_TRY},
+    {"捕获", TokenType::ZH_CATCH},
+    {"枚举", TokenType::ZH_ENUM},
+    {"抛出", TokenType::ZH_THROW},
+    {"记录", TokenType::ZH_JILU},
+    
+    // 中文布尔值
+    {"真", TokenType::BOOL_LITERAL},
+    {"假", TokenType::BOOL_LITERAL}
+};
+
+constexpr size_t KEYWORD_COUNT = sizeof(KEYWORDS) / sizeof(KEYWORDS[0]);
+constexpr size_t KEYWORD_TABLE_SIZE = 64;
+
+// 关键字哈希：只看长度、首字节和末字节，对上面的关键字集合无冲突
+constexpr size_t keywordHash(std::string_view text) {
+    return (text.size() +
+            7 * static_cast<unsigned char>(text.front()) +
+            29 * static_cast<unsigned char>(text.back())) & (KEYWORD_TABLE_SIZE - 1);
+}
+
+// 编译期构造哈希槽位表，槽位中存放KEYWORDS的下标，-1表示空
+constexpr std::array<int, KEYWORD_TABLE_SIZE> buildKeywordSlots() {
+    std::array<int, KEYWORD_TABLE_SIZE> slots{};
+    for (size_t i = 0; i < KEYWORD_TABLE_SIZE; i++) {
+        slots[i] = -1;
+    }
+    for (size_t i = 0; i < KEYWORD_COUNT; i++) {
+        slots[keywordHash(KEYWORDS[i].text)] = static_cast<int>(i);
+    }
+    return slots;
+}
+
+constexpr std::array<int, KEYWORD_TABLE_SIZE> KEYWORD_SLOTS = buildKeywordSlots();
+
+// 检查哈希是否完美（每个关键字都占据自己的槽位）
+constexpr bool keywordHashIsPerfect() {
+    for (size_t i = 0; i < KEYWORD_COUNT; i++) {
+        if (KEYWORD_SLOTS[keywordHash(KEYWORDS[i].text)] != static_cast<int>(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(keywordHashIsPerfect(), "关键字哈希存在冲突，新增关键字后请调整keywordHash的系数");
+
+// 最长关键字的字节数，更长的标识符无需查表
+constexpr size_t maxKeywordLength() {
+    size_t maxLength = 0;
+    for (size_t i = 0; i < KEYWORD_COUNT; i++) {
+        if (KEYWORDS[i].text.size() > maxLength) {
+            maxLength = KEYWORDS[i].text.size();
+        }
+    }
+    return maxLength;
+}
+
+constexpr size_t MAX_KEYWORD_LENGTH = maxKeywordLength();
+
+// 并行分析时每段的最小字节数
+constexpr size_t PARALLEL_MIN_CHUNK_SIZE = Lexer::PARALLEL_MIN_SIZE / 2;
+
+// 估算token个数用的平均每个token占用的源代码字节数（含空白），估小一些以免扩容
+constexpr size_t ESTIMATED_BYTES_PER_TOKEN = 4;
+
+// 每个线程分到的段数，段数多于线程数可以平衡各段耗时的差异
+constexpr size_t CHUNKS_PER_THREAD = 4;
+
+// 从target开始查找可以切分的位置
+// 字符串和注释都在换行处结束，唯一的例外是字符串中被反斜杠转义的换行，
+// 因此在前一个字节不是反斜杠的换行符之后切分，返回切分点的偏移
+size_t findSplitPoint(std::string_view source, size_t target) {
+    const char* begin = source.data();
+    const char* end = begin + source.size();
+    
+    const char* p = scan::findNewline(begin + target, end);
+    while (p < end && p > begin && p[-1] == '\\') {
+        p = scan::findNewline(p + 1, end);
+    }
+    return p < end ? static_cast<size_t>(p - begin) + 1 : source.size();
+}
+
+// 一段源代码的分析结果
+struct ChunkResult {
+    TokenBuffer tokens;
+    std::vector<std::string> errors;
+};
+
+} // namespace
+
 // 构造函数
-Lexer::Lexer(const std::string& source, const std::string& filename)
+Lexer::Lexer(std::string_view source, const std::string& filename)
     : source_(source), filename_(filename) {
-    initKeywords();
+    fileId_ = FileTable::instance().addFile(filename_, source_);
+    ownsFile_ = true;
+}
+
+// 从文件中间开始分析的构造函数
+Lexer::Lexer(std::string_view source, const std::string& filename, FileId fileId, size_t begin)
+    : source_(source), filename_(filename), fileId_(fileId), position_(begin), tokenStart_(begin) {
 }
 
 // 析构函数
-Lexer::~Lexer() {}
+Lexer::~Lexer() {
+    if (ownsFile_) {
+        FileTable::instance().removeFile(fileId_);
+    }
+}
 
 // 获取下一个token
 Token Lexer::getNextToken() {
@@ -22,8 +169,10 @@ Token Lexer::getNextToken() {
     
     skipWhitespace();
     
+    tokenStart_ = position_;
+    
     if (isAtEnd()) {
-        return Token(TokenType::END_OF_FILE, "", getCurrentLocation());
+        return makeToken(TokenType::END_OF_FILE);
     }
     
     return scanToken();
@@ -45,7 +194,13 @@ bool Lexer::isAtEnd(size_t offset) const {
 
 // 获取当前位置信息
 SourceLocation Lexer::getCurrentLocation() const {
-    return SourceLocation(filename_, line_, column_);
+    return getLocation(position_);
+}
+
+// 获取某个字节偏移的位置信息
+SourceLocation Lexer::getLocation(size_t offset) const {
+    LineColumn position = FileTable::instance().getLineColumn(fileId_, static_cast<uint32_t>(offset));
+    return SourceLocation(filename_, static_cast<int>(position.line), static_cast<int>(position.column));
 }
 
 // 获取所有tokens（调试用）
@@ -64,61 +219,143 @@ std::vector<Token> Lexer::tokenize() {
     return tokens;
 }
 
-// 初始化关键字表
-void Lexer::initKeywords() {
-    // 英文关键字
-    keywords_["import"] = TokenType::IMPORT;
-    keywords_["set"] = TokenType::SET;
-    keywords_["print"] = TokenType::PRINT;
-    keywords_["if"] = TokenType::IF;
-    keywords_["elif"] = TokenType::ELIF;
-    keywords_["else"] = TokenType::ELSE;
-    keywords_["loop"] = TokenType::LOOP;
-    keywords_["define"] = TokenType::DEFINE;
-    keywords_["return"] = TokenType::RETURN;
-    keywords_["try"] = TokenType::TRY;
-    keywords_["catch"] = TokenType::CATCH;
-    keywords_["enum"] = TokenType::ENUM;
-    keywords_["throw"] = TokenType::THROW;
-    keywords_["jilu"] = TokenType::JILU;
-    
-    // 布尔值
-    keywords_["true"] = TokenType::BOOL_LITERAL;
-    keywords_["false"] = TokenType::BOOL_LITERAL;
+// 将全部token写入token缓冲区
+TokenBuffer Lexer::tokenizeToBuffer() {
+    TokenBuffer tokens(fileId_);
+    tokens.reserve(source_.size() / ESTIMATED_BYTES_PER_TOKEN + 1);
     
-    // 中文关键字
-    keywords_["导入"] = TokenType::ZH_IMPORT;
-    keywords_["设置"] = TokenType::ZH_SET;
-    keywords_["输出"] = TokenType::ZH_PRINT;
-    keywords_["如果"] = TokenType::ZH_IF;
-    keywords_["否则如果"] = TokenType::ZH_ELIF;
-    keywords_["否则"] = TokenType::ZH_ELSE;
-    keywords_["循环"] = TokenType::ZH_LOOP;
-    keywords_["定义"] = TokenType::ZH_DEFINE;
-    keywords_["返回"] = TokenType::ZH_RETURN;
-    keywords_["尝试"] = TokenType::ZH_TRY;
-    keywords_["捕获"] = TokenType::ZH_CATCH;
-    keywords_["枚举"] = TokenType::ZH_ENUM;
-    keywords_["抛出"] = TokenType::ZH_THROW;
-    keywords_["记录"] = TokenType::ZH_JILU;
+    while (true) {
+        Token token = getNextToken();
+        tokens.push(token);
+        
+        if (token.isEOF()) {
+            break;
+        }
+    }
     
-    // 中文布尔值
-    keywords_["真"] = TokenType::BOOL_LITERAL;
-    keywords_["假"] = TokenType::BOOL_LITERAL;
+    return tokens;
 }
 
-// 读取下一个字符并前进
-char Lexer::advance() {
-    char c = source_[position_++];
+// 按需分析
+size_t Lexer::tokenizeBatch(TokenBuffer& out, size_t maxCount) {
+    size_t count = 0;
+    while (count < maxCount) {
+        Token token = getNextToken();
+        out.push(token);
+        count++;
+        
+        if (token.isEOF()) {
+            break;
+        }
+    }
+    return count;
+}
+
+// 流式分析
+void Lexer::tokenizeToRing(TokenRing& ring) {
+    while (true) {
+        Token token = getNextToken();
+        if (!ring.push(token) || token.isEOF()) {
+            break;
+        }
+    }
+}
+
+// 并行分析
+TokenBuffer Lexer::tokenizeParallel(ThreadPool& pool) {
+    size_t chunkCount = std::min(pool.size() * CHUNKS_PER_THREAD,
+                                 source_.size() / PARALLEL_MIN_CHUNK_SIZE);
+    if (pool.size() <= 1 || chunkCount < 2 || source_.size() < PARALLEL_MIN_SIZE ||
+        position_ != 0 || hasNextToken_) {
+        return tokenizeToBuffer();
+    }
     
-    if (c == '\n') {
-        line_++;
-        column_ = 1;
-    } else {
-        column_++;
+    // 按大致相等的大小确定各段边界
+    std::vector<size_t> bounds;
+    bounds.push_back(0);
+    for (size_t i = 1; i < chunkCount; i++) {
+        size_t target = std::max(source_.size() / chunkCount * i, bounds.back());
+        size_t split = findSplitPoint(source_, target);
+        if (split >= source_.size()) {
+            break;
+        }
+        if (split > bounds.back()) {
+            bounds.push_back(split);
+        }
+    }
+    bounds.push_back(source_.size());
+    
+    // 各段分别分析，token偏移仍相对于整个文件
+    std::vector<std::future<ChunkResult>> futures;
+    futures.reserve(bounds.size() - 1);
+    for (size_t i = 0; i + 1 < bounds.size(); i++) {
+        size_t begin = bounds[i];
+        size_t end = bounds[i + 1];
+        futures.push_back(pool.submit([this, begin, end]() {
+            Lexer chunkLexer(source_.substr(0, end), filename_, fileId_, begin);
+            
+            ChunkResult result;
+            result.tokens = TokenBuffer(fileId_);
+            result.tokens.reserve((end - begin) / ESTIMATED_BYTES_PER_TOKEN + 1);
+            while (true) {
+                Token token = chunkLexer.getNextToken();
+                if (token.isEOF()) {
+                    break;
+                }
+                result.tokens.push(token);
+            }
+            result.errors = std::move(chunkLexer.errors_);
+            return result;
+        }));
     }
     
-    return c;
+    // 按顺序拼接
+    std::vector<ChunkResult> results;
+    results.reserve(futures.size());
+    size_t total = 1;
+    for (auto& future : futures) {
+        results.push_back(future.get());
+        total += results.back().tokens.size();
+    }
+    
+    TokenBuffer tokens(fileId_);
+    tokens.reserve(total);
+    for (ChunkResult& result : results) {
+        tokens.append(result.tokens);
+        for (std::string& error : result.errors) {
+            errors_.push_back(std::move(error));
+        }
+    }
+    
+    position_ = source_.size();
+    tokenStart_ = position_;
+    tokens.push(TokenType::END_OF_FILE, static_cast<uint32_t>(position_), 0);
+    return tokens;
+}
+
+// 用[tokenStart_, position_)范围构造token
+Token Lexer::makeToken(TokenType type) const {
+    return Token(type, fileId_,
+                 static_cast<uint32_t>(tokenStart_),
+                 static_cast<uint32_t>(position_ - tokenStart_));
+}
+
+// 查询关键字类型
+TokenType Lexer::lookupKeyword(std::string_view text) {
+    if (text.empty() || text.size() > MAX_KEYWORD_LENGTH) {
+        return TokenType::IDENTIFIER;
+    }
+    
+    int slot = KEYWORD_SLOTS[keywordHash(text)];
+    if (slot >= 0 && KEYWORDS[slot].text == text) {
+        return KEYWORDS[slot].type;
+    }
+    return TokenType::IDENTIFIER;
+}
+
+// 读取下一个字符并前进
+char Lexer::advance() {
+    return source_[position_++];
 }
 
 // 查看当前字符
@@ -138,21 +375,32 @@ bool Lexer::match(char expected) {
     if (isAtEnd() || source_[position_] != expected) return false;
     
     position_++;
-    column_++;
     return true;
 }
 
 // 跳过空白字符
 void Lexer::skipWhitespace() {
+    const char* begin = source_.data();
+    const char* end = begin + source_.size();
+    
     while (!isAtEnd()) {
-        char c = peek();
+        char c = source_[position_];
         switch (c) {
             case ' ':
             case '\t':
             case '\r':
-            case '\n':
-                advance();
+            case '\n': {
+                // token之间最常见的是单个空白字符，直接处理
+                char next = peekNext();
+                if (next != ' ' && next != '\t' && next != '\r' && next != '\n') {
+                    position_++;
+                    break;
+                }
+                // 缩进、空行等较长的空白段批量扫描
+                const char* p = scan::skipWhitespace(begin + position_, end);
+                position_ = static_cast<size_t>(p - begin);
                 break;
+            }
             case '#':
                 skipComment();
                 break;
@@ -165,9 +413,9 @@ void Lexer::skipWhitespace() {
 // 跳过注释
 void Lexer::skipComment() {
     // 跳过直到行尾
-    while (peek() != '\n' && !isAtEnd()) {
-        advance();
-    }
+    const char* begin = source_.data();
+    const char* p = scan::findNewline(begin + position_, begin + source_.size());
+    position_ = static_cast<size_t>(p - begin);
 }
 
 // 检查是否是数字
@@ -175,12 +423,9 @@ bool Lexer::isDigit(char c) const {
     return c >= '0' && c <= '9';
 }
 
-// 检查是否是字母
+// 检查是否是ASCII字母或下划线（非ASCII字符由unicodeToken处理）
 bool Lexer::isAlpha(char c) const {
-    return (c >= 'a' && c <= 'z') || 
-           (c >= 'A' && c <= 'Z') || 
-           c == '_' || 
-           isChineseChar(c);
+    return utf8::isAsciiIdStart(static_cast<unsigned char>(c));
 }
 
 // 检查是否是字母或数字
@@ -188,22 +433,19 @@ bool Lexer::isAlphaNumeric(char c) const {
     return isAlpha(c) || isDigit(c);
 }
 
-// 检查是否是中文字符（简单实现，实际中需要更复杂的Unicode处理）
-bool Lexer::isChineseChar(char c) const {
-    // UTF-8中文字符的首字节范围通常是0xE4-0xE9
-    // 这是一个简化实现，完整实现需要处理多字节UTF-8字符
-    unsigned char uc = static_cast<unsigned char>(c);
-    return (uc >= 0xE4 && uc <= 0xE9) || uc >= 0x80;
-}
-
-// 添加词法错误
+// 添加词法错误，位置是出错token的起点，与token和语法错误的位置一致
 void Lexer::addError(const std::string& message) {
-    std::string error = getCurrentLocation().toString() + ": " + message;
+    std::string error = getLocation(tokenStart_).toString() + ": " + message;
     errors_.push_back(error);
 }
 
 // 扫描单个token
 Token Lexer::scanToken() {
+    // 中文标识符、中文关键字等以多字节字符开头
+    if (static_cast<unsigned char>(peek()) >= 0x80) {
+        return unicodeToken();
+    }
+    
     char c = advance();
     
     // 标识符
@@ -221,97 +463,134 @@ Token Lexer::scanToken() {
         case '"': return string();
         
         // 单字符tokens
-        case '(': return Token(TokenType::LEFT_PAREN, "(", getCurrentLocation());
-        case ')': return Token(TokenType::RIGHT_PAREN, ")", getCurrentLocation());
-        case '{': return Token(TokenType::LEFT_BRACE, "{", getCurrentLocation());
-        case '}': return Token(TokenType::RIGHT_BRACE, "}", getCurrentLocation());
-        case '[': return Token(TokenType::LEFT_BRACKET, "[", getCurrentLocation());
-        case ']': return Token(TokenType::RIGHT_BRACKET, "]", getCurrentLocation());
-        case ',': return Token(TokenType::COMMA, ",", getCurrentLocation());
-        case '.': return Token(TokenType::DOT, ".", getCurrentLocation());
-        case ';': return Token(TokenType::SEMICOLON, ";", getCurrentLocation());
-        case ':': return Token(TokenType::COLON, ":", getCurrentLocation());
-        case '+': return Token(TokenType::PLUS, "+", getCurrentLocation());
-        case '-': return Token(TokenType::MINUS, "-", getCurrentLocation());
-        case '*': return Token(TokenType::STAR, "*", getCurrentLocation());
-        case '/': return Token(TokenType::SLASH, "/", getCurrentLocation());
-        case '%': return Token(TokenType::PERCENT, "%", getCurrentLocation());
+        case '(': return makeToken(TokenType::LEFT_PAREN);
+        case ')': return makeToken(TokenType::RIGHT_PAREN);
+        case '{': return makeToken(TokenType::LEFT_BRACE);
+        case '}': return makeToken(TokenType::RIGHT_BRACE);
+        case '[': return makeToken(TokenType::LEFT_BRACKET);
+        case ']': return makeToken(TokenType::RIGHT_BRACKET);
+        case ',': return makeToken(TokenType::COMMA);
+        case '.': return makeToken(TokenType::DOT);
+        case ';': return makeToken(TokenType::SEMICOLON);
+        case ':': return makeToken(TokenType::COLON);
+        case '+': return makeToken(TokenType::PLUS);
+        case '-': return makeToken(TokenType::MINUS);
+        case '*': return makeToken(TokenType::STAR);
+        case '/': return makeToken(TokenType::SLASH);
+        case '%': return makeToken(TokenType::PERCENT);
         
         // 可能是双字符tokens
         case '=':
             if (match('=')) {
-                return Token(TokenType::EQUAL, "==", getCurrentLocation());
+                return makeToken(TokenType::EQUAL);
             } else {
-                return Token(TokenType::ASSIGN, "=", getCurrentLocation());
+                return makeToken(TokenType::ASSIGN);
             }
             
         case '!':
             if (match('=')) {
-                return Token(TokenType::NOT_EQUAL, "!=", getCurrentLocation());
+                return makeToken(TokenType::NOT_EQUAL);
             } else {
-                return Token(TokenType::NOT, "!", getCurrentLocation());
+                return makeToken(TokenType::NOT);
             }
             
         case '<':
             if (match('=')) {
-                return Token(TokenType::LESS_EQUAL, "<=", getCurrentLocation());
+                return makeToken(TokenType::LESS_EQUAL);
             } else {
-                return Token(TokenType::LESS, "<", getCurrentLocation());
+                return makeToken(TokenType::LESS);
             }
             
         case '>':
             if (match('=')) {
-                return Token(TokenType::GREATER_EQUAL, ">=", getCurrentLocation());
+                return makeToken(TokenType::GREATER_EQUAL);
             } else {
-                return Token(TokenType::GREATER, ">", getCurrentLocation());
+                return makeToken(TokenType::GREATER);
             }
             
         case '&':
             if (match('&')) {
-                return Token(TokenType::AND, "&&", getCurrentLocation());
+                return makeToken(TokenType::AND);
             } else {
                 addError("Unexpected character '&', did you mean '&&'?");
-                return Token(TokenType::ERROR, "&", getCurrentLocation());
+                return makeToken(TokenType::ERROR);
             }
             
         case '|':
             if (match('|')) {
-                return Token(TokenType::OR, "||", getCurrentLocation());
+                return makeToken(TokenType::OR);
             } else {
                 addError("Unexpected character '|', did you mean '||'?");
-                return Token(TokenType::ERROR, "|", getCurrentLocation());
+                return makeToken(TokenType::ERROR);
             }
             
         default:
             // 未识别的字符
             addError("Unexpected character: " + std::string(1, c));
-            return Token(TokenType::ERROR, std::string(1, c), getCurrentLocation());
+            return makeToken(TokenType::ERROR);
     }
 }
 
 // 处理标识符和关键字
 Token Lexer::identifier() {
-    size_t start = position_ - 1;
+    const char* begin = source_.data();
+    const char* end = begin + source_.size();
+    const char* p = begin + position_;
     
-    while (isAlphaNumeric(peek())) {
-        advance();
+    while (p < end) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        
+        if (c < 0x80) {
+            // ASCII部分查表判断，连续的一段批量扫描
+            if (!utf8::isAsciiIdContinue(c)) {
+                break;
+            }
+            p = scan::skipIdentifier(p, end);
+            continue;
+        }
+        
+        // 多字节字符：解码的同时校验并分类
+        utf8::CodePoint cp = utf8::decodeMultibyte(p, end);
+        if (cp.kind != utf8::CharKind::ID_START && cp.kind != utf8::CharKind::ID_CONTINUE) {
+            // 非法序列或标点等留给下一个token报告
+            break;
+        }
+        p += cp.length;
     }
+    position_ = static_cast<size_t>(p - begin);
     
-    std::string text = source_.substr(start, position_ - start);
+    // 直接在源代码上查询关键字，不分配内存
+    std::string_view text = source_.substr(tokenStart_, position_ - tokenStart_);
+    TokenType type = lookupKeyword(text);
+    if (type != TokenType::IDENTIFIER) {
+        return makeToken(type);
+    }
+    
+    // 标识符登记到符号表
+    Token token = makeToken(type);
+    return Token(type, fileId_, token.getOffset(), token.getLength(), symbols_.intern(text));
+}
+
+// 处理以非ASCII字符开头的token
+Token Lexer::unicodeToken() {
+    const char* begin = source_.data();
+    utf8::CodePoint cp = utf8::decodeMultibyte(begin + position_, begin + source_.size());
+    position_ += cp.length;
     
-    // 检查是否是关键字
-    auto it = keywords_.find(text);
-    if (it != keywords_.end()) {
-        return Token(it->second, text, getCurrentLocation());
+    if (cp.kind == utf8::CharKind::ID_START) {
+        return identifier();
     }
     
-    return Token(TokenType::IDENTIFIER, text, getCurrentLocation());
+    if (cp.kind == utf8::CharKind::INVALID) {
+        addError("Invalid UTF-8 sequence");
+    } else {
+        addError("Unexpected character: " + std::string(source_.substr(tokenStart_, cp.length)));
+    }
+    return makeToken(TokenType::ERROR);
 }
 
 // 处理数字字面量
 Token Lexer::number() {
-    size_t start = position_ - 1;
-    
     while (isDigit(peek())) {
         advance();
     }
@@ -326,44 +605,40 @@ Token Lexer::number() {
         }
     }
     
-    std::string text = source_.substr(start, position_ - start);
-    return Token(TokenType::NUMBER_LITERAL, text, getCurrentLocation());
+    return makeToken(TokenType::NUMBER_LITERAL);
 }
 
 // 处理字符串字面量
 Token Lexer::string() {
-    size_t start = position_;
-    int startLine = line_;
-    int startColumn = column_ - 1;  // 已经消耗了开引号
+    const char* begin = source_.data();
+    const char* end = begin + source_.size();
     
-    while (peek() != '"' && !isAtEnd()) {
-        if (peek() == '\n') {
+    while (true) {
+        // 批量跳过普通字符，停在引号、反斜杠或换行处
+        const char* p = scan::findStringSpecial(begin + position_, end);
+        position_ = static_cast<size_t>(p - begin);
+        
+        if (isAtEnd() || peek() == '\n') {
             addError("Unterminated string");
-            return Token(TokenType::ERROR, "Unterminated string", 
-                        SourceLocation(filename_, startLine, startColumn));
+            return makeToken(TokenType::ERROR);
         }
         
-        if (peek() == '\\' && !isAtEnd(1)) {
-            // 处理转义字符
-            advance();  // 消耗反斜杠
+        if (peek() == '"') {
+            break;
         }
         
+        // 处理转义字符：消耗反斜杠和被转义的字符
         advance();
-    }
-    
-    if (isAtEnd()) {
-        addError("Unterminated string");
-        return Token(TokenType::ERROR, "Unterminated string", 
-                    SourceLocation(filename_, startLine, startColumn));
+        if (!isAtEnd()) {
+            advance();
+        }
     }
     
     // 消耗结束引号
     advance();
     
-    // 获取字符串内容（不包括引号）
-    std::string value = source_.substr(start, position_ - start - 1);
-    return Token(TokenType::STRING_LITERAL, value, 
-                SourceLocation(filename_, startLine, startColumn));
+    // token范围包含引号，getValue()返回不含引号的内容
+    return makeToken(TokenType::STRING_LITERAL);
 }
 
 } // namespace jvav 
\ No newline at end of file
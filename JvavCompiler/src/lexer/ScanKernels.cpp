@@ -0,0 +1,385 @@
+#include "lexer/ScanKernels.h"
+#include <cstdint>
+#include <cstring>
+
+// x86-64上SSE2是基础指令集，可以直接使用；AVX2需要运行时检测
+#if defined(__x86_64__) || defined(_M_X64)
+#define JVAV_SCAN_SSE2 1
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define JVAV_SCAN_AVX2 1
+#define JVAV_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace jvav {
+namespace scan {
+
+namespace {
+
+// 位运算辅助函数
+inline unsigned countTrailingZeros(uint32_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctz(x));
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, x);
+    return static_cast<unsigned>(index);
+#else
+    unsigned n = 0;
+    while (!(x & 1u)) {
+        x >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+inline unsigned highestBit(uint32_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 31u - static_cast<unsigned>(__builtin_clz(x));
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse(&index, x);
+    return static_cast<unsigned>(index);
+#else
+    unsigned n = 0;
+    while (x >>= 1) {
+        n++;
+    }
+    return n;
+#endif
+}
+
+inline unsigned popCount(uint32_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_popcount(x));
+#else
+    unsigned n = 0;
+    while (x) {
+        x &= x - 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+inline bool isSpace(unsigned char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+inline bool isIdentifierAscii(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') || c == '_';
+}
+
+// ---------------- 标量实现 ----------------
+
+const char* skipWhitespaceScalar(const char* p, const char* end) {
+    while (p < end && isSpace(static_cast<unsigned char>(*p))) {
+        p++;
+    }
+    return p;
+}
+
+const char* findNewlineScalar(const char* p, const char* end) {
+    const void* found = std::memchr(p, '\n', static_cast<size_t>(end - p));
+    return found ? static_cast<const char*>(found) : end;
+}
+
+const char* findStringSpecialScalar(const char* p, const char* end) {
+    while (p < end && *p != '"' && *p != '\\' && *p != '\n') {
+        p++;
+    }
+    return p;
+}
+
+const char* skipIdentifierScalar(const char* p, const char* end) {
+    while (p < end && isIdentifierAscii(static_cast<unsigned char>(*p))) {
+        p++;
+    }
+    return p;
+}
+
+size_t countNewlinesScalar(const char* p, const char* end, const char** lastNewline) {
+    size_t count = 0;
+    *lastNewline = nullptr;
+    for (; p < end; p++) {
+        if (*p == '\n') {
+            count++;
+            *lastNewline = p;
+        }
+    }
+    return count;
+}
+
+#ifdef JVAV_SCAN_SSE2
+// ---------------- SSE2实现（每次16字节） ----------------
+
+inline __m128i load16(const char* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+// 无符号范围检查：lo <= v <= lo + span
+inline __m128i inRange16(__m128i v, char lo, char span) {
+    __m128i shifted = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+    return _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(span)), shifted);
+}
+
+const char* skipWhitespaceSSE2(const char* p, const char* end) {
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i nl = _mm_set1_epi8('\n');
+
+    while (end - p >= 16) {
+        __m128i v = load16(p);
+        __m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)),
+                                  _mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, nl)));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(ws)) ^ 0xFFFFu;
+        if (mask) {
+            return p + countTrailingZeros(mask);
+        }
+        p += 16;
+    }
+    return skipWhitespaceScalar(p, end);
+}
+
+const char* findNewlineSSE2(const char* p, const char* end) {
+    const __m128i nl = _mm_set1_epi8('\n');
+
+    while (end - p >= 16) {
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(load16(p), nl)));
+        if (mask) {
+            return p + countTrailingZeros(mask);
+        }
+        p += 16;
+    }
+    return findNewlineScalar(p, end);
+}
+
+const char* findStringSpecialSSE2(const char* p, const char* end) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i nl = _mm_set1_epi8('\n');
+
+    while (end - p >= 16) {
+        __m128i v = load16(p);
+        __m128i special = _mm_or_si128(_mm_cmpeq_epi8(v, quote),
+                                       _mm_or_si128(_mm_cmpeq_epi8(v, backslash), _mm_cmpeq_epi8(v, nl)));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(special));
+        if (mask) {
+            return p + countTrailingZeros(mask);
+        }
+        p += 16;
+    }
+    return findStringSpecialScalar(p, end);
+}
+
+const char* skipIdentifierSSE2(const char* p, const char* end) {
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    const __m128i underscore = _mm_set1_epi8('_');
+
+    while (end - p >= 16) {
+        __m128i v = load16(p);
+        __m128i alpha = inRange16(_mm_or_si128(v, caseBit), 'a', 'z' - 'a');
+        __m128i digit = inRange16(v, '0', '9' - '0');
+        __m128i ident = _mm_or_si128(_mm_or_si128(alpha, digit), _mm_cmpeq_epi8(v, underscore));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(ident)) ^ 0xFFFFu;
+        if (mask) {
+            return p + countTrailingZeros(mask);
+        }
+        p += 16;
+    }
+    return skipIdentifierScalar(p, end);
+}
+
+size_t countNewlinesSSE2(const char* p, const char* end, const char** lastNewline) {
+    const __m128i nl = _mm_set1_epi8('\n');
+    size_t count = 0;
+    const char* last = nullptr;
+
+    while (end - p >= 16) {
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(load16(p), nl)));
+        if (mask) {
+            count += popCount(mask);
+            last = p + highestBit(mask);
+        }
+        p += 16;
+    }
+
+    const char* tailLast;
+    count += countNewlinesScalar(p, end, &tailLast);
+    *lastNewline = tailLast ? tailLast : last;
+    return count;
+}
+#endif // JVAV_SCAN_SSE2
+
+#ifdef JVAV_SCAN_AVX2
+// ---------------- AVX2实现（每次32字节） ----------------
+
+JVAV_TARGET_AVX2 inline __m256i load32(const char* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+JVAV_TARGET_AVX2 inline __m256i inRange32(__m256i v, char lo, char span) {
+    __m256i shifted = _mm256_sub_epi8(v, _mm256_set1_epi8(lo));
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8(span)), shifted);
+}
+
+JVAV_TARGET_AVX2 const char* skipWhitespaceAVX2(const char* p, const char* end) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i nl = _mm256_set1_epi8('\n');
+
+    while (end - p >= 32) {
+        __m256i v = load32(p);
+        __m256i ws = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, space), _mm256_cmpeq_epi8(v, tab)),
+                                     _mm256_or_si256(_mm256_cmpeq_epi8(v, cr), _mm256_cmpeq_epi8(v, nl)));
+        uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(ws));
+        if (mask) {
+            return p + countTrailingZeros(mask);
+        }
+        p += 32;
+    }
+    return skipWhitespaceSSE2(p, end);
+}
+
+JVAV_TARGET_AVX2 const char* findNewlineAVX2(const char* p, const char* end) {
+    const __m256i nl = _mm256_set1_epi8('\n');
+
+    while (end - p >= 32) {
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(load32(p), nl)));
+        if (mask) {
+            return p + countTrailingZeros(mask);
+        }
+        p += 32;
+    }
+    return findNewlineSSE2(p, end);
+}
+
+JVAV_TARGET_AVX2 const char* findStringSpecialAVX2(const char* p, const char* end) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i nl = _mm256_set1_epi8('\n');
+
+    while (end - p >= 32) {
+        __m256i v = load32(p);
+        __m256i special = _mm256_or_si256(_mm256_cmpeq_epi8(v, quote),
+                                          _mm256_or_si256(_mm256_cmpeq_epi8(v, backslash), _mm256_cmpeq_epi8(v, nl)));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(special));
+        if (mask) {
+            return p + countTrailingZeros(mask);
+        }
+        p += 32;
+    }
+    return findStringSpecialSSE2(p, end);
+}
+
+JVAV_TARGET_AVX2 const char* skipIdentifierAVX2(const char* p, const char* end) {
+    const __m256i caseBit = _mm256_set1_epi8(0x20);
+    const __m256i underscore = _mm256_set1_epi8('_');
+
+    while (end - p >= 32) {
+        __m256i v = load32(p);
+        __m256i alpha = inRange32(_mm256_or_si256(v, caseBit), 'a', 'z' - 'a');
+        __m256i digit = inRange32(v, '0', '9' - '0');
+        __m256i ident = _mm256_or_si256(_mm256_or_si256(alpha, digit), _mm256_cmpeq_epi8(v, underscore));
+        uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(ident));
+        if (mask) {
+            return p + countTrailingZeros(mask);
+        }
+        p += 32;
+    }
+    return skipIdentifierSSE2(p, end);
+}
+
+JVAV_TARGET_AVX2 size_t countNewlinesAVX2(const char* p, const char* end, const char** lastNewline) {
+    const __m256i nl = _mm256_set1_epi8('\n');
+    size_t count = 0;
+    const char* last = nullptr;
+
+    while (end - p >= 32) {
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(load32(p), nl)));
+        if (mask) {
+            count += popCount(mask);
+            last = p + highestBit(mask);
+        }
+        p += 32;
+    }
+
+    const char* tailLast;
+    count += countNewlinesSSE2(p, end, &tailLast);
+    *lastNewline = tailLast ? tailLast : last;
+    return count;
+}
+#endif // JVAV_SCAN_AVX2
+
+// ---------------- 运行时选择实现 ----------------
+
+struct ScanImpl {
+    const char* name;
+    const char* (*skipWhitespace)(const char*, const char*);
+    const char* (*findNewline)(const char*, const char*);
+    const char* (*findStringSpecial)(const char*, const char*);
+    const char* (*skipIdentifier)(const char*, const char*);
+    size_t (*countNewlines)(const char*, const char*, const char**);
+};
+
+ScanImpl selectImpl() {
+#ifdef JVAV_SCAN_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        return {"avx2", skipWhitespaceAVX2, findNewlineAVX2, findStringSpecialAVX2,
+                skipIdentifierAVX2, countNewlinesAVX2};
+    }
+#endif
+#ifdef JVAV_SCAN_SSE2
+    return {"sse2", skipWhitespaceSSE2, findNewlineSSE2, findStringSpecialSSE2,
+            skipIdentifierSSE2, countNewlinesSSE2};
+#else
+    return {"scalar", skipWhitespaceScalar, findNewlineScalar, findStringSpecialScalar,
+            skipIdentifierScalar, countNewlinesScalar};
+#endif
+}
+
+// 程序启动时选择一次，之后每次调用只是一次间接跳转
+const ScanImpl selectedImpl = selectImpl();
+
+inline const ScanImpl& impl() {
+    return selectedImpl;
+}
+
+} // namespace
+
+const char* skipWhitespace(const char* p, const char* end) {
+    return impl().skipWhitespace(p, end);
+}
+
+const char* findNewline(const char* p, const char* end) {
+    return impl().findNewline(p, end);
+}
+
+const char* findStringSpecial(const char* p, const char* end) {
+    return impl().findStringSpecial(p, end);
+}
+
+const char* skipIdentifier(const char* p, const char* end) {
+    return impl().skipIdentifier(p, end);
+}
+
+size_t countNewlines(const char* p, const char* end, const char** lastNewline) {
+    return impl().countNewlines(p, end, lastNewline);
+}
+
+const char* implementationName() {
+    return impl().name;
+}
+
+} // namespace scan
+} // namespace jvav
@@ -0,0 +1,124 @@
+#include "lexer/SourceBuffer.h"
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace jvav {
+
+// 析构函数：解除映射
+SourceBuffer::~SourceBuffer() {
+#ifndef _WIN32
+    if (mapped_ && size_ > 0) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+}
+
+// 从文件加载源代码
+std::unique_ptr<SourceBuffer> SourceBuffer::fromFile(const std::string& path, std::string& error) {
+    std::unique_ptr<SourceBuffer> buffer(new SourceBuffer());
+
+#ifdef _WIN32
+    // Windows下统一使用read()方式
+    if (path == "-") {
+        _setmode(0, _O_BINARY);
+        if (!buffer->readAll(0, error)) {
+            return nullptr;
+        }
+        return buffer;
+    }
+
+    int fd = _open(path.c_str(), _O_RDONLY | _O_BINARY);
+    if (fd < 0) {
+        error = std::strerror(errno);
+        return nullptr;
+    }
+    bool ok = buffer->readAll(fd, error);
+    _close(fd);
+    if (!ok) {
+        return nullptr;
+    }
+    return buffer;
+#else
+    if (path == "-") {
+        if (!buffer->readAll(STDIN_FILENO, error)) {
+            return nullptr;
+        }
+        return buffer;
+    }
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = std::strerror(errno);
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        if (st.st_size == 0) {
+            // 空文件无法映射，也不需要映射
+            close(fd);
+            return buffer;
+        }
+
+        void* addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            // 词法分析从头到尾顺序扫描
+            madvise(addr, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+            close(fd);
+            buffer->data_ = static_cast<const char*>(addr);
+            buffer->size_ = static_cast<size_t>(st.st_size);
+            buffer->mapped_ = true;
+            return buffer;
+        }
+    }
+
+    // 管道、字符设备或映射失败时退回read()
+    bool ok = buffer->readAll(fd, error);
+    close(fd);
+    if (!ok) {
+        return nullptr;
+    }
+    return buffer;
+#endif
+}
+
+// 从文件描述符读取全部内容
+bool SourceBuffer::readAll(int fd, std::string& error) {
+    char chunk[64 * 1024];
+
+    while (true) {
+#ifdef _WIN32
+        int n = _read(fd, chunk, sizeof(chunk));
+#else
+        ssize_t n = read(fd, chunk, sizeof(chunk));
+#endif
+        if (n == 0) {
+            break;
+        }
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error = std::strerror(errno);
+            return false;
+        }
+        storage_.append(chunk, static_cast<size_t>(n));
+    }
+
+    data_ = storage_.data();
+    size_ = storage_.size();
+    mapped_ = false;
+    return true;
+}
+
+} // namespace jvav
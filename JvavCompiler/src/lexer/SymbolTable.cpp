@@ -0,0 +1,80 @@
+#include "lexer/SymbolTable.h"
+
+namespace jvav {
+
+namespace {
+
+// 哈希表的初始槽位数（必须是2的幂）
+constexpr size_t INITIAL_SLOTS = 1024;
+
+} // namespace
+
+// 获取全局符号表
+SymbolTable& SymbolTable::instance() {
+    static SymbolTable table;
+    return table;
+}
+
+// 构造函数：编号0保留给"不是标识符"
+SymbolTable::SymbolTable() : slots_(INITIAL_SLOTS, Slot{0, INVALID_SYMBOL}) {
+    names_.emplace_back();
+}
+
+// 登记标识符
+Symbol SymbolTable::intern(std::string_view text) {
+    return intern(text, hashText(text));
+}
+
+Symbol SymbolTable::intern(std::string_view text, uint32_t hash) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    size_t mask = slots_.size() - 1;
+    size_t index = hash & mask;
+    while (slots_[index].symbol != INVALID_SYMBOL) {
+        const Slot& slot = slots_[index];
+        if (slot.hash == hash && names_[slot.symbol] == text) {
+            return slot.symbol;
+        }
+        index = (index + 1) & mask;
+    }
+
+    Symbol symbol = static_cast<Symbol>(names_.size());
+    names_.push_back(text_.copyString(text));
+    slots_[index] = Slot{hash, symbol};
+    if (names_.size() * 2 > slots_.size()) {
+        grow();
+    }
+    return symbol;
+}
+
+// 获取符号的文本
+std::string_view SymbolTable::name(Symbol symbol) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return symbol < names_.size() ? names_[symbol] : std::string_view();
+}
+
+// 已分配的最大编号加一
+size_t SymbolTable::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return names_.size();
+}
+
+// 槽位数翻倍，重新放置所有符号
+void SymbolTable::grow() {
+    std::vector<Slot> old = std::move(slots_);
+    slots_.assign(old.size() * 2, Slot{0, INVALID_SYMBOL});
+
+    size_t mask = slots_.size() - 1;
+    for (const Slot& slot : old) {
+        if (slot.symbol == INVALID_SYMBOL) {
+            continue;
+        }
+        size_t index = slot.hash & mask;
+        while (slots_[index].symbol != INVALID_SYMBOL) {
+            index = (index + 1) & mask;
+        }
+        slots_[index] = slot;
+    }
+}
+
+} // namespace jvav
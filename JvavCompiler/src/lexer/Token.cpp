@@ -2,17 +2,44 @@
 
 namespace jvav {
 
+std::string_view Token::getLexeme() const {
+    if (length == 0) {
+        return symbol != INVALID_SYMBOL ? SymbolTable::instance().name(symbol) : std::string_view();
+    }
+    return FileTable::instance().getText(getFile()).substr(offset, length);
+}
+
+std::string_view Token::getValue() const {
+    std::string_view lexeme = getLexeme();
+    
+    // 字符串字面量去掉首尾引号
+    if (getType() == TokenType::STRING_LITERAL && lexeme.size() >= 2) {
+        return lexeme.substr(1, lexeme.size() - 2);
+    }
+    return lexeme;
+}
+
+SourceLocation Token::getLocation() const {
+    FileTable& table = FileTable::instance();
+    LineColumn position = table.getLineColumn(getFile(), offset);
+    return SourceLocation(table.getName(getFile()),
+                          static_cast<int>(position.line), static_cast<int>(position.column));
+}
+
 std::string Token::toString() const {
+    TokenType type = getType();
     std::string typeStr = tokenTypeToString(type);
     std::string result = typeStr;
     
     if (type == TokenType::IDENTIFIER || 
         type == TokenType::STRING_LITERAL || 
         type == TokenType::NUMBER_LITERAL) {
-        result += " '" + value + "'";
+        result += " '";
+        result += getValue();
+        result += "'";
     }
     
-    result += " at " + location.toString();
+    result += " at " + getLocation().toString();
     return result;
 }
 
@@ -0,0 +1,29 @@
+#include "lexer/TokenBuffer.h"
+
+namespace jvav {
+
+// 预留容量
+void TokenBuffer::reserve(size_t count) {
+    types_.reserve(count);
+    offsets_.reserve(count);
+    lengths_.reserve(count);
+    symbols_.reserve(count);
+}
+
+// 追加另一个缓冲区中的全部token
+void TokenBuffer::append(const TokenBuffer& other) {
+    types_.insert(types_.end(), other.types_.begin(), other.types_.end());
+    offsets_.insert(offsets_.end(), other.offsets_.begin(), other.offsets_.end());
+    lengths_.insert(lengths_.end(), other.lengths_.begin(), other.lengths_.end());
+    symbols_.insert(symbols_.end(), other.symbols_.begin(), other.symbols_.end());
+}
+
+// 清空所有token
+void TokenBuffer::clear() {
+    types_.clear();
+    offsets_.clear();
+    lengths_.clear();
+    symbols_.clear();
+}
+
+} // namespace jvav
@@ -0,0 +1,65 @@
+#include "lexer/TokenRing.h"
+#include <thread>
+
+namespace jvav {
+
+// 构造函数
+TokenRing::TokenRing(FileId file, size_t capacity) : file_(file) {
+    size_t size = 2;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    slots_.resize(size);
+    mask_ = size - 1;
+}
+
+// 生产者：写入一个token
+bool TokenRing::push(const Token& token) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+
+    // 先用旧的消费者位置判断，确实满了才重新读取
+    while (tail - cachedHead_ > mask_) {
+        if (closed_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        cachedHead_ = head_.load(std::memory_order_acquire);
+        if (tail - cachedHead_ > mask_) {
+            std::this_thread::yield();
+        }
+    }
+
+    slots_[tail & mask_] = token;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+// 消费者：批量读出token
+size_t TokenRing::popBatch(TokenBuffer& out, size_t maxCount) {
+    size_t head = head_.load(std::memory_order_relaxed);
+
+    while (cachedTail_ == head) {
+        cachedTail_ = tail_.load(std::memory_order_acquire);
+        if (cachedTail_ == head) {
+            std::this_thread::yield();
+        }
+    }
+
+    size_t count = cachedTail_ - head;
+    if (count > maxCount) {
+        count = maxCount;
+    }
+    for (size_t i = 0; i < count; i++) {
+        const Token& token = slots_[(head + i) & mask_];
+        out.push(token);
+    }
+
+    head_.store(head + count, std::memory_order_release);
+    return count;
+}
+
+// 消费者：关闭缓冲区
+void TokenRing::close() {
+    closed_.store(true, std::memory_order_release);
+}
+
+} // namespace jvav
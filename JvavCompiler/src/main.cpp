@@ -1,5 +1,7 @@
 #include "JvavCompiler.h"
 #include "lexer/Lexer.h"
+#include "lexer/SourceBuffer.h"
+#include "compiler/ThreadPool.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -34,6 +36,7 @@ void printVersion() {
 
 void printHelp() {
     std::cout << "使用方法: jvavc [选项] <源文件>" << std::endl;
+    std::cout << "源文件为 - 时从标准输入读取" << std::endl;
     std::cout << "选项:" << std::endl;
     std::cout << "  -h, --help            显示帮助信息" << std::endl;
     std::cout << "  -v, --version         显示版本信息" << std::endl;
@@ -43,10 +46,16 @@ void printHelp() {
     std::cout << "  --emit-llvm           生成LLVM IR" << std::endl;
     std::cout << "  --target=<平台>       指定目标平台 (windows, macos, linux, harmony)" << std::endl;
     std::cout << "  --wasm                生成WebAssembly (默认)" << std::endl;
+    std::cout << "  --ir                  经由SSA中间表示生成WebAssembly（不支持的语法回退到语法树后端）" << std::endl;
+    std::cout << "  --emit-ir             输出优化后的SSA中间表示" << std::endl;
     std::cout << "  -O<级别>              设置优化级别 (0-3)" << std::endl;
+    std::cout << "  --unroll=<倍数>       循环部分展开的倍数 (-O2起生效，默认4，小于2时不展开)" << std::endl;
     std::cout << "  -g                    生成调试信息" << std::endl;
     std::cout << "  --tokens              仅执行词法分析并输出tokens" << std::endl;
     std::cout << "  --parse               仅执行语法分析" << std::endl;
+    std::cout << "  --stream-tokens       词法分析与语法分析在两个线程中流水进行" << std::endl;
+    std::cout << "  --max-depth=<层数>    括号和语句块的最大嵌套层数 (默认256)" << std::endl;
+    std::cout << "  --ast-cache=<目录>    缓存语法树，源代码未修改时跳过词法和语法分析" << std::endl;
     std::cout << "  --verbose             显示详细编译信息" << std::endl;
 }
 
@@ -80,6 +89,10 @@ bool parseArgs(int argc, char* argv[], JvavCompilerOptions& options, std::string
             options.targetType = JvavTargetType::LLVM_IR;
         } else if (arg == "--wasm") {
             options.targetType = JvavTargetType::WASM;
+        } else if (arg == "--ir") {
+            options.useIR = true;
+        } else if (arg == "--emit-ir") {
+            options.targetType = JvavTargetType::SSA_IR;
         } else if (arg.find("--target=") == 0) {
             options.targetPlatform = arg.substr(9);
         } else if (arg.rfind("-O", 0) == 0) {
@@ -87,15 +100,23 @@ bool parseArgs(int argc, char* argv[], JvavCompilerOptions& options, std::string
             if (arg.length() > 2) {
                 options.optimizationLevel = std::stoi(arg.substr(2, 1));
             }
+        } else if (arg.find("--unroll=") == 0) {
+            options.unrollFactor = std::stoi(arg.substr(9));
         } else if (arg == "-g") {
             options.emitDebugInfo = true;
         } else if (arg == "--tokens") {
             onlyTokens = true;
         } else if (arg == "--parse") {
             onlyParse = true;
+        } else if (arg == "--stream-tokens") {
+            options.streamTokens = true;
+        } else if (arg.find("--max-depth=") == 0) {
+            options.maxNestingDepth = std::stoul(arg.substr(12));
+        } else if (arg.find("--ast-cache=") == 0) {
+            options.astCacheDirectory = arg.substr(12);
         } else if (arg == "--verbose") {
             options.verbose = true;
-        } else if (arg[0] != '-') {
+        } else if (arg[0] != '-' || arg == "-") {
             // 认为是源文件
             sourceFile = arg;
         } else {
@@ -120,6 +141,8 @@ bool parseArgs(int argc, char* argv[], JvavCompilerOptions& options, std::string
                 options.outputFile = baseName + ".s";
             } else if (options.targetType == JvavTargetType::LLVM_IR) {
                 options.outputFile = baseName + ".ll";
+            } else if (options.targetType == JvavTargetType::SSA_IR) {
+                options.outputFile = baseName + ".ir";
             } else if (options.targetType == JvavTargetType::WASM) {
                 options.outputFile = baseName + ".wasm";
             } else {
@@ -141,21 +164,20 @@ bool parseArgs(int argc, char* argv[], JvavCompilerOptions& options, std::string
     // 特殊模式处理
     if (onlyTokens) {
         // 仅执行词法分析
-        std::ifstream file(sourceFile);
-        if (!file) {
-            std::cerr << "错误: 无法打开源文件: " << sourceFile << std::endl;
+        std::string error;
+        auto buffer = jvav::SourceBuffer::fromFile(sourceFile, error);
+        if (!buffer) {
+            std::cerr << "错误: 无法打开源文件: " << sourceFile << " (" << error << ")" << std::endl;
             return false;
         }
         
-        std::stringstream buffer;
-        buffer << file.rdbuf();
-        std::string source = buffer.str();
+        // 大文件按行切分后并行分析
+        jvav::ThreadPool pool;
+        jvav::Lexer lexer(buffer->getText(), sourceFile);
+        jvav::TokenBuffer tokens = lexer.tokenizeParallel(pool);
         
-        jvav::Lexer lexer(source, sourceFile);
-        auto tokens = lexer.tokenize();
-        
-        for (const auto& token : tokens) {
-            std::cout << token << std::endl;
+        for (size_t i = 0; i < tokens.size(); i++) {
+            std::cout << tokens.get(i) << std::endl;
         }
         
         if (!lexer.getErrors().empty()) {
@@ -0,0 +1,73 @@
+#include "optimizer/Bindings.h"
+#include "ast/NodeWalker.h"
+#include "lexer/SymbolTable.h"
+
+namespace jvav {
+
+// 统计绑定次数
+std::vector<uint32_t> countBindings(Program& program) {
+    std::vector<uint32_t> counts(SymbolTable::instance().size(), 0);
+    auto bind = [&counts](const Token& name) {
+        Symbol symbol = name.getSymbol();
+        if (symbol != INVALID_SYMBOL && symbol < counts.size()) {
+            counts[symbol]++;
+        }
+    };
+
+    NodeWalker walker;
+    walker.walk(program.statements,
+        [&bind](Stmt* stmt) {
+            switch (stmt->getType()) {
+                case StmtType::SET:
+                    bind(static_cast<SetStmt*>(stmt)->name);
+                    break;
+                case StmtType::LOOP:
+                    bind(static_cast<LoopStmt*>(stmt)->variable);
+                    break;
+                case StmtType::DEFINE: {
+                    auto* define = static_cast<DefineStmt*>(stmt);
+                    bind(define->name);
+                    for (const Token& parameter : define->parameters) {
+                        bind(parameter);
+                    }
+                    break;
+                }
+                case StmtType::IMPORT: {
+                    auto* import = static_cast<ImportStmt*>(stmt);
+                    bind(import->module);
+                    bind(import->alias);
+                    break;
+                }
+                case StmtType::ARRAY:
+                    bind(static_cast<ArrayStmt*>(stmt)->name);
+                    break;
+                case StmtType::RECORD_DEF:
+                    bind(static_cast<RecordDefStmt*>(stmt)->name);
+                    break;
+                case StmtType::RECORD_ACCESS:
+                    bind(static_cast<RecordAccessStmt*>(stmt)->record);
+                    break;
+                case StmtType::ENUM_DEF: {
+                    auto* enumDef = static_cast<EnumDefStmt*>(stmt);
+                    bind(enumDef->name);
+                    for (const Token& value : enumDef->values) {
+                        bind(value);
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+        },
+        [&bind](Expr* expr) {
+            if (expr->getType() == ExprType::ASSIGNMENT) {
+                auto* assignment = static_cast<AssignmentExpr*>(expr);
+                if (assignment->target->getType() == ExprType::VARIABLE) {
+                    bind(static_cast<VariableExpr*>(assignment->target)->name);
+                }
+            }
+        });
+    return counts;
+}
+
+} // namespace jvav
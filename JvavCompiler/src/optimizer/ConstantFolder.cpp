@@ -0,0 +1,329 @@
+#include "optimizer/ConstantFolder.h"
+#include "ast/ASTVisitor.h"
+#include "optimizer/Bindings.h"
+#include <charconv>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace jvav {
+
+namespace {
+
+// 按i32补码回绕的结果
+int32_t wrap(uint32_t value) {
+    return static_cast<int32_t>(value);
+}
+
+// 计算二元运算，与生成的WebAssembly指令一致
+// 运行时会陷入的运算和不认识的运算符返回false，留给运行时处理
+bool foldBinary(TokenType op, int32_t a, int32_t b, int32_t& result) {
+    uint32_t ua = static_cast<uint32_t>(a);
+    uint32_t ub = static_cast<uint32_t>(b);
+
+    switch (op) {
+        case TokenType::PLUS:          result = wrap(ua + ub); return true;
+        case TokenType::MINUS:         result = wrap(ua - ub); return true;
+        case TokenType::STAR:          result = wrap(ua * ub); return true;
+        case TokenType::SLASH:
+            // i32.div_s：除以0和INT32_MIN / -1都会陷入
+            if (b == 0 || (a == INT32_MIN && b == -1)) {
+                return false;
+            }
+            result = a / b;
+            return true;
+        case TokenType::PERCENT:
+            // i32.rem_s：除以0陷入，INT32_MIN % -1为0
+            if (b == 0) {
+                return false;
+            }
+            result = (b == -1) ? 0 : a % b;
+            return true;
+        case TokenType::EQUAL:         result = a == b; return true;
+        case TokenType::NOT_EQUAL:     result = a != b; return true;
+        case TokenType::LESS:          result = a < b; return true;
+        case TokenType::LESS_EQUAL:    result = a <= b; return true;
+        case TokenType::GREATER:       result = a > b; return true;
+        case TokenType::GREATER_EQUAL: result = a >= b; return true;
+        case TokenType::AND:           result = a & b; return true;
+        case TokenType::OR:            result = a | b; return true;
+        default:
+            return false;
+    }
+}
+
+// 计算一元运算：取负生成为乘以-1，取反生成为i32.eqz
+bool foldUnary(TokenType op, int32_t a, int32_t& result) {
+    switch (op) {
+        case TokenType::MINUS: result = wrap(0u - static_cast<uint32_t>(a)); return true;
+        case TokenType::NOT:   result = a == 0; return true;
+        default:
+            return false;
+    }
+}
+
+// 一次折叠：先统计每个变量被绑定的次数，再逐条顶层语句折叠
+// 语句和表达式的子节点由各visit重载排入显式栈，表达式按后序折叠，
+// 子表达式都折叠完之后再看父节点的操作数是否都成了常量。
+class FoldingPass : public ASTVisitor<FoldingPass> {
+public:
+    explicit FoldingPass(Program& program) : program_(program) {}
+
+    void run();
+
+    size_t folded() const { return folded_; }
+    size_t propagated() const { return propagated_; }
+
+private:
+    friend class ASTVisitor<FoldingPass>;
+
+    // 待折叠的表达式位置：折叠后的节点直接写回*slot
+    struct Slot {
+        Expr** slot;
+        bool keepVariable;  // 位置上的变量不能替换为常量（被调用者、赋值目标等）
+        bool expanded;
+    };
+
+    // 待处理的语句，propagate为false时其中的变量引用不替换（函数体）
+    struct PendingStmt {
+        Stmt* stmt;
+        bool propagate;
+    };
+
+    // 折叠一条语句及其全部子孙中的表达式
+    void foldStatement(Stmt* stmt, bool propagate);
+
+    // 折叠一个位置上的表达式树
+    void foldExpression(Expr** slot, bool keepVariable);
+
+    // 子表达式都已折叠，尝试折叠节点本身，返回替换它的节点
+    Expr* foldNode(Expr* expr, bool keepVariable);
+
+    // 顶层设置语句执行之后，记下值为常量、且只被这一处写入的变量
+    void recordConstant(const SetStmt* stmt);
+
+    // 排入子节点
+    void pushExpr(Expr** slot, bool keepVariable = false) {
+        if (*slot != nullptr) {
+            slots_.push_back(Slot{slot, keepVariable, false});
+        }
+    }
+    void pushStatements(NodeList<Stmt*> statements, bool propagate) {
+        for (Stmt*& stmt : statements) {
+            stmts_.push_back(PendingStmt{stmt, propagate});
+        }
+    }
+
+    // 语句：排入它的表达式和子语句
+    void visit(ExpressionStmt* stmt) { pushExpr(&stmt->expression); }
+    void visit(ImportStmt*) {}
+    void visit(DakaiStmt* stmt) { pushExpr(&stmt->path); }
+    void visit(SetStmt* stmt) { pushExpr(&stmt->value); }
+    void visit(PrintStmt* stmt) { pushExpr(&stmt->value); }
+    void visit(IfStmt* stmt) {
+        for (Branch& branch : stmt->branches) {
+            pushExpr(&branch.condition);
+            pushStatements(branch.body, propagate_);
+        }
+    }
+    void visit(LoopStmt* stmt) {
+        pushExpr(&stmt->count);
+        pushStatements(stmt->body, propagate_);
+    }
+    void visit(DefineStmt* stmt) { pushStatements(stmt->body, false); }
+    void visit(ReturnStmt* stmt) { pushExpr(&stmt->value); }
+    void visit(ArrayStmt* stmt) {
+        for (Expr*& element : stmt->elements) {
+            pushExpr(&element);
+        }
+    }
+    void visit(RecordDefStmt*) {}
+    void visit(RecordAccessStmt* stmt) { pushExpr(&stmt->value); }
+    void visit(TryCatchStmt* stmt) {
+        pushStatements(stmt->tryBlock, propagate_);
+        pushStatements(stmt->catchBlock, propagate_);
+    }
+    void visit(EnumDefStmt*) {}
+    void visit(BlockStmt* stmt) { pushStatements(stmt->statements, propagate_); }
+    void visit(ErrorStmt*) {}
+
+    // 表达式：排入子表达式
+    void visit(LiteralExpr*) {}
+    void visit(VariableExpr*) {}
+    void visit(UnaryExpr* expr) { pushExpr(&expr->right); }
+    void visit(BinaryExpr* expr) {
+        pushExpr(&expr->left);
+        pushExpr(&expr->right);
+    }
+    void visit(CallExpr* expr) {
+        pushExpr(&expr->callee, true);
+        for (Expr*& argument : expr->arguments) {
+            pushExpr(&argument);
+        }
+    }
+    void visit(ArrayAccessExpr* expr) {
+        pushExpr(&expr->array, true);
+        pushExpr(&expr->index);
+    }
+    void visit(RecordAccessExpr* expr) { pushExpr(&expr->record, true); }
+    void visit(AssignmentExpr* expr) {
+        pushExpr(&expr->target, true);
+        pushExpr(&expr->value);
+    }
+    void visit(ErrorExpr*) {}
+
+    Program& program_;
+
+    std::vector<PendingStmt> stmts_;
+    std::vector<Slot> slots_;
+    std::vector<Slot> roots_;  // 当前语句直接包含的表达式
+    bool propagate_ = true;
+
+    // 按符号编号索引：被绑定的次数（见countBindings），以及已知的常量值
+    std::vector<uint32_t> writes_;
+    std::vector<uint8_t> known_;
+    std::vector<int32_t> values_;
+
+    size_t folded_ = 0;
+    size_t propagated_ = 0;
+};
+
+void FoldingPass::run() {
+    writes_ = countBindings(program_);
+    known_.assign(writes_.size(), 0);
+    values_.assign(writes_.size(), 0);
+
+    // 顶层语句按执行顺序处理，一个变量的常量值只用于它被设置之后的语句
+    for (Stmt*& stmt : program_.statements) {
+        foldStatement(stmt, true);
+        if (stmt->getType() == StmtType::SET) {
+            recordConstant(static_cast<const SetStmt*>(stmt));
+        }
+    }
+}
+
+void FoldingPass::foldStatement(Stmt* stmt, bool propagate) {
+    stmts_.push_back(PendingStmt{stmt, propagate});
+    while (!stmts_.empty()) {
+        PendingStmt pending = stmts_.back();
+        stmts_.pop_back();
+
+        // 排入语句的表达式（到slots_）和子语句（到stmts_），再折叠这些表达式
+        propagate_ = pending.propagate;
+        size_t mark = slots_.size();
+        visitStmt(pending.stmt);
+        roots_.assign(slots_.begin() + mark, slots_.end());
+        slots_.resize(mark);
+        for (const Slot& root : roots_) {
+            foldExpression(root.slot, root.keepVariable);
+        }
+    }
+}
+
+void FoldingPass::foldExpression(Expr** slot, bool keepVariable) {
+    size_t base = slots_.size();
+    slots_.push_back(Slot{slot, keepVariable, false});
+    while (slots_.size() > base) {
+        // 第一次到达栈顶时展开子表达式，子表达式都折叠完后再次到达栈顶
+        if (!slots_.back().expanded) {
+            slots_.back().expanded = true;
+            visitExpr(*slots_.back().slot);
+            continue;
+        }
+
+        Slot top = slots_.back();
+        slots_.pop_back();
+        *top.slot = foldNode(*top.slot, top.keepVariable);
+    }
+}
+
+Expr* FoldingPass::foldNode(Expr* expr, bool keepVariable) {
+    int32_t a = 0;
+    int32_t b = 0;
+    int32_t result = 0;
+
+    switch (expr->getType()) {
+        case ExprType::VARIABLE: {
+            auto* variable = static_cast<VariableExpr*>(expr);
+            Symbol symbol = variable->name.getSymbol();
+            if (keepVariable || !propagate_ || symbol >= known_.size() || !known_[symbol]) {
+                return expr;
+            }
+            propagated_++;
+            return ConstantFolder::makeLiteral(program_.arena, values_[symbol], variable->name);
+        }
+        case ExprType::UNARY: {
+            auto* unary = static_cast<UnaryExpr*>(expr);
+            if (!ConstantFolder::evaluate(unary->right, a) ||
+                !foldUnary(unary->op.getType(), a, result)) {
+                return expr;
+            }
+            folded_++;
+            return ConstantFolder::makeLiteral(program_.arena, result, unary->op);
+        }
+        case ExprType::BINARY: {
+            auto* binary = static_cast<BinaryExpr*>(expr);
+            if (!ConstantFolder::evaluate(binary->left, a) ||
+                !ConstantFolder::evaluate(binary->right, b) ||
+                !foldBinary(binary->op.getType(), a, b, result)) {
+                return expr;
+            }
+            folded_++;
+            return ConstantFolder::makeLiteral(program_.arena, result, binary->op);
+        }
+        default:
+            return expr;
+    }
+}
+
+void FoldingPass::recordConstant(const SetStmt* stmt) {
+    Symbol symbol = stmt->name.getSymbol();
+    int32_t value = 0;
+    if (symbol < writes_.size() && writes_[symbol] == 1 &&
+        ConstantFolder::evaluate(stmt->value, value)) {
+        known_[symbol] = 1;
+        values_[symbol] = value;
+    }
+}
+
+} // namespace
+
+// 折叠常量
+void ConstantFolder::run(Program& program) {
+    FoldingPass pass(program);
+    pass.run();
+    folded_ = pass.folded();
+    propagated_ = pass.propagated();
+}
+
+// 求常量表达式的值
+bool ConstantFolder::evaluate(const Expr* expr, int32_t& value) {
+    if (expr == nullptr || expr->getType() != ExprType::LITERAL) {
+        return false;
+    }
+
+    auto* literal = static_cast<const LiteralExpr*>(expr);
+    switch (literal->token.getType()) {
+        case TokenType::NUMBER_LITERAL: {
+            // 与代码生成中的std::stoi一致：取开头的整数部分，超出范围的留给它报错
+            const char* begin = literal->value.data();
+            const char* end = begin + literal->value.size();
+            auto [next, error] = std::from_chars(begin, end, value);
+            return error == std::errc() && next != begin;
+        }
+        case TokenType::BOOL_LITERAL:
+            value = (literal->value == "true" || literal->value == "真") ? 1 : 0;
+            return true;
+        default:
+            return false;
+    }
+}
+
+// 构造数字字面量
+LiteralExpr* ConstantFolder::makeLiteral(Arena& arena, int32_t value, const Token& position) {
+    std::string_view text = arena.copyString(std::to_string(value));
+    Token token(TokenType::NUMBER_LITERAL, position.getFile(), position.getOffset(), 0);
+    return arena.make<LiteralExpr>(token, text);
+}
+
+} // namespace jvav
@@ -0,0 +1,259 @@
+#include "optimizer/DeadCodeEliminator.h"
+#include "ast/ASTVisitor.h"
+#include "optimizer/ConstantFolder.h"
+#include <algorithm>
+#include <vector>
+
+namespace jvav {
+
+namespace {
+
+// 一次消除：从顶层语句列表开始，逐个重写语句列表
+// 保留下来的语句中的子语句列表由各visit重载排入栈中，之后再处理。
+class EliminationPass : public ASTVisitor<EliminationPass> {
+public:
+    explicit EliminationPass(Program& program) : program_(program) {}
+
+    void run();
+
+    size_t removed() const { return removed_; }
+
+private:
+    friend class ASTVisitor<EliminationPass>;
+
+    // 待重写的语句列表，inFunction表示列表在函数体中（return之后的语句不可达）
+    struct PendingList {
+        NodeList<Stmt*>* list;
+        bool inFunction;
+    };
+
+    // 重写一个语句列表
+    void rewriteList(NodeList<Stmt*>& list, bool inFunction);
+
+    // 删除if中不会执行的分支
+    // 返回true表示执行哪些语句在编译期就已确定（只剩else分支或一个分支都不剩），
+    // 这些语句放在taken中（可能为空），由调用者用它们代替if
+    bool pruneBranches(IfStmt* stmt, NodeList<Stmt*>& taken);
+
+    void pushList(NodeList<Stmt*>& list) {
+        lists_.push_back(PendingList{&list, inFunction_});
+    }
+
+    // 保留下来的语句：排入它的子语句列表
+    void visit(ExpressionStmt*) {}
+    void visit(ImportStmt*) {}
+    void visit(DakaiStmt*) {}
+    void visit(SetStmt*) {}
+    void visit(PrintStmt*) {}
+    void visit(IfStmt* stmt) {
+        for (Branch& branch : stmt->branches) {
+            pushList(branch.body);
+        }
+    }
+    void visit(LoopStmt* stmt) { pushList(stmt->body); }
+    void visit(DefineStmt* stmt) { lists_.push_back(PendingList{&stmt->body, true}); }
+    void visit(ReturnStmt*) {}
+    void visit(ArrayStmt*) {}
+    void visit(RecordDefStmt*) {}
+    void visit(RecordAccessStmt*) {}
+    void visit(TryCatchStmt* stmt) {
+        pushList(stmt->tryBlock);
+        pushList(stmt->catchBlock);
+    }
+    void visit(EnumDefStmt*) {}
+    void visit(BlockStmt* stmt) { pushList(stmt->statements); }
+    void visit(ErrorStmt*) {}
+
+    Program& program_;
+
+    std::vector<PendingList> lists_;
+    bool inFunction_ = false;
+
+    // 重写列表时的输入（逆序，栈顶是下一条语句）和输出
+    std::vector<Stmt*> input_;
+    std::vector<Stmt*> output_;
+    std::vector<Branch> branches_;
+
+    size_t removed_ = 0;
+};
+
+void EliminationPass::run() {
+    lists_.push_back(PendingList{&program_.statements, false});
+    while (!lists_.empty()) {
+        PendingList pending = lists_.back();
+        lists_.pop_back();
+        rewriteList(*pending.list, pending.inFunction);
+    }
+}
+
+void EliminationPass::rewriteList(NodeList<Stmt*>& list, bool inFunction) {
+    input_.assign(list.begin(), list.end());
+    std::reverse(input_.begin(), input_.end());
+    output_.clear();
+    bool changed = false;
+
+    while (!input_.empty()) {
+        Stmt* stmt = input_.back();
+        input_.pop_back();
+
+        switch (stmt->getType()) {
+            case StmtType::EXPRESSION:
+                if (DeadCodeEliminator::isPure(static_cast<ExpressionStmt*>(stmt)->expression)) {
+                    removed_++;
+                    changed = true;
+                    continue;
+                }
+                break;
+            case StmtType::IF: {
+                NodeList<Stmt*> taken;
+                if (pruneBranches(static_cast<IfStmt*>(stmt), taken)) {
+                    // 一定执行的else分支的语句接着在本列表中处理
+                    for (size_t i = taken.size(); i > 0; i--) {
+                        input_.push_back(taken[i - 1]);
+                    }
+                    removed_++;
+                    changed = true;
+                    continue;
+                }
+                break;
+            }
+            case StmtType::LOOP: {
+                int32_t count = 0;
+                if (ConstantFolder::evaluate(static_cast<LoopStmt*>(stmt)->count, count) && count <= 0) {
+                    removed_++;
+                    changed = true;
+                    continue;
+                }
+                break;
+            }
+            case StmtType::RETURN:
+                // 函数就此返回，同一列表中后面的语句都不可达
+                if (inFunction && !input_.empty()) {
+                    removed_ += input_.size();
+                    changed = true;
+                    input_.clear();
+                }
+                break;
+            default:
+                break;
+        }
+        output_.push_back(stmt);
+    }
+
+    if (changed) {
+        list = program_.arena.copyList(output_.data(), output_.size());
+    }
+
+    // 子语句列表留到之后处理，input_和output_可以复用
+    inFunction_ = inFunction;
+    for (Stmt* stmt : list) {
+        visitStmt(stmt);
+    }
+}
+
+bool EliminationPass::pruneBranches(IfStmt* stmt, NodeList<Stmt*>& taken) {
+    branches_.clear();
+    bool changed = false;
+
+    for (Branch& branch : stmt->branches) {
+        int32_t value = 0;
+        if (branch.condition == nullptr) {
+            branches_.push_back(branch);
+            break;
+        }
+        if (!ConstantFolder::evaluate(branch.condition, value)) {
+            branches_.push_back(branch);
+            continue;
+        }
+        // 恒假的分支不会执行；恒真的分支在前面的分支都不执行时一定执行，
+        // 相当于else，后面的分支不可达
+        changed = true;
+        if (value != 0) {
+            branches_.push_back(Branch(nullptr, branch.body));
+            break;
+        }
+    }
+    removed_ += stmt->branches.size() - branches_.size();
+
+    if (branches_.empty()) {
+        taken = NodeList<Stmt*>();
+        return true;
+    }
+    if (branches_.front().condition == nullptr) {
+        taken = branches_.front().body;
+        return true;
+    }
+    if (changed) {
+        stmt->branches = program_.arena.copyList(branches_.data(), branches_.size());
+    }
+    return false;
+}
+
+} // namespace
+
+// 消除死代码
+void DeadCodeEliminator::run(Program& program) {
+    EliminationPass pass(program);
+    pass.run();
+    removed_ = pass.removed();
+}
+
+// 表达式是否没有副作用
+// 调用、赋值可能有副作用；除法和取余的除数不是非零常量时可能陷入；
+// 数组、记录访问和语法错误的占位保守地当作有副作用
+bool DeadCodeEliminator::isPure(const Expr* expr) {
+    std::vector<const Expr*> stack{expr};
+    while (!stack.empty()) {
+        const Expr* current = stack.back();
+        stack.pop_back();
+
+        switch (current->getType()) {
+            case ExprType::LITERAL:
+            case ExprType::VARIABLE:
+                break;
+            case ExprType::UNARY: {
+                auto* unary = static_cast<const UnaryExpr*>(current);
+                if (unary->op.getType() != TokenType::MINUS && unary->op.getType() != TokenType::NOT) {
+                    return false;
+                }
+                stack.push_back(unary->right);
+                break;
+            }
+            case ExprType::BINARY: {
+                auto* binary = static_cast<const BinaryExpr*>(current);
+                switch (binary->op.getType()) {
+                    case TokenType::SLASH:
+                    case TokenType::PERCENT: {
+                        int32_t divisor = 0;
+                        if (!ConstantFolder::evaluate(binary->right, divisor) || divisor == 0 || divisor == -1) {
+                            return false;
+                        }
+                        break;
+                    }
+                    case TokenType::PLUS:
+                    case TokenType::MINUS:
+                    case TokenType::STAR:
+                    case TokenType::EQUAL:
+                    case TokenType::NOT_EQUAL:
+                    case TokenType::LESS:
+                    case TokenType::LESS_EQUAL:
+                    case TokenType::GREATER:
+                    case TokenType::GREATER_EQUAL:
+                    case TokenType::AND:
+                    case TokenType::OR:
+                        break;
+                    default:
+                        return false;
+                }
+                stack.push_back(binary->left);
+                stack.push_back(binary->right);
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+} // namespace jvav
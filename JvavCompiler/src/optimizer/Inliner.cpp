@@ -0,0 +1,377 @@
+#include "optimizer/Inliner.h"
+#include "ast/ASTCloner.h"
+#include "ast/ASTVisitor.h"
+#include "optimizer/Bindings.h"
+#include "optimizer/DeadCodeEliminator.h"
+#include <vector>
+
+namespace jvav {
+
+namespace {
+
+// 一个可以内联的函数
+struct Candidate {
+    const DefineStmt* define;
+    const Expr* body;                   // return的返回值表达式，分析时的副本
+    std::vector<uint32_t> uses;         // 每个参数在函数体中被使用的次数
+    std::vector<Symbol> freeVariables;  // 函数体中引用的全局变量
+    bool hasCall;                       // 函数体中是否还有调用
+};
+
+// 一次内联：先找出可以内联的函数，再按后序访问所有表达式，替换对它们的调用
+class InliningPass : public ASTVisitor<InliningPass> {
+public:
+    InliningPass(Program& program, size_t maxBodySize)
+        : program_(program), maxBodySize_(maxBodySize) {}
+
+    void run();
+
+    size_t inlined() const { return inlined_; }
+
+private:
+    friend class ASTVisitor<InliningPass>;
+
+    // 待处理的表达式位置
+    struct Slot {
+        Expr** slot;
+        bool expanded;
+    };
+
+    // 待处理的语句，function为它所在的函数（不在函数中时为nullptr），
+    // scope为包含它的最内层带循环变量的循环在loopScopes_中的下标（没有时为-1）
+    struct PendingStmt {
+        Stmt* stmt;
+        const DefineStmt* function;
+        int scope;
+    };
+
+    // 循环变量的作用域链，parent为外层的项（没有时为-1）
+    struct LoopScope {
+        Symbol iterator;
+        int parent;
+    };
+
+    // 检查函数能否内联，能时登记为候选
+    void analyze(const DefineStmt* define);
+
+    // 参数的下标，不是参数时返回-1
+    static int parameterIndex(const DefineStmt* define, Symbol symbol);
+
+    // 当前语句中的名字symbol是否指所在函数的参数或外层循环的循环变量，而不是全局变量
+    bool isShadowed(Symbol symbol) const;
+
+    // 处理一个位置上的表达式树
+    void inlineExpression(Expr** slot);
+
+    // 子表达式都已处理，节点是可以内联的调用时返回替换它的副本
+    Expr* inlineCall(Expr* expr);
+
+    // 复制候选函数的函数体，参数替换为实参
+    Expr* cloneBody(const Candidate& candidate, const NodeList<Expr*>& arguments);
+
+    void pushExpr(Expr** slot) {
+        if (*slot != nullptr) {
+            slots_.push_back(Slot{slot, false});
+        }
+    }
+    void pushStatements(NodeList<Stmt*> statements, const DefineStmt* function, int scope) {
+        for (Stmt*& stmt : statements) {
+            stmts_.push_back(PendingStmt{stmt, function, scope});
+        }
+    }
+
+    // 语句：排入它的表达式和子语句
+    void visit(ExpressionStmt* stmt) { pushExpr(&stmt->expression); }
+    void visit(ImportStmt*) {}
+    void visit(DakaiStmt* stmt) { pushExpr(&stmt->path); }
+    void visit(SetStmt* stmt) { pushExpr(&stmt->value); }
+    void visit(PrintStmt* stmt) { pushExpr(&stmt->value); }
+    void visit(IfStmt* stmt) {
+        for (Branch& branch : stmt->branches) {
+            pushExpr(&branch.condition);
+            pushStatements(branch.body, function_, scope_);
+        }
+    }
+    void visit(LoopStmt* stmt) {
+        pushExpr(&stmt->count);
+        int scope = scope_;
+        if (stmt->variable.getSymbol() != INVALID_SYMBOL) {
+            loopScopes_.push_back(LoopScope{stmt->variable.getSymbol(), scope_});
+            scope = static_cast<int>(loopScopes_.size() - 1);
+        }
+        pushStatements(stmt->body, function_, scope);
+    }
+    // 函数体中看不到外面的循环变量
+    void visit(DefineStmt* stmt) { pushStatements(stmt->body, stmt, -1); }
+    void visit(ReturnStmt* stmt) { pushExpr(&stmt->value); }
+    void visit(ArrayStmt* stmt) {
+        for (Expr*& element : stmt->elements) {
+            pushExpr(&element);
+        }
+    }
+    void visit(RecordDefStmt*) {}
+    void visit(RecordAccessStmt* stmt) { pushExpr(&stmt->value); }
+    void visit(TryCatchStmt* stmt) {
+        pushStatements(stmt->tryBlock, function_, scope_);
+        pushStatements(stmt->catchBlock, function_, scope_);
+    }
+    void visit(EnumDefStmt*) {}
+    void visit(BlockStmt* stmt) { pushStatements(stmt->statements, function_, scope_); }
+    void visit(ErrorStmt*) {}
+
+    // 表达式：排入子表达式
+    void visit(LiteralExpr*) {}
+    void visit(VariableExpr*) {}
+    void visit(UnaryExpr* expr) { pushExpr(&expr->right); }
+    void visit(BinaryExpr* expr) {
+        pushExpr(&expr->left);
+        pushExpr(&expr->right);
+    }
+    void visit(CallExpr* expr) {
+        pushExpr(&expr->callee);
+        for (Expr*& argument : expr->arguments) {
+            pushExpr(&argument);
+        }
+    }
+    void visit(ArrayAccessExpr* expr) {
+        pushExpr(&expr->array);
+        pushExpr(&expr->index);
+    }
+    void visit(RecordAccessExpr* expr) { pushExpr(&expr->record); }
+    void visit(AssignmentExpr* expr) {
+        pushExpr(&expr->target);
+        pushExpr(&expr->value);
+    }
+    void visit(ErrorExpr*) {}
+
+    Program& program_;
+    size_t maxBodySize_;
+
+    // 按符号编号索引的绑定次数，以及候选函数在candidates_中的下标（-1表示不是候选）
+    std::vector<uint32_t> bindings_;
+    std::vector<int> candidateIndex_;
+    std::vector<Candidate> candidates_;
+
+    std::vector<PendingStmt> stmts_;
+    std::vector<Slot> slots_;
+    std::vector<Slot> roots_;  // 当前语句直接包含的表达式
+    const DefineStmt* function_ = nullptr;
+    std::vector<LoopScope> loopScopes_;
+    int scope_ = -1;
+
+    size_t inlined_ = 0;
+};
+
+void InliningPass::run() {
+    bindings_ = countBindings(program_);
+    candidateIndex_.assign(bindings_.size(), -1);
+
+    // 找出候选函数
+    pushStatements(program_.statements, nullptr, -1);
+    while (!stmts_.empty()) {
+        PendingStmt pending = stmts_.back();
+        stmts_.pop_back();
+        if (pending.stmt->getType() == StmtType::DEFINE) {
+            analyze(static_cast<const DefineStmt*>(pending.stmt));
+        }
+        function_ = pending.function;
+        scope_ = pending.scope;
+        visitStmt(pending.stmt);
+        slots_.clear();
+    }
+    if (candidates_.empty()) {
+        return;
+    }
+    loopScopes_.clear();
+
+    // 替换调用
+    pushStatements(program_.statements, nullptr, -1);
+    while (!stmts_.empty()) {
+        PendingStmt pending = stmts_.back();
+        stmts_.pop_back();
+
+        function_ = pending.function;
+        scope_ = pending.scope;
+        size_t mark = slots_.size();
+        visitStmt(pending.stmt);
+        roots_.assign(slots_.begin() + mark, slots_.end());
+        slots_.resize(mark);
+        for (const Slot& root : roots_) {
+            inlineExpression(root.slot);
+        }
+    }
+}
+
+int InliningPass::parameterIndex(const DefineStmt* define, Symbol symbol) {
+    for (size_t i = 0; i < define->parameters.size(); i++) {
+        if (define->parameters[i].getSymbol() == symbol) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+bool InliningPass::isShadowed(Symbol symbol) const {
+    if (function_ != nullptr && parameterIndex(function_, symbol) >= 0) {
+        return true;
+    }
+    for (int scope = scope_; scope >= 0; scope = loopScopes_[scope].parent) {
+        if (loopScopes_[scope].iterator == symbol) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void InliningPass::analyze(const DefineStmt* define) {
+    Symbol name = define->name.getSymbol();
+    if (name == INVALID_SYMBOL || name >= bindings_.size() || bindings_[name] != 1) {
+        return;
+    }
+    if (define->body.size() != 1 || define->body[0]->getType() != StmtType::RETURN) {
+        return;
+    }
+    const Expr* body = static_cast<const ReturnStmt*>(define->body[0])->value;
+    if (body == nullptr) {
+        return;
+    }
+
+    // 参数名必须互不相同
+    for (size_t i = 0; i < define->parameters.size(); i++) {
+        if (parameterIndex(define, define->parameters[i].getSymbol()) != static_cast<int>(i)) {
+            return;
+        }
+    }
+
+    Candidate candidate{define, body, std::vector<uint32_t>(define->parameters.size(), 0), {}, false};
+    size_t nodes = 0;
+    std::vector<const Expr*> stack{body};
+    while (!stack.empty()) {
+        const Expr* expr = stack.back();
+        stack.pop_back();
+        if (++nodes > maxBodySize_) {
+            return;
+        }
+
+        switch (expr->getType()) {
+            case ExprType::LITERAL:
+                break;
+            case ExprType::VARIABLE: {
+                Symbol symbol = static_cast<const VariableExpr*>(expr)->name.getSymbol();
+                int index = parameterIndex(define, symbol);
+                if (index >= 0) {
+                    candidate.uses[index]++;
+                } else {
+                    candidate.freeVariables.push_back(symbol);
+                }
+                break;
+            }
+            case ExprType::UNARY:
+                stack.push_back(static_cast<const UnaryExpr*>(expr)->right);
+                break;
+            case ExprType::BINARY:
+                stack.push_back(static_cast<const BinaryExpr*>(expr)->left);
+                stack.push_back(static_cast<const BinaryExpr*>(expr)->right);
+                break;
+            case ExprType::CALL: {
+                // 被调用者必须是普通的名字，不能是函数自己或参数
+                auto* call = static_cast<const CallExpr*>(expr);
+                if (call->callee->getType() != ExprType::VARIABLE) {
+                    return;
+                }
+                Symbol callee = static_cast<const VariableExpr*>(call->callee)->name.getSymbol();
+                if (callee == name || parameterIndex(define, callee) >= 0) {
+                    return;
+                }
+                candidate.hasCall = true;
+                for (const Expr* argument : call->arguments) {
+                    stack.push_back(argument);
+                }
+                break;
+            }
+            default:
+                return;
+        }
+    }
+
+    // 替换调用时函数体本身也可能被改写，之后按分析时的副本复制，与上面的结果保持一致
+    candidate.body = ASTCloner(program_.arena).clone(body);
+    candidateIndex_[name] = static_cast<int>(candidates_.size());
+    candidates_.push_back(std::move(candidate));
+}
+
+void InliningPass::inlineExpression(Expr** slot) {
+    size_t base = slots_.size();
+    slots_.push_back(Slot{slot, false});
+    while (slots_.size() > base) {
+        if (!slots_.back().expanded) {
+            slots_.back().expanded = true;
+            visitExpr(*slots_.back().slot);
+            continue;
+        }
+
+        Slot top = slots_.back();
+        slots_.pop_back();
+        *top.slot = inlineCall(*top.slot);
+    }
+}
+
+Expr* InliningPass::inlineCall(Expr* expr) {
+    if (expr->getType() != ExprType::CALL) {
+        return expr;
+    }
+    auto* call = static_cast<CallExpr*>(expr);
+    if (call->callee->getType() != ExprType::VARIABLE) {
+        return expr;
+    }
+    Symbol callee = static_cast<VariableExpr*>(call->callee)->name.getSymbol();
+    if (callee >= candidateIndex_.size() || candidateIndex_[callee] < 0) {
+        return expr;
+    }
+    const Candidate& candidate = candidates_[candidateIndex_[callee]];
+    if (call->arguments.size() != candidate.define->parameters.size()) {
+        return expr;
+    }
+
+    // 函数体中的全局变量不能被调用处所在函数的参数或外层循环的循环变量遮蔽
+    for (Symbol symbol : candidate.freeVariables) {
+        if (isShadowed(symbol)) {
+            return expr;
+        }
+    }
+
+    // 实参替换进函数体后，求值的次数、时机和副作用都不能改变
+    for (size_t i = 0; i < call->arguments.size(); i++) {
+        const Expr* argument = call->arguments[i];
+        ExprType type = argument->getType();
+        if (candidate.hasCall && type != ExprType::LITERAL) {
+            return expr;
+        }
+        bool trivial = type == ExprType::LITERAL || type == ExprType::VARIABLE;
+        if (!trivial && (candidate.uses[i] > 1 || !DeadCodeEliminator::isPure(argument))) {
+            return expr;
+        }
+    }
+
+    inlined_++;
+    return cloneBody(candidate, call->arguments);
+}
+
+Expr* InliningPass::cloneBody(const Candidate& candidate, const NodeList<Expr*>& arguments) {
+    ASTCloner cloner(program_.arena);
+    for (size_t i = 0; i < arguments.size(); i++) {
+        cloner.substitute(candidate.define->parameters[i].getSymbol(), arguments[i]);
+    }
+    return cloner.clone(candidate.body);
+}
+
+} // namespace
+
+// 内联小函数
+void Inliner::run(Program& program) {
+    InliningPass pass(program, maxBodySize_);
+    pass.run();
+    inlined_ = pass.inlined();
+}
+
+} // namespace jvav
@@ -0,0 +1,613 @@
+#include "optimizer/LoopOptimizer.h"
+#include "ast/ASTCloner.h"
+#include "ast/ASTVisitor.h"
+#include "ast/NodeWalker.h"
+#include "lexer/SymbolTable.h"
+#include "optimizer/Bindings.h"
+#include "optimizer/ConstantFolder.h"
+#include "optimizer/DeadCodeEliminator.h"
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace jvav {
+
+namespace {
+
+// 循环体的分析结果
+struct LoopInfo {
+    size_t nodes = 0;             // 循环体的节点数
+    bool hasDefinition = false;   // 有函数、数组、记录、枚举定义或导入，不能复制
+    bool hasCall = false;         // 有函数调用
+    std::vector<Symbol> written;  // 循环中被写入的变量，包括循环变量
+};
+
+// 收集语句列表中所有语句（含嵌套的子语句）直接包含的表达式位置
+class RootCollector : public ASTVisitor<RootCollector> {
+public:
+    void collect(NodeList<Stmt*> statements, std::vector<Expr**>& roots) {
+        roots_ = &roots;
+        pushList(statements);
+        while (!stmts_.empty()) {
+            Stmt* stmt = stmts_.back();
+            stmts_.pop_back();
+            visitStmt(stmt);
+        }
+    }
+
+private:
+    friend class ASTVisitor<RootCollector>;
+
+    void push(Expr** slot) {
+        if (*slot != nullptr) {
+            roots_->push_back(slot);
+        }
+    }
+    void pushList(NodeList<Stmt*> statements) {
+        stmts_.insert(stmts_.end(), statements.begin(), statements.end());
+    }
+
+    void visit(ExpressionStmt* stmt) { push(&stmt->expression); }
+    void visit(ImportStmt*) {}
+    void visit(DakaiStmt* stmt) { push(&stmt->path); }
+    void visit(SetStmt* stmt) { push(&stmt->value); }
+    void visit(PrintStmt* stmt) { push(&stmt->value); }
+    void visit(IfStmt* stmt) {
+        for (Branch& branch : stmt->branches) {
+            push(&branch.condition);
+            pushList(branch.body);
+        }
+    }
+    void visit(LoopStmt* stmt) {
+        push(&stmt->count);
+        pushList(stmt->body);
+    }
+    void visit(DefineStmt*) {}  // 函数体不属于循环，函数在调用时才执行
+    void visit(ReturnStmt* stmt) { push(&stmt->value); }
+    void visit(ArrayStmt* stmt) {
+        for (Expr*& element : stmt->elements) {
+            push(&element);
+        }
+    }
+    void visit(RecordDefStmt*) {}
+    void visit(RecordAccessStmt* stmt) { push(&stmt->value); }
+    void visit(TryCatchStmt* stmt) {
+        pushList(stmt->tryBlock);
+        pushList(stmt->catchBlock);
+    }
+    void visit(EnumDefStmt*) {}
+    void visit(BlockStmt* stmt) { pushList(stmt->statements); }
+    void visit(ErrorStmt*) {}
+
+    std::vector<Expr**>* roots_ = nullptr;
+    std::vector<Stmt*> stmts_;
+};
+
+// 一次循环优化：从顶层语句列表开始逐个重写语句列表，
+// 其中的循环换成外提的临时变量和优化后的循环（或展开的语句），
+// 保留下来的语句中的子语句列表由各visit重载排入栈中，之后再处理，
+// 因此外层循环先于内层循环优化，展开出的每份内层循环各自再优化。
+class LoopPass : public ASTVisitor<LoopPass> {
+public:
+    LoopPass(Program& program, int unrollFactor)
+        : program_(program), cloner_(program.arena), unrollFactor_(unrollFactor) {}
+
+    void run();
+
+    size_t unrolled() const { return unrolled_; }
+    size_t hoisted() const { return hoisted_; }
+    size_t reduced() const { return reduced_; }
+
+private:
+    friend class ASTVisitor<LoopPass>;
+
+    // 表达式位置，expanded表示子表达式是否已经排入
+    struct Slot {
+        Expr** slot;
+        bool expanded;
+    };
+
+    // 重写一个语句列表
+    void rewriteList(NodeList<Stmt*>& list);
+
+    // 优化一个循环，结果放入output_，需要继续处理的语句放回input_，没有任何变换时返回false
+    bool optimizeLoop(LoopStmt* loop);
+
+    // 分析循环体
+    LoopInfo analyze(const LoopStmt* loop);
+
+    // 换成N份循环体
+    void unrollFully(const LoopStmt* loop, int32_t trips);
+
+    // 强度削弱，累加器的初值设置放入output_，返回后loop->body已更新
+    void reduceStrength(LoopStmt* loop, LoopInfo& info);
+
+    // 外提不变表达式，临时变量的设置放入output_
+    void hoistInvariants(LoopStmt* loop, const LoopInfo& info);
+
+    // 按倍数部分展开
+    void unrollPartially(LoopStmt* loop, int32_t trips);
+
+    // 表达式节点中可以被改写的子表达式位置（被调用者、赋值目标等名字位置除外）
+    static void childSlots(Expr* expr, std::vector<Expr**>& slots);
+
+    // expr是i * k或k * i时返回k，否则返回nullptr
+    static const Expr* inductionFactor(const Expr* expr, Symbol iterator);
+
+    // 外提后能省下运算的表达式
+    static bool isWorthHoisting(const Expr* expr);
+
+    // 节点本身能否在循环外求值（子节点另行判断）
+    static bool isInvariantOperation(const Expr* expr);
+
+    // 把slot上的表达式换成临时变量，在循环前设置它
+    void hoist(Expr** slot, const Token& position);
+
+    // 新的临时变量名字
+    Token freshName(const char* prefix, const Token& position);
+
+    // 语法节点构造
+    LiteralExpr* number(int32_t value, const Token& position) {
+        return ConstantFolder::makeLiteral(program_.arena, value, position);
+    }
+    BinaryExpr* binary(Expr* left, TokenType op, Expr* right, const Token& position) {
+        Token token(op, position.getFile(), position.getOffset(), 0);
+        return program_.arena.make<BinaryExpr>(left, token, right);
+    }
+    VariableExpr* variable(const Token& name) {
+        return program_.arena.make<VariableExpr>(name);
+    }
+
+    // 复制语句列表并把循环变量换成replacement
+    NodeList<Stmt*> cloneBody(const LoopStmt* loop, const Expr* replacement);
+
+    // 把语句放回input_，按原来的顺序接着处理
+    void pushInput(const NodeList<Stmt*>& statements) {
+        for (size_t i = statements.size(); i > 0; i--) {
+            input_.push_back(statements[i - 1]);
+        }
+    }
+
+    // 保留下来的语句：排入它的子语句列表
+    void pushList(NodeList<Stmt*>& list) { lists_.push_back(&list); }
+    void visit(ExpressionStmt*) {}
+    void visit(ImportStmt*) {}
+    void visit(DakaiStmt*) {}
+    void visit(SetStmt*) {}
+    void visit(PrintStmt*) {}
+    void visit(IfStmt* stmt) {
+        for (Branch& branch : stmt->branches) {
+            pushList(branch.body);
+        }
+    }
+    void visit(LoopStmt* stmt) { pushList(stmt->body); }
+    void visit(DefineStmt* stmt) { pushList(stmt->body); }
+    void visit(ReturnStmt*) {}
+    void visit(ArrayStmt*) {}
+    void visit(RecordDefStmt*) {}
+    void visit(RecordAccessStmt*) {}
+    void visit(TryCatchStmt* stmt) {
+        pushList(stmt->tryBlock);
+        pushList(stmt->catchBlock);
+    }
+    void visit(EnumDefStmt*) {}
+    void visit(BlockStmt* stmt) { pushList(stmt->statements); }
+    void visit(ErrorStmt*) {}
+
+    Program& program_;
+    ASTCloner cloner_;
+    int unrollFactor_;
+
+    std::vector<uint32_t> bindings_;
+    std::vector<NodeList<Stmt*>*> lists_;
+
+    // 重写列表时的输入（逆序，栈顶是下一条语句）和输出
+    std::vector<Stmt*> input_;
+    std::vector<Stmt*> output_;
+
+    // 遍历表达式用的栈
+    std::vector<Slot> slots_;
+    std::vector<uint8_t> results_;
+    std::vector<Expr**> children_;
+
+    size_t nextTemporary_ = 0;
+    size_t unrolled_ = 0;
+    size_t hoisted_ = 0;
+    size_t reduced_ = 0;
+};
+
+void LoopPass::run() {
+    bindings_ = countBindings(program_);
+    lists_.push_back(&program_.statements);
+    while (!lists_.empty()) {
+        NodeList<Stmt*>* list = lists_.back();
+        lists_.pop_back();
+        rewriteList(*list);
+    }
+}
+
+void LoopPass::rewriteList(NodeList<Stmt*>& list) {
+    input_.assign(list.begin(), list.end());
+    std::reverse(input_.begin(), input_.end());
+    output_.clear();
+    bool changed = false;
+
+    while (!input_.empty()) {
+        Stmt* stmt = input_.back();
+        input_.pop_back();
+        if (stmt->getType() != StmtType::LOOP) {
+            output_.push_back(stmt);
+            continue;
+        }
+
+        if (optimizeLoop(static_cast<LoopStmt*>(stmt))) {
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        list = program_.arena.copyList(output_.data(), output_.size());
+    }
+    for (Stmt* stmt : list) {
+        visitStmt(stmt);
+    }
+}
+
+bool LoopPass::optimizeLoop(LoopStmt* loop) {
+    Symbol iterator = loop->variable.getSymbol();
+    LoopInfo info = analyze(loop);
+    if (info.hasDefinition ||
+        (iterator != INVALID_SYMBOL && (iterator >= bindings_.size() || bindings_[iterator] != 1))) {
+        output_.push_back(loop);
+        return false;
+    }
+
+    int32_t trips = 0;
+    bool constant = ConstantFolder::evaluate(loop->count, trips);
+    if (constant && trips >= 1 && trips <= LoopOptimizer::FULL_UNROLL_MAX_TRIPS &&
+        static_cast<size_t>(trips) * info.nodes <= LoopOptimizer::FULL_UNROLL_BUDGET) {
+        unrollFully(loop, trips);
+        return true;
+    }
+
+    size_t before = hoisted_ + reduced_;
+    // 累加器和外提的临时变量都是全局变量，在次数之前赋值；循环体或次数中的调用
+    // （例如递归调用循环所在的函数）可能改写它们，这时既不削弱也不外提
+    if (!info.hasCall && DeadCodeEliminator::isPure(loop->count)) {
+        reduceStrength(loop, info);
+        hoistInvariants(loop, info);
+    }
+
+    if (constant && unrollFactor_ >= 2 && trips >= unrollFactor_ &&
+        info.nodes * static_cast<size_t>(unrollFactor_) <= LoopOptimizer::PARTIAL_UNROLL_BUDGET) {
+        unrollPartially(loop, trips);
+        return true;
+    }
+    output_.push_back(loop);
+    return hoisted_ + reduced_ != before;
+}
+
+LoopInfo LoopPass::analyze(const LoopStmt* loop) {
+    LoopInfo info;
+    if (loop->variable.getSymbol() != INVALID_SYMBOL) {
+        info.written.push_back(loop->variable.getSymbol());
+    }
+
+    NodeWalker walker;
+    walker.walk(loop->body,
+        [&info](Stmt* stmt) {
+            info.nodes++;
+            switch (stmt->getType()) {
+                case StmtType::DEFINE:
+                case StmtType::ARRAY:
+                case StmtType::RECORD_DEF:
+                case StmtType::ENUM_DEF:
+                case StmtType::IMPORT:
+                    info.hasDefinition = true;
+                    break;
+                case StmtType::SET:
+                    info.written.push_back(static_cast<SetStmt*>(stmt)->name.getSymbol());
+                    break;
+                case StmtType::LOOP:
+                    info.written.push_back(static_cast<LoopStmt*>(stmt)->variable.getSymbol());
+                    break;
+                case StmtType::RECORD_ACCESS:
+                    info.written.push_back(static_cast<RecordAccessStmt*>(stmt)->record.getSymbol());
+                    break;
+                default:
+                    break;
+            }
+        },
+        [&info](Expr* expr) {
+            info.nodes++;
+            if (expr->getType() == ExprType::CALL) {
+                info.hasCall = true;
+            } else if (expr->getType() == ExprType::ASSIGNMENT) {
+                auto* assignment = static_cast<AssignmentExpr*>(expr);
+                if (assignment->target->getType() == ExprType::VARIABLE) {
+                    info.written.push_back(static_cast<VariableExpr*>(assignment->target)->name.getSymbol());
+                }
+            }
+        });
+    return info;
+}
+
+NodeList<Stmt*> LoopPass::cloneBody(const LoopStmt* loop, const Expr* replacement) {
+    cloner_.clearSubstitutions();
+    if (loop->variable.getSymbol() != INVALID_SYMBOL && replacement != nullptr) {
+        cloner_.substitute(loop->variable.getSymbol(), replacement);
+    }
+    return cloner_.clone(loop->body);
+}
+
+void LoopPass::unrollFully(const LoopStmt* loop, int32_t trips) {
+    // 次数表达式是常量，不必保留它的求值
+    std::vector<Stmt*> statements;
+    for (int32_t i = 0; i < trips; i++) {
+        NodeList<Stmt*> copy = cloneBody(loop, number(i, loop->variable));
+        statements.insert(statements.end(), copy.begin(), copy.end());
+    }
+    pushInput(program_.arena.copyList(statements.data(), statements.size()));
+    unrolled_++;
+}
+
+void LoopPass::reduceStrength(LoopStmt* loop, LoopInfo& info) {
+    Symbol iterator = loop->variable.getSymbol();
+    if (iterator == INVALID_SYMBOL) {
+        return;
+    }
+
+    // 每个不同的k一个累加器，它的值始终等于i * k
+    std::vector<std::pair<int32_t, Token>> accumulators;
+    std::vector<Expr**> roots;
+    RootCollector().collect(loop->body, roots);
+    for (Expr** root : roots) {
+        children_.assign(1, root);
+        while (!children_.empty()) {
+            Expr** slot = children_.back();
+            children_.pop_back();
+
+            int32_t k = 0;
+            const Expr* factor = inductionFactor(*slot, iterator);
+            if (factor == nullptr || !ConstantFolder::evaluate(factor, k)) {
+                childSlots(*slot, children_);
+                continue;
+            }
+
+            auto found = std::find_if(accumulators.begin(), accumulators.end(),
+                [k](const auto& accumulator) { return accumulator.first == k; });
+            if (found == accumulators.end()) {
+                accumulators.emplace_back(k, freshName("iv", loop->variable));
+                found = accumulators.end() - 1;
+            }
+            *slot = variable(found->second);
+            reduced_++;
+        }
+    }
+    if (accumulators.empty()) {
+        return;
+    }
+
+    // 循环前置0，每次迭代末尾加k
+    std::vector<Stmt*> body(loop->body.begin(), loop->body.end());
+    for (const auto& [k, name] : accumulators) {
+        output_.push_back(program_.arena.make<SetStmt>(name, number(0, loop->variable)));
+        Expr* next = binary(variable(name), TokenType::PLUS, number(k, loop->variable), loop->variable);
+        body.push_back(program_.arena.make<SetStmt>(name, next));
+        info.written.push_back(name.getSymbol());
+    }
+    loop->body = program_.arena.copyList(body.data(), body.size());
+}
+
+const Expr* LoopPass::inductionFactor(const Expr* expr, Symbol iterator) {
+    if (expr->getType() != ExprType::BINARY) {
+        return nullptr;
+    }
+    auto* product = static_cast<const BinaryExpr*>(expr);
+    if (product->op.getType() != TokenType::STAR) {
+        return nullptr;
+    }
+    auto isIterator = [iterator](const Expr* operand) {
+        return operand->getType() == ExprType::VARIABLE &&
+               static_cast<const VariableExpr*>(operand)->name.getSymbol() == iterator;
+    };
+    if (isIterator(product->left)) {
+        return product->right;
+    }
+    if (isIterator(product->right)) {
+        return product->left;
+    }
+    return nullptr;
+}
+
+void LoopPass::hoistInvariants(LoopStmt* loop, const LoopInfo& info) {
+    std::vector<Symbol> written = info.written;
+    std::sort(written.begin(), written.end());
+    auto isWritten = [&written](Symbol symbol) {
+        return std::binary_search(written.begin(), written.end(), symbol);
+    };
+
+    // 后序计算每个节点能否在循环外求值，结果按顺序放在results_中；
+    // 不能外提的节点把它能外提的子节点外提，整棵能外提的树只在根上外提一次
+    std::vector<Expr**> roots;
+    RootCollector().collect(loop->body, roots);
+    for (Expr** root : roots) {
+        results_.clear();
+        slots_.assign(1, Slot{root, false});
+        while (!slots_.empty()) {
+            if (!slots_.back().expanded) {
+                slots_.back().expanded = true;
+                Expr* expr = *slots_.back().slot;
+                size_t mark = children_.size();
+                childSlots(expr, children_);
+                for (size_t i = mark; i < children_.size(); i++) {
+                    slots_.push_back(Slot{children_[i], false});
+                }
+                children_.resize(mark);
+                continue;
+            }
+
+            Expr** slot = slots_.back().slot;
+            slots_.pop_back();
+            Expr* expr = *slot;
+
+            children_.clear();
+            childSlots(expr, children_);
+            size_t count = children_.size();
+            // 子节点按childSlots的顺序排入栈，后序完成的顺序与之相反
+            std::reverse(children_.begin(), children_.end());
+            bool invariant = isInvariantOperation(expr);
+            if (expr->getType() == ExprType::VARIABLE) {
+                invariant = !isWritten(static_cast<VariableExpr*>(expr)->name.getSymbol());
+            }
+            for (size_t i = 0; i < count; i++) {
+                invariant = invariant && results_[results_.size() - count + i];
+            }
+            if (!invariant) {
+                for (size_t i = 0; i < count; i++) {
+                    Expr** child = children_[i];
+                    if (results_[results_.size() - count + i] && isWorthHoisting(*child)) {
+                        hoist(child, loop->variable);
+                    }
+                }
+            }
+            results_.resize(results_.size() - count);
+            results_.push_back(invariant);
+        }
+        if (results_.back() && isWorthHoisting(*root)) {
+            hoist(root, loop->variable);
+        }
+    }
+    children_.clear();
+}
+
+bool LoopPass::isInvariantOperation(const Expr* expr) {
+    switch (expr->getType()) {
+        case ExprType::LITERAL:
+        case ExprType::VARIABLE:
+            return true;
+        case ExprType::UNARY: {
+            TokenType op = static_cast<const UnaryExpr*>(expr)->op.getType();
+            return op == TokenType::MINUS || op == TokenType::NOT;
+        }
+        case ExprType::BINARY: {
+            // 外提后即使循环一次也不执行也会求值，所以不能外提可能陷入的除法和取余
+            auto* binary = static_cast<const BinaryExpr*>(expr);
+            switch (binary->op.getType()) {
+                case TokenType::SLASH:
+                case TokenType::PERCENT: {
+                    int32_t divisor = 0;
+                    return ConstantFolder::evaluate(binary->right, divisor) && divisor != 0 && divisor != -1;
+                }
+                case TokenType::PLUS:
+                case TokenType::MINUS:
+                case TokenType::STAR:
+                case TokenType::EQUAL:
+                case TokenType::NOT_EQUAL:
+                case TokenType::LESS:
+                case TokenType::LESS_EQUAL:
+                case TokenType::GREATER:
+                case TokenType::GREATER_EQUAL:
+                case TokenType::AND:
+                case TokenType::OR:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+        default:
+            return false;
+    }
+}
+
+bool LoopPass::isWorthHoisting(const Expr* expr) {
+    // 字面量和变量本身已经是一条指令
+    return expr->getType() == ExprType::UNARY || expr->getType() == ExprType::BINARY;
+}
+
+void LoopPass::hoist(Expr** slot, const Token& position) {
+    Token name = freshName("licm", position);
+    output_.push_back(program_.arena.make<SetStmt>(name, *slot));
+    *slot = variable(name);
+    hoisted_++;
+}
+
+void LoopPass::unrollPartially(LoopStmt* loop, int32_t trips) {
+    int32_t factor = unrollFactor_;
+    int32_t rounds = trips / factor;
+    Symbol iterator = loop->variable.getSymbol();
+
+    // 循环体复制factor份，第r份中的i换成j * factor + r
+    Token outer = iterator != INVALID_SYMBOL ? freshName("unroll", loop->variable) : Token();
+    std::vector<Stmt*> body;
+    for (int32_t r = 0; r < factor; r++) {
+        const Expr* index = nullptr;
+        if (iterator != INVALID_SYMBOL) {
+            Expr* base = binary(variable(outer), TokenType::STAR, number(factor, loop->variable), loop->variable);
+            index = r == 0 ? base : binary(base, TokenType::PLUS, number(r, loop->variable), loop->variable);
+        }
+        NodeList<Stmt*> copy = cloneBody(loop, index);
+        body.insert(body.end(), copy.begin(), copy.end());
+    }
+
+    // 余下的几次在循环之后逐份执行
+    std::vector<Stmt*> remainder;
+    for (int32_t i = rounds * factor; i < trips; i++) {
+        NodeList<Stmt*> copy = cloneBody(loop, number(i, loop->variable));
+        remainder.insert(remainder.end(), copy.begin(), copy.end());
+    }
+
+    loop->count = number(rounds, loop->variable);
+    loop->body = program_.arena.copyList(body.data(), body.size());
+    if (iterator != INVALID_SYMBOL) {
+        loop->variable = outer;
+    }
+    output_.push_back(loop);
+    pushInput(program_.arena.copyList(remainder.data(), remainder.size()));
+    unrolled_++;
+}
+
+Token LoopPass::freshName(const char* prefix, const Token& position) {
+    std::string text = std::string(prefix) + "." + std::to_string(nextTemporary_++);
+    Symbol symbol = SymbolTable::instance().intern(text);
+    return Token(TokenType::IDENTIFIER, position.getFile(), position.getOffset(), 0, symbol);
+}
+
+void LoopPass::childSlots(Expr* expr, std::vector<Expr**>& slots) {
+    switch (expr->getType()) {
+        case ExprType::UNARY:
+            slots.push_back(&static_cast<UnaryExpr*>(expr)->right);
+            break;
+        case ExprType::BINARY:
+            slots.push_back(&static_cast<BinaryExpr*>(expr)->left);
+            slots.push_back(&static_cast<BinaryExpr*>(expr)->right);
+            break;
+        case ExprType::CALL:
+            for (Expr*& argument : static_cast<CallExpr*>(expr)->arguments) {
+                slots.push_back(&argument);
+            }
+            break;
+        case ExprType::ARRAY_ACCESS:
+            slots.push_back(&static_cast<ArrayAccessExpr*>(expr)->index);
+            break;
+        case ExprType::ASSIGNMENT:
+            slots.push_back(&static_cast<AssignmentExpr*>(expr)->value);
+            break;
+        default:
+            break;
+    }
+}
+
+} // namespace
+
+// 优化循环
+void LoopOptimizer::run(Program& program) {
+    LoopPass pass(program, unrollFactor_);
+    pass.run();
+    unrolled_ = pass.unrolled();
+    hoisted_ = pass.hoisted();
+    reduced_ = pass.reduced();
+}
+
+} // namespace jvav
@@ -1,15 +1,109 @@
 #include "optimizer/Optimizer.h"
-#include <iostream>
+#include "ir/ConstantPropagator.h"
+#include "ir/DeadValueEliminator.h"
+#include "ir/LoopInvariantMotion.h"
+#include "ir/ValueNumbering.h"
+#include "optimizer/ConstantFolder.h"
+#include "optimizer/DeadCodeEliminator.h"
+#include "optimizer/Inliner.h"
+#include "optimizer/LoopOptimizer.h"
 
 namespace jvav {
 
-// 前向声明私有实现类
+// 优化器的私有实现
 class Optimizer::OptimizerImpl {
 public:
-    void optimize(std::vector<std::unique_ptr<Stmt>>& ast, int optimizationLevel) {
-        // 空实现，将在后续完善
-        std::cout << "AST优化暂未实现 (级别: " << optimizationLevel << ")" << std::endl;
+    void optimize(Program& program, int optimizationLevel) {
+        stats_ = OptimizationStats();
+        if (optimizationLevel < 1) {
+            return;
+        }
+        
+        simplify(program);
+        
+        // 内联小函数，之后实参和函数体合在一起，再化简一遍
+        // 一轮内联展开的副本中的调用留到下一轮，-O3多做几轮
+        if (optimizationLevel >= 2) {
+            Inliner inliner(optimizationLevel >= 3 ? Inliner::O3_MAX_BODY_SIZE
+                                                   : Inliner::O2_MAX_BODY_SIZE);
+            int rounds = optimizationLevel >= 3 ? O3_INLINE_ROUNDS : 1;
+            for (int round = 0; round < rounds; round++) {
+                inliner.run(program);
+                if (inliner.inlinedCount() == 0) {
+                    break;
+                }
+                stats_.inlinedCalls += inliner.inlinedCount();
+                simplify(program);
+            }
+            
+            // 循环优化，展开出的常量循环变量再折叠一遍
+            LoopOptimizer loops(unrollFactor_);
+            loops.run(program);
+            stats_.unrolledLoops += loops.unrolledCount();
+            stats_.hoistedExpressions += loops.hoistedCount();
+            stats_.reducedMultiplications += loops.reducedCount();
+            if (loops.unrolledCount() + loops.hoistedCount() + loops.reducedCount() > 0) {
+                simplify(program);
+            }
+        }
     }
+    
+    void optimize(IRModule& module, int optimizationLevel) {
+        if (optimizationLevel < 1) {
+            return;
+        }
+        for (IRFunction& function : module.functions) {
+            ConstantPropagator propagator;
+            propagator.run(function);
+            stats_.irConstants += propagator.foldedCount();
+            stats_.irRemovedBlocks += propagator.removedBlockCount();
+            
+            // 值编号删掉平凡的phi之后，外提才能看出操作数在循环外
+            if (optimizationLevel >= 2) {
+                ValueNumbering numbering;
+                numbering.run(function);
+                stats_.irRedundantValues += numbering.removedCount();
+                
+                LoopInvariantMotion motion;
+                motion.run(function);
+                stats_.irHoistedValues += motion.hoistedCount();
+                
+                // 外提到同一个前置块的运算可能重复
+                if (motion.hoistedCount() > 0) {
+                    numbering.run(function);
+                    stats_.irRedundantValues += numbering.removedCount();
+                }
+            }
+            
+            DeadValueEliminator eliminator;
+            eliminator.run(function);
+            stats_.irDeadValues += eliminator.removedCount();
+            stats_.irRemovedBlocks += function.mergeBlocks();
+        }
+    }
+    
+    void setUnrollFactor(int factor) { unrollFactor_ = factor; }
+    
+    const OptimizationStats& getStats() const { return stats_; }
+    
+private:
+    // -O3的内联轮数
+    static constexpr int O3_INLINE_ROUNDS = 3;
+    
+    // 常量折叠和常量传播，然后消除因此变得不可达的代码
+    void simplify(Program& program) {
+        ConstantFolder folder;
+        folder.run(program);
+        stats_.foldedExpressions += folder.foldedCount();
+        stats_.propagatedConstants += folder.propagatedCount();
+        
+        DeadCodeEliminator eliminator;
+        eliminator.run(program);
+        stats_.removedStatements += eliminator.removedCount();
+    }
+    
+    OptimizationStats stats_;
+    int unrollFactor_ = LoopOptimizer::DEFAULT_UNROLL_FACTOR;
 };
 
 // 构造函数
@@ -20,8 +114,23 @@ Optimizer::Optimizer() : impl_(std::make_unique<OptimizerImpl>()) {
 Optimizer::~Optimizer() = default;
 
 // 优化AST
-void Optimizer::optimize(std::vector<std::unique_ptr<Stmt>>& ast, int optimizationLevel) {
-    impl_->optimize(ast, optimizationLevel);
+void Optimizer::optimize(Program& program, int optimizationLevel) {
+    impl_->optimize(program, optimizationLevel);
+}
+
+// 优化中间表示
+void Optimizer::optimize(IRModule& module, int optimizationLevel) {
+    impl_->optimize(module, optimizationLevel);
+}
+
+// 设置循环部分展开的倍数
+void Optimizer::setUnrollFactor(int factor) {
+    impl_->setUnrollFactor(factor);
+}
+
+// 上次优化的统计
+const OptimizationStats& Optimizer::getStats() const {
+    return impl_->getStats();
 }
 
-} // namespace jvav 
\ No newline at end of file
+} // namespace jvav
@@ -0,0 +1,32 @@
+#include "parser/Diagnostics.h"
+#include <algorithm>
+
+namespace jvav {
+
+// 格式化错误信息
+std::string Diagnostic::toString() const {
+    std::string result = token.getLocation().toString();
+    if (token.getType() == TokenType::END_OF_FILE) {
+        result += " 文件结束: ";
+    } else {
+        result += " 在 '";
+        result += token.getLexeme();
+        result += "': ";
+    }
+    result += message;
+    return result;
+}
+
+// 并入另一组错误
+void DiagnosticSink::merge(const DiagnosticSink& other) {
+    size_t middle = diagnostics_.size();
+    diagnostics_.insert(diagnostics_.end(), other.diagnostics_.begin(), other.diagnostics_.end());
+    
+    // 两组各自已按位置有序，归并即可
+    std::inplace_merge(diagnostics_.begin(), diagnostics_.begin() + middle, diagnostics_.end(),
+                       [](const Diagnostic& a, const Diagnostic& b) {
+                           return a.token.getOffset() < b.token.getOffset();
+                       });
+}
+
+} // namespace jvav
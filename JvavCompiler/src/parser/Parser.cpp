@@ -1,296 +1,566 @@
 #include "parser/Parser.h"
+#include "lexer/Lexer.h"
+#include <algorithm>
+#include <array>
 #include <iostream>
+#include <memory>
 
 namespace jvav {
 
+namespace {
+
+// 导入别名和循环变量前面的"as"不是关键字，按标识符的符号编号识别
+Symbol asSymbol() {
+    static const Symbol symbol = SymbolTable::instance().intern("as");
+    return symbol;
+}
+
+// 流式模式下每次从环形缓冲区读取的最大token数
+constexpr size_t RING_BATCH_SIZE = 1024;
+
+// 按需模式下每次让词法分析器分析的token数
+// 增量解析通常只需要一两条语句的token，批量小一些以免多分析
+constexpr size_t LEXER_BATCH_SIZE = 64;
+
+// 表达式中各中缀/后缀操作符的优先级，按TokenType下标索引
+// TokenType的最后一个枚举值是RIGHT_BRACKET
+constexpr size_t TOKEN_TYPE_COUNT = static_cast<size_t>(TokenType::RIGHT_BRACKET) + 1;
+
+constexpr std::array<Precedence, TOKEN_TYPE_COUNT> buildPrecedenceTable() {
+    std::array<Precedence, TOKEN_TYPE_COUNT> table{};
+    auto set = [&table](TokenType type, Precedence precedence) {
+        table[static_cast<size_t>(type)] = precedence;
+    };
+    
+    set(TokenType::OR, Precedence::OR);
+    set(TokenType::AND, Precedence::AND);
+    set(TokenType::EQUAL, Precedence::EQUALITY);
+    set(TokenType::NOT_EQUAL, Precedence::EQUALITY);
+    set(TokenType::LESS, Precedence::COMPARISON);
+    set(TokenType::LESS_EQUAL, Precedence::COMPARISON);
+    set(TokenType::GREATER, Precedence::COMPARISON);
+    set(TokenType::GREATER_EQUAL, Precedence::COMPARISON);
+    set(TokenType::PLUS, Precedence::TERM);
+    set(TokenType::MINUS, Precedence::TERM);
+    set(TokenType::STAR, Precedence::FACTOR);
+    set(TokenType::SLASH, Precedence::FACTOR);
+    set(TokenType::PERCENT, Precedence::FACTOR);
+    set(TokenType::LEFT_PAREN, Precedence::CALL);
+    set(TokenType::DOT, Precedence::CALL);
+    set(TokenType::LEFT_BRACKET, Precedence::CALL);
+    return table;
+}
+
+constexpr std::array<Precedence, TOKEN_TYPE_COUNT> PRECEDENCE_TABLE = buildPrecedenceTable();
+
+// 操作符作为中缀/后缀时的优先级，不是操作符时为NONE
+inline Precedence infixPrecedence(TokenType type) {
+    return PRECEDENCE_TABLE[static_cast<size_t>(type)];
+}
+
+// 高一级的优先级，用于左结合二元操作符的右操作数
+inline Precedence nextPrecedence(Precedence precedence) {
+    return static_cast<Precedence>(static_cast<uint8_t>(precedence) + 1);
+}
+
+// 在临时栈上收集一个子节点列表，完成后复制到arena
+// 析构时把栈恢复到开始时的高度，解析中途出错提前返回也不会留下残余元素
+template <typename T>
+class ScratchList {
+public:
+    explicit ScratchList(std::vector<T>& stack) : stack_(stack), mark_(stack.size()) {}
+    ~ScratchList() { stack_.resize(mark_); }
+    
+    ScratchList(const ScratchList&) = delete;
+    ScratchList& operator=(const ScratchList&) = delete;
+    
+    void push(T item) { stack_.push_back(item); }
+    
+    size_t size() const { return stack_.size() - mark_; }
+    const T& operator[](size_t index) const { return stack_[mark_ + index]; }
+    
+    NodeList<T> finish(Arena& arena) const {
+        return arena.copyList(stack_.data() + mark_, stack_.size() - mark_);
+    }
+    
+private:
+    std::vector<T>& stack_;
+    size_t mark_;
+};
+
+// 进入一层嵌套（括号内的表达式、语句块），离开作用域时退出
+class NestingScope {
+public:
+    explicit NestingScope(size_t& depth) : depth_(depth) { depth_++; }
+    ~NestingScope() { depth_--; }
+    
+    NestingScope(const NestingScope&) = delete;
+    NestingScope& operator=(const NestingScope&) = delete;
+    
+private:
+    size_t& depth_;
+};
+
+} // namespace
+
 // 构造函数
-Parser::Parser(Lexer& lexer) : lexer_(lexer) {
-    // 预先读取第一个token
-    current_ = lexer_.getNextToken();
+Parser::Parser(const TokenBuffer& tokens, Arena& arena) : tokens_(&tokens), arena_(arena) {
+}
+
+// 流式模式的构造函数
+Parser::Parser(TokenRing& ring, Arena& arena)
+    : tokens_(&window_), ring_(&ring), window_(ring.getFile()), arena_(arena) {
+    window_.reserve(RING_BATCH_SIZE + 1);
+    ring_->popBatch(window_, RING_BATCH_SIZE);
+}
+
+// 按需模式的构造函数
+Parser::Parser(Lexer& lexer, Arena& arena)
+    : tokens_(&window_), lexer_(&lexer), window_(lexer.getFileId()), arena_(arena) {
+    window_.reserve(LEXER_BATCH_SIZE + 1);
+    lexer_->tokenizeBatch(window_, LEXER_BATCH_SIZE);
 }
 
 // 解析源代码
-std::vector<std::unique_ptr<Stmt>> Parser::parse() {
-    std::vector<std::unique_ptr<Stmt>> statements;
+NodeList<Stmt*> Parser::parse() {
+    ScratchList<Stmt*> statements(stmtScratch_);
+    
+    // 解析直到文件结束
+    while (!check(TokenType::END_OF_FILE)) {
+        statements.push(declaration());
+    }
+    
+    return statements.finish(arena_);
+}
+
+// 解析为扁平语法树
+FlatTree Parser::parseFlat() {
+    FlatBuilder builder;
+    while (!check(TokenType::END_OF_FILE)) {
+        builder.addRoot(declaration());
+        arena_.reset();
+    }
+    return builder.finish();
+}
+
+// 并行解析
+NodeList<Stmt*> Parser::parseParallel(ThreadPool& pool) {
+    if (ring_ || lexer_ || pool.size() <= 1 || current_ != 0) {
+        return parse();
+    }
     
-    try {
-        // 解析直到文件结束
-        while (!check(TokenType::END_OF_FILE)) {
-            statements.push_back(declaration());
+    findTopLevelBodies();
+    size_t bodyTokens = 0;
+    for (const DeferredBody& span : bodySpans_) {
+        bodyTokens += span.close - span.open - 1;
+    }
+    if (bodyTokens < PARALLEL_MIN_BODY_TOKENS) {
+        bodySpans_.clear();
+        return parse();
+    }
+    
+    // 顶层解析，函数体只记录不解析
+    NodeList<Stmt*> statements = parse();
+    bodySpans_.clear();
+    nextBodySpan_ = 0;
+    if (deferredBodies_.empty()) {
+        return statements;
+    }
+    
+    // 按token数把函数体分成大致相等的若干组，每组内保持源代码顺序
+    size_t deferredTokens = 0;
+    for (const DeferredBody& body : deferredBodies_) {
+        deferredTokens += body.close - body.open - 1;
+    }
+    size_t groupCount = std::min(pool.size() * GROUPS_PER_THREAD, deferredBodies_.size());
+    size_t groupTarget = deferredTokens / groupCount + 1;
+    
+    std::vector<size_t> bounds;
+    bounds.push_back(0);
+    size_t groupTokens = 0;
+    for (size_t i = 0; i < deferredBodies_.size(); i++) {
+        groupTokens += deferredBodies_[i].close - deferredBodies_[i].open - 1;
+        if (groupTokens >= groupTarget && i + 1 < deferredBodies_.size()) {
+            bounds.push_back(i + 1);
+            groupTokens = 0;
         }
-    } catch (const ParseError& error) {
-        // 恢复并继续解析
-        synchronize();
+    }
+    bounds.push_back(deferredBodies_.size());
+    
+    // 每组使用自己的arena，解析完成后并入编译单元的arena
+    size_t groups = bounds.size() - 1;
+    std::vector<std::unique_ptr<Arena>> arenas;
+    std::vector<std::future<DiagnosticSink>> futures;
+    arenas.reserve(groups);
+    futures.reserve(groups);
+    for (size_t i = 0; i < groups; i++) {
+        arenas.push_back(std::make_unique<Arena>());
+        const DeferredBody* bodies = deferredBodies_.data() + bounds[i];
+        size_t count = bounds[i + 1] - bounds[i];
+        Arena* arena = arenas.back().get();
+        const TokenBuffer* tokens = tokens_;
+        size_t maxDepth = maxDepth_;
+        futures.push_back(pool.submit([tokens, bodies, count, arena, maxDepth]() {
+            return parseBodies(*tokens, bodies, count, *arena, maxDepth);
+        }));
+    }
+    
+    // 等所有组结束后再取结果，某一组抛出异常时其他组不会再访问这里的数据
+    for (auto& future : futures) {
+        future.wait();
+    }
+    for (size_t i = 0; i < groups; i++) {
+        diagnostics_.merge(futures[i].get());
+        arena_.absorb(*arenas[i]);
     }
     
+    deferredBodies_.clear();
     return statements;
 }
 
-// 声明解析
-std::unique_ptr<Stmt> Parser::declaration() {
-    try {
-        // 检查特定类型的声明
-        if (match(TokenType::IMPORT) || match(TokenType::ZH_IMPORT)) {
-            return importStatement();
-        }
-        if (match(TokenType::SET) || match(TokenType::ZH_SET)) {
-            return setStatement();
-        }
-        if (match(TokenType::PRINT) || match(TokenType::ZH_PRINT)) {
-            return printStatement();
-        }
-        if (match(TokenType::IF) || match(TokenType::ZH_IF)) {
-            return ifStatement();
-        }
-        if (match(TokenType::LOOP) || match(TokenType::ZH_LOOP)) {
-            return loopStatement();
-        }
-        if (match(TokenType::DEFINE) || match(TokenType::ZH_DEFINE)) {
-            return defineStatement();
-        }
-        if (match(TokenType::RETURN) || match(TokenType::ZH_RETURN)) {
-            return returnStatement();
-        }
-        if (match(TokenType::TRY) || match(TokenType::ZH_TRY)) {
-            return tryStatement();
+// 预扫描：匹配花括号，找出每个顶层函数定义的函数体
+// 与语法分析中braceDepth_的计算方式相同，多余的右花括号不计入层数；
+// 没有配对的函数体不记录，留给顶层解析按原样处理。
+void Parser::findTopLevelBodies() {
+    bodySpans_.clear();
+    nextBodySpan_ = 0;
+    
+    size_t depth = 0;
+    bool afterDefine = false;
+    bool inBody = false;
+    size_t open = 0;
+    size_t count = tokens_->size();
+    for (size_t i = 0; i < count; i++) {
+        switch (tokens_->type(i)) {
+            case TokenType::DEFINE:
+            case TokenType::ZH_DEFINE:
+                if (depth == 0) {
+                    afterDefine = true;
+                }
+                break;
+            case TokenType::LEFT_BRACE:
+                if (depth == 0) {
+                    // 函数定义之后的第一个顶层左花括号是函数体
+                    inBody = afterDefine;
+                    afterDefine = false;
+                    open = i;
+                }
+                depth++;
+                break;
+            case TokenType::RIGHT_BRACE:
+                if (depth > 0) {
+                    depth--;
+                    if (depth == 0 && inBody) {
+                        bodySpans_.push_back(DeferredBody{open, i, nullptr});
+                        inBody = false;
+                    }
+                }
+                break;
+            default:
+                break;
         }
-        if (match(TokenType::ENUM) || match(TokenType::ZH_ENUM)) {
-            return enumDefinition();
-        }
-        if (match(TokenType::JILU) || match(TokenType::ZH_JILU)) {
-            return recordDefinition();
-        }
-        
-        // 其他情况当作表达式语句处理
-        return expressionStatement();
-    } catch (const ParseError& error) {
-        synchronize();
-        return nullptr;
     }
 }
 
+// 函数体的左花括号刚被消费，如果它是预扫描找到的顶层函数体，
+// 就记下它并跳到右花括号之后，返回true
+bool Parser::deferBody(DefineStmt* stmt) {
+    // 跳过顶层解析没有经过的函数体（例如所在的函数头有错误）
+    while (nextBodySpan_ < bodySpans_.size() && bodySpans_[nextBodySpan_].open < previous_) {
+        nextBodySpan_++;
+    }
+    if (nextBodySpan_ == bodySpans_.size() || bodySpans_[nextBodySpan_].open != previous_) {
+        return false;
+    }
+    
+    DeferredBody body = bodySpans_[nextBodySpan_++];
+    body.stmt = stmt;
+    deferredBodies_.push_back(body);
+    
+    // 函数体内的花括号是配对的，消费右花括号后层数回到函数定义之前
+    current_ = body.close;
+    advance();
+    return true;
+}
+
+// 依次解析一组函数体，在工作线程中运行
+// 函数体内的语句不会越过配对的右花括号，因此与串行解析得到的结果相同
+DiagnosticSink Parser::parseBodies(const TokenBuffer& tokens, const DeferredBody* bodies,
+                                   size_t count, Arena& arena, size_t maxDepth) {
+    Parser parser(tokens, arena);
+    parser.maxDepth_ = maxDepth;
+    for (size_t i = 0; i < count; i++) {
+        // 从左花括号之后开始，状态与串行解析到这里时相同
+        parser.previous_ = bodies[i].open;
+        parser.current_ = bodies[i].open + 1;
+        parser.braceDepth_ = 1;
+        bodies[i].stmt->body = parser.block();
+    }
+    return std::move(parser.diagnostics_);
+}
+
+// 设置最大嵌套层数
+void Parser::setMaxDepth(size_t depth) {
+    maxDepth_ = std::max<size_t>(depth, 1);
+}
+
+// 解析一条顶层语句
+Stmt* Parser::parseDeclaration() {
+    return declaration();
+}
+
+// 声明解析
+// 语句中出错时各解析方法立即返回，在这里同步到同一层的下一条语句，
+// 出错的语句用ErrorStmt代替，之后的语句照常解析
+Stmt* Parser::declaration() {
+    Token start = peek();
+    size_t depth = braceDepth_;
+    
+    Stmt* stmt = statement();
+    
+    // 没有消费任何token说明当前token不能开始一条语句，错误已在primary()中报告
+    bool stalled = peek().getOffset() == start.getOffset();
+    if (panicMode_ || stalled) {
+        synchronize(depth);
+        return arena_.make<ErrorStmt>(start);
+    }
+    return stmt;
+}
+
+// 按开头的关键字分派到各语句的解析方法
+Stmt* Parser::statement() {
+    // 检查特定类型的声明
+    if (match(TokenType::IMPORT) || match(TokenType::ZH_IMPORT)) {
+        return importStatement();
+    }
+    if (match(TokenType::SET) || match(TokenType::ZH_SET)) {
+        return setStatement();
+    }
+    if (match(TokenType::PRINT) || match(TokenType::ZH_PRINT)) {
+        return printStatement();
+    }
+    if (match(TokenType::IF) || match(TokenType::ZH_IF)) {
+        return ifStatement();
+    }
+    if (match(TokenType::LOOP) || match(TokenType::ZH_LOOP)) {
+        return loopStatement();
+    }
+    if (match(TokenType::DEFINE) || match(TokenType::ZH_DEFINE)) {
+        return defineStatement();
+    }
+    if (match(TokenType::RETURN) || match(TokenType::ZH_RETURN)) {
+        return returnStatement();
+    }
+    if (match(TokenType::TRY) || match(TokenType::ZH_TRY)) {
+        return tryStatement();
+    }
+    if (match(TokenType::ENUM) || match(TokenType::ZH_ENUM)) {
+        return enumDefinition();
+    }
+    if (match(TokenType::JILU) || match(TokenType::ZH_JILU)) {
+        return recordDefinition();
+    }
+    
+    // 其他情况当作表达式语句处理
+    return expressionStatement();
+}
+
 // 导入语句
-std::unique_ptr<Stmt> Parser::importStatement() {
+Stmt* Parser::importStatement() {
     // 解析模块名
     Token module = consume(TokenType::IDENTIFIER, "期望是模块名称.");
+    if (panicMode_) return nullptr;
     // 可选的别名
     Token alias;
-    if (match(TokenType::IDENTIFIER) && previous().getValue() == "as") {
+    if (match(TokenType::IDENTIFIER) && previous().getSymbol() == asSymbol()) {
         alias = consume(TokenType::IDENTIFIER, "期望是模块别名.");
+        if (panicMode_) return nullptr;
     }
-    return std::make_unique<ImportStmt>(module, alias);
+    return arena_.make<ImportStmt>(module, alias);
 }
 
 // 设置变量语句
-std::unique_ptr<Stmt> Parser::setStatement() {
+Stmt* Parser::setStatement() {
     Token name = consume(TokenType::IDENTIFIER, "期望是变量名.");
+    if (panicMode_) return nullptr;
     
     // 可选的类型声明
     Token type;
     if (match(TokenType::COLON)) {
         type = consume(TokenType::IDENTIFIER, "期望是类型名.");
+        if (panicMode_) return nullptr;
     }
     
     consume(TokenType::EQUAL, "期望是'=='.");
+    if (panicMode_) return nullptr;
     if (check(TokenType::EQUAL)) {
         advance(); // 支持 "==" 作为赋值符号
     }
     
     auto value = expression();
-    return std::make_unique<SetStmt>(name, std::move(value), type);
+    if (panicMode_) return nullptr;
+    return arena_.make<SetStmt>(name, value, type);
 }
 
 // 打印语句
-std::unique_ptr<Stmt> Parser::printStatement() {
+Stmt* Parser::printStatement() {
     consume(TokenType::LEFT_PAREN, "期望是'('.");
+    if (panicMode_) return nullptr;
     auto value = expression();
+    if (panicMode_) return nullptr;
     consume(TokenType::RIGHT_PAREN, "期望是')'.");
-    return std::make_unique<PrintStmt>(std::move(value));
+    if (panicMode_) return nullptr;
+    return arena_.make<PrintStmt>(value);
 }
 
 // 表达式语句
-std::unique_ptr<Stmt> Parser::expressionStatement() {
+Stmt* Parser::expressionStatement() {
     auto expr = expression();
-    return std::make_unique<ExpressionStmt>(std::move(expr));
+    if (panicMode_) return nullptr;
+    return arena_.make<ExpressionStmt>(expr);
 }
 
 // 表达式解析
-std::unique_ptr<Expr> Parser::expression() {
-    return assignment();
-}
-
-// 赋值表达式
-std::unique_ptr<Expr> Parser::assignment() {
-    auto expr = logicalOr();
+Expr* Parser::expression() {
+    NestingScope nesting(depth_);
+    if (tooDeep()) return nullptr;
+    
+    Expr* expr = parsePrecedence(Precedence::OR);
+    if (panicMode_) return nullptr;
     
+    // 赋值的优先级最低且右结合，单独处理
     if (match(TokenType::EQUAL)) {
         Token equals = previous();
-        auto value = assignment();
+        Expr* value = expression();
+        if (panicMode_) return nullptr;
         
         // 确保左边是一个可赋值的目标
-        if (expr->getType() == ExprType::VARIABLE) {
-            return std::make_unique<AssignmentExpr>(std::move(expr), equals, std::move(value));
-        } else if (expr->getType() == ExprType::ARRAY_ACCESS || expr->getType() == ExprType::RECORD_ACCESS) {
-            return std::make_unique<AssignmentExpr>(std::move(expr), equals, std::move(value));
+        if (expr->getType() == ExprType::VARIABLE ||
+            expr->getType() == ExprType::ARRAY_ACCESS ||
+            expr->getType() == ExprType::RECORD_ACCESS) {
+            return arena_.make<AssignmentExpr>(expr, equals, value);
         }
         
-        error(equals, "无效的赋值目标.");
-    }
-    
-    return expr;
-}
-
-// 逻辑或
-std::unique_ptr<Expr> Parser::logicalOr() {
-    auto expr = logicalAnd();
-    
-    while (match(TokenType::OR)) {
-        Token op = previous();
-        auto right = logicalAnd();
-        expr = std::make_unique<BinaryExpr>(std::move(expr), op, std::move(right));
-    }
-    
-    return expr;
-}
-
-// 逻辑与
-std::unique_ptr<Expr> Parser::logicalAnd() {
-    auto expr = equality();
-    
-    while (match(TokenType::AND)) {
-        Token op = previous();
-        auto right = equality();
-        expr = std::make_unique<BinaryExpr>(std::move(expr), op, std::move(right));
+        // 只报告错误，不影响后续解析
+        errorAt(equals, "无效的赋值目标.");
     }
     
     return expr;
 }
 
-// 相等性比较
-std::unique_ptr<Expr> Parser::equality() {
-    auto expr = comparison();
+// 按优先级解析表达式（Pratt分析）
+// 先解析前缀部分，然后只要下一个中缀/后缀操作符的优先级不低于minPrecedence
+// 就把它并入左操作数。二元操作符左结合，右操作数按高一级的优先级解析。
+Expr* Parser::parsePrecedence(Precedence minPrecedence) {
+    Expr* expr = prefix();
+    if (panicMode_) return nullptr;
     
-    while (match({TokenType::EQUAL, TokenType::NOT_EQUAL})) {
-        Token op = previous();
-        auto right = comparison();
-        expr = std::make_unique<BinaryExpr>(std::move(expr), op, std::move(right));
-    }
-    
-    return expr;
-}
-
-// 比较
-std::unique_ptr<Expr> Parser::comparison() {
-    auto expr = term();
-    
-    while (match({TokenType::LESS, TokenType::LESS_EQUAL, TokenType::GREATER, TokenType::GREATER_EQUAL})) {
-        Token op = previous();
-        auto right = term();
-        expr = std::make_unique<BinaryExpr>(std::move(expr), op, std::move(right));
-    }
-    
-    return expr;
-}
-
-// 加减法
-std::unique_ptr<Expr> Parser::term() {
-    auto expr = factor();
-    
-    while (match({TokenType::PLUS, TokenType::MINUS})) {
-        Token op = previous();
-        auto right = factor();
-        expr = std::make_unique<BinaryExpr>(std::move(expr), op, std::move(right));
+    while (true) {
+        Precedence precedence = infixPrecedence(tokens_->type(current_));
+        if (precedence == Precedence::NONE || precedence < minPrecedence) {
+            break;
+        }
+        
+        Token op = advance();
+        switch (op.getType()) {
+            case TokenType::LEFT_PAREN:
+                expr = finishCall(expr);
+                if (panicMode_) return nullptr;
+                break;
+            case TokenType::DOT: {
+                Token name = consume(TokenType::IDENTIFIER, "期望是属性名.");
+                if (panicMode_) return nullptr;
+                expr = arena_.make<RecordAccessExpr>(expr, name);
+                break;
+            }
+            case TokenType::LEFT_BRACKET: {
+                Expr* index = expression();
+                if (panicMode_) return nullptr;
+                Token bracket = consume(TokenType::RIGHT_BRACKET, "期望是']'.");
+                if (panicMode_) return nullptr;
+                expr = arena_.make<ArrayAccessExpr>(expr, index, bracket);
+                break;
+            }
+            default: {
+                Expr* right = parsePrecedence(nextPrecedence(precedence));
+                if (panicMode_) return nullptr;
+                expr = arena_.make<BinaryExpr>(expr, op, right);
+                break;
+            }
+        }
     }
     
     return expr;
 }
 
-// 乘除法和取模
-std::unique_ptr<Expr> Parser::factor() {
-    auto expr = unary();
-    
-    while (match({TokenType::STAR, TokenType::SLASH, TokenType::PERCENT})) {
-        Token op = previous();
-        auto right = unary();
-        expr = std::make_unique<BinaryExpr>(std::move(expr), op, std::move(right));
+// 前缀部分：一元操作或基本表达式
+// 连续的一元操作符先全部读入，解析完操作数后从内向外构造，不为每个操作符递归一层
+Expr* Parser::prefix() {
+    if (!check(TokenType::MINUS) && !check(TokenType::NOT)) {
+        return primary();
     }
     
-    return expr;
-}
-
-// 一元操作
-std::unique_ptr<Expr> Parser::unary() {
-    if (match({TokenType::MINUS, TokenType::NOT})) {
-        Token op = previous();
-        auto right = unary();
-        return std::make_unique<UnaryExpr>(op, std::move(right));
+    ScratchList<Token> operators(tokenScratch_);
+    while (check(TokenType::MINUS) || check(TokenType::NOT)) {
+        operators.push(advance());
     }
     
-    return call();
-}
-
-// 函数调用
-std::unique_ptr<Expr> Parser::call() {
-    auto expr = primary();
+    // 一元操作符的操作数只能再带后缀操作（调用、字段、下标）
+    Expr* expr = parsePrecedence(Precedence::UNARY);
+    if (panicMode_) return nullptr;
     
-    while (true) {
-        if (match(TokenType::LEFT_PAREN)) {
-            expr = finishCall(std::move(expr));
-        } else if (match(TokenType::DOT)) {
-            Token name = consume(TokenType::IDENTIFIER, "期望是属性名.");
-            expr = std::make_unique<RecordAccessExpr>(std::move(expr), name);
-        } else if (match(TokenType::LEFT_BRACKET)) {
-            auto index = expression();
-            Token bracket = consume(TokenType::RIGHT_BRACKET, "期望是']'.");
-            expr = std::make_unique<ArrayAccessExpr>(std::move(expr), std::move(index), bracket);
-        } else {
-            break;
-        }
+    for (size_t i = operators.size(); i-- > 0;) {
+        expr = arena_.make<UnaryExpr>(operators[i], expr);
     }
-    
     return expr;
 }
 
 // 完成函数调用解析
-std::unique_ptr<Expr> Parser::finishCall(std::unique_ptr<Expr> callee) {
-    std::vector<std::unique_ptr<Expr>> arguments;
+Expr* Parser::finishCall(Expr* callee) {
+    ScratchList<Expr*> arguments(exprScratch_);
     
     if (!check(TokenType::RIGHT_PAREN)) {
         do {
-            arguments.push_back(expression());
+            arguments.push(expression());
+            if (panicMode_) return nullptr;
         } while (match(TokenType::COMMA));
     }
     
     Token paren = consume(TokenType::RIGHT_PAREN, "期望是')'.");
+    if (panicMode_) return nullptr;
     
-    return std::make_unique<CallExpr>(std::move(callee), paren, std::move(arguments));
+    return arena_.make<CallExpr>(callee, paren, arguments.finish(arena_));
 }
 
 // 基本表达式
-std::unique_ptr<Expr> Parser::primary() {
+Expr* Parser::primary() {
     if (match(TokenType::BOOL_LITERAL)) {
-        return std::make_unique<LiteralExpr>(previous());
+        return arena_.make<LiteralExpr>(previous());
     }
     
     if (match(TokenType::NUMBER_LITERAL)) {
-        return std::make_unique<LiteralExpr>(previous());
+        return arena_.make<LiteralExpr>(previous());
     }
     
     if (match(TokenType::STRING_LITERAL)) {
-        return std::make_unique<LiteralExpr>(previous());
+        return arena_.make<LiteralExpr>(previous());
     }
     
     if (match(TokenType::IDENTIFIER)) {
-        return std::make_unique<VariableExpr>(previous());
+        return arena_.make<VariableExpr>(previous());
     }
     
     if (match(TokenType::LEFT_PAREN)) {
         auto expr = expression();
+        if (panicMode_) return nullptr;
         consume(TokenType::RIGHT_PAREN, "期望是')'.");
+        if (panicMode_) return nullptr;
         return expr;
     }
     
-    throw error(peek(), "期望是表达式.");
+    // 用占位节点代替，不消费token，由外层继续解析
+    errorAt(peek(), "期望是表达式.");
+    return arena_.make<ErrorExpr>(peek());
 }
 
 // 辅助方法
@@ -302,7 +572,7 @@ bool Parser::match(TokenType type) {
     return false;
 }
 
-bool Parser::match(const std::vector<TokenType>& types) {
+bool Parser::match(std::initializer_list<TokenType> types) {
     for (TokenType type : types) {
         if (check(type)) {
             advance();
@@ -313,310 +583,407 @@ bool Parser::match(const std::vector<TokenType>& types) {
 }
 
 bool Parser::check(TokenType type) const {
-    return current_.getType() == type;
+    return tokens_->type(current_) == type;
 }
 
 Token Parser::advance() {
-    Token previous = current_;
     previous_ = current_;  // 保存当前token为上一个token
-    current_ = lexer_.getNextToken();
-    return previous;
+    // 停在END_OF_FILE上，之后的advance()都返回它
+    TokenType type = tokens_->type(current_);
+    if (type != TokenType::END_OF_FILE) {
+        if (type == TokenType::LEFT_BRACE) {
+            braceDepth_++;
+        } else if (type == TokenType::RIGHT_BRACE && braceDepth_ > 0) {
+            braceDepth_--;
+        }
+        
+        current_++;
+        if (current_ == tokens_->size() && (ring_ || lexer_)) {
+            refill();
+        }
+    }
+    return tokens_->get(previous_);
+}
+
+// 流式/按需模式下窗口用完时从环形缓冲区或词法分析器补充，保留上一个token供previous()使用
+void Parser::refill() {
+    Token last = window_.get(previous_);
+    window_.clear();
+    window_.push(last);
+    if (ring_) {
+        ring_->popBatch(window_, RING_BATCH_SIZE);
+    } else {
+        lexer_->tokenizeBatch(window_, LEXER_BATCH_SIZE);
+    }
+    
+    previous_ = 0;
+    current_ = 1;
 }
 
 Token Parser::peek() const {
-    return current_;
+    return tokens_->get(current_);
 }
 
 Token Parser::previous() const {
-    return previous_;  // 返回存储的上一个token
+    return tokens_->get(previous_);
 }
 
-Token Parser::consume(TokenType type, const std::string& message) {
+// 期望当前token是type并消费它
+// 不是时报告错误并进入恐慌模式，返回的token没有意义，调用者应检查panicMode_后返回
+Token Parser::consume(TokenType type, const char* message) {
     if (check(type)) {
         return advance();
     }
     
-    addError(current_, message);
-    throw ParseError(message);
+    errorAtCurrent(message);
+    return peek();
 }
 
 // 新增支持多种类型的consume方法
-Token Parser::consume(const std::vector<TokenType>& types, const std::string& message) {
+Token Parser::consume(std::initializer_list<TokenType> types, const char* message) {
     for (TokenType type : types) {
         if (check(type)) {
             return advance();
         }
     }
     
-    addError(current_, message);
-    throw ParseError(message);
+    errorAtCurrent(message);
+    return peek();
 }
 
-ParseError Parser::error(const Token& token, const std::string& message) {
-    addError(token, message);
-    return ParseError(message);
+// 报告错误，同一个token上只报告第一个错误，避免连锁错误
+void Parser::errorAt(const Token& token, const char* message) {
+    if (!diagnostics_.empty() && diagnostics_.back().token.getOffset() == token.getOffset()) {
+        return;
+    }
+    diagnostics_.report(token, message);
 }
 
-void Parser::synchronize() {
+// 在当前token处报告错误并进入恐慌模式
+void Parser::errorAtCurrent(const char* message) {
+    errorAt(peek(), message);
+    panicMode_ = true;
+}
+
+// 嵌套层数超过上限时报告错误并进入恐慌模式
+bool Parser::tooDeep() {
+    if (depth_ <= maxDepth_) {
+        return false;
+    }
+    errorAtCurrent("嵌套层数过多.");
+    return true;
+}
+
+// 跳过出错语句的剩余部分，停在花括号层数为depth的下一条语句开头，
+// 或者交给外层语句块处理的右花括号上。出错位置内层的花括号整体跳过。
+void Parser::synchronize(size_t depth) {
     panicMode_ = false;
     
     while (!check(TokenType::END_OF_FILE)) {
-        // 同步到语句的开始
-        if (check(TokenType::IMPORT) || check(TokenType::ZH_IMPORT) ||
-            check(TokenType::SET) || check(TokenType::ZH_SET) ||
-            check(TokenType::PRINT) || check(TokenType::ZH_PRINT) ||
-            check(TokenType::IF) || check(TokenType::ZH_IF) ||
-            check(TokenType::LOOP) || check(TokenType::ZH_LOOP) ||
-            check(TokenType::DEFINE) || check(TokenType::ZH_DEFINE) ||
-            check(TokenType::RETURN) || check(TokenType::ZH_RETURN) ||
-            check(TokenType::TRY) || check(TokenType::ZH_TRY) ||
-            check(TokenType::ENUM) || check(TokenType::ZH_ENUM) ||
-            check(TokenType::JILU) || check(TokenType::ZH_JILU)) {
-            return;
+        if (braceDepth_ == depth) {
+            // 同步到语句的开始
+            if (isStatementStart(tokens_->type(current_))) {
+                return;
+            }
+            if (depth > 0 && check(TokenType::RIGHT_BRACE)) {
+                return;
+            }
         }
         
         advance();
     }
 }
 
-void Parser::addError(const std::string& message) {
-    errors_.push_back(message);
-}
-
-void Parser::addError(const Token& token, const std::string& message) {
-    std::string errorMsg;
-    if (token.getType() == TokenType::END_OF_FILE) {
-        errorMsg = token.getLocation().toString() + " 文件结束: " + message;
-    } else {
-        errorMsg = token.getLocation().toString() + " 在 '" + token.getValue() + "': " + message;
+// 是否是语句开头的关键字
+bool Parser::isStatementStart(TokenType type) const {
+    switch (type) {
+        case TokenType::IMPORT: case TokenType::ZH_IMPORT:
+        case TokenType::SET: case TokenType::ZH_SET:
+        case TokenType::PRINT: case TokenType::ZH_PRINT:
+        case TokenType::IF: case TokenType::ZH_IF:
+        case TokenType::LOOP: case TokenType::ZH_LOOP:
+        case TokenType::DEFINE: case TokenType::ZH_DEFINE:
+        case TokenType::RETURN: case TokenType::ZH_RETURN:
+        case TokenType::TRY: case TokenType::ZH_TRY:
+        case TokenType::ENUM: case TokenType::ZH_ENUM:
+        case TokenType::JILU: case TokenType::ZH_JILU:
+            return true;
+        default:
+            return false;
     }
-    errors_.push_back(errorMsg);
 }
 
 // 还需要实现其他语句解析方法，如ifStatement、loopStatement等
-std::unique_ptr<Stmt> Parser::ifStatement() {
+Stmt* Parser::ifStatement() {
     // 解析条件
     consume(TokenType::LEFT_PAREN, "期望是'('.");
+    if (panicMode_) return nullptr;
     auto condition = expression();
+    if (panicMode_) return nullptr;
     consume(TokenType::RIGHT_PAREN, "期望是')'.");
+    if (panicMode_) return nullptr;
     
     // 解析if块
     consume(TokenType::LEFT_BRACE, "期望是'{'.");
+    if (panicMode_) return nullptr;
     auto ifBody = block();
-    auto* blockStmt = static_cast<BlockStmt*>(ifBody.get());
+    if (panicMode_) return nullptr;
     
     // 创建分支数组
     std::vector<Branch> branches;
-    branches.push_back(Branch(std::move(condition), std::move(blockStmt->statements)));
+    branches.push_back(Branch(condition, ifBody));
     
     // 解析elif块
     while (match({TokenType::ELIF, TokenType::ZH_ELIF})) {
         consume(TokenType::LEFT_PAREN, "期望是'('.");
+        if (panicMode_) return nullptr;
         auto elifCondition = expression();
+        if (panicMode_) return nullptr;
         consume(TokenType::RIGHT_PAREN, "期望是')'.");
+        if (panicMode_) return nullptr;
         
         consume(TokenType::LEFT_BRACE, "期望是'{'.");
+        if (panicMode_) return nullptr;
         auto elifBody = block();
-        auto* elifBlockStmt = static_cast<BlockStmt*>(elifBody.get());
+        if (panicMode_) return nullptr;
         
-        branches.push_back(Branch(std::move(elifCondition), std::move(elifBlockStmt->statements)));
+        branches.push_back(Branch(elifCondition, elifBody));
     }
     
     // 解析else块
     if (match({TokenType::ELSE, TokenType::ZH_ELSE})) {
         consume(TokenType::LEFT_BRACE, "期望是'{'.");
+        if (panicMode_) return nullptr;
         auto elseBody = block();
-        auto* elseBlockStmt = static_cast<BlockStmt*>(elseBody.get());
+        if (panicMode_) return nullptr;
         
         // else块的条件为null
-        branches.push_back(Branch(nullptr, std::move(elseBlockStmt->statements)));
+        branches.push_back(Branch(nullptr, elseBody));
     }
     
-    return std::make_unique<IfStmt>(std::move(branches));
+    return arena_.make<IfStmt>(arena_.copyList(branches.data(), branches.size()));
 }
 
-std::unique_ptr<Stmt> Parser::loopStatement() {
+Stmt* Parser::loopStatement() {
     // 检查是否有as关键字
     bool hasIterator = false;
     Token iterVar;
     
-    if (match(TokenType::IDENTIFIER) && previous().getValue() == "as") {
+    if (match(TokenType::IDENTIFIER) && previous().getSymbol() == asSymbol()) {
         hasIterator = true;
         iterVar = consume(TokenType::IDENTIFIER, "期望是迭代变量名.");
+        if (panicMode_) return nullptr;
     }
     
     // 获取循环计数表达式
     auto countExpr = expression();
+    if (panicMode_) return nullptr;
     
     // 解析循环体
     consume(TokenType::LEFT_BRACE, "期望是'{'.");
+    if (panicMode_) return nullptr;
     auto loopBody = block();
-    auto* blockStmt = static_cast<BlockStmt*>(loopBody.get());
+    if (panicMode_) return nullptr;
     
     if (hasIterator) {
-        return std::make_unique<LoopStmt>(iterVar, std::move(countExpr), std::move(blockStmt->statements));
+        return arena_.make<LoopStmt>(iterVar, countExpr, loopBody);
     } else {
         // 使用空的iterator
-        return std::make_unique<LoopStmt>(Token(), std::move(countExpr), std::move(blockStmt->statements));
+        return arena_.make<LoopStmt>(Token(), countExpr, loopBody);
     }
 }
 
-std::unique_ptr<Stmt> Parser::block() {
-    std::vector<std::unique_ptr<Stmt>> statements;
+// 语句块，左花括号已被消费，返回块内的语句列表
+NodeList<Stmt*> Parser::block() {
+    NestingScope nesting(depth_);
+    if (tooDeep()) return NodeList<Stmt*>();
+    
+    ScratchList<Stmt*> statements(stmtScratch_);
     
     while (!check(TokenType::RIGHT_BRACE) && !check(TokenType::END_OF_FILE)) {
-        statements.push_back(declaration());
+        statements.push(declaration());
     }
     
     consume(TokenType::RIGHT_BRACE, "期望是'}'.");
     
-    return std::make_unique<BlockStmt>(std::move(statements));
+    return statements.finish(arena_);
 }
 
 // 函数定义
-std::unique_ptr<Stmt> Parser::defineStatement() {
+Stmt* Parser::defineStatement() {
     // 解析函数名
     Token name = consume(TokenType::IDENTIFIER, "期望是函数名.");
+    if (panicMode_) return nullptr;
     
     // 解析参数列表
     consume(TokenType::LEFT_PAREN, "期望是'('.");
+    if (panicMode_) return nullptr;
     std::vector<Token> parameters;
     
     if (!check(TokenType::RIGHT_PAREN)) {
         do {
             parameters.push_back(consume(TokenType::IDENTIFIER, "期望是参数名."));
+            if (panicMode_) return nullptr;
         } while (match(TokenType::COMMA));
     }
     
     consume(TokenType::RIGHT_PAREN, "期望是')'.");
+    if (panicMode_) return nullptr;
     
     // 解析函数体
     consume(TokenType::LEFT_BRACE, "期望是'{'.");
-    auto functionBody = block();
-    auto* blockStmt = static_cast<BlockStmt*>(functionBody.get());
+    if (panicMode_) return nullptr;
+    auto* stmt = arena_.make<DefineStmt>(name, arena_.copyList(parameters.data(), parameters.size()),
+                                         NodeList<Stmt*>());
+    
+    // 并行解析时顶层函数体留给线程池
+    if (!deferBody(stmt)) {
+        stmt->body = block();
+        if (panicMode_) return nullptr;
+    }
     
-    return std::make_unique<DefineStmt>(name, std::move(parameters), std::move(blockStmt->statements));
+    return stmt;
 }
 
 // 返回语句
-std::unique_ptr<Stmt> Parser::returnStatement() {
+Stmt* Parser::returnStatement() {
     Token keyword = previous();
-    std::unique_ptr<Expr> value = nullptr;
+    Expr* value = nullptr;
     
     // 解析返回值(如果有)
     if (!check(TokenType::RIGHT_BRACE)) {
         value = expression();
+        if (panicMode_) return nullptr;
     }
     
-    return std::make_unique<ReturnStmt>(keyword, std::move(value));
+    return arena_.make<ReturnStmt>(keyword, value);
 }
 
 // 数组语句
-std::unique_ptr<Stmt> Parser::arrayStatement() {
+Stmt* Parser::arrayStatement() {
     Token name = consume(TokenType::IDENTIFIER, "期望是数组名.");
+    if (panicMode_) return nullptr;
     
     // 可选的元素类型
     Token elementType;
     if (match(TokenType::COLON)) {
         elementType = consume(TokenType::IDENTIFIER, "期望是类型名.");
+        if (panicMode_) return nullptr;
     }
     
     // 解析数组内容
-    std::vector<std::unique_ptr<Expr>> elements;
+    ScratchList<Expr*> elements(exprScratch_);
     
     consume(TokenType::LEFT_BRACKET, "期望是'['.");
+    if (panicMode_) return nullptr;
     
     if (!check(TokenType::RIGHT_BRACKET)) {
         do {
-            elements.push_back(expression());
+            elements.push(expression());
+            if (panicMode_) return nullptr;
         } while (match(TokenType::COMMA));
     }
     
     consume(TokenType::RIGHT_BRACKET, "期望是']'.");
+    if (panicMode_) return nullptr;
     
-    return std::make_unique<ArrayStmt>(name, elementType, std::move(elements));
+    return arena_.make<ArrayStmt>(name, elementType, elements.finish(arena_));
 }
 
 // 记录定义
-std::unique_ptr<Stmt> Parser::recordDefinition() {
+Stmt* Parser::recordDefinition() {
     Token name = consume(TokenType::IDENTIFIER, "期望是记录类型名.");
+    if (panicMode_) return nullptr;
     
     // 解析字段列表
     consume(TokenType::LEFT_BRACE, "期望是'{'.");
+    if (panicMode_) return nullptr;
     
     std::vector<FieldDefinition> fields;
     
     while (!check(TokenType::RIGHT_BRACE) && !check(TokenType::END_OF_FILE)) {
         Token fieldName = consume(TokenType::IDENTIFIER, "期望是字段名.");
+        if (panicMode_) return nullptr;
         
         // 字段类型(可选)
         Token fieldType;
         if (match(TokenType::COLON)) {
             fieldType = consume(TokenType::IDENTIFIER, "期望是类型名.");
+            if (panicMode_) return nullptr;
         }
         
         fields.push_back(FieldDefinition(fieldName, fieldType));
     }
     
     consume(TokenType::RIGHT_BRACE, "期望是'}'.");
+    if (panicMode_) return nullptr;
     
-    return std::make_unique<RecordDefStmt>(name, std::move(fields));
+    return arena_.make<RecordDefStmt>(name, arena_.copyList(fields.data(), fields.size()));
 }
 
 // 枚举定义
-std::unique_ptr<Stmt> Parser::enumDefinition() {
+Stmt* Parser::enumDefinition() {
     Token name = consume(TokenType::IDENTIFIER, "期望是枚举类型名.");
+    if (panicMode_) return nullptr;
     
     // 解析枚举值列表
     consume(TokenType::LEFT_BRACE, "期望是'{'.");
+    if (panicMode_) return nullptr;
     
     std::vector<Token> values;
     
     while (!check(TokenType::RIGHT_BRACE) && !check(TokenType::END_OF_FILE)) {
         values.push_back(consume(TokenType::IDENTIFIER, "期望是枚举值名."));
+        if (panicMode_) return nullptr;
     }
     
     consume(TokenType::RIGHT_BRACE, "期望是'}'.");
+    if (panicMode_) return nullptr;
     
-    return std::make_unique<EnumDefStmt>(name, std::move(values));
+    return arena_.make<EnumDefStmt>(name, arena_.copyList(values.data(), values.size()));
 }
 
 // try-catch语句
-std::unique_ptr<Stmt> Parser::tryStatement() {
+Stmt* Parser::tryStatement() {
     // 解析try块
     consume(TokenType::LEFT_BRACE, "期望是'{'.");
+    if (panicMode_) return nullptr;
     auto tryBlock = block();
-    auto* tryBlockStmt = static_cast<BlockStmt*>(tryBlock.get());
+    if (panicMode_) return nullptr;
     
     // 解析catch块
     consume({TokenType::CATCH, TokenType::ZH_CATCH}, "期望是'catch'或'捕获'.");
+    if (panicMode_) return nullptr;
     
     // 捕获的异常类型(可选)
     // 注意：当前TryCatchStmt不支持存储异常类型信息，我们只解析但不使用它
     if (match(TokenType::LEFT_PAREN)) {
-        Token exceptionType = consume(TokenType::IDENTIFIER, "期望是异常类型.");
+        consume(TokenType::IDENTIFIER, "期望是异常类型.");
+        if (panicMode_) return nullptr;
         consume(TokenType::RIGHT_PAREN, "期望是')'.");
-        // 这里不保存exceptionType，因为TryCatchStmt没有相应的字段
+        if (panicMode_) return nullptr;
+        // 这里不保存异常类型，因为TryCatchStmt没有相应的字段
     }
     
     consume(TokenType::LEFT_BRACE, "期望是'{'.");
+    if (panicMode_) return nullptr;
     auto catchBlock = block();
-    auto* catchBlockStmt = static_cast<BlockStmt*>(catchBlock.get());
+    if (panicMode_) return nullptr;
     
-    return std::make_unique<TryCatchStmt>(
-        std::move(tryBlockStmt->statements), 
-        std::move(catchBlockStmt->statements)
-    );
+    return arena_.make<TryCatchStmt>(tryBlock, catchBlock);
 }
 
 // dakai语句
-std::unique_ptr<Stmt> Parser::dakaiStatement() {
+Stmt* Parser::dakaiStatement() {
     // 解析路径表达式
     consume(TokenType::LEFT_PAREN, "期望是'('.");
+    if (panicMode_) return nullptr;
     auto path = expression();
+    if (panicMode_) return nullptr;
     consume(TokenType::RIGHT_PAREN, "期望是')'.");
+    if (panicMode_) return nullptr;
     
-    return std::make_unique<DakaiStmt>(std::move(path));
+    return arena_.make<DakaiStmt>(path);
 }
 
 } // namespace jvav 
\ No newline at end of file
@@ -0,0 +1,318 @@
+#include "parser/SyntaxTree.h"
+#include "parser/Parser.h"
+#include "lexer/Lexer.h"
+#include "lexer/FileTable.h"
+#include "ast/NodeWalker.h"
+#include <algorithm>
+
+namespace jvav {
+
+namespace {
+
+// 词法分析器判断一个token在哪里结束时，最多会查看其后的这么多字节（一个UTF-8字符）
+constexpr size_t LEXER_LOOKAHEAD = 4;
+
+// 源代码缓冲区至少额外预留的字节数
+constexpr size_t INITIAL_SLACK = 4096;
+
+// 把复用的语句平移到修改后的位置
+// token的偏移和指向源代码的字面量文本都加上delta，指向arena的字面量文本保持不变
+class OffsetShifter {
+public:
+    OffsetShifter(FileId file, int64_t delta, std::string_view source)
+        : file_(file), delta_(delta), source_(source) {}
+
+    void shift(Token& token) const {
+        // 可选的token（如省略的类型）是默认构造的，不属于任何文件
+        if (token.getFile() != file_) {
+            return;
+        }
+        token = Token(token.getType(), file_, static_cast<uint32_t>(token.getOffset() + delta_),
+                      token.getLength(), token.getSymbol());
+    }
+
+    void shift(std::string_view& text) const {
+        const char* begin = source_.data();
+        if (text.data() < begin || text.data() >= begin + source_.size()) {
+            return;
+        }
+        text = std::string_view(text.data() + delta_, text.size());
+    }
+
+    void shift(NodeList<Token>& tokens) const {
+        for (Token& token : tokens) {
+            shift(token);
+        }
+    }
+
+    // 平移节点自身的字段，子节点由NodeWalker逐个访问
+    void shiftFields(Expr* expr) const {
+        switch (expr->getType()) {
+            case ExprType::LITERAL: {
+                auto* literal = static_cast<LiteralExpr*>(expr);
+                shift(literal->token);
+                shift(literal->value);
+                break;
+            }
+            case ExprType::VARIABLE:
+                shift(static_cast<VariableExpr*>(expr)->name);
+                break;
+            case ExprType::UNARY:
+                shift(static_cast<UnaryExpr*>(expr)->op);
+                break;
+            case ExprType::BINARY:
+                shift(static_cast<BinaryExpr*>(expr)->op);
+                break;
+            case ExprType::CALL:
+                shift(static_cast<CallExpr*>(expr)->paren);
+                break;
+            case ExprType::ARRAY_ACCESS:
+                shift(static_cast<ArrayAccessExpr*>(expr)->bracket);
+                break;
+            case ExprType::RECORD_ACCESS:
+                shift(static_cast<RecordAccessExpr*>(expr)->field);
+                break;
+            case ExprType::ASSIGNMENT:
+                shift(static_cast<AssignmentExpr*>(expr)->op);
+                break;
+            case ExprType::ERROR:
+                shift(static_cast<ErrorExpr*>(expr)->token);
+                break;
+        }
+    }
+
+    void shiftFields(Stmt* stmt) const {
+        switch (stmt->getType()) {
+            case StmtType::IMPORT: {
+                auto* import = static_cast<ImportStmt*>(stmt);
+                shift(import->module);
+                shift(import->alias);
+                break;
+            }
+            case StmtType::SET: {
+                auto* set = static_cast<SetStmt*>(stmt);
+                shift(set->name);
+                shift(set->type);
+                break;
+            }
+            case StmtType::LOOP:
+                shift(static_cast<LoopStmt*>(stmt)->variable);
+                break;
+            case StmtType::DEFINE: {
+                auto* define = static_cast<DefineStmt*>(stmt);
+                shift(define->name);
+                shift(define->parameters);
+                break;
+            }
+            case StmtType::RETURN:
+                shift(static_cast<ReturnStmt*>(stmt)->keyword);
+                break;
+            case StmtType::ARRAY: {
+                auto* array = static_cast<ArrayStmt*>(stmt);
+                shift(array->name);
+                shift(array->elementType);
+                break;
+            }
+            case StmtType::RECORD_DEF: {
+                auto* record = static_cast<RecordDefStmt*>(stmt);
+                shift(record->name);
+                for (FieldDefinition& field : record->fields) {
+                    shift(field.name);
+                    shift(field.type);
+                }
+                break;
+            }
+            case StmtType::RECORD_ACCESS: {
+                auto* access = static_cast<RecordAccessStmt*>(stmt);
+                shift(access->record);
+                shift(access->field);
+                break;
+            }
+            case StmtType::ENUM_DEF: {
+                auto* enumDef = static_cast<EnumDefStmt*>(stmt);
+                shift(enumDef->name);
+                shift(enumDef->values);
+                break;
+            }
+            case StmtType::ERROR:
+                shift(static_cast<ErrorStmt*>(stmt)->token);
+                break;
+            case StmtType::EXPRESSION:
+            case StmtType::DAKAI:
+            case StmtType::PRINT:
+            case StmtType::IF:
+            case StmtType::TRY_CATCH:
+            case StmtType::BLOCK:
+                // 只有子节点
+                break;
+        }
+    }
+
+private:
+    FileId file_;
+    int64_t delta_;
+    std::string_view source_;  // 修改前源代码所在的范围
+};
+
+} // namespace
+
+// 构造函数
+SyntaxTree::SyntaxTree(const std::string& filename, std::string source)
+    : filename_(filename), source_(std::move(source)) {
+    // 预留一些空间，编辑时尽量不重新分配缓冲区
+    source_.reserve(source_.size() + source_.size() / 4 + INITIAL_SLACK);
+    fileId_ = FileTable::instance().addFile(filename_, source_);
+    parseAll();
+}
+
+// 析构函数
+SyntaxTree::~SyntaxTree() {
+    FileTable::instance().removeFile(fileId_);
+}
+
+// 完整解析
+void SyntaxTree::parseAll() {
+    program_.arena.reset();
+    statements_.clear();
+    starts_.clear();
+    firstDiagnostics_.clear();
+
+    Lexer lexer(source_, filename_, fileId_, 0);
+    Parser parser(lexer, program_.arena);
+    while (!parser.isAtEnd()) {
+        starts_.push_back(parser.currentOffset());
+        firstDiagnostics_.push_back(static_cast<uint32_t>(parser.getDiagnostics().size()));
+        statements_.push_back(parser.parseDeclaration());
+    }
+
+    diagnostics_ = parser.getDiagnostics();
+    fullParseBytes_ = program_.arena.bytesReserved();
+    reparsedCount_ = statements_.size();
+    updateProgram();
+}
+
+// 让语法树的语句列表指向当前的语句
+void SyntaxTree::updateProgram() {
+    program_.statements = NodeList<Stmt*>(statements_.data(), static_cast<uint32_t>(statements_.size()));
+}
+
+// 应用修改并增量更新
+bool SyntaxTree::applyEdit(const TextEdit& edit) {
+    if (edit.begin > edit.end || edit.end > source_.size()) {
+        return false;
+    }
+
+    // 就地修改源代码，修改位置之前的字面量文本仍然有效；
+    // 缓冲区重新分配时所有字面量都会失效，只能完整解析
+    const char* oldData = source_.data();
+    size_t oldSize = source_.size();
+    source_.replace(edit.begin, edit.end - edit.begin, edit.text);
+    FileTable::instance().updateText(fileId_, source_);
+
+    size_t limit = ARENA_GROWTH_LIMIT * std::max(fullParseBytes_, Arena::DEFAULT_SLAB_SIZE);
+    if (source_.data() != oldData || program_.arena.bytesReserved() > limit) {
+        parseAll();
+        return true;
+    }
+
+    int64_t delta = static_cast<int64_t>(edit.text.size()) -
+                    static_cast<int64_t>(edit.end - edit.begin);
+    size_t count = statements_.size();
+
+    // 从哪条语句开始重新解析
+    // 保留的语句在解析时会看到下一条语句的第一个token，词法分析器确定这个token在哪里结束时
+    // 又会查看它后面的几个字节，所以下一条语句之后还要再有一条语句的起点在修改位置之前，
+    // 并且相隔足够远，保留的语句和它们的错误才不会受修改影响
+    size_t before = 0;
+    if (edit.begin >= LEXER_LOOKAHEAD) {
+        before = static_cast<size_t>(std::upper_bound(starts_.begin(), starts_.end(),
+                                                      edit.begin - LEXER_LOOKAHEAD) - starts_.begin());
+    }
+    size_t first = before >= 2 ? before - 2 : 0;
+    size_t regionStart = first == 0 ? 0 : starts_[first];
+
+    // 可以复用的旧语句必须完全在修改范围之后
+    size_t candidate = static_cast<size_t>(std::lower_bound(starts_.begin(), starts_.end(),
+                                                            edit.end) - starts_.begin());
+
+    // 逐条解析新的语句，直到下一条语句恰好从某条可以复用的旧语句的新位置开始。
+    // 从那里起token和旧的完全相同，顶层语句之间解析器也没有其他状态，之后的解析结果必然相同。
+    // 出错的旧语句不复用：它的第一个错误可能因为与上一条语句的错误位置相同而被省略了。
+    Lexer lexer(source_, filename_, fileId_, regionStart);
+    Parser parser(lexer, program_.arena);
+    std::vector<Stmt*> statements;
+    std::vector<uint32_t> starts;
+    std::vector<uint32_t> firstDiagnostics;
+    size_t reused = count;
+    while (!parser.isAtEnd()) {
+        int64_t offset = parser.currentOffset();
+        while (candidate < count && starts_[candidate] + delta < offset) {
+            candidate++;
+        }
+        if (candidate < count && starts_[candidate] + delta == offset &&
+            statements_[candidate]->getType() != StmtType::ERROR) {
+            reused = candidate;
+            break;
+        }
+
+        starts.push_back(static_cast<uint32_t>(offset));
+        firstDiagnostics.push_back(static_cast<uint32_t>(parser.getDiagnostics().size()));
+        statements.push_back(parser.parseDeclaration());
+    }
+
+    // 拼接错误：保留的语句的错误、新解析的错误、复用的语句平移后的错误
+    // 新解析的第一个错误与保留的最后一个错误位置相同时省略，与完整解析时的规则一致
+    DiagnosticSink diagnostics;
+    size_t keptDiagnostics = first == 0 ? 0 : firstDiagnostics_[first];
+    for (size_t i = 0; i < keptDiagnostics; i++) {
+        diagnostics.report(diagnostics_[i].token, diagnostics_[i].message);
+    }
+
+    const DiagnosticSink& parsed = parser.getDiagnostics();
+    size_t skipped = 0;
+    if (!parsed.empty() && !diagnostics.empty() &&
+        parsed[0].token.getOffset() == diagnostics.back().token.getOffset()) {
+        skipped = 1;
+    }
+    for (size_t i = skipped; i < parsed.size(); i++) {
+        diagnostics.report(parsed[i].token, parsed[i].message);
+    }
+    for (uint32_t& index : firstDiagnostics) {
+        index = static_cast<uint32_t>(keptDiagnostics + (index > 0 ? index - skipped : 0));
+    }
+
+    OffsetShifter shifter(fileId_, delta, std::string_view(oldData, oldSize));
+    size_t reusedDiagnostics = reused < count ? firstDiagnostics_[reused] : diagnostics_.size();
+    int64_t diagnosticDelta = static_cast<int64_t>(diagnostics.size()) -
+                              static_cast<int64_t>(reusedDiagnostics);
+    for (size_t i = reusedDiagnostics; i < diagnostics_.size(); i++) {
+        Token token = diagnostics_[i].token;
+        shifter.shift(token);
+        diagnostics.report(token, diagnostics_[i].message);
+    }
+    diagnostics_ = std::move(diagnostics);
+
+    // 平移复用的语句，再把新解析的语句换进去
+    NodeList<Stmt*> reusedStatements(statements_.data() + reused, static_cast<uint32_t>(count - reused));
+    NodeWalker().walk(reusedStatements,
+                      [&shifter](Stmt* stmt) { shifter.shiftFields(stmt); },
+                      [&shifter](Expr* expr) { shifter.shiftFields(expr); });
+    for (size_t i = reused; i < count; i++) {
+        starts_[i] = static_cast<uint32_t>(starts_[i] + delta);
+        firstDiagnostics_[i] = static_cast<uint32_t>(firstDiagnostics_[i] + diagnosticDelta);
+    }
+
+    statements_.erase(statements_.begin() + first, statements_.begin() + reused);
+    statements_.insert(statements_.begin() + first, statements.begin(), statements.end());
+    starts_.erase(starts_.begin() + first, starts_.begin() + reused);
+    starts_.insert(starts_.begin() + first, starts.begin(), starts.end());
+    firstDiagnostics_.erase(firstDiagnostics_.begin() + first, firstDiagnostics_.begin() + reused);
+    firstDiagnostics_.insert(firstDiagnostics_.begin() + first,
+                             firstDiagnostics.begin(), firstDiagnostics.end());
+
+    reparsedCount_ = statements.size();
+    updateProgram();
+    return true;
+}
+
+} // namespace jvav
@@ -0,0 +1,606 @@
+// 程序输出测试
+// 按编译器的流程解析、优化源程序并降低为SSA中间表示，再用一个简单的解释器执行，
+// 把打印的内容与期望输出逐行比较。每个程序在各个优化级别上各跑一次，
+// 优化前后输出不同就说明某个优化遍改变了程序的语义。
+// 运行时陷入（除以0等）输出一行trap并停止执行。
+//
+// 源程序中以"# @"开头的注释是附加的检查，<级别>写作O2（只在-O2）、O2+（-O2及以上）或O0-1：
+//   # @stat <级别> <统计项> <比较> <数>   优化统计，比较为== >= <=，统计项见STATISTICS
+//   # @ir <级别> contains|lacks <文本>     优化后中间表示的文本形式中有或没有这段文本
+//   # @wat                                 另外用语法树后端生成WebAssembly文本，检查局部变量
+//                                          都在函数开头声明、不重复、引用的都已声明，
+//                                          再执行其中的$main并与期望输出比较
+//   # @wat <级别> contains|lacks <文本>    语法树后端生成的文本中有或没有这段文本，同样检查局部变量，
+//                                          但不执行
+//   # @no-ast                              不运行语法树上的优化，只用中间表示的优化遍，
+//                                          用来单独检查它们
+// 语法树后端只支持全局变量、循环、if和打印数字，不带级别的@wat只能用于这样的程序。
+// 用法: jvav_program_test <源文件> <期望输出文件> <优化级别>
+
+#include "codegen/CodeGenerator.h"
+#include "ir/IR.h"
+#include "ir/IRLowering.h"
+#include "lexer/Lexer.h"
+#include "optimizer/Optimizer.h"
+#include "parser/Parser.h"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// 调用深度上限，超过时按栈溢出陷入
+constexpr int MAX_CALL_DEPTH = 10000;
+
+// WebAssembly解释器执行的最大指令数
+constexpr size_t MAX_WAT_STEPS = 10000000;
+
+// 运行时陷入
+struct Trap {};
+
+// 可以检查的优化统计
+const std::pair<const char*, size_t jvav::OptimizationStats::*> STATISTICS[] = {
+    {"folded", &jvav::OptimizationStats::foldedExpressions},
+    {"propagated", &jvav::OptimizationStats::propagatedConstants},
+    {"removed", &jvav::OptimizationStats::removedStatements},
+    {"inlined", &jvav::OptimizationStats::inlinedCalls},
+    {"unrolled", &jvav::OptimizationStats::unrolledLoops},
+    {"hoisted", &jvav::OptimizationStats::hoistedExpressions},
+    {"reduced", &jvav::OptimizationStats::reducedMultiplications},
+    {"irConstants", &jvav::OptimizationStats::irConstants},
+    {"irRedundant", &jvav::OptimizationStats::irRedundantValues},
+    {"irHoisted", &jvav::OptimizationStats::irHoistedValues},
+    {"irDead", &jvav::OptimizationStats::irDeadValues},
+    {"irBlocks", &jvav::OptimizationStats::irRemovedBlocks},
+};
+
+// 中间表示解释器
+class Interpreter {
+public:
+    explicit Interpreter(const jvav::IRModule& module)
+        : module_(module), globals_(module.globals.size(), 0) {}
+
+    // 执行main，返回打印的各行
+    std::vector<std::string> run() {
+        try {
+            call(0, {}, 0);
+        } catch (const Trap&) {
+            output_.push_back("trap");
+        }
+        return output_;
+    }
+
+private:
+    int32_t call(uint32_t index, const std::vector<int32_t>& arguments, int depth);
+
+    const jvav::IRModule& module_;
+    std::vector<int32_t> globals_;
+    std::vector<std::string> output_;
+};
+
+int32_t Interpreter::call(uint32_t index, const std::vector<int32_t>& arguments, int depth) {
+    using jvav::IROpcode;
+    if (depth > MAX_CALL_DEPTH) {
+        throw Trap();
+    }
+
+    const jvav::IRFunction& function = module_.functions[index];
+    std::vector<int32_t> values(function.values.size(), 0);
+    jvav::BlockId block = 0;
+    jvav::BlockId previous = jvav::NO_BLOCK;
+    while (true) {
+        const jvav::BasicBlock& current = function.blocks[block];
+
+        // phi按进入的边同时取值
+        size_t i = 0;
+        std::vector<std::pair<jvav::ValueId, int32_t>> phis;
+        for (; i < current.instructions.size(); i++) {
+            jvav::ValueId value = current.instructions[i];
+            const jvav::Instruction& instruction = function.values[value];
+            if (instruction.op != IROpcode::PHI) {
+                break;
+            }
+            auto edge = std::find(current.predecessors.begin(), current.predecessors.end(), previous);
+            phis.emplace_back(value, values[instruction.operands[edge - current.predecessors.begin()]]);
+        }
+        for (const auto& [value, result] : phis) {
+            values[value] = result;
+        }
+
+        for (; i < current.instructions.size(); i++) {
+            jvav::ValueId value = current.instructions[i];
+            const jvav::Instruction& instruction = function.values[value];
+            int32_t a = instruction.operands.size() > 0 ? values[instruction.operands[0]] : 0;
+            int32_t b = instruction.operands.size() > 1 ? values[instruction.operands[1]] : 0;
+            switch (instruction.op) {
+                case IROpcode::CONST:
+                    values[value] = instruction.imm;
+                    break;
+                case IROpcode::PARAM:
+                    values[value] = arguments[instruction.imm];
+                    break;
+                case IROpcode::LOAD_GLOBAL:
+                    values[value] = globals_[instruction.imm];
+                    break;
+                case IROpcode::STORE_GLOBAL:
+                    globals_[instruction.imm] = a;
+                    break;
+                case IROpcode::CALL: {
+                    std::vector<int32_t> callArguments;
+                    for (jvav::ValueId operand : instruction.operands) {
+                        callArguments.push_back(values[operand]);
+                    }
+                    values[value] = call(static_cast<uint32_t>(instruction.imm), callArguments, depth + 1);
+                    break;
+                }
+                case IROpcode::PRINT:
+                    output_.push_back(std::to_string(a));
+                    break;
+                case IROpcode::PRINT_STRING:
+                    output_.push_back(module_.strings[instruction.imm]);
+                    break;
+                default:
+                    // 算术和比较与代码生成使用同一份计算，不能计算的就是运行时陷入
+                    if (!jvav::foldInstruction(instruction.op, a, b, values[value])) {
+                        throw Trap();
+                    }
+                    break;
+            }
+        }
+
+        switch (current.terminator) {
+            case jvav::Terminator::JUMP:
+                previous = block;
+                block = current.successors[0];
+                break;
+            case jvav::Terminator::BRANCH:
+                previous = block;
+                block = current.successors[values[current.operand] != 0 ? 0 : 1];
+                break;
+            default:
+                return values[current.operand];
+        }
+    }
+}
+
+// 语法树后端生成的WebAssembly文本，每行一条指令或一个结构的开头、结尾
+class WatProgram {
+public:
+    explicit WatProgram(const std::string& text);
+
+    // 检查局部变量的声明和引用，出错时返回false
+    bool validate(std::string& error) const;
+
+    // 执行$main，返回打印的各行；遇到不支持的指令时返回false
+    bool run(std::vector<std::string>& output, std::string& error) const;
+
+private:
+    // 第一个词
+    static std::string opcode(const std::string& line) { return line.substr(0, line.find(' ')); }
+
+    // 第二个词（变量名、标签等）
+    static std::string operand(const std::string& line);
+
+    std::vector<std::string> lines_;   // 去掉注释和首尾空白后的非空行
+    std::vector<size_t> match_;        // 结构开头对应的结尾行，结尾对应开头
+    bool balanced_ = true;
+};
+
+WatProgram::WatProgram(const std::string& text) {
+    std::istringstream in(text);
+    std::string line;
+    while (std::getline(in, line)) {
+        line = line.substr(0, line.find(";;"));
+        size_t begin = line.find_first_not_of(" \t\r");
+        size_t end = line.find_last_not_of(" \t\r");
+        if (begin != std::string::npos) {
+            lines_.push_back(line.substr(begin, end - begin + 1));
+        }
+    }
+
+    match_.assign(lines_.size(), 0);
+    std::vector<size_t> open;
+    for (size_t i = 0; i < lines_.size(); i++) {
+        int depth = 0;
+        for (char c : lines_[i]) {
+            depth += c == '(' ? 1 : c == ')' ? -1 : 0;
+        }
+        if (depth > 0) {
+            open.insert(open.end(), static_cast<size_t>(depth), i);
+        }
+        for (; depth < 0; depth++) {
+            if (open.empty()) {
+                balanced_ = false;
+                return;
+            }
+            match_[open.back()] = i;
+            match_[i] = open.back();
+            open.pop_back();
+        }
+    }
+    balanced_ = open.empty();
+}
+
+std::string WatProgram::operand(const std::string& line) {
+    size_t begin = line.find(' ');
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    begin = line.find_first_not_of(' ', begin);
+    size_t end = line.find_first_of(" )", begin);
+    return line.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+}
+
+bool WatProgram::validate(std::string& error) const {
+    if (!balanced_) {
+        error = "括号不配对";
+        return false;
+    }
+
+    // 嵌套的函数各自检查
+    struct Function {
+        std::set<std::string> names;
+        bool started = false;  // 已经出现过指令
+    };
+    std::vector<Function> functions;
+    std::vector<size_t> ends;
+    for (size_t i = 0; i < lines_.size(); i++) {
+        while (!ends.empty() && i > ends.back()) {
+            ends.pop_back();
+            functions.pop_back();
+        }
+        const std::string& line = lines_[i];
+        if (line.rfind("(func ", 0) == 0) {
+            if (!functions.empty()) {
+                functions.back().started = true;
+            }
+            Function function;
+            for (size_t p = line.find("(param $"); p != std::string::npos; p = line.find("(param $", p + 1)) {
+                function.names.insert(operand(line.substr(p + 1)));
+            }
+            functions.push_back(std::move(function));
+            ends.push_back(match_[i]);
+            continue;
+        }
+        if (functions.empty()) {
+            continue;
+        }
+
+        Function& function = functions.back();
+        std::string op = opcode(line);
+        if (op == "(local") {
+            std::string name = operand(line);
+            if (function.started) {
+                error = "第" + std::to_string(i + 1) + "行: 局部变量" + name + "没有在函数开头声明";
+                return false;
+            }
+            if (!function.names.insert(name).second) {
+                error = "第" + std::to_string(i + 1) + "行: 重复声明局部变量" + name;
+                return false;
+            }
+            continue;
+        }
+        function.started = true;
+        if (op == "local.get" || op == "local.set" || op == "local.tee") {
+            std::string name = operand(line);
+            if (name.size() < 2 || function.names.count(name) == 0) {
+                error = "第" + std::to_string(i + 1) + "行: 引用了未声明的局部变量'" + name + "'";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool WatProgram::run(std::vector<std::string>& output, std::string& error) const {
+    size_t begin = 0;
+    while (begin < lines_.size() && lines_[begin].rfind("(func $main", 0) != 0) {
+        begin++;
+    }
+    if (!balanced_ || begin == lines_.size()) {
+        error = "没有$main";
+        return false;
+    }
+    size_t end = match_[begin];
+
+    // br_if跳到同名的最内层loop的开头
+    std::vector<size_t> targets(lines_.size(), 0);
+    std::vector<size_t> open;
+    for (size_t i = begin + 1; i < end; i++) {
+        while (!open.empty() && i > match_[open.back()]) {
+            open.pop_back();
+        }
+        std::string op = opcode(lines_[i]);
+        if (match_[i] > i) {
+            open.push_back(i);
+        } else if (op == "br_if") {
+            auto loop = std::find_if(open.rbegin(), open.rend(), [&](size_t start) {
+                return opcode(lines_[start]) == "(loop" && operand(lines_[start]) == operand(lines_[i]);
+            });
+            if (loop == open.rend()) {
+                error = "第" + std::to_string(i + 1) + "行: br_if的目标不是外层的loop";
+                return false;
+            }
+            targets[i] = *loop;
+        }
+    }
+
+    static const std::map<std::string, jvav::IROpcode> BINARY = {
+        {"i32.add", jvav::IROpcode::ADD}, {"i32.sub", jvav::IROpcode::SUB}, {"i32.mul", jvav::IROpcode::MUL},
+        {"i32.div_s", jvav::IROpcode::DIV}, {"i32.rem_s", jvav::IROpcode::REM},
+        {"i32.eq", jvav::IROpcode::EQ}, {"i32.ne", jvav::IROpcode::NE}, {"i32.lt_s", jvav::IROpcode::LT},
+        {"i32.le_s", jvav::IROpcode::LE}, {"i32.gt_s", jvav::IROpcode::GT}, {"i32.ge_s", jvav::IROpcode::GE},
+        {"i32.and", jvav::IROpcode::AND}, {"i32.or", jvav::IROpcode::OR},
+    };
+    std::map<std::string, int32_t> variables;
+    std::vector<int32_t> stack;
+    auto pop = [&stack]() {
+        int32_t value = stack.empty() ? 0 : stack.back();
+        if (!stack.empty()) {
+            stack.pop_back();
+        }
+        return value;
+    };
+
+    size_t steps = 0;
+    for (size_t pc = begin + 1; pc < end;) {
+        if (++steps > MAX_WAT_STEPS) {
+            error = "执行超时";
+            return false;
+        }
+        const std::string& line = lines_[pc];
+        std::string op = opcode(line);
+        if (op == "i32.const") {
+            stack.push_back(static_cast<int32_t>(std::stol(operand(line))));
+        } else if (op == "global.get" || op == "local.get") {
+            stack.push_back(variables[op[0] + operand(line)]);
+        } else if (op == "global.set" || op == "local.set") {
+            variables[op[0] + operand(line)] = pop();
+        } else if (op == "i32.eqz") {
+            stack.push_back(pop() == 0);
+        } else if (op == "drop") {
+            pop();
+        } else if (op == "call" && (operand(line) == "$print_number" || operand(line) == "$console_log")) {
+            output.push_back(std::to_string(pop()));
+        } else if (BINARY.count(op) != 0) {
+            int32_t b = pop();
+            int32_t a = pop();
+            int32_t result;
+            if (!jvav::foldInstruction(BINARY.at(op), a, b, result)) {
+                output.push_back("trap");
+                return true;
+            }
+            stack.push_back(result);
+        } else if (op == "(if") {
+            // 条件为0时跳过then，有else时进入else
+            if (pop() == 0) {
+                size_t after = match_[pc + 1] + 1;
+                pc = after < end && opcode(lines_[after]) == "(else" ? after + 1 : after;
+                continue;
+            }
+        } else if (op == "(else") {
+            // 执行完then之后跳过else
+            pc = match_[pc] + 1;
+            continue;
+        } else if (op == "br_if") {
+            if (pop() != 0) {
+                pc = targets[pc] + 1;
+                continue;
+            }
+        } else if (op != "(then" && op != "(loop" && op != "(block" && op != ")" &&
+                   op != "(local" && op != "(global") {
+            error = "第" + std::to_string(pc + 1) + "行: 不支持的指令 " + line;
+            return false;
+        }
+        pc++;
+    }
+    return true;
+}
+
+// 级别范围，例如O2、O2+、O0-1
+bool parseLevels(const std::string& text, int& low, int& high) {
+    if (text.size() < 2 || text[0] != 'O' || !std::isdigit(static_cast<unsigned char>(text[1]))) {
+        return false;
+    }
+    low = high = text[1] - '0';
+    if (text.size() == 3 && text[2] == '+') {
+        high = 3;
+    } else if (text.size() == 4 && text[2] == '-' && std::isdigit(static_cast<unsigned char>(text[3]))) {
+        high = text[3] - '0';
+    } else if (text.size() != 2) {
+        return false;
+    }
+    return true;
+}
+
+// 源程序中是否有这一行
+bool hasLine(const std::string& source, const std::string& text) {
+    std::istringstream in(source);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line == text) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 执行源程序中的附加检查，出错时在errors中给出原因；wat为语法树后端生成的文本
+void checkDirectives(const std::string& source, int level, const jvav::OptimizationStats& stats,
+                     const std::string& ir, const std::string& wat, std::vector<std::string>& errors) {
+    std::istringstream in(source);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.rfind("# @stat ", 0) != 0 && line.rfind("# @ir ", 0) != 0 && line.rfind("# @wat ", 0) != 0) {
+            continue;
+        }
+        std::istringstream words(line.substr(2));
+        std::string kind;
+        std::string levels;
+        words >> kind >> levels;
+        int low = 0;
+        int high = 0;
+        if (!parseLevels(levels, low, high)) {
+            errors.push_back("级别写错了: " + line);
+            continue;
+        }
+        if (level < low || level > high) {
+            continue;
+        }
+
+        if (kind == "@stat") {
+            std::string name;
+            std::string comparison;
+            size_t expected = 0;
+            words >> name >> comparison >> expected;
+            auto found = std::find_if(std::begin(STATISTICS), std::end(STATISTICS),
+                                      [&name](const auto& entry) { return name == entry.first; });
+            if (found == std::end(STATISTICS) || !words) {
+                errors.push_back("检查写错了: " + line);
+                continue;
+            }
+            size_t actual = stats.*(found->second);
+            bool passed = comparison == "==" ? actual == expected :
+                          comparison == ">=" ? actual >= expected :
+                          comparison == "<=" ? actual <= expected : false;
+            if (!passed) {
+                errors.push_back(line + " 不成立，实际为" + std::to_string(actual));
+            }
+        } else {
+            std::string mode;
+            std::string text;
+            words >> mode;
+            std::getline(words >> std::ws, text);
+            if ((mode != "contains" && mode != "lacks") || text.empty()) {
+                errors.push_back("检查写错了: " + line);
+                continue;
+            }
+            const std::string& target = kind == "@ir" ? ir : wat;
+            if ((target.find(text) != std::string::npos) != (mode == "contains")) {
+                errors.push_back(line + " 不成立");
+            }
+        }
+    }
+}
+
+// 按行读入文件，忽略末尾的空行
+bool readLines(const std::string& path, std::vector<std::string>& lines) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        lines.push_back(line);
+    }
+    while (!lines.empty() && lines.back().empty()) {
+        lines.pop_back();
+    }
+    return true;
+}
+
+// 比较输出，不同时打印两边并返回false
+bool compareOutput(const std::string& title, const std::vector<std::string>& expected,
+                   const std::vector<std::string>& actual) {
+    if (actual == expected) {
+        return true;
+    }
+    std::cerr << title << " 输出与期望不同（左边为期望）" << std::endl;
+    for (size_t i = 0; i < std::max(actual.size(), expected.size()); i++) {
+        const char* mark = i < actual.size() && i < expected.size() && actual[i] == expected[i] ? "  " : "! ";
+        std::cerr << mark << (i < expected.size() ? expected[i] : "<无>") << " | "
+                  << (i < actual.size() ? actual[i] : "<无>") << std::endl;
+    }
+    return false;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc != 4) {
+        std::cerr << "用法: jvav_program_test <源文件> <期望输出文件> <优化级别>" << std::endl;
+        return 2;
+    }
+    std::string sourcePath = argv[1];
+    int level = std::atoi(argv[3]);
+
+    std::ifstream in(sourcePath, std::ios::binary);
+    std::vector<std::string> expected;
+    if (!in || !readLines(argv[2], expected)) {
+        std::cerr << "无法读取测试文件" << std::endl;
+        return 2;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string source = buffer.str();
+
+    // 与编译器相同的流程：解析，语法树优化，降低为中间表示，中间表示优化
+    jvav::Lexer lexer(source, sourcePath);
+    jvav::Program program;
+    jvav::Parser parser(lexer, program.arena);
+    program.statements = parser.parse();
+    if (!parser.getDiagnostics().empty()) {
+        for (const auto& diagnostic : parser.getDiagnostics()) {
+            std::cerr << diagnostic.toString() << std::endl;
+        }
+        return 1;
+    }
+    jvav::Optimizer optimizer;
+    if (level > 0 && !hasLine(source, "# @no-ast")) {
+        optimizer.optimize(program, level);
+    }
+
+    jvav::IRModule module;
+    std::string error;
+    if (!jvav::IRLowering().lower(program, module, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    if (level > 0) {
+        optimizer.optimize(module, level);
+    }
+    if (!module.verify(error)) {
+        std::cerr << "中间表示验证失败: " << error << std::endl;
+        return 1;
+    }
+
+    std::string title = sourcePath + " -O" + std::to_string(level);
+    bool passed = compareOutput(title, expected, Interpreter(module).run());
+
+    // 语法树后端
+    std::vector<std::string> errors;
+    std::string watText;
+    bool runWat = hasLine(source, "# @wat");
+    if (runWat || source.find("# @wat ") != std::string::npos) {
+        std::filesystem::path watPath = std::filesystem::temp_directory_path() /
+            (std::filesystem::path(sourcePath).stem().string() + ".O" + std::to_string(level) + ".wat");
+        jvav::CodeGenerator().generateCode(program, watPath.string());
+        std::ifstream watFile(watPath);
+        std::stringstream watBuffer;
+        watBuffer << watFile.rdbuf();
+        watText = watBuffer.str();
+        watFile.close();
+        std::filesystem::remove(watPath);
+
+        WatProgram wat(watText);
+        std::vector<std::string> watOutput;
+        if (!wat.validate(error) || (runWat && !wat.run(watOutput, error))) {
+            errors.push_back("WebAssembly: " + error);
+        } else if (runWat) {
+            passed = compareOutput(title + " (WebAssembly)", expected, watOutput) && passed;
+        }
+    }
+    checkDirectives(source, level, optimizer.getStats(), module.toString(), watText, errors);
+
+    for (const std::string& message : errors) {
+        std::cerr << title << ": " << message << std::endl;
+    }
+    return passed && errors.empty() ? 0 : 1;
+}